@@ -0,0 +1,694 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>                                           /*  getopt  */
+#include <fcntl.h>                                              /*  open  */
+#include <time.h>                                      /*  clock_gettime  */
+#include <unistd.h>                                /*  fork, execv, dup2  */
+#include <sys/types.h>
+#include <sys/stat.h>                                     /*  stat, mkdir  */
+#include <sys/time.h>
+#include <sys/resource.h>                                 /*  struct rusage  */
+#include <sys/wait.h>                                           /*  wait4  */
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "corpus.h"
+#include "bench.h"
+
+#define COMPARE_BUF_SIZE 65536
+#define LOG_LINE_SIZE 1024
+
+/*
+**  Synthetic corpora used when none are given:
+**  name:length:alphabet:repeat:type
+*/
+static const R_CHAR *default_corpora[] = {
+  "text-low-repeat:2000000:64:20:1",
+  "text-high-repeat:2000000:64:90:1",
+  "short-4096:1000000:4096:60:2",
+  "int-100000:500000:100000:60:4",
+  NULL
+};
+
+static void usage (BENCH_INFO *bench);
+static void parseList (BENCH_INFO *bench, R_CHAR *text, R_UINT *values, R_UINT *count);
+static R_CHAR *joinPath (const R_CHAR *dir, const R_CHAR *name, const R_CHAR *suffix);
+static void addCorpus (BENCH_INFO *bench, R_CHAR *name, R_CHAR *filename, R_UINT datatype);
+static void addSyntheticCorpus (BENCH_INFO *bench, R_CHAR *text);
+static void addFileCorpus (BENCH_INFO *bench, R_CHAR *text);
+static void addDespair (BENCH_INFO *bench, R_CHAR *text);
+static void parseArguments (BENCH_INFO *bench, R_INT argc, R_CHAR *argv[]);
+static R_ULL_INT fileSize (const R_CHAR *filename);
+static void redirectOutput (R_INT fd, const R_CHAR *filename);
+static void runProgram (R_CHAR **argv, const R_CHAR *out_name, const R_CHAR *err_name, RUN_RESULT *result);
+static void runRepeated (BENCH_INFO *bench, R_CHAR **argv, const R_CHAR *err_name, RUN_RESULT *result);
+static R_BOOLEAN sameFiles (const R_CHAR *first, const R_CHAR *second);
+static void readBlockStats (BENCH_INFO *bench, const R_CHAR *log_name);
+static void writeJSONString (FILE *fp, const R_CHAR *text);
+static void writeJSONResult (FILE *fp, RUN_RESULT *result, R_ULL_INT bytes);
+static void writeCSVRow (BENCH_INFO *bench, BENCH_CORPUS *corpus, R_UINT block_size, R_UINT min_count, R_UINT heuristic, const R_CHAR *program, RUN_RESULT *result, R_ULL_INT prel_bytes, R_ULL_INT seq_bytes);
+static void benchConfig (BENCH_INFO *bench, BENCH_CORPUS *corpus, R_UINT block_size, R_UINT min_count, R_UINT heuristic);
+static void openOutputs (BENCH_INFO *bench);
+static void closeOutputs (BENCH_INFO *bench);
+
+
+static void usage (BENCH_INFO *bench) {
+  fprintf (stderr, "Re-Pair benchmarks\n");
+  fprintf (stderr, "==================\n\n");
+  fprintf (stderr, "Usage:  %s [options]\n\n", bench -> progname);
+  fprintf (stderr, "Options:\n");
+  fprintf (stderr, "-r <file>       :  Re-Pair executable  [Required]\n");
+  fprintf (stderr, "-d [name=]<file>:  Des-Pair executable; repeat to compare builds,\n");
+  fprintf (stderr, "                   such as the expansion modes  [Required]\n");
+  fprintf (stderr, "-g <spec>       :  Synthetic corpus, as\n");
+  fprintf (stderr, "                   name:length:alphabet:repeat:type[:seed]; repeat\n");
+  fprintf (stderr, "                   is the percentage of runs copied from earlier\n");
+  fprintf (stderr, "-i <file>[:type]:  Corpus file  [default type:  1]\n");
+  fprintf (stderr, "-b <list>       :  Block sizes (-b) swept  [default:  0]\n");
+  fprintf (stderr, "-x <list>       :  Minimum counts (-x) swept  [default:  0]\n");
+  fprintf (stderr, "-e <list>       :  Heuristics (-e) swept  [default:  0]\n");
+  fprintf (stderr, "-n <runs>       :  Runs of each; the fastest is kept  [default:  1]\n");
+  fprintf (stderr, "-w <dir>        :  Work directory  [default:  bench-work]\n");
+  fprintf (stderr, "-o <prefix>     :  Prefix of the results  [default:  bench]\n");
+  fprintf (stderr, "\nLists are separated by commas; 0 leaves the option to the\n");
+  fprintf (stderr, "program's default.  Without -g or -i, a set of synthetic corpora\n");
+  fprintf (stderr, "is used.  Results are written to <prefix>.csv (one row per\n");
+  fprintf (stderr, "program run), <prefix>-blocks.csv (one row per block) and\n");
+  fprintf (stderr, "<prefix>.json (both).\n\n");
+
+  exit (EXIT_FAILURE);
+}
+
+
+/*  Read a list of numbers, separated by commas  */
+static void parseList (BENCH_INFO *bench, R_CHAR *text, R_UINT *values, R_UINT *count) {
+  R_CHAR *end = NULL;
+
+  *count = 0;
+  while (*text != '\0') {
+    if (*count == MAX_SWEEP) {
+      fprintf (stderr, "Error:  At most %u values can be swept.\n", MAX_SWEEP);
+      exit (EXIT_FAILURE);
+    }
+    errno = 0;
+    values[*count] = (R_UINT) strtoul (text, &end, 10);
+    if ((end == text) || (errno != 0) || ((*end != ',') && (*end != '\0'))) {
+      usage (bench);
+    }
+    (*count)++;
+    text = (*end == ',') ? end + 1 : end;
+  }
+  if (*count == 0) {
+    usage (bench);
+  }
+
+  return;
+}
+
+
+static R_CHAR *joinPath (const R_CHAR *dir, const R_CHAR *name, const R_CHAR *suffix) {
+  R_CHAR *path = wmalloc (strlen (dir) + strlen (name) + strlen (suffix) + 2);
+
+  strcpy (path, dir);
+  strcat (path, "/");
+  strcat (path, name);
+  strcat (path, suffix);
+
+  return (path);
+}
+
+
+static void addCorpus (BENCH_INFO *bench, R_CHAR *name, R_CHAR *filename, R_UINT datatype) {
+  BENCH_CORPUS *corpus = wmalloc (sizeof (BENCH_CORPUS));
+
+  corpus -> name = name;
+  corpus -> filename = filename;
+  corpus -> datatype = datatype;
+  corpus -> bytes = 0;
+  corpus -> synthetic = NULL;
+  corpus -> next = NULL;
+  if (bench -> corpora == NULL) {
+    bench -> corpora = corpus;
+  }
+  else {
+    bench -> corpora_last -> next = corpus;
+  }
+  bench -> corpora_last = corpus;
+
+  return;
+}
+
+
+/*  The corpus is written to the work directory when the runs start  */
+static void addSyntheticCorpus (BENCH_INFO *bench, R_CHAR *text) {
+  CORPUS_SPEC *spec = wmalloc (sizeof (CORPUS_SPEC));
+
+  if (parseCorpusSpec (text, spec) == R_FALSE) {
+    fprintf (stderr, "Error:  Corpus %s not valid.\n", text);
+    exit (EXIT_FAILURE);
+  }
+  addCorpus (bench, spec -> name, NULL, spec -> datatype);
+  bench -> corpora_last -> synthetic = spec;
+
+  return;
+}
+
+
+static void addFileCorpus (BENCH_INFO *bench, R_CHAR *text) {
+  R_CHAR *colon = strrchr (text, ':');
+  R_CHAR *slash = strrchr (text, '/');
+  R_UINT datatype = (R_UINT) sizeof (R_UCHAR);
+
+  if ((colon != NULL) && ((colon[1] == '1') || (colon[1] == '2') || (colon[1] == '4')) && (colon[2] == '\0')) {
+    datatype = (R_UINT) (colon[1] - '0');
+    *colon = '\0';
+  }
+  addCorpus (bench, (slash != NULL) ? slash + 1 : text, text, datatype);
+
+  return;
+}
+
+
+static void addDespair (BENCH_INFO *bench, R_CHAR *text) {
+  R_CHAR *equals = strchr (text, '=');
+  R_CHAR *slash = NULL;
+
+  if (bench -> num_despairs == MAX_DESPAIRS) {
+    fprintf (stderr, "Error:  At most %u Des-Pair executables can be compared.\n", MAX_DESPAIRS);
+    exit (EXIT_FAILURE);
+  }
+  if (equals != NULL) {
+    *equals = '\0';
+    bench -> despair_names[bench -> num_despairs] = text;
+    bench -> despair_paths[bench -> num_despairs] = equals + 1;
+  }
+  else {
+    slash = strrchr (text, '/');
+    bench -> despair_names[bench -> num_despairs] = (slash != NULL) ? slash + 1 : text;
+    bench -> despair_paths[bench -> num_despairs] = text;
+  }
+  bench -> num_despairs++;
+
+  return;
+}
+
+
+static void parseArguments (BENCH_INFO *bench, R_INT argc, R_CHAR *argv[]) {
+  R_INT c;
+  R_UINT i = 0;
+
+  bench -> progname = argv[0];
+  bench -> repair = NULL;
+  bench -> num_despairs = 0;
+  bench -> corpora = NULL;
+  bench -> corpora_last = NULL;
+  bench -> block_sizes[0] = 0;
+  bench -> num_block_sizes = 1;
+  bench -> min_counts[0] = 0;
+  bench -> num_min_counts = 1;
+  bench -> heuristics[0] = 0;
+  bench -> num_heuristics = 1;
+  bench -> repeats = 1;
+  bench -> work_dir = (R_CHAR*) "bench-work";
+  bench -> out_prefix = (R_CHAR*) "bench";
+  bench -> csv_file = NULL;
+  bench -> blocks_file = NULL;
+  bench -> json_file = NULL;
+  bench -> num_configs = 0;
+  bench -> num_blocks = 0;
+
+  while ((c = getopt (argc, argv, "r:d:g:i:b:x:e:n:w:o:")) != EOF) {
+    switch (c) {
+      case 'r':  bench -> repair = optarg;
+                 break;
+      case 'd':  addDespair (bench, optarg);
+                 break;
+      case 'g':  addSyntheticCorpus (bench, optarg);
+                 break;
+      case 'i':  addFileCorpus (bench, optarg);
+                 break;
+      case 'b':  parseList (bench, optarg, bench -> block_sizes, &(bench -> num_block_sizes));
+                 break;
+      case 'x':  parseList (bench, optarg, bench -> min_counts, &(bench -> num_min_counts));
+                 break;
+      case 'e':  parseList (bench, optarg, bench -> heuristics, &(bench -> num_heuristics));
+                 break;
+      case 'n':  bench -> repeats = (R_UINT) atoi (optarg);
+                 break;
+      case 'w':  bench -> work_dir = optarg;
+                 break;
+      case 'o':  bench -> out_prefix = optarg;
+                 break;
+      default:  usage (bench);
+    }
+  }
+
+  if ((bench -> repair == NULL) || (bench -> num_despairs == 0) || (bench -> repeats == 0) || (optind != argc)) {
+    usage (bench);
+  }
+  for (i = 0; i < bench -> num_heuristics; i++) {
+    if (bench -> heuristics[i] > 3) {
+      fprintf (stderr, "Error:  Heuristic %u not known.\n", bench -> heuristics[i]);
+      exit (EXIT_FAILURE);
+    }
+  }
+
+  if (bench -> corpora == NULL) {
+    for (i = 0; default_corpora[i] != NULL; i++) {
+      addSyntheticCorpus (bench, (R_CHAR*) default_corpora[i]);
+    }
+  }
+
+  return;
+}
+
+
+static R_ULL_INT fileSize (const R_CHAR *filename) {
+  struct stat statbuffer;
+
+  if (stat (filename, &statbuffer) != 0) {
+    return (0);
+  }
+
+  return ((R_ULL_INT) statbuffer.st_size);
+}
+
+
+/*  Send fd to filename, or discard it if filename is NULL  */
+static void redirectOutput (R_INT fd, const R_CHAR *filename) {
+  R_INT new_fd = open ((filename != NULL) ? filename : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if ((new_fd < 0) || (dup2 (new_fd, fd) < 0)) {
+    perror ((filename != NULL) ? filename : "/dev/null");
+    _exit (EXIT_FAILURE);
+  }
+  (void) close (new_fd);
+
+  return;
+}
+
+
+/*
+**  Run argv[0] with the arguments argv and wait for it.  Its standard
+**  output and error are written to out_name and err_name (NULL
+**  discards them).  The time and peak memory of the child are those
+**  reported by the kernel when it exits.
+*/
+static void runProgram (R_CHAR **argv, const R_CHAR *out_name, const R_CHAR *err_name, RUN_RESULT *result) {
+  struct timespec start;
+  struct timespec end;
+  struct rusage usage_info;
+  pid_t pid;
+  R_INT status = 0;
+
+  (void) clock_gettime (CLOCK_MONOTONIC, &start);
+  pid = fork ();
+  if (pid < 0) {
+    perror ("fork");
+    exit (EXIT_FAILURE);
+  }
+  if (pid == 0) {
+    redirectOutput (STDOUT_FILENO, out_name);
+    redirectOutput (STDERR_FILENO, err_name);
+    (void) execv (argv[0], argv);
+    _exit (127);
+  }
+  if (wait4 (pid, &status, 0, &usage_info) != pid) {
+    perror ("wait4");
+    exit (EXIT_FAILURE);
+  }
+  (void) clock_gettime (CLOCK_MONOTONIC, &end);
+
+  result -> wall = (R_DOUBLE) (end.tv_sec - start.tv_sec) + (R_DOUBLE) (end.tv_nsec - start.tv_nsec) / 1e9;
+  result -> user = (R_DOUBLE) usage_info.ru_utime.tv_sec + (R_DOUBLE) usage_info.ru_utime.tv_usec / 1e6;
+  result -> sys = (R_DOUBLE) usage_info.ru_stime.tv_sec + (R_DOUBLE) usage_info.ru_stime.tv_usec / 1e6;
+  result -> peak_rss = (R_ULL_INT) usage_info.ru_maxrss;
+  result -> ok = ((WIFEXITED (status)) && (WEXITSTATUS (status) == 0)) ? R_TRUE : R_FALSE;
+  if ((WIFEXITED (status)) && (WEXITSTATUS (status) == 127)) {
+    fprintf (stderr, "Warning:  %s could not be run.\n", argv[0]);
+  }
+
+  return;
+}
+
+
+/*
+**  Run a program bench -> repeats times and keep the fastest run.
+**  The peak memory is the largest of all of the runs.
+*/
+static void runRepeated (BENCH_INFO *bench, R_CHAR **argv, const R_CHAR *err_name, RUN_RESULT *result) {
+  RUN_RESULT current;
+  R_UINT i = 0;
+
+  runProgram (argv, NULL, err_name, result);
+  for (i = 1; (i < bench -> repeats) && (result -> ok == R_TRUE); i++) {
+    runProgram (argv, NULL, err_name, &current);
+    if (current.peak_rss > result -> peak_rss) {
+      result -> peak_rss = current.peak_rss;
+    }
+    if (current.ok == R_FALSE) {
+      result -> ok = R_FALSE;
+    }
+    else if (current.wall < result -> wall) {
+      result -> wall = current.wall;
+      result -> user = current.user;
+      result -> sys = current.sys;
+    }
+  }
+
+  return;
+}
+
+
+static R_BOOLEAN sameFiles (const R_CHAR *first, const R_CHAR *second) {
+  R_UCHAR *buf1 = NULL;
+  R_UCHAR *buf2 = NULL;
+  FILE *fp1 = fopen (first, "r");
+  FILE *fp2 = fopen (second, "r");
+  size_t n1 = 0;
+  size_t n2 = 0;
+  R_BOOLEAN same = R_TRUE;
+
+  if ((fp1 == NULL) || (fp2 == NULL)) {
+    same = R_FALSE;
+  }
+  else {
+    buf1 = wmalloc (COMPARE_BUF_SIZE);
+    buf2 = wmalloc (COMPARE_BUF_SIZE);
+    do {
+      n1 = fread (buf1, 1, COMPARE_BUF_SIZE, fp1);
+      n2 = fread (buf2, 1, COMPARE_BUF_SIZE, fp2);
+      if ((n1 != n2) || (memcmp (buf1, buf2, n1) != 0)) {
+        same = R_FALSE;
+      }
+    } while ((same == R_TRUE) && (n1 > 0));
+    wfree (buf1);
+    wfree (buf2);
+  }
+  if (fp1 != NULL) {
+    FCLOSE (fp1);
+  }
+  if (fp2 != NULL) {
+    FCLOSE (fp2);
+  }
+
+  return (same);
+}
+
+
+/*
+**  Read the per-block statistics which repair -v prints to standard
+**  error; one line of six numbers per block, before the totals
+*/
+static void readBlockStats (BENCH_INFO *bench, const R_CHAR *log_name) {
+  R_CHAR line[LOG_LINE_SIZE];
+  BLOCK_STATS *stats = NULL;
+  R_UINT sum = 0;
+  FILE *fp = fopen (log_name, "r");
+
+  bench -> num_blocks = 0;
+  if (fp == NULL) {
+    return;
+  }
+  while ((fgets (line, LOG_LINE_SIZE, fp) != NULL) && (line[0] != '-')) {
+    if (bench -> num_blocks == MAX_BLOCKS_KEPT) {
+      break;
+    }
+    stats = &(bench -> blocks[bench -> num_blocks]);
+    if (sscanf (line, "%u %u %u %u %u %llu", &(stats -> block), &(stats -> prims), &(stats -> phrases), &sum, &(stats -> generations), &(stats -> symbols)) == 6) {
+      bench -> num_blocks++;
+    }
+  }
+  FCLOSE (fp);
+
+  return;
+}
+
+
+static void writeJSONString (FILE *fp, const R_CHAR *text) {
+  fputc ('"', fp);
+  for (; *text != '\0'; text++) {
+    if ((*text == '"') || (*text == '\\')) {
+      fputc ('\\', fp);
+      fputc (*text, fp);
+    }
+    else if ((R_UCHAR) *text < 0x20) {
+      fprintf (fp, "\\u%04x", (R_UINT) (R_UCHAR) *text);
+    }
+    else {
+      fputc (*text, fp);
+    }
+  }
+  fputc ('"', fp);
+
+  return;
+}
+
+
+static void writeJSONResult (FILE *fp, RUN_RESULT *result, R_ULL_INT bytes) {
+  fprintf (fp, "\"ok\": %s, \"wall_s\": %.6f, \"user_s\": %.6f, \"sys_s\": %.6f, \"peak_rss_kib\": %llu, \"mb_per_s\": %.3f", (result -> ok == R_TRUE) ? "true" : "false", result -> wall, result -> user, result -> sys, result -> peak_rss, (result -> wall > 0) ? (R_DOUBLE) bytes / result -> wall / 1e6 : 0.0);
+
+  return;
+}
+
+
+static void writeCSVRow (BENCH_INFO *bench, BENCH_CORPUS *corpus, R_UINT block_size, R_UINT min_count, R_UINT heuristic, const R_CHAR *program, RUN_RESULT *result, R_ULL_INT prel_bytes, R_ULL_INT seq_bytes) {
+  fprintf (bench -> csv_file, "%s,%llu,%u,%u,%u,%u,%s,%u,%.6f,%.6f,%.6f,%llu,%.3f,%llu,%llu,%.6f\n", corpus -> name, corpus -> bytes, corpus -> datatype, block_size, min_count, heuristic, program, (result -> ok == R_TRUE) ? 1u : 0u, result -> wall, result -> user, result -> sys, result -> peak_rss, (result -> wall > 0) ? (R_DOUBLE) corpus -> bytes / result -> wall / 1e6 : 0.0, prel_bytes, seq_bytes, (corpus -> bytes > 0) ? (R_DOUBLE) (prel_bytes + seq_bytes) / (R_DOUBLE) corpus -> bytes : 0.0);
+
+  return;
+}
+
+
+/*
+**  Compress one corpus with one setting of the options, decompress
+**  it with each Des-Pair, and write out the results
+*/
+static void benchConfig (BENCH_INFO *bench, BENCH_CORPUS *corpus, R_UINT block_size, R_UINT min_count, R_UINT heuristic) {
+  R_CHAR *args[16];
+  R_CHAR type_arg[16];
+  R_CHAR block_arg[16];
+  R_CHAR count_arg[16];
+  R_CHAR heur_arg[16];
+  R_CHAR *base = joinPath (bench -> work_dir, "run", "");
+  R_CHAR *log_name = joinPath (bench -> work_dir, "run", ".log");
+  R_CHAR *prel_name = joinPath (bench -> work_dir, "run", ".prel");
+  R_CHAR *seq_name = joinPath (bench -> work_dir, "run", ".seq");
+  R_CHAR *index_name = joinPath (bench -> work_dir, "run", ".idx");
+  R_CHAR *out_name = joinPath (bench -> work_dir, "run", ".u");
+  RUN_RESULT repair_result;
+  RUN_RESULT despair_result;
+  R_ULL_INT prel_bytes = 0;
+  R_ULL_INT seq_bytes = 0;
+  R_UINT n = 0;
+  R_UINT i = 0;
+
+  (void) sprintf (type_arg, "%u", corpus -> datatype);
+  (void) sprintf (block_arg, "%u", block_size);
+  (void) sprintf (count_arg, "%u", min_count);
+  (void) sprintf (heur_arg, "%u", heuristic);
+
+  fprintf (stderr, "%s -b %u -x %u -e %u\n", corpus -> name, block_size, min_count, heuristic);
+
+  args[n++] = bench -> repair;
+  args[n++] = (R_CHAR*) "-i";
+  args[n++] = corpus -> filename;
+  args[n++] = (R_CHAR*) "-o";
+  args[n++] = base;
+  args[n++] = (R_CHAR*) "-t";
+  args[n++] = type_arg;
+  args[n++] = (R_CHAR*) "-v";
+  if (block_size != 0) {
+    args[n++] = (R_CHAR*) "-b";
+    args[n++] = block_arg;
+  }
+  if (min_count != 0) {
+    args[n++] = (R_CHAR*) "-x";
+    args[n++] = count_arg;
+  }
+  if (heuristic != 0) {
+    args[n++] = (R_CHAR*) "-e";
+    args[n++] = heur_arg;
+  }
+  args[n] = NULL;
+  runRepeated (bench, args, log_name, &repair_result);
+  readBlockStats (bench, log_name);
+  prel_bytes = fileSize (prel_name);
+  seq_bytes = fileSize (seq_name);
+  writeCSVRow (bench, corpus, block_size, min_count, heuristic, "repair", &repair_result, prel_bytes, seq_bytes);
+  for (i = 0; i < bench -> num_blocks; i++) {
+    fprintf (bench -> blocks_file, "%s,%u,%u,%u,%u,%u,%u,%u,%u,%llu\n", corpus -> name, corpus -> datatype, block_size, min_count, heuristic, bench -> blocks[i].block, bench -> blocks[i].prims, bench -> blocks[i].phrases, bench -> blocks[i].generations, bench -> blocks[i].symbols);
+  }
+
+  fprintf (bench -> json_file, "%s\n    {\"corpus\": ", (bench -> num_configs == 0) ? "" : ",");
+  writeJSONString (bench -> json_file, corpus -> name);
+  fprintf (bench -> json_file, ", \"bytes\": %llu, \"type\": %u, \"block_size\": %u, \"min_count\": %u, \"heuristic\": %u,\n", corpus -> bytes, corpus -> datatype, block_size, min_count, heuristic);
+  fprintf (bench -> json_file, "     \"prel_bytes\": %llu, \"seq_bytes\": %llu, \"ratio\": %.6f,\n", prel_bytes, seq_bytes, (corpus -> bytes > 0) ? (R_DOUBLE) (prel_bytes + seq_bytes) / (R_DOUBLE) corpus -> bytes : 0.0);
+  fprintf (bench -> json_file, "     \"repair\": {");
+  writeJSONResult (bench -> json_file, &repair_result, corpus -> bytes);
+  fprintf (bench -> json_file, "},\n     \"blocks\": [");
+  for (i = 0; i < bench -> num_blocks; i++) {
+    fprintf (bench -> json_file, "%s{\"block\": %u, \"prims\": %u, \"phrases\": %u, \"generations\": %u, \"symbols\": %llu}", (i == 0) ? "" : ", ", bench -> blocks[i].block, bench -> blocks[i].prims, bench -> blocks[i].phrases, bench -> blocks[i].generations, bench -> blocks[i].symbols);
+  }
+  fprintf (bench -> json_file, "],\n     \"despair\": [");
+  bench -> num_configs++;
+
+  for (i = 0; i < bench -> num_despairs; i++) {
+    n = 0;
+    args[n++] = bench -> despair_paths[i];
+    args[n++] = (R_CHAR*) "-i";
+    args[n++] = base;
+    args[n++] = (R_CHAR*) "-t";
+    args[n++] = type_arg;
+    args[n] = NULL;
+    despair_result.ok = R_FALSE;
+    despair_result.wall = 0;
+    despair_result.user = 0;
+    despair_result.sys = 0;
+    despair_result.peak_rss = 0;
+    if (repair_result.ok == R_TRUE) {
+      runRepeated (bench, args, NULL, &despair_result);
+      if (sameFiles (corpus -> filename, out_name) == R_FALSE) {
+        despair_result.ok = R_FALSE;
+      }
+    }
+    (void) unlink (out_name);
+
+    writeCSVRow (bench, corpus, block_size, min_count, heuristic, bench -> despair_names[i], &despair_result, prel_bytes, seq_bytes);
+    fprintf (bench -> json_file, "%s\n       {\"name\": ", (i == 0) ? "" : ",");
+    writeJSONString (bench -> json_file, bench -> despair_names[i]);
+    fprintf (bench -> json_file, ", ");
+    writeJSONResult (bench -> json_file, &despair_result, corpus -> bytes);
+    fprintf (bench -> json_file, "}");
+  }
+  fprintf (bench -> json_file, "]}");
+
+  (void) unlink (prel_name);
+  (void) unlink (seq_name);
+  (void) unlink (index_name);
+  (void) unlink (log_name);
+  wfree (base);
+  wfree (log_name);
+  wfree (prel_name);
+  wfree (seq_name);
+  wfree (index_name);
+  wfree (out_name);
+
+  return;
+}
+
+
+static void openOutputs (BENCH_INFO *bench) {
+  R_CHAR *name = NULL;
+
+  name = wmalloc (strlen (bench -> out_prefix) + 12);
+  sprintf (name, "%s.csv", bench -> out_prefix);
+  FOPEN (name, bench -> csv_file, "w");
+  sprintf (name, "%s-blocks.csv", bench -> out_prefix);
+  FOPEN (name, bench -> blocks_file, "w");
+  sprintf (name, "%s.json", bench -> out_prefix);
+  FOPEN (name, bench -> json_file, "w");
+  wfree (name);
+
+  fprintf (bench -> csv_file, "corpus,bytes,type,block_size,min_count,heuristic,program,ok,wall_s,user_s,sys_s,peak_rss_kib,mb_per_s,prel_bytes,seq_bytes,ratio\n");
+  fprintf (bench -> blocks_file, "corpus,type,block_size,min_count,heuristic,block,prims,phrases,generations,symbols\n");
+  fprintf (bench -> json_file, "{\n  \"runs\": [");
+
+  return;
+}
+
+
+static void closeOutputs (BENCH_INFO *bench) {
+  fprintf (bench -> json_file, "\n  ]\n}\n");
+  FCLOSE (bench -> csv_file);
+  FCLOSE (bench -> blocks_file);
+  FCLOSE (bench -> json_file);
+
+  return;
+}
+
+
+R_INT main (R_INT argc, R_CHAR *argv[]) {
+  BENCH_INFO *bench = NULL;
+  BENCH_CORPUS *corpus = NULL;
+  BENCH_CORPUS *next = NULL;
+  R_UINT b = 0;
+  R_UINT x = 0;
+  R_UINT e = 0;
+
+  bench = wmalloc (sizeof (BENCH_INFO));
+  parseArguments (bench, argc, argv);
+
+  if ((mkdir (bench -> work_dir, 0755) != 0) && (errno != EEXIST)) {
+    perror (bench -> work_dir);
+    exit (EXIT_FAILURE);
+  }
+
+  for (corpus = bench -> corpora; corpus != NULL; corpus = corpus -> next) {
+    if (corpus -> synthetic != NULL) {
+      corpus -> filename = joinPath (bench -> work_dir, corpus -> name, ".corpus");
+      writeCorpus (corpus -> synthetic, corpus -> filename);
+    }
+    corpus -> bytes = fileSize (corpus -> filename);
+    if (corpus -> bytes == 0) {
+      fprintf (stderr, "Error:  Corpus %s is empty or missing.\n", corpus -> filename);
+      exit (EXIT_FAILURE);
+    }
+  }
+
+  openOutputs (bench);
+  for (corpus = bench -> corpora; corpus != NULL; corpus = corpus -> next) {
+    for (b = 0; b < bench -> num_block_sizes; b++) {
+      for (x = 0; x < bench -> num_min_counts; x++) {
+        for (e = 0; e < bench -> num_heuristics; e++) {
+          /*  Word-aligned pairing is only for bytes  */
+          if ((bench -> heuristics[e] == 1) && (corpus -> datatype != (R_UINT) sizeof (R_UCHAR))) {
+            continue;
+          }
+          benchConfig (bench, corpus, bench -> block_sizes[b], bench -> min_counts[x], bench -> heuristics[e]);
+        }
+      }
+    }
+  }
+  closeOutputs (bench);
+
+  for (corpus = bench -> corpora; corpus != NULL; corpus = next) {
+    next = corpus -> next;
+    if (corpus -> synthetic != NULL) {
+      (void) unlink (corpus -> filename);
+      wfree (corpus -> filename);
+      wfree (corpus -> synthetic -> name);
+      wfree (corpus -> synthetic);
+    }
+    wfree (corpus);
+  }
+  wfree (bench);
+
+  return (EXIT_SUCCESS);
+}
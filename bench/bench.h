@@ -0,0 +1,94 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#define MAX_DESPAIRS 8            /*  Most Des-Pair builds compared at once  */
+#define MAX_SWEEP 32                  /*  Most values of each option swept  */
+#define MAX_BLOCKS_KEPT 4096
+                         /*  Most blocks whose statistics are kept per run  */
+
+/*
+**  One input of the benchmarks; either a file given by the user or a
+**  synthetic corpus written to the work directory
+*/
+typedef struct bench_corpus {
+  R_CHAR *name;
+  R_CHAR *filename;
+  R_UINT datatype;
+  R_ULL_INT bytes;
+  CORPUS_SPEC *synthetic;            /*  NULL for the files of the user  */
+  struct bench_corpus *next;
+} BENCH_CORPUS;
+
+/*  Resources used by one run of a program  */
+typedef struct run_result {
+  R_DOUBLE wall;                                    /*  Times, in seconds  */
+  R_DOUBLE user;
+  R_DOUBLE sys;
+  R_ULL_INT peak_rss;                         /*  Peak resident set, in KiB  */
+  R_BOOLEAN ok;                  /*  Exited with 0 and, for Des-Pair, the  */
+                                            /*  output matched the input  */
+} RUN_RESULT;
+
+/*  Statistics of one block, as printed by repair -v  */
+typedef struct block_stats {
+  R_UINT block;
+  R_UINT prims;
+  R_UINT phrases;
+  R_UINT generations;
+  R_ULL_INT symbols;
+} BLOCK_STATS;
+
+typedef struct bench_info {
+  R_CHAR *progname;
+  R_CHAR *repair;                                /*  Path of the programs  */
+  R_CHAR *despair_names[MAX_DESPAIRS];
+  R_CHAR *despair_paths[MAX_DESPAIRS];
+  R_UINT num_despairs;
+  BENCH_CORPUS *corpora;
+  BENCH_CORPUS *corpora_last;
+
+  /*  Values swept; 0 leaves the option to the program's default  */
+  R_UINT block_sizes[MAX_SWEEP];                                   /*  -b  */
+  R_UINT num_block_sizes;
+  R_UINT min_counts[MAX_SWEEP];                                    /*  -x  */
+  R_UINT num_min_counts;
+  R_UINT heuristics[MAX_SWEEP];                                    /*  -e  */
+  R_UINT num_heuristics;
+  R_UINT repeats;               /*  Runs of each; the fastest is reported  */
+
+  R_CHAR *work_dir;
+  R_CHAR *out_prefix;
+  FILE *csv_file;
+  FILE *blocks_file;
+  FILE *json_file;
+  R_UINT num_configs;                  /*  Configurations written so far  */
+
+  BLOCK_STATS blocks[MAX_BLOCKS_KEPT];
+  R_UINT num_blocks;
+} BENCH_INFO;
+
+#endif
@@ -0,0 +1,165 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "corpus.h"
+
+#define PRINTABLE_FIRST ' '
+#define PRINTABLE_COUNT 95
+
+static R_ULL_INT nextRandom (R_ULL_INT *state);
+static void putSymbol (R_UCHAR *dest, R_UINT datatype, R_UINT x);
+
+/*  xorshift64*; the state must not be 0  */
+static R_ULL_INT nextRandom (R_ULL_INT *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+
+  return (*state * 0x2545F4914F6CDD1Dull);
+}
+
+
+/*  Store symbol x in the byte order of this machine, as Re-Pair reads it  */
+static void putSymbol (R_UCHAR *dest, R_UINT datatype, R_UINT x) {
+  R_UCHAR c = (R_UCHAR) x;
+  R_USHRT s = (R_USHRT) x;
+
+  if (datatype == (R_UINT) sizeof (R_UCHAR)) {
+    memcpy (dest, &c, sizeof (R_UCHAR));
+  }
+  else if (datatype == (R_UINT) sizeof (R_USHRT)) {
+    memcpy (dest, &s, sizeof (R_USHRT));
+  }
+  else {
+    memcpy (dest, &x, sizeof (R_UINT));
+  }
+
+  return;
+}
+
+
+/*
+**  Fill in spec from text of the form
+**  name:length:alphabet:repeat:type[:seed].  Returns R_FALSE if the
+**  text is not of this form or the values are out of range.
+*/
+R_BOOLEAN parseCorpusSpec (R_CHAR *text, CORPUS_SPEC *spec) {
+  R_CHAR *colon = strchr (text, ':');
+  R_UINT fields = 0;
+
+  if ((colon == NULL) || (colon == text)) {
+    return (R_FALSE);
+  }
+
+  spec -> name = wmalloc ((size_t) (colon - text) + 1);
+  memcpy (spec -> name, text, (size_t) (colon - text));
+  spec -> name[colon - text] = '\0';
+  spec -> seed = 1;
+  fields = (R_UINT) sscanf (colon + 1, "%llu:%u:%u:%u:%llu", &(spec -> length), &(spec -> alphabet), &(spec -> repeat), &(spec -> datatype), &(spec -> seed));
+  if (fields < 4) {
+    return (R_FALSE);
+  }
+
+  if ((spec -> datatype != (R_UINT) sizeof (R_UCHAR)) && (spec -> datatype != (R_UINT) sizeof (R_USHRT)) && (spec -> datatype != (R_UINT) sizeof (R_UINT))) {
+    return (R_FALSE);
+  }
+  if ((spec -> alphabet == 0) || (spec -> repeat > 100) || (spec -> length == 0)) {
+    return (R_FALSE);
+  }
+  if ((spec -> datatype < (R_UINT) sizeof (R_UINT)) && (spec -> alphabet > (1u << (spec -> datatype * 8)))) {
+    return (R_FALSE);
+  }
+  if (spec -> seed == 0) {
+    spec -> seed = 1;
+  }
+
+  return (R_TRUE);
+}
+
+
+/*
+**  Write the corpus described by spec to filename.  Byte corpora with
+**  at most 95 symbols use the printable ASCII characters, so that the
+**  word-aligned heuristic (-e 1) sees words and punctuation.
+*/
+void writeCorpus (CORPUS_SPEC *spec, const R_CHAR *filename) {
+  R_ULL_INT state = spec -> seed;
+  R_UCHAR *data = NULL;
+  size_t width = (size_t) spec -> datatype;
+  R_ULL_INT pos = 0;
+  R_ULL_INT from = 0;
+  R_ULL_INT run = 0;
+  R_ULL_INT i = 0;
+  R_UINT base = 0;
+  R_UINT x = 0;
+  FILE *fp = NULL;
+
+  if (spec -> length > (R_ULL_INT) (((size_t) -1) / width)) {
+    fprintf (stderr, "Error:  Corpus %s is too large.\n", spec -> name);
+    exit (EXIT_FAILURE);
+  }
+  if ((width == sizeof (R_UCHAR)) && (spec -> alphabet <= PRINTABLE_COUNT)) {
+    base = PRINTABLE_FIRST;
+  }
+
+  data = wmalloc ((size_t) (spec -> length * width));
+  while (pos < spec -> length) {
+    run = CORPUS_MIN_RUN + nextRandom (&state) % (CORPUS_MAX_RUN - CORPUS_MIN_RUN + 1);
+    if (run > spec -> length - pos) {
+      run = spec -> length - pos;
+    }
+
+    if ((pos > 0) && (nextRandom (&state) % 100 < (R_ULL_INT) spec -> repeat)) {
+      /*  Copied a symbol at a time, since the runs may overlap  */
+      from = nextRandom (&state) % pos;
+      for (i = 0; i < run; i++) {
+        memcpy (data + (pos + i) * width, data + (from + i) * width, width);
+      }
+    }
+    else {
+      for (i = 0; i < run; i++) {
+        x = base + (R_UINT) (nextRandom (&state) % spec -> alphabet);
+        putSymbol (data + (pos + i) * width, spec -> datatype, x);
+      }
+    }
+    pos += run;
+  }
+
+  FOPEN (filename, fp, "w");
+  if (fwrite (data, width, (size_t) spec -> length, fp) != (size_t) spec -> length) {
+    fprintf (stderr, "Error writing %s.\n", filename);
+    exit (EXIT_FAILURE);
+  }
+  FCLOSE (fp);
+  wfree (data);
+
+  return;
+}
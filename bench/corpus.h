@@ -0,0 +1,49 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#define CORPUS_MIN_RUN 4         /*  Shortest run of copied or random symbols  */
+#define CORPUS_MAX_RUN 64                                 /*  Longest run  */
+
+/*
+**  A synthetic corpus.  It is made of runs of CORPUS_MIN_RUN to
+**  CORPUS_MAX_RUN symbols; each run is either copied from a random
+**  earlier position of the corpus, with probability repeat percent,
+**  or drawn at random from the alphabet.
+*/
+typedef struct corpus_spec {
+  R_CHAR *name;
+  R_ULL_INT length;                                /*  Number of symbols  */
+  R_UINT alphabet;                     /*  Number of different symbols  */
+  R_UINT repeat;                 /*  Percentage of runs copied (0 - 100)  */
+  R_UINT datatype;                   /*  Bytes per symbol:  1, 2 or 4 (-t)  */
+  R_ULL_INT seed;                         /*  Seed of the random numbers  */
+} CORPUS_SPEC;
+
+R_BOOLEAN parseCorpusSpec (R_CHAR *text, CORPUS_SPEC *spec);
+void writeCorpus (CORPUS_SPEC *spec, const R_CHAR *filename);
+
+#endif
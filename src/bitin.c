@@ -25,15 +25,26 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <errno.h>
+#include <string.h>
 #include <limits.h>
+#include <sys/types.h>                                         /*  off_t  */
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
 #include "utils.h"
 #include "bitin.h"
 
 #define UINT_SIZE_BITS 32
-
+#define ULL_SIZE_BITS 64
+#define REFILL_BITS 56
+                  /*  After a refill, at least this many bits are held  */
+                                       /*  unless the file has ended  */
+
+static void fillBits (BITINREC *r);
+static R_UINT countLeadingZeros (R_ULL_INT x);
+static void skipBits (R_UINT bits, BITINREC *r);
 static R_UINT readBits (R_UINT bits, BITINREC *r);
 static R_UINT unaryDecode (R_UINT lo, BITINREC *r);
 
@@ -48,131 +59,257 @@ BITINREC *newBitin (FILE *in) {
   bitrec -> bufferPos = bitrec -> buffer;
   bitrec -> bufferTop = bitrec -> buffer;
   bitrec -> bitBuffer = 0;
+  bitrec -> map = NULL;
+  bitrec -> map_size = 0;
 
   return (bitrec);
 }
 
 
-static R_UINT readNext (R_UINT minBits, BITINREC *r) {
-  R_UCHAR *b;
-  R_UINT n;
-  R_UINT newBits;
+/*
+**  Read bits straight from map_size bytes already in memory, such as
+**  a file mapped with mmap, without copying them
+*/
+BITINREC *newBitinMap (const R_UCHAR *map, size_t map_size) {
+  BITINREC *bitrec;
+  bitrec = wmalloc (sizeof (BITINREC));
+
+  bitrec -> in = NULL;
+  bitrec -> availableBits = 0;
+
+  bitrec -> buffer = NULL;
+  bitrec -> bufferPos = map;
+  bitrec -> bufferTop = map + map_size;
+  bitrec -> bitBuffer = 0;
+  bitrec -> map = map;
+  bitrec -> map_size = map_size;
+
+  return (bitrec);
+}
+
+
+void deleteBitin (BITINREC *r) {
+  if (r -> buffer != NULL) {
+    wfree (r -> buffer);
+  }
+  wfree (r);
+
+  return;
+}
+
 
-  if (r -> bufferPos == r -> bufferTop) {
-    n = (R_UINT) fread (r -> buffer, 1, sizeof (r -> buffer), r -> in);
-    if (ferror (r -> in) != R_FALSE) {
-      perror (__FILE__);
-      exit (EXIT_FAILURE);
+/*
+**  Move to the given offset, in bits, from the start of the input
+**  file.  The file must be seekable and the stream must have been
+**  written in 32-bit words (as bitout.c does).
+*/
+void seekBitin (BITINREC *r, R_ULL_INT offset) {
+  R_ULL_INT byte_offset = (offset / UINT_SIZE_BITS) * 4;
+
+  if (r -> map != NULL) {
+    if (byte_offset > (R_ULL_INT) r -> map_size) {
+      raiseError ("ERROR:  Seek past the end of file in %s on line %d.\n", __FILE__, __LINE__);
     }
-    if (n < 1) {
-      fprintf (stderr, "ERROR:  Unexpected end of file in %s on line %d.\n", __FILE__, __LINE__);
-      exit (EXIT_FAILURE);
+    r -> bufferPos = r -> map + byte_offset;
+    r -> bufferTop = r -> map + r -> map_size;
+  }
+  else {
+    if (fseeko (r -> in, (off_t) byte_offset, SEEK_SET) != 0) {
+      raiseError ("%s: %s\n", __FILE__, strerror (errno));
     }
     r -> bufferPos = r -> buffer;
-    r -> bufferTop = r -> bufferPos + n;
+    r -> bufferTop = r -> buffer;
   }
-  b = r -> bufferPos;
-  r -> bufferPos = b + 4;
+  r -> availableBits = 0;
+  r -> bitBuffer = 0;
+
+  skipBits ((R_UINT) (offset % UINT_SIZE_BITS), r);
 
-  r -> bitBuffer = (R_UINT) b[0]<<24|
-    (R_UINT) b[1]<<16|
-    (R_UINT) b[2]<<8|
-    (R_UINT) b[3];
+  return;
+}
+
+
+/*
+**  Top up bitBuffer with whole bytes from the input buffer, reading
+**  more of the file when the buffer is empty (a mapped file is all in
+**  the buffer already).  At the end of the file,
+**  fewer than REFILL_BITS bits may be available.
+**
+**  bitBuffer holds the next bits of the stream from its most significant
+**  bit down.  Bits below the first availableBits are either 0 or copies
+**  of the stream bits which follow, so or-ing in the next 8 bytes at
+**  once is safe.
+*/
+static void fillBits (BITINREC *r) {
+  const R_UCHAR *b;
+  R_ULL_INT w;
+  R_UINT n;
 
-  if (r -> bufferPos > r -> bufferTop) {
-    newBits = (R_UINT) (32 - ((r -> bufferPos - r -> bufferTop) * 8));
-    if (newBits < minBits) {
-      fprintf (stderr, "ERROR:  Unexpected end of file in %s on line %d.\n", __FILE__, __LINE__);
-      exit (EXIT_FAILURE);
+  while (r -> availableBits <= REFILL_BITS) {
+    if (r -> bufferTop - r -> bufferPos >= 8) {
+      b = r -> bufferPos;
+      w = (R_ULL_INT) b[0] << 56 | (R_ULL_INT) b[1] << 48 |
+        (R_ULL_INT) b[2] << 40 | (R_ULL_INT) b[3] << 32 |
+        (R_ULL_INT) b[4] << 24 | (R_ULL_INT) b[5] << 16 |
+        (R_ULL_INT) b[6] << 8 | (R_ULL_INT) b[7];
+      r -> bitBuffer |= w >> r -> availableBits;
+      n = (ULL_SIZE_BITS - 1 - r -> availableBits) >> 3;
+      r -> bufferPos += n;
+      r -> availableBits += n << 3;
+      return;
     }
-    r -> bufferTop = r -> bufferPos;
-    return (newBits);
-  } 
-  else {
-    return (32u);
+    if (r -> bufferPos == r -> bufferTop) {
+      if (r -> in == NULL) {
+        return;                              /*  End of the mapped file  */
+      }
+      n = (R_UINT) fread (r -> buffer, 1, BITINREC_BUF_SIZE, r -> in);
+      if (ferror (r -> in) != R_FALSE) {
+        raiseError ("%s: %s\n", __FILE__, strerror (errno));
+      }
+      if (n < 1) {
+        return;                                       /*  End of file  */
+      }
+      r -> bufferPos = r -> buffer;
+      r -> bufferTop = r -> bufferPos + n;
+      continue;
+    }
+    /*  Fewer than 8 bytes left in the buffer; take one at a time  */
+    r -> bitBuffer |= (R_ULL_INT) *(r -> bufferPos) << (REFILL_BITS - r -> availableBits);
+    r -> bufferPos++;
+    r -> availableBits += 8;
   }
+
+  return;
 }
 
-static R_UINT readBits (R_UINT bits, BITINREC *r) {
-  R_UINT x = 0;
 
-  if (bits > 32) {
-    fprintf (stderr, "Unexpected error -- too many bits (%s, %u).\n", __FILE__, __LINE__);
-    exit (EXIT_FAILURE);
-  }
+/*  Number of leading 0 bits in x, which must not be 0  */
+static R_UINT countLeadingZeros (R_ULL_INT x) {
+#if defined (__GNUC__)
+  return ((R_UINT) __builtin_clzll (x));
+#else
+  R_UINT n = 0;
 
-  if (bits == 0) {
-    return (0);
+  while ((x & (1ull << (ULL_SIZE_BITS - 1))) == 0) {
+    x <<= 1;
+    n++;
   }
-  if (r -> availableBits == 0) {
-    x = 0;
+  return (n);
+#endif
+}
+
+
+/*  Make sure that at least 'bits' bits are available  */
+#define NEEDBITS(BITS,R) \
+  if ((R) -> availableBits < (BITS)) { \
+    fillBits (R); \
+    if ((R) -> availableBits < (BITS)) { \
+      raiseError ("ERROR:  Unexpected end of file in %s on line %d.\n", __FILE__, __LINE__); \
+    } \
   }
-  else {
-    x = (r -> bitBuffer) >> (32u - bits);
+
+
+/*  Discard the next 'bits' bits, which must be fewer than 64  */
+static void skipBits (R_UINT bits, BITINREC *r) {
+  if (bits == 0) {
+    return;
   }
-  if (bits <= r -> availableBits) {
-    r -> bitBuffer <<= bits;
-    r -> availableBits -= bits;
+  NEEDBITS (bits, r);
+  r -> bitBuffer <<= bits;
+  r -> availableBits -= bits;
+
+  return;
+}
+
+
+/*  Read the next 'bits' bits, at most 32  */
+static R_UINT readBits (R_UINT bits, BITINREC *r) {
+  R_UINT x;
+
+  if (bits > UINT_SIZE_BITS) {
+    raiseError ("Unexpected error -- too many bits (%s, %u).\n", __FILE__, __LINE__);
   }
-  else {
-    bits -= r -> availableBits;
-    r -> availableBits = readNext (bits, r)-bits;
-    x |= (r -> bitBuffer) >> (32u - bits);
-    r -> bitBuffer <<= bits;
+
+  if (bits == 0) {
+    return (0);
   }
+  NEEDBITS (bits, r);
+  x = (R_UINT) (r -> bitBuffer >> (ULL_SIZE_BITS - bits));
+  r -> bitBuffer <<= bits;
+  r -> availableBits -= bits;
 
   return (x);
 }
 
 
+/*
+**  Count the 0's before the next 1 and consume them and the 1.  The
+**  leading 1 is found with a single count-leading-zeros unless the
+**  run of 0's is longer than the bits held.
+*/
 static R_UINT unaryDecode (R_UINT lo, BITINREC *r) {
   R_UINT x;
 
-  while (r -> bitBuffer == 0) {
-    lo += r -> availableBits;
-    r -> availableBits = readNext (1, r);
+  if (r -> availableBits <= REFILL_BITS) {
+    fillBits (r);
   }
-  x = 0;
-  while ((r -> bitBuffer & MASK_HIGHEST) != MASK_HIGHEST) {
-    r -> bitBuffer <<= 1;
-    x++;
+  while ((r -> bitBuffer == 0) || ((x = countLeadingZeros (r -> bitBuffer)) >= r -> availableBits)) {
+    if (r -> availableBits == 0) {
+      raiseError ("ERROR:  Unexpected end of file in %s on line %d.\n", __FILE__, __LINE__);
+    }
+    lo += r -> availableBits;
+    r -> bitBuffer = 0;
+    r -> availableBits = 0;
+    fillBits (r);
   }
-  r -> bitBuffer <<= 1;
+  r -> bitBuffer = (r -> bitBuffer << x) << 1;
   r -> availableBits -= x + 1;
 
   return (x + lo);
 }
 
 
+/*
+**  Decode a unary code in the range lo .. hi - 1.  The largest value
+**  is written without its terminating 1 (see unaryEncodeUpperLimit).
+*/
 R_UINT boundedUnarydecode (R_UINT lo, R_UINT hi, BITINREC *r) {
   R_UINT x;
 
-  hi -= lo + 1;
-  while (r -> bitBuffer == 0) {
+  hi -= lo + 1;                       /*  Maximum number of 0's to read  */
+  if (r -> availableBits <= REFILL_BITS) {
+    fillBits (r);
+  }
+  while ((r -> bitBuffer == 0) || ((x = countLeadingZeros (r -> bitBuffer)) >= r -> availableBits)) {
     if (r -> availableBits >= hi) {
-      r -> availableBits -= hi;
-      r -> bitBuffer <<= hi;
+      skipBits (hi, r);
       return (lo + hi);
     }
+    if (r -> availableBits == 0) {
+      raiseError ("ERROR:  Unexpected end of file in %s on line %d.\n", __FILE__, __LINE__);
+    }
     lo += r -> availableBits;
     hi -= r -> availableBits;
-    r -> availableBits = readNext (1, r);
-  }
-  x = 0;
-  while (x < hi) {
-    if (r -> bitBuffer == UINT_MAX) {
-      r -> bitBuffer <<= 1;
-      --r -> availableBits;
-      break;
-    }
-    r -> bitBuffer <<= 1;
-    x++;
+    r -> bitBuffer = 0;
+    r -> availableBits = 0;
+    fillBits (r);
   }
-  r -> availableBits -= x;
+  if (x >= hi) {
+    skipBits (hi, r);
+    return (lo + hi);
+  }
+  r -> bitBuffer = (r -> bitBuffer << x) << 1;
+  r -> availableBits -= x + 1;
 
   return (x + lo);
 }
 
+
+/*
+**  Decode a value written by binaryEncode.  The code is either
+**  logint - 1 or logint bits long; when logint bits are held, they
+**  are looked at once and only the length of the code is consumed.
+*/
 R_ULL_INT binaryDecode(R_ULL_INT lo, R_ULL_INT hi, BITINREC *r) {
   R_ULL_INT x = 0ull;
   R_ULL_INT t = 0ull;
@@ -185,7 +322,23 @@ R_ULL_INT binaryDecode(R_ULL_INT lo, R_ULL_INT hi, BITINREC *r) {
   }
   logint = ceilLogULL (hi + 1ull);
   t = (1ull << (R_ULL_INT) logint) - hi;
-   
+
+  if (logint <= REFILL_BITS) {
+    if (r -> availableBits < logint) {
+      fillBits (r);
+    }
+    if (r -> availableBits >= logint) {
+      x = r -> bitBuffer >> (ULL_SIZE_BITS - logint);
+      if ((x >> 1ull) < t) {
+        skipBits (logint - 1, r);
+        return ((x >> 1ull) + lo);
+      }
+      skipBits (logint, r);
+      return (x - t + lo);
+    }
+  }
+
+  /*  Long codes, or the end of the file is near  */
   if (logint - 1 > UINT_SIZE_BITS) {
     x0 = readBits (logint - 1 - UINT_SIZE_BITS, r);
     x1 = readBits (UINT_SIZE_BITS, r);
@@ -28,16 +28,27 @@
 
 #define BITINREC_BUF_SIZE 32768 /* (1 << 15) */
 
+/*
+**  State of one input bit stream.  bitBuffer holds up to 64 of the
+**  next bits, starting from its most significant bit.  The bytes come
+**  either from a file, through buffer, or from a file mapped in
+**  memory (in is then NULL and buffer is not used).
+*/
 typedef struct bitinrec {
-  R_UINT bitBuffer;
+  R_ULL_INT bitBuffer;
   R_UINT availableBits;
   FILE *in;
-  R_UCHAR *bufferPos;
-  R_UCHAR *bufferTop;
+  const R_UCHAR *bufferPos;
+  const R_UCHAR *bufferTop;
   R_UCHAR *buffer;
+  const R_UCHAR *map;                        /*  Mapped input, if any  */
+  size_t map_size;
 } BITINREC;
 
 BITINREC *newBitin (FILE *in);
+BITINREC *newBitinMap (const R_UCHAR *map, size_t map_size);
+void deleteBitin (BITINREC *r);
+void seekBitin (BITINREC *r, R_ULL_INT offset);
 R_UINT ceilLog (R_UINT x);
 R_UINT ceilLogULL (R_ULL_INT x);
 R_UINT boundedUnarydecode (R_UINT lo, R_UINT hi, BITINREC *r);
@@ -27,84 +27,187 @@
 #include <stdlib.h>
 
 #include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
 #include "repair-defn.h"
 #include "utils.h"
 #include "bitout.h"
 
-static void unaryEncode (FILE *filedesc, R_UINT x, R_UINT lo);
-static void unaryEncodeUpperLimit (FILE *filedesc, R_UINT x, R_UINT lo, R_UINT hi);
+static void emitWord (BITOUTREC *w, R_UINT word);
+static void putBits (BITOUTREC *w, R_UINT x, R_UINT bits);
+static void flushBits (BITOUTREC *w);
+static void unaryEncode (BITOUTREC *w, R_UINT x, R_UINT lo);
+static void unaryEncodeUpperLimit (BITOUTREC *w, R_UINT x, R_UINT lo, R_UINT hi);
 
-void writeBits (FILE *filedesc, R_UINT x, R_UINT bits, R_BOOLEAN isflush) {
-  R_UINT n_written = 0;
-  static R_UINT bitBuffer = 0;
-  static R_UINT unusedBits = UINT_SIZE_BITS;
-  static R_UINT bufferPos = 0;
-  static R_UCHAR buffer[BUFFERTOP];
+/*
+**  Create a new output bit stream.  If out is NULL, the stream is
+**  kept in memory.
+*/
+BITOUTREC *newBitout (FILE *out) {
+  BITOUTREC *bitrec;
+  bitrec = wmalloc (sizeof (BITOUTREC));
 
-  if (bits > UINT_SIZE_BITS) {
-    fprintf (stderr, "Error:  bits larger than UINT_SIZE_BITS in %s, line %u.", __FILE__, __LINE__);
-    exit (EXIT_FAILURE);
+  bitrec -> out = out;
+  bitrec -> bitBuffer = 0;
+  bitrec -> bitCount = 0;
+  bitrec -> bufferPos = 0;
+  bitrec -> bufferTop = BUFFERTOP;
+  bitrec -> buffer = wmalloc (sizeof (R_UCHAR) * BUFFERTOP);
+  bitrec -> bitsWritten = 0;
+
+  return (bitrec);
+}
+
+
+void deleteBitout (BITOUTREC *w) {
+  wfree (w -> buffer);
+  wfree (w);
+
+  return;
+}
+
+
+/*
+**  Append all of the bits held in the in-memory stream src to the
+**  stream dest, as if they had been written to dest directly.  src
+**  is emptied so that it can be used again.
+*/
+void appendBitout (BITOUTREC *dest, BITOUTREC *src) {
+  size_t i;
+  R_UINT x;
+
+  /*  src -> buffer only ever holds whole 32-bit words  */
+  for (i = 0; i < src -> bufferPos; i += 4) {
+    x = (R_UINT) src -> buffer[i] << 24 |
+      (R_UINT) src -> buffer[i + 1] << 16 |
+      (R_UINT) src -> buffer[i + 2] << 8 |
+      (R_UINT) src -> buffer[i + 3];
+    putBits (dest, x, UINT_SIZE_BITS);
   }
+  putBits (dest, (R_UINT) src -> bitBuffer, src -> bitCount);
 
-  if (isflush == R_FALSE) {
-    if (bits <= unusedBits) {          /*  If buffer still has space  */
-      if (bits != UINT_SIZE_BITS) {
-        bitBuffer = (bitBuffer << bits) | (x & ((1 << bits) - 1));
-      }
-      else {
-        bitBuffer = x;
-      }
-      unusedBits -= bits;
+  src -> bitBuffer = 0;
+  src -> bitCount = 0;
+  src -> bufferPos = 0;
+  src -> bitsWritten = 0;
+
+  return;
+}
+
+
+/*
+**  Return the whole bytes held by an in-memory stream and set length
+**  to their number.  The buffer is emptied, so the bytes must be used
+**  before anything else is written to the stream.  Pending bits are
+**  kept.
+*/
+const R_UCHAR *takeBitoutBytes (BITOUTREC *w, size_t *length) {
+  *length = w -> bufferPos;
+  w -> bufferPos = 0;
+
+  return (w -> buffer);
+}
+
+
+/*
+**  Store one 32-bit word in the buffer, most significant byte first.
+**  When the buffer is full, it is written out or, for an in-memory
+**  stream, enlarged.
+*/
+static void emitWord (BITOUTREC *w, R_UINT word) {
+  R_UCHAR *b = w -> buffer + w -> bufferPos;
+
+  b[0] = (R_UCHAR) (word >> 24);
+  b[1] = (R_UCHAR) (word >> 16);
+  b[2] = (R_UCHAR) (word >> 8);
+  b[3] = (R_UCHAR) word;
+  w -> bufferPos += 4;
+
+  if (w -> bufferPos >= w -> bufferTop) {
+    if (w -> out != NULL) {                          /*  Write bits out  */
+      (void) fwrite (w -> buffer, sizeof (w -> buffer[0]), w -> bufferPos, w -> out);
+      w -> bufferPos = 0;
     }
-    else {                              /*  If buffer will overflow  */
-      bitBuffer = (bitBuffer << unusedBits) | ((x >> (bits - unusedBits)) & ((1 << (unusedBits)) - 1));
-      buffer[bufferPos++] = (R_UCHAR) (bitBuffer >> (UINT_SIZE_BITS - 8));
-      buffer[bufferPos++] = (R_UCHAR) (bitBuffer >> (UINT_SIZE_BITS - 16));
-      buffer[bufferPos++] = (R_UCHAR) (bitBuffer >> (UINT_SIZE_BITS - 24));
-      buffer[bufferPos++] = (R_UCHAR) (bitBuffer);
-
-      if (bufferPos >= BUFFERTOP) {            /*  Write bits out  */
-        n_written = (R_UINT) fwrite (buffer, sizeof (buffer[0]), (size_t) bufferPos, filedesc);
-        bufferPos = 0;
-      }
-      if (bits - unusedBits != UINT_SIZE_BITS) {
-        bitBuffer = x & ((1 << (bits - unusedBits)) - 1);
-      }
-      else {
-        bitBuffer = x;
-      }
-      unusedBits += UINT_SIZE_BITS - bits;
+    else {                                 /*  Keep in memory; enlarge  */
+      w -> bufferTop = w -> bufferTop << 1;
+      w -> buffer = wrealloc (w -> buffer, sizeof (R_UCHAR) * w -> bufferTop);
     }
   }
-  else {                                            /*  Flush buffers  */
-    bitBuffer <<= unusedBits;      /*  Pad remaining space with 0's  */
-    while (unusedBits < UINT_SIZE_BITS) {
-      buffer[bufferPos++] = (R_UCHAR) (bitBuffer >> (UINT_SIZE_BITS - 8));
-      bitBuffer <<= 8;
-      unusedBits += 8;
-    }
 
-    if (bufferPos > 0) {
-      n_written = (R_UINT) fwrite (buffer, sizeof (buffer[0]), (size_t) bufferPos, filedesc);
-      (void) fflush (filedesc);
+  return;
+}
+
+
+/*
+**  Append the low 'bits' bits of x (at most 32) to the stream.  Fewer
+**  than 32 bits are ever pending, so the 64-bit accumulator cannot
+**  overflow and at most one word is completed per call.
+*/
+static void putBits (BITOUTREC *w, R_UINT x, R_UINT bits) {
+  w -> bitsWritten += bits;
+  w -> bitBuffer = (w -> bitBuffer << bits) | ((R_ULL_INT) x & ((1ull << bits) - 1ull));
+  w -> bitCount += bits;
+
+  if (w -> bitCount >= UINT_SIZE_BITS) {
+    w -> bitCount -= UINT_SIZE_BITS;
+    emitWord (w, (R_UINT) (w -> bitBuffer >> w -> bitCount));
+  }
+
+  return;
+}
+
+
+/*  Pad the pending bits with 0's to a whole byte and write everything out  */
+static void flushBits (BITOUTREC *w) {
+  R_UINT word;
+  R_UINT i;
+
+  if (w -> bitCount > 0) {
+    word = (R_UINT) (w -> bitBuffer << (UINT_SIZE_BITS - w -> bitCount));
+    for (i = 0; i < w -> bitCount; i += 8) {
+      w -> buffer[w -> bufferPos++] = (R_UCHAR) (word >> (24 - i));
     }
-    bitBuffer = 0;
-    unusedBits = UINT_SIZE_BITS;
-    bufferPos = 0;
   }
+
+  if ((w -> bufferPos > 0) && (w -> out != NULL)) {
+    (void) fwrite (w -> buffer, sizeof (w -> buffer[0]), w -> bufferPos, w -> out);
+    (void) fflush (w -> out);
+    w -> bufferPos = 0;
+  }
+  w -> bitBuffer = 0;
+  w -> bitCount = 0;
+
+  return;
+}
+
+
+void writeBits (BITOUTREC *w, R_UINT x, R_UINT bits, R_BOOLEAN isflush) {
+  if (bits > UINT_SIZE_BITS) {
+    raiseError ("Error:  bits larger than UINT_SIZE_BITS in %s, line %u.", __FILE__, __LINE__);
+  }
+
+  if (isflush == R_FALSE) {
+    putBits (w, x, bits);
+  }
+  else {
+    flushBits (w);
+  }
+
+  return;
 }
 
 
 /*
 **  Encodes x which is at least 'lo' in unary.
 */
-static void unaryEncode (FILE *filedesc, R_UINT x, R_UINT lo) {
+static void unaryEncode (BITOUTREC *w, R_UINT x, R_UINT lo) {
   x -= lo;
   while (x >= UINT_SIZE_BITS) {
-    writeBits (filedesc, 0, UINT_SIZE_BITS, R_FALSE);
+    putBits (w, 0, UINT_SIZE_BITS);
     x -= UINT_SIZE_BITS;
   }
-  writeBits (filedesc, 1, x + 1, R_FALSE);
+  putBits (w, 1, x + 1);
 }
 
 
@@ -112,18 +215,18 @@ static void unaryEncode (FILE *filedesc, R_UINT x, R_UINT lo) {
 **  Encodes x which is at least 'lo' in unary with an
 **  upper bound.
 */
-static void unaryEncodeUpperLimit (FILE *filedesc, R_UINT x, R_UINT lo, R_UINT hi) {
+static void unaryEncodeUpperLimit (BITOUTREC *w, R_UINT x, R_UINT lo, R_UINT hi) {
   R_UINT b = x - lo;
 
   while (b >= UINT_SIZE_BITS) {
-    writeBits (filedesc, 0, UINT_SIZE_BITS, R_FALSE);
+    putBits (w, 0, UINT_SIZE_BITS);
     b -= UINT_SIZE_BITS;
   }
   if (x < hi - 1) {
-    writeBits (filedesc, 1, b + 1, R_FALSE);
+    putBits (w, 1, b + 1);
   }
   else {
-    writeBits (filedesc, 0, b, R_FALSE);
+    putBits (w, 0, b);
   }
 }
 
@@ -135,63 +238,57 @@ static void unaryEncodeUpperLimit (FILE *filedesc, R_UINT x, R_UINT lo, R_UINT h
 **  are used for the lower part of the range rather than the higher
 **  one.
 */
-void binaryEncode (FILE *filedesc, R_ULL_INT x, R_ULL_INT lo, R_ULL_INT hi) {
+void binaryEncode (BITOUTREC *w, R_ULL_INT x, R_ULL_INT lo, R_ULL_INT hi) {
   R_UINT logint;
   R_ULL_INT t;
-  R_UINT x0 = 0;
-  R_UINT x1 = 0;
+  R_UINT bits;
 
   hi -= lo;
   x -= lo;
   logint = ceilLogULL (hi + 1ull);
   t = (1ull << (R_ULL_INT) logint) - hi;
 
+  /*  Short codes for the lower part of the range  */
   if (x < t) {
-    if (logint - 1 > UINT_SIZE_BITS) {
-      x0 = (R_UINT) (x >> (R_ULL_INT) UINT_SIZE_BITS);
-      x1 = (R_UINT) (x & MASK_LOWER);
-      writeBits (filedesc, x0, logint - 1 - UINT_SIZE_BITS, R_FALSE);
-      writeBits (filedesc, x1, UINT_SIZE_BITS, R_FALSE);
-    }
-    else {
-      x1 = (R_UINT) (x & MASK_LOWER);
-      writeBits (filedesc, x1, logint - 1, R_FALSE);
-    }
+    bits = logint - 1;
   }
   else {
-    if (logint > UINT_SIZE_BITS) {
-      x0 = (R_UINT) ((x + t) >> (R_ULL_INT) UINT_SIZE_BITS);
-      x1 = (R_UINT) ((x + t) & MASK_LOWER);
-      writeBits (filedesc, x0, logint - UINT_SIZE_BITS, R_FALSE);
-      writeBits (filedesc, x1, UINT_SIZE_BITS, R_FALSE);
-    }
-    else {
-      x1 = (R_UINT) ((x + t) & MASK_LOWER);
-      writeBits (filedesc, x1, logint, R_FALSE);
-    }
+    bits = logint;
+    x += t;
+  }
+
+  if (bits > UINT_SIZE_BITS) {
+    putBits (w, (R_UINT) (x >> (R_ULL_INT) UINT_SIZE_BITS), bits - UINT_SIZE_BITS);
+    bits = UINT_SIZE_BITS;
   }
+  putBits (w, (R_UINT) (x & MASK_LOWER), bits);
 }
 
 
 /*
 **  Gamma encode resulting in an exponent in unary and
-**  mantissa in binary.
+**  mantissa in binary.  The unary part followed by the mantissa is
+**  just x in 2 * logx + 1 bits, so it is written at once when short.
 */
-void gammaEncode (FILE *filedesc, R_UINT x, R_UINT lo) {
+void gammaEncode (BITOUTREC *w, R_UINT x, R_UINT lo) {
   R_UINT logx;
 
   x -= lo - 1;
   logx = floorLog (x);
 
-  unaryEncode (filedesc, logx, 0);
-  writeBits (filedesc, x - (1 << logx), logx, R_FALSE);
+  if (logx < (UINT_SIZE_BITS >> 1)) {
+    putBits (w, x, (logx << 1) + 1);
+    return;
+  }
+  unaryEncode (w, logx, 0);
+  putBits (w, x - (1 << logx), logx);
 }
 
 
 /*
 **  Gamma encode with upper bound.
 */
-void gammaEncodeUpperLimit (FILE *filedesc, R_UINT x, R_UINT lo, R_UINT hi) {
+void gammaEncodeUpperLimit (BITOUTREC *w, R_UINT x, R_UINT lo, R_UINT hi) {
   R_UINT logx;
   R_UINT loghi;
 
@@ -199,12 +296,16 @@ void gammaEncodeUpperLimit (FILE *filedesc, R_UINT x, R_UINT lo, R_UINT hi) {
   hi -= lo;
   logx = floorLog (x);
   loghi = floorLog (hi);
-  unaryEncodeUpperLimit (filedesc, logx, 0, loghi + 1);
+  if ((logx < loghi) && (logx < (UINT_SIZE_BITS >> 1))) {
+    putBits (w, x, (logx << 1) + 1);              /*  As in gammaEncode  */
+    return;
+  }
+  unaryEncodeUpperLimit (w, logx, 0, loghi + 1);
   if (logx < loghi) {
-    writeBits (filedesc, x - (1 << logx), logx, R_FALSE);
+    putBits (w, x - (1 << logx), logx);
   }
   else {
-    binaryEncode (filedesc, x, (1ull << logx), hi + 1);
+    binaryEncode (w, x, (1ull << logx), hi + 1);
   }
 }
 
@@ -212,12 +313,11 @@ void gammaEncodeUpperLimit (FILE *filedesc, R_UINT x, R_UINT lo, R_UINT hi) {
 /*
 **  Delta encode with exponent in gamma and mantissa in binary.
 */
-void deltaEncode (FILE *filedesc, R_UINT x, R_UINT lo) {
+void deltaEncode (BITOUTREC *w, R_UINT x, R_UINT lo) {
   R_UINT logx;
 
   x -= lo - 1;
   logx = floorLog (x);
-  gammaEncode (filedesc, logx, 0);
-  writeBits (filedesc, x - (1 << logx), logx, R_FALSE);
+  gammaEncode (w, logx, 0);
+  putBits (w, x - (1 << logx), logx);
 }
-
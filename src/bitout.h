@@ -29,11 +29,32 @@
 #define BUFFERTOP 131072
 #define UINT_SIZE_BITS 32
 
-void writeBits (FILE *filedesc, R_UINT x, R_UINT bits, R_BOOLEAN isflush);
-void binaryEncode (FILE *filedesc, R_ULL_INT x, R_ULL_INT lo, R_ULL_INT hi);
-void gammaEncode (FILE *filedesc, R_UINT x, R_UINT lo);
-void gammaEncodeUpperLimit (FILE *filedesc, R_UINT x, R_UINT lo, R_UINT hi);
-void deltaEncode (FILE *filedesc, R_UINT x, R_UINT lo);
+/*
+**  State of one output bit stream.  If out is NULL, the bits are
+**  kept in memory (buffer grows as needed) so that they can be
+**  appended to another stream later with appendBitout.  Streams
+**  share no state, so several can be written at once.
+*/
+typedef struct bitoutrec {
+  R_ULL_INT bitBuffer;           /*  Pending bits, in the low bitCount bits  */
+  R_UINT bitCount;                 /*  Number of pending bits; less than 32  */
+  FILE *out;
+  size_t bufferPos;
+  size_t bufferTop;
+  R_UCHAR *buffer;
+  R_ULL_INT bitsWritten;         /*  Bits written so far, without padding  */
+} BITOUTREC;
+
+BITOUTREC *newBitout (FILE *out);
+void deleteBitout (BITOUTREC *w);
+void appendBitout (BITOUTREC *dest, BITOUTREC *src);
+const R_UCHAR *takeBitoutBytes (BITOUTREC *w, size_t *length);
+
+void writeBits (BITOUTREC *w, R_UINT x, R_UINT bits, R_BOOLEAN isflush);
+void binaryEncode (BITOUTREC *w, R_ULL_INT x, R_ULL_INT lo, R_ULL_INT hi);
+void gammaEncode (BITOUTREC *w, R_UINT x, R_UINT lo);
+void gammaEncodeUpperLimit (BITOUTREC *w, R_UINT x, R_UINT lo, R_UINT hi);
+void deltaEncode (BITOUTREC *w, R_UINT x, R_UINT lo);
 
 #endif
 
@@ -0,0 +1,225 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>                                         /*  off_t  */
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "blockindex.h"
+
+static void writeLE (FILE *fp, R_ULL_INT x, R_UINT bytes);
+static R_ULL_INT readLE (FILE *fp, R_UINT bytes, R_BOOLEAN *found);
+static R_ULL_INT readBlockSample (FILE *fp, BLOCKINDEXENTRY *entry, R_ULL_INT k, R_ULL_INT *bits);
+
+
+/*
+**  Write x to fp as an integer of the given number of bytes, least
+**  significant byte first.
+*/
+static void writeLE (FILE *fp, R_ULL_INT x, R_UINT bytes) {
+  R_UCHAR buffer[8];
+  R_UINT i;
+
+  for (i = 0; i < bytes; i++) {
+    buffer[i] = (R_UCHAR) (x & MASK_EIGHT);
+    x >>= 8;
+  }
+  if (fwrite (buffer, sizeof (R_UCHAR), (size_t) bytes, fp) != (size_t) bytes) {
+    raiseError ("Error writing to the block index in %s, line %u.\n", __FILE__, __LINE__);
+  }
+
+  return;
+}
+
+
+/*
+**  Read an integer of the given number of bytes.  If found is NULL,
+**  the program exits at the end of the file; otherwise, found is set
+**  to R_FALSE if the end of the file was reached before any byte.
+*/
+static R_ULL_INT readLE (FILE *fp, R_UINT bytes, R_BOOLEAN *found) {
+  R_UCHAR buffer[8];
+  R_ULL_INT x = 0;
+  size_t n;
+
+  n = fread (buffer, sizeof (R_UCHAR), (size_t) bytes, fp);
+  if (ferror (fp) != R_FALSE) {
+    raiseError ("%s: %s\n", __FILE__, strerror (errno));
+  }
+  if ((n == 0) && (found != NULL)) {
+    *found = R_FALSE;
+    return (0);
+  }
+  if (n != (size_t) bytes) {
+    raiseError ("Error:  Block index is truncated.\n");
+  }
+  if (found != NULL) {
+    *found = R_TRUE;
+  }
+
+  while (bytes > 0) {
+    bytes--;
+    x = (x << 8) | (R_ULL_INT) buffer[bytes];
+  }
+
+  return (x);
+}
+
+
+void writeBlockIndexHeader (FILE *fp, R_UINT sample_rate) {
+  writeLE (fp, (R_ULL_INT) BLOCKINDEX_MAGIC, 4);
+  writeLE (fp, (R_ULL_INT) BLOCKINDEX_VERSION, 4);
+  writeLE (fp, (R_ULL_INT) sample_rate, 4);
+
+  return;
+}
+
+
+void writeBlockIndexEntry (FILE *fp, BLOCKINDEXENTRY *entry, R_ULL_INT *samples, R_ULL_INT *sample_bits) {
+  R_ULL_INT i;
+
+  writeLE (fp, entry -> prel_offset, 8);
+  writeLE (fp, entry -> seq_offset, 8);
+  writeLE (fp, entry -> length, 8);
+  writeLE (fp, entry -> num_samples, 8);
+  for (i = 0; i < entry -> num_samples; i++) {
+    writeLE (fp, samples[i], 8);
+    writeLE (fp, sample_bits[i], 8);
+  }
+
+  return;
+}
+
+
+/*
+**  Read the entries of a whole index file, skipping over the samples.
+**  The index ends at offset end of fp or, if end is 0, at the end of
+**  the file.  Returns an array of entries, one per block, and sets
+**  num_blocks to its size.  The program exits if the file is not a
+**  valid index.
+*/
+BLOCKINDEXENTRY *readBlockIndex (FILE *fp, R_ULL_INT end, R_UINT *num_blocks, R_UINT *sample_rate) {
+  BLOCKINDEXENTRY *entries = NULL;
+  R_UINT entries_size = 64;
+  R_UINT version = 0;
+  R_BOOLEAN found = R_FALSE;
+  R_ULL_INT x = 0;
+
+  if (readLE (fp, 4, NULL) != BLOCKINDEX_MAGIC) {
+    raiseError ("Error:  Block index is not valid.\n");
+  }
+  version = (R_UINT) readLE (fp, 4, NULL);
+  if (version != BLOCKINDEX_VERSION) {
+    raiseError ("Error:  Block index version %u is not supported.\n", version);
+  }
+  *sample_rate = (R_UINT) readLE (fp, 4, NULL);
+  if (*sample_rate == 0) {
+    raiseError ("Error:  Block index is not valid.\n");
+  }
+
+  *num_blocks = 0;
+  entries = wmalloc (sizeof (BLOCKINDEXENTRY) * entries_size);
+  while (R_TRUE) {
+    if ((end != 0) && ((R_ULL_INT) ftello (fp) >= end)) {
+      break;
+    }
+    x = readLE (fp, 8, &found);
+    if (found == R_FALSE) {
+      break;
+    }
+
+    if (*num_blocks == entries_size) {
+      entries_size = entries_size << 1;
+      entries = wrealloc (entries, sizeof (BLOCKINDEXENTRY) * entries_size);
+    }
+    entries[*num_blocks].prel_offset = x;
+    entries[*num_blocks].seq_offset = readLE (fp, 8, NULL);
+    entries[*num_blocks].length = readLE (fp, 8, NULL);
+    entries[*num_blocks].num_samples = readLE (fp, 8, NULL);
+    entries[*num_blocks].samples_pos = (R_ULL_INT) ftello (fp);
+    if (fseeko (fp, (off_t) (entries[*num_blocks].num_samples * BLOCKINDEX_SAMPLE_SIZE), SEEK_CUR) != 0) {
+      raiseError ("%s: %s\n", __FILE__, strerror (errno));
+    }
+    (*num_blocks)++;
+  }
+
+  return (entries);
+}
+
+
+/*
+**  Read sample k of one block from an index file.  Returns its
+**  position; if bits is not NULL, it is set to the sample's offset in
+**  the coded data.
+*/
+static R_ULL_INT readBlockSample (FILE *fp, BLOCKINDEXENTRY *entry, R_ULL_INT k, R_ULL_INT *bits) {
+  R_ULL_INT position = 0;
+
+  if (fseeko (fp, (off_t) (entry -> samples_pos + k * BLOCKINDEX_SAMPLE_SIZE), SEEK_SET) != 0) {
+    raiseError ("%s: %s\n", __FILE__, strerror (errno));
+  }
+  position = readLE (fp, 8, NULL);
+  if (bits != NULL) {
+    *bits = readLE (fp, 8, NULL);
+  }
+
+  return (position);
+}
+
+
+/*
+**  Find the last position sample of one block at or before offset,
+**  with a binary search of the samples where they are in the index
+**  file; only O(log num_samples) of them are read.  Sets sample to
+**  its number and bits to its offset in the coded data, and returns
+**  its position.
+*/
+R_ULL_INT findBlockSample (FILE *fp, BLOCKINDEXENTRY *entry, R_ULL_INT offset, R_ULL_INT *sample, R_ULL_INT *bits) {
+  R_ULL_INT lo = 0;
+  R_ULL_INT hi = entry -> num_samples;
+  R_ULL_INT mid = 0;
+
+  if (entry -> num_samples == 0) {
+    raiseError ("Error:  Block index has no position samples.\n");
+  }
+
+  while (hi - lo > 1) {
+    mid = lo + ((hi - lo) >> 1);
+    if (readBlockSample (fp, entry, mid, NULL) <= offset) {
+      lo = mid;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  *sample = lo;
+
+  return (readBlockSample (fp, entry, lo, bits));
+}
@@ -0,0 +1,70 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef BLOCKINDEX_H
+#define BLOCKINDEX_H
+
+/******************************
+Definitions
+******************************/
+#define BLOCKINDEX_MAGIC (0x58495052u)  /*  "RPIX" in little-endian order  */
+#define BLOCKINDEX_VERSION (3u)
+#define BLOCKINDEX_SAMPLE_RATE (64u)
+               /*  Number of sequence symbols between two position samples  */
+#define BLOCKINDEX_SAMPLE_SIZE (16u)       /*  Bytes of one stored sample  */
+
+/******************************
+Structure definitions
+******************************/
+/*
+**  Position of one block in the .prel and .seq files.
+**
+**  The index file (.idx) starts with three 4-byte integers:  the magic
+**  number, the version and the sample rate.  Then, for each block, four
+**  8-byte integers (prel_offset, seq_offset, length and num_samples)
+**  are followed by num_samples samples of two 8-byte integers each.
+**  Sample k is the position in the original block at which the
+**  (k * sample_rate)-th symbol of the block's sequence starts, then
+**  the offset in bits of that symbol in the coded data of a coded
+**  block (0 if the block is not coded).  All integers are stored in
+**  little-endian order.
+*/
+typedef struct blockindexentry {
+  R_ULL_INT prel_offset;       /*  Offset of the block in the .prel file  */
+                                        /*  in bits; not byte-aligned  */
+  R_ULL_INT seq_offset;  /*  Offset of the block in the .seq file, in bytes  */
+  R_ULL_INT length;           /*  Number of symbols in the original block  */
+  R_ULL_INT num_samples;                          /*  Number of samples  */
+  R_ULL_INT samples_pos;
+               /*  Offset of the samples in the index file; not stored  */
+} BLOCKINDEXENTRY;
+
+void writeBlockIndexHeader (FILE *fp, R_UINT sample_rate);
+void writeBlockIndexEntry (FILE *fp, BLOCKINDEXENTRY *entry, R_ULL_INT *samples, R_ULL_INT *sample_bits);
+BLOCKINDEXENTRY *readBlockIndex (FILE *fp, R_ULL_INT end, R_UINT *num_blocks, R_UINT *sample_rate);
+R_ULL_INT findBlockSample (FILE *fp, BLOCKINDEXENTRY *entry, R_ULL_INT offset, R_ULL_INT *sample, R_ULL_INT *bits);
+
+#endif
+
@@ -63,16 +63,17 @@ Bit masking
 #define MASK_LOWER (0xFFFFFFFFu)  /*  4294967295  */
 #define MASK_HIGHEST (1u << ((sizeof (unsigned int) * 8) - 1))  /*  2147483648  */
 
+/*  Open a file, raising an error if it can not be; files which use
+**  FOPEN must include error.h  */
 #define FOPEN(FILENAME,FP,MODE) \
   FP = fopen ((R_CHAR*) FILENAME, MODE); \
   if (FP == NULL) { \
     if (strcmp (MODE, "w") == 0) { \
-      fprintf (stderr, "Error creating %s.\n", FILENAME); \
+      raiseError ("Error creating %s.\n", FILENAME); \
     } \
     else { \
-      fprintf (stderr, "Error opening %s.\n", FILENAME); \
+      raiseError ("Error opening %s.\n", FILENAME); \
     } \
-    exit (EXIT_FAILURE); \
   }
 
 #define FCLOSE(FP) \
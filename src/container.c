@@ -0,0 +1,435 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "crc32c.h"
+#include "stream.h"
+#include "blockindex.h"
+#include "container.h"
+
+#define CONTAINER_INDEX_SIZE 4096
+#define CONTAINER_PADDED(L) (((L) + 3) & ~((R_ULL_INT) 3))
+                     /*  Length of a frame's data with its zero padding  */
+
+static void packContainerLE (R_UCHAR *buffer, R_ULL_INT x, R_UINT bytes);
+static R_ULL_INT unpackContainerLE (const R_UCHAR *buffer, R_UINT bytes);
+static R_UINT frameCRC (const R_UCHAR *header, const R_UCHAR *data, size_t length);
+static void writeContainerFrame (CONTAINER_OUT *c, R_UINT type, const R_UCHAR *data, size_t length);
+static void appendContainerIndex (CONTAINER_OUT *c, R_ULL_INT x, R_UINT bytes);
+static void readContainerBytes (CONTAINER_IN *c, R_UCHAR *dest, size_t length);
+static const R_UCHAR *readContainerFrame (CONTAINER_IN *c, R_UINT slot, R_UINT *type, R_ULL_INT *length);
+
+
+/*
+**  Store x in buffer as an integer of the given number of bytes,
+**  least significant byte first.
+*/
+static void packContainerLE (R_UCHAR *buffer, R_ULL_INT x, R_UINT bytes) {
+  R_UINT i;
+
+  for (i = 0; i < bytes; i++) {
+    buffer[i] = (R_UCHAR) (x & MASK_EIGHT);
+    x >>= 8;
+  }
+
+  return;
+}
+
+
+static R_ULL_INT unpackContainerLE (const R_UCHAR *buffer, R_UINT bytes) {
+  R_ULL_INT x = 0;
+
+  while (bytes > 0) {
+    bytes--;
+    x = (x << 8) | (R_ULL_INT) buffer[bytes];
+  }
+
+  return (x);
+}
+
+
+/*
+**  Checksum of a frame:  the type and length in its header, then its
+**  data (without the padding)
+*/
+static R_UINT frameCRC (const R_UCHAR *header, const R_UCHAR *data, size_t length) {
+  R_UINT crc = 0;
+
+  crc = crc32c (crc, header, 12);
+  crc = crc32c (crc, data, length);
+
+  return (crc);
+}
+
+
+static void writeContainerFrame (CONTAINER_OUT *c, R_UINT type, const R_UCHAR *data, size_t length) {
+  R_UCHAR header[CONTAINER_FRAME_HEADER_SIZE];
+  R_UCHAR padding[4] = { 0, 0, 0, 0 };
+  size_t padded = (size_t) CONTAINER_PADDED ((R_ULL_INT) length);
+
+  packContainerLE (header, (R_ULL_INT) type, 4);
+  packContainerLE (header + 4, (R_ULL_INT) length, 8);
+  packContainerLE (header + 12, (R_ULL_INT) frameCRC (header, data, length), 4);
+  writeStreamBytes (c -> out, header, CONTAINER_FRAME_HEADER_SIZE);
+  if (length > 0) {
+    writeStreamBytes (c -> out, data, length);
+  }
+  if (padded > length) {
+    writeStreamBytes (c -> out, padding, padded - length);
+  }
+  c -> pos += (R_ULL_INT) (CONTAINER_FRAME_HEADER_SIZE + padded);
+
+  return;
+}
+
+
+/*
+**  Add an integer to the data of the index frame
+*/
+static void appendContainerIndex (CONTAINER_OUT *c, R_ULL_INT x, R_UINT bytes) {
+  if (c -> index_size - c -> index_length < (size_t) bytes) {
+    c -> index_size = c -> index_size << 1;
+    c -> index = wrealloc (c -> index, sizeof (R_UCHAR) * c -> index_size);
+  }
+  packContainerLE (c -> index + c -> index_length, x, bytes);
+  c -> index_length += (size_t) bytes;
+
+  return;
+}
+
+
+/*
+**  Start a container on out, up to and including its header frame.
+**  The index is kept in memory until finishContainerOut.
+*/
+CONTAINER_OUT *newContainerOut (STREAM_OUT *out, R_UINT base_datatype, R_UINT sample_rate) {
+  CONTAINER_OUT *c = wmalloc (sizeof (CONTAINER_OUT));
+  R_UCHAR buffer[8];
+
+  c -> out = out;
+  c -> pos = 0;
+  c -> index_size = CONTAINER_INDEX_SIZE;
+  c -> index_length = 0;
+  c -> index = wmalloc (sizeof (R_UCHAR) * c -> index_size);
+
+  packContainerLE (buffer, (R_ULL_INT) CONTAINER_MAGIC, 4);
+  writeStreamBytes (out, buffer, 4);
+  c -> pos = 4;
+
+  packContainerLE (buffer, (R_ULL_INT) CONTAINER_VERSION, 4);
+  packContainerLE (buffer + 4, (R_ULL_INT) base_datatype, 4);
+  writeContainerFrame (c, CONTAINER_FRAME_HEADER, buffer, 8);
+
+  appendContainerIndex (c, (R_ULL_INT) BLOCKINDEX_MAGIC, 4);
+  appendContainerIndex (c, (R_ULL_INT) BLOCKINDEX_VERSION, 4);
+  appendContainerIndex (c, (R_ULL_INT) sample_rate, 4);
+
+  return (c);
+}
+
+
+/*
+**  Write the frames of one block and add it to the index.  The
+**  hierarchy must start and end on a byte.
+*/
+void writeContainerBlock (CONTAINER_OUT *c, const R_UCHAR *prel, size_t prel_length, const R_UCHAR *seq, size_t seq_length, R_ULL_INT length, R_ULL_INT num_samples, const R_ULL_INT *samples, const R_ULL_INT *sample_bits) {
+  R_ULL_INT i;
+
+  appendContainerIndex (c, (c -> pos + CONTAINER_FRAME_HEADER_SIZE) * 8, 8);
+  writeContainerFrame (c, CONTAINER_FRAME_PREL, prel, prel_length);
+  appendContainerIndex (c, c -> pos + CONTAINER_FRAME_HEADER_SIZE, 8);
+  writeContainerFrame (c, CONTAINER_FRAME_SEQ, seq, seq_length);
+
+  appendContainerIndex (c, length, 8);
+  appendContainerIndex (c, num_samples, 8);
+  for (i = 0; i < num_samples; i++) {
+    appendContainerIndex (c, samples[i], 8);
+    appendContainerIndex (c, sample_bits[i], 8);
+  }
+
+  return;
+}
+
+
+/*
+**  End the container with its index and end frames
+*/
+void finishContainerOut (CONTAINER_OUT *c) {
+  R_UCHAR buffer[8];
+
+  packContainerLE (buffer, c -> pos, 8);
+  writeContainerFrame (c, CONTAINER_FRAME_INDEX, c -> index, c -> index_length);
+  writeContainerFrame (c, CONTAINER_FRAME_END, buffer, 8);
+  if ((c -> out) -> fp != NULL) {
+    (void) fflush ((c -> out) -> fp);
+  }
+
+  return;
+}
+
+
+void deleteContainerOut (CONTAINER_OUT *c) {
+  wfree (c -> index);
+  wfree (c);
+
+  return;
+}
+
+
+static void readContainerBytes (CONTAINER_IN *c, R_UCHAR *dest, size_t length) {
+  if (fread (dest, sizeof (R_UCHAR), length, c -> fp) != length) {
+    raiseError ("Error:  Container is truncated.\n");
+  }
+
+  return;
+}
+
+
+/*
+**  Read the next frame, check its checksum and return its data.  The
+**  data stays valid until the next frame read into the same slot (0
+**  or 1) if it is copied.
+*/
+static const R_UCHAR *readContainerFrame (CONTAINER_IN *c, R_UINT slot, R_UINT *type, R_ULL_INT *length) {
+  R_UCHAR header_buffer[CONTAINER_FRAME_HEADER_SIZE];
+  const R_UCHAR *header = header_buffer;
+  const R_UCHAR *data = NULL;
+  R_ULL_INT padded = 0;
+  R_ULL_INT frame_pos = c -> pos;
+
+  if (c -> fp != NULL) {
+    readContainerBytes (c, header_buffer, CONTAINER_FRAME_HEADER_SIZE);
+  }
+  else {
+    if ((R_ULL_INT) c -> map_size - c -> pos < CONTAINER_FRAME_HEADER_SIZE) {
+      raiseError ("Error:  Container is truncated.\n");
+    }
+    header = c -> map + c -> pos;
+  }
+  *type = (R_UINT) unpackContainerLE (header, 4);
+  *length = unpackContainerLE (header + 4, 8);
+  c -> pos += CONTAINER_FRAME_HEADER_SIZE;
+
+  /*  The type and length are checked before the data is read, so that
+  **  a corrupt length is not taken for a truncated container.  The
+  **  header and end frames have 8 bytes of data.  */
+  if ((*type < CONTAINER_FRAME_HEADER) || (*type > CONTAINER_FRAME_END) ||
+      (((*type == CONTAINER_FRAME_HEADER) || (*type == CONTAINER_FRAME_END)) && (*length != 8))) {
+    raiseError ("Error:  Frame at byte %llu is not valid; the container is corrupt.\n", frame_pos);
+  }
+
+  if (c -> fp != NULL) {
+    if (*length > (R_ULL_INT) ((size_t) -1 >> 1)) {
+      raiseError ("Error:  Container is corrupt.\n");
+    }
+    padded = CONTAINER_PADDED (*length);
+    if (c -> buffer_size[slot] < (size_t) padded) {
+      c -> buffer[slot] = wrealloc (c -> buffer[slot], (size_t) padded);
+      c -> buffer_size[slot] = (size_t) padded;
+    }
+    readContainerBytes (c, c -> buffer[slot], (size_t) padded);
+    data = c -> buffer[slot];
+  }
+  else {
+    if (*length > (R_ULL_INT) c -> map_size - c -> pos) {
+      raiseError ("Error:  Container is truncated.\n");
+    }
+    padded = CONTAINER_PADDED (*length);
+    if (padded > (R_ULL_INT) c -> map_size - c -> pos) {
+      raiseError ("Error:  Container is truncated.\n");
+    }
+    data = c -> map + c -> pos;
+    if ((c -> copy == R_TRUE) && (*length > 0)) {
+      if (c -> buffer_size[slot] < (size_t) padded) {
+        c -> buffer[slot] = wrealloc (c -> buffer[slot], (size_t) padded);
+        c -> buffer_size[slot] = (size_t) padded;
+      }
+      memcpy (c -> buffer[slot], data, (size_t) padded);
+      data = c -> buffer[slot];
+    }
+  }
+  c -> pos += padded;
+
+  if (frameCRC (header, data, (size_t) *length) != (R_UINT) unpackContainerLE (header + 12, 4)) {
+    raiseError ("Error:  Checksum of the frame at byte %llu does not match; the container is corrupt.\n", frame_pos);
+  }
+
+  return (data);
+}
+
+
+/*
+**  Start reading a container from fp, whose magic number has already
+**  been read, or from the map_size bytes at map if fp is NULL.  The
+**  header frame is read and checked.
+*/
+CONTAINER_IN *newContainerIn (FILE *fp, const R_UCHAR *map, size_t map_size) {
+  CONTAINER_IN *c = wmalloc (sizeof (CONTAINER_IN));
+  const R_UCHAR *data = NULL;
+  R_UINT type = 0;
+  R_ULL_INT length = 0;
+  R_UINT version = 0;
+
+  c -> fp = fp;
+  c -> map = map;
+  c -> map_size = map_size;
+  c -> pos = 4;
+  c -> buffer[0] = NULL;
+  c -> buffer[1] = NULL;
+  c -> buffer_size[0] = 0;
+  c -> buffer_size[1] = 0;
+  c -> base_datatype = 0;
+
+  /*  Sequences are read as words, in place if they are aligned  */
+  c -> copy = (R_BOOLEAN) ((fp == NULL) && (((size_t) map % sizeof (R_UINT)) != 0));
+  if ((fp == NULL) && ((map_size < 4) || (unpackContainerLE (map, 4) != CONTAINER_MAGIC))) {
+    raiseError ("Error:  Input is not a Re-Pair container.\n");
+  }
+
+  data = readContainerFrame (c, 0, &type, &length);
+  if (type != CONTAINER_FRAME_HEADER) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+  version = (R_UINT) unpackContainerLE (data, 4);
+  if ((version == 0) || (version > CONTAINER_VERSION)) {
+    raiseError ("Error:  Container version %u is not supported.\n", version);
+  }
+  c -> base_datatype = (R_UINT) unpackContainerLE (data + 4, 4);
+  if ((c -> base_datatype != (R_UINT) sizeof (R_UCHAR)) && (c -> base_datatype != (R_UINT) sizeof (R_USHRT)) && (c -> base_datatype != (R_UINT) sizeof (R_UINT))) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+
+  return (c);
+}
+
+
+/*
+**  Read the frames of the next block, checking their checksums, and
+**  return their data.  Returns R_FALSE instead once the index is
+**  reached, after checking it and the end frame.
+*/
+R_BOOLEAN readContainerBlock (CONTAINER_IN *c, const R_UCHAR **prel, size_t *prel_length, const R_UINT **seq, size_t *seq_words) {
+  const R_UCHAR *data = NULL;
+  R_UINT type = 0;
+  R_ULL_INT length = 0;
+  R_ULL_INT index_pos = c -> pos;
+
+  data = readContainerFrame (c, 0, &type, &length);
+  if (type == CONTAINER_FRAME_INDEX) {
+    data = readContainerFrame (c, 1, &type, &length);
+    if ((type != CONTAINER_FRAME_END) || (length != 8) || (unpackContainerLE (data, 8) != index_pos)) {
+      raiseError ("Error:  Container is corrupt.\n");
+    }
+    if ((c -> fp == NULL) && (c -> pos != (R_ULL_INT) c -> map_size)) {
+      raiseError ("Error:  Container is corrupt.\n");
+    }
+    return (R_FALSE);
+  }
+  if (type != CONTAINER_FRAME_PREL) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+  *prel = data;
+  *prel_length = (size_t) length;
+
+  data = readContainerFrame (c, 1, &type, &length);
+  if ((type != CONTAINER_FRAME_SEQ) || (length % sizeof (R_UINT) != 0)) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+  *seq = (const R_UINT*) data;
+  *seq_words = (size_t) (length / sizeof (R_UINT));
+
+  return (R_TRUE);
+}
+
+
+void deleteContainerIn (CONTAINER_IN *c) {
+  if (c -> buffer[0] != NULL) {
+    wfree (c -> buffer[0]);
+  }
+  if (c -> buffer[1] != NULL) {
+    wfree (c -> buffer[1]);
+  }
+  wfree (c);
+
+  return;
+}
+
+
+/*
+**  Check the checksum of the frame, of the given type, whose data is
+**  at data_pos of the container in memory.  Returns the length of its
+**  data.
+*/
+R_ULL_INT checkContainerFrame (const R_UCHAR *map, size_t map_size, R_ULL_INT data_pos, R_UINT type) {
+  const R_UCHAR *header = NULL;
+  R_ULL_INT length = 0;
+
+  if ((data_pos < 4 + CONTAINER_FRAME_HEADER_SIZE) || (data_pos % 4 != 0) || (data_pos > (R_ULL_INT) map_size)) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+  header = map + (data_pos - CONTAINER_FRAME_HEADER_SIZE);
+  length = unpackContainerLE (header + 4, 8);
+  if (((R_UINT) unpackContainerLE (header, 4) != type) || (length > (R_ULL_INT) map_size - data_pos)) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+  if (frameCRC (header, map + data_pos, (size_t) length) != (R_UINT) unpackContainerLE (header + 12, 4)) {
+    raiseError ("Error:  Checksum of the frame at byte %llu does not match; the container is corrupt.\n", data_pos - CONTAINER_FRAME_HEADER_SIZE);
+  }
+
+  return (length);
+}
+
+
+/*
+**  Find the index of a container in memory through its end frame.
+**  Returns the offset of the index's data and sets index_length to
+**  its length; both frames are checked.
+*/
+R_ULL_INT findContainerIndex (const R_UCHAR *map, size_t map_size, R_ULL_INT *index_length) {
+  R_ULL_INT end_pos = 0;
+  R_ULL_INT index_pos = 0;
+
+  if (map_size < 4 + CONTAINER_END_SIZE) {
+    raiseError ("Error:  Container is truncated.\n");
+  }
+  end_pos = (R_ULL_INT) map_size - CONTAINER_END_SIZE + CONTAINER_FRAME_HEADER_SIZE;
+  if (checkContainerFrame (map, map_size, end_pos, CONTAINER_FRAME_END) != 8) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+  index_pos = unpackContainerLE (map + end_pos, 8);
+  if (index_pos > (R_ULL_INT) map_size) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+  *index_length = checkContainerFrame (map, map_size, index_pos + CONTAINER_FRAME_HEADER_SIZE, CONTAINER_FRAME_INDEX);
+
+  return (index_pos + CONTAINER_FRAME_HEADER_SIZE);
+}
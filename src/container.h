@@ -0,0 +1,109 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+/******************************
+Forward declaration of important structures defined in other files
+******************************/
+struct stream_out;                                         /*  stream.h  */
+
+/******************************
+Definitions
+******************************/
+#define CONTAINER_MAGIC (0x4e435052u)   /*  "RPCN" in little-endian order  */
+#define CONTAINER_VERSION (1u)
+#define CONTAINER_SUFFIX ".rp"
+#define CONTAINER_FRAME_HEADER (1u)
+#define CONTAINER_FRAME_PREL (2u)
+#define CONTAINER_FRAME_SEQ (3u)
+#define CONTAINER_FRAME_INDEX (4u)
+#define CONTAINER_FRAME_END (5u)
+#define CONTAINER_FRAME_HEADER_SIZE (16u)
+#define CONTAINER_END_SIZE (24u)
+                         /*  Size of the end frame, which ends the file  */
+
+/*
+**  Single file written by Re-Pair with --container, in place of the
+**  .prel, .seq and .idx files.
+**
+**  The container starts with the 4-byte magic number.  It is followed
+**  by frames, each made of a 4-byte type, an 8-byte length and the
+**  CRC-32C of the type, the length and the data; then length bytes of
+**  data, padded with zeros to a multiple of 4 bytes, so that the data
+**  of every frame starts on a multiple of 4 bytes.  The frames are:
+**    - CONTAINER_FRAME_HEADER:  the version and the data type (-t),
+**      4 bytes each.
+**    - For each block, CONTAINER_FRAME_PREL with its phrase hierarchy,
+**      as in the .prel file but starting on a byte of its own, then
+**      CONTAINER_FRAME_SEQ with its sequence, as in the .seq file.
+**    - CONTAINER_FRAME_INDEX, laid out as the .idx file (see
+**      blockindex.h).  Its offsets are those of the data of each
+**      block's frames in the container; in bits for the hierarchy and
+**      in bytes for the sequence.
+**    - CONTAINER_FRAME_END, with the 8-byte offset of the index frame.
+**  All integers are stored in little-endian order.
+*/
+
+/******************************
+Structure definitions
+******************************/
+typedef struct container_out {
+  struct stream_out *out;
+  R_ULL_INT pos;                             /*  Bytes written so far  */
+  R_UCHAR *index;               /*  Data of the index frame, so far  */
+  size_t index_length;
+  size_t index_size;
+} CONTAINER_OUT;
+
+/*
+**  A container read from fp, one frame after another, or from the
+**  map_size bytes at map if fp is NULL
+*/
+typedef struct container_in {
+  FILE *fp;
+  const R_UCHAR *map;
+  size_t map_size;
+  R_BOOLEAN copy;
+           /*  Frames are copied to buffer, rather than used in place  */
+  R_ULL_INT pos;                        /*  Offset of the next frame  */
+  R_UCHAR *buffer[2];   /*  Data of the last two frames, if copied  */
+  size_t buffer_size[2];
+  R_UINT base_datatype;                     /*  From the header frame  */
+} CONTAINER_IN;
+
+CONTAINER_OUT *newContainerOut (struct stream_out *out, R_UINT base_datatype, R_UINT sample_rate);
+void writeContainerBlock (CONTAINER_OUT *c, const R_UCHAR *prel, size_t prel_length, const R_UCHAR *seq, size_t seq_length, R_ULL_INT length, R_ULL_INT num_samples, const R_ULL_INT *samples, const R_ULL_INT *sample_bits);
+void finishContainerOut (CONTAINER_OUT *c);
+void deleteContainerOut (CONTAINER_OUT *c);
+CONTAINER_IN *newContainerIn (FILE *fp, const R_UCHAR *map, size_t map_size);
+R_BOOLEAN readContainerBlock (CONTAINER_IN *c, const R_UCHAR **prel, size_t *prel_length, const R_UINT **seq, size_t *seq_words);
+void deleteContainerIn (CONTAINER_IN *c);
+R_ULL_INT checkContainerFrame (const R_UCHAR *map, size_t map_size, R_ULL_INT data_pos, R_UINT type);
+R_ULL_INT findContainerIndex (const R_UCHAR *map, size_t map_size, R_ULL_INT *index_length);
+
+#endif
@@ -0,0 +1,181 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>                                    /*  pthread_once  */
+
+/*
+**  The CRC32 instructions are used directly if they are enabled at
+**  compile time.  Otherwise, on x86 with gcc or clang, the SSE4.2
+**  version is still compiled, and chosen by the first call if the
+**  processor has SSE4.2; the lookup tables are the fallback.
+*/
+#if defined (__SSE4_2__) || defined (__ARM_FEATURE_CRC32)
+#define CRC32C_HARDWARE
+#define CRC32C_TARGET
+#elif defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define CRC32C_DISPATCH
+#define CRC32C_TARGET __attribute__ ((target ("sse4.2")))
+#endif
+
+#if defined (__SSE4_2__) || defined (CRC32C_DISPATCH)
+#include <nmmintrin.h>                         /*  _mm_crc32_u8, _u32, _u64  */
+#elif defined (__ARM_FEATURE_CRC32)
+#include <arm_acle.h>                                    /*  __crc32cb, cd  */
+#endif
+
+#include "common-def.h"
+#include "crc32c.h"
+
+#define CRC32C_POLY (0x82F63B78u)               /*  Reflected polynomial  */
+
+/*  Both versions take and return the CRC inverted  */
+typedef R_UINT (*CRC32C_FUNCTION) (R_UINT crc, const R_UCHAR *data, size_t length);
+
+#if defined (CRC32C_HARDWARE) || defined (CRC32C_DISPATCH)
+static R_UINT crc32cHardware (R_UINT crc, const R_UCHAR *data, size_t length) CRC32C_TARGET;
+#endif
+
+#if !defined (CRC32C_HARDWARE)
+/*
+**  Tables for slicing-by-8:  crc_table[0] is the usual table of one
+**  byte, and crc_table[k] advances a byte by k more bytes of zeros.
+**  They are filled in, and the version to use is chosen, once, by the
+**  first call.
+*/
+static R_UINT crc_table[8][256];
+static CRC32C_FUNCTION crc_function = NULL;
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void initCRC (void);
+static R_UINT crc32cTable (R_UINT crc, const R_UCHAR *data, size_t length);
+
+
+static void initCRC (void) {
+  R_UINT i;
+  R_UINT j;
+  R_UINT crc;
+
+#if defined (CRC32C_DISPATCH)
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("sse4.2")) {
+    crc_function = crc32cHardware;
+    return;
+  }
+#endif
+
+  for (i = 0; i < 256; i++) {
+    crc = i;
+    for (j = 0; j < 8; j++) {
+      crc = (crc >> 1) ^ ((crc & 1u) != 0 ? CRC32C_POLY : 0u);
+    }
+    crc_table[0][i] = crc;
+  }
+  for (i = 0; i < 256; i++) {
+    for (j = 1; j < 8; j++) {
+      crc_table[j][i] = (crc_table[j - 1][i] >> 8) ^ crc_table[0][crc_table[j - 1][i] & MASK_EIGHT];
+    }
+  }
+  crc_function = crc32cTable;
+
+  return;
+}
+
+
+static R_UINT crc32cTable (R_UINT crc, const R_UCHAR *data, size_t length) {
+  R_UINT lo;
+  R_UINT hi;
+
+  /*  Eight bytes at a time, read a byte at a time so that the order
+  **  of the bytes in memory does not matter  */
+  while (length >= 8) {
+    lo = crc ^ ((R_UINT) data[0] | (R_UINT) data[1] << 8 | (R_UINT) data[2] << 16 | (R_UINT) data[3] << 24);
+    hi = (R_UINT) data[4] | (R_UINT) data[5] << 8 | (R_UINT) data[6] << 16 | (R_UINT) data[7] << 24;
+    crc = crc_table[7][lo & MASK_EIGHT] ^ crc_table[6][(lo >> 8) & MASK_EIGHT] ^
+      crc_table[5][(lo >> 16) & MASK_EIGHT] ^ crc_table[4][lo >> 24] ^
+      crc_table[3][hi & MASK_EIGHT] ^ crc_table[2][(hi >> 8) & MASK_EIGHT] ^
+      crc_table[1][(hi >> 16) & MASK_EIGHT] ^ crc_table[0][hi >> 24];
+    data += 8;
+    length -= 8;
+  }
+  while (length > 0) {
+    crc = (crc >> 8) ^ crc_table[0][(crc ^ *data) & MASK_EIGHT];
+    data++;
+    length--;
+  }
+
+  return (crc);
+}
+#endif
+
+
+#if defined (CRC32C_HARDWARE) || defined (CRC32C_DISPATCH)
+static R_UINT crc32cHardware (R_UINT crc, const R_UCHAR *data, size_t length) {
+#if defined (__ARM_FEATURE_CRC32) || defined (__x86_64__)
+  R_ULL_INT word;
+#else
+  R_UINT word;
+#endif
+
+  /*  A word at a time; memcpy as data need not be aligned  */
+  while (length >= sizeof (word)) {
+    memcpy (&word, data, sizeof (word));
+#if defined (__ARM_FEATURE_CRC32)
+    crc = __crc32cd (crc, word);
+#elif defined (__x86_64__)
+    crc = (R_UINT) _mm_crc32_u64 ((R_ULL_INT) crc, word);
+#else
+    crc = _mm_crc32_u32 (crc, word);
+#endif
+    data += sizeof (word);
+    length -= sizeof (word);
+  }
+  while (length > 0) {
+#if defined (__ARM_FEATURE_CRC32)
+    crc = __crc32cb (crc, *data);
+#else
+    crc = _mm_crc32_u8 (crc, *data);
+#endif
+    data++;
+    length--;
+  }
+
+  return (crc);
+}
+#endif
+
+
+R_UINT crc32c (R_UINT crc, const R_UCHAR *data, size_t length) {
+#if defined (CRC32C_HARDWARE)
+  return (~crc32cHardware (~crc, data, length));
+#else
+  (void) pthread_once (&crc_once, initCRC);
+
+  return (~crc_function (~crc, data, length));
+#endif
+}
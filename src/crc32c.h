@@ -0,0 +1,38 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef CRC32C_H
+#define CRC32C_H
+
+/*
+**  CRC-32C (Castagnoli) of length bytes at data, continuing from crc,
+**  the value returned for the bytes before them (0 for none).  With
+**  SSE4.2 or the ARMv8 CRC32 extension enabled at compile time, the
+**  processor's own instructions are used (see src/CMakeLists.txt).
+**  Otherwise, on x86, SSE4.2 is still used if the processor has it.
+*/
+R_UINT crc32c (R_UINT crc, const R_UCHAR *data, size_t length);
+
+#endif
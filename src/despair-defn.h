@@ -32,6 +32,9 @@ Forward declaration of important structures defined in other files
 struct gennode;
 struct bitinrec;                                          /*  bitinput.h  */
 struct pair;                                               /*  despair.h  */
+struct blockindexentry;                                 /*  blockindex.h  */
+struct stream_out;                                         /*  stream.h  */
+struct container_in;                                    /*  container.h  */
 
 /******************************
 Definitions
@@ -41,6 +44,13 @@ Definitions
 #define MAX_GEN 256
   /*  Maximum generations  */
 
+/*  Phases of each block which are timed (see stats.h)  */
+enum R_DESPAIR_PHASE { PHASE_DECODE_HIERARCHY = 0, PHASE_DECODE_SEQUENCE = 1, PHASE_WRITE = 2, NUM_DESPAIR_PHASES = 3 };
+
+/*  Structures whose memory is counted (see stats.h); 0 is the total.
+**  The expansions of the phrases are only kept with FAVOUR_TIME_EXPAND.  */
+enum R_DESPAIR_MEMORY { MEM_PHRASE_TABLE = 1, MEM_SEQUENCE = 2, MEM_IO_BUFFERS = 3, MEM_EXPANSIONS = 4, NUM_DESPAIR_MEMORY = 5 };
+
 /******************************
 Structure definitions
 ******************************/
@@ -53,9 +63,16 @@ typedef struct args_info {
   R_CHAR *progname;
   R_CHAR *base_filename;
   R_UINT base_datatype;
+  R_CHAR *stats_filename;
 
   R_BOOLEAN apply_split;
   R_BOOLEAN verbose_level;
+  R_BOOLEAN perf_counters;
+  R_UINT num_threads;
+  R_BOOLEAN extract;
+  R_ULL_INT extract_offset;
+  R_ULL_INT extract_length;
+  R_BOOLEAN check;
 } ARGS_INFO;
 
 
@@ -70,9 +87,25 @@ typedef struct prog_info {
   R_CHAR *progname;                                     /*  Program name  */
 
   FILE *out_file;                                        /*  Output file  */
+  struct stream_out *out_stream;
+                /*  Output of despairBuffer; NULL if written to out_file  */
   FILE *seq_file;                                /*  Input sequence file  */
   FILE **seq_file_list;
   FILE *prel_file;                                /*  Input prelude file  */
+  R_UCHAR *prel_map;
+                 /*  Prelude file mapped in memory; NULL if it is read  */
+                                                        /*  with fread  */
+  size_t prel_map_size;
+  R_UINT *seq_map;
+                /*  Sequence file mapped in memory; NULL if it is read  */
+                                                        /*  with fread  */
+  size_t seq_map_size;                           /*  Its length in words  */
+  R_BOOLEAN in_buffer;
+            /*  prel_map and seq_map were split from a stream in memory  */
+                                      /*  by despairBuffer, not mapped  */
+  struct container_in *container_in;
+                  /*  Input is a container (see container.h), whose blocks  */
+                              /*  are read from its frames; NULL otherwise  */
   R_CHAR *base_filename;                               /*  Base filename  */
   R_UINT base_datatype;
 
@@ -81,6 +114,10 @@ typedef struct prog_info {
                                /*  Pointer to the end of sequence buffer  */
   R_UINT *seq_buf_p;
               /*  Pointer to the current position in the sequence buffer  */
+                     /*  (both point into seq_map if the file is mapped)  */
+  struct seqdecoder *seq_decoder;
+                   /*  Decoder of the current block if it is coded (see  */
+                              /*  seqformat.h); NULL for 4-byte integers  */
 
   R_UINT **seq_buf_list;                             /*  Sequence buffer  */
   R_UINT *seq_buf_p_list;
@@ -88,28 +125,54 @@ typedef struct prog_info {
   R_UINT *seq_buf_end_list;
                            /*  Pointer to the end of the sequence buffer  */
 
-  R_UCHAR *out_buf_c;
-  R_USHRT *out_buf_s;
-
   /*
   **  Variables that the user can change at the command line  
   */
   R_BOOLEAN apply_split;
   R_BOOLEAN verbose_level;
+  R_BOOLEAN perf_counters;
+                 /*  Count hardware events of each phase (--perf-counters)  */
+  R_UINT num_threads;           /*  Number of blocks decoded at once  */
+
+  FILE *index_file;                              /*  Block index file  */
+  struct blockindexentry *block_index;
+                                /*  Position of each block; NULL if the  */
+                                            /*  index is not being used  */
+  R_UINT block_index_size;                    /*  Number of blocks in it  */
+  R_UINT sample_rate;
+                /*  Number of sequence symbols between position samples  */
+
+  /*
+  **  Extract only the symbols [extract_offset, extract_offset +
+  **  extract_length) of the original file
+  */
+  R_BOOLEAN extract;
+  R_ULL_INT extract_offset;
+  R_ULL_INT extract_length;
+  R_BOOLEAN check;
+                     /*  Only check the checksums of a container (--check)  */
 
   /*
   **  Statistics collected in the Despair process across all blocks
   */
   R_UINT maximum_total_num_phrases;
-  R_UINT total_num_prims;
-  R_UINT total_num_phrases;
-  R_UINT total_num_symbols;
+  R_ULL_INT total_num_prims;
+  R_ULL_INT total_num_phrases;
+  R_ULL_INT total_num_symbols;
   R_UINT maximum_generations;
   R_UINT maximum_primitives;
 
   struct bitinrec *bit_in_rec;
   R_UINT total_blocks;
 
+  FILE *stats_file;
+                /*  Statistics in JSON (--stats-json); NULL if not kept  */
+  PHASE_STATS total_phases[NUM_DESPAIR_PHASES];
+  MEM_STATS memory[NUM_DESPAIR_MEMORY];
+         /*  Memory kept across blocks, with the peaks of any one block  */
+  PHASE_STATS run_start;           /*  When Des-Pair started, and the  */
+  PHASE_STATS run_time;             /*  whole time it took, once done  */
+
   ARGS_INFO *args_struct;
                      /*  Structure of arguments passed from command line  */
                        /*  Should be NULL if no arguments were passed in  */
@@ -121,10 +184,16 @@ typedef struct block_info {
   struct gennode *generation_array;
   R_ULL_INT buffer_num;
 
-  R_UINT *prims_buf;
-  R_UINT *out_buf;
-  R_UINT *out_buf_end;
-  R_UINT *out_buf_p;
+  void *prims_buf;                /*  Value of each primitive, followed  */
+                                                  /*  by the output buffer  */
+  void *out_buf;
+  void *out_buf_end;
+  void *out_buf_p;
+      /*  All four hold symbols of the output datatype (R_UCHAR, R_USHRT  */
+                           /*  or R_UINT, by base_datatype in PROG_INFO)  */
+
+  R_UINT *expand_stack;
+                      /*  Explicit stack used by outPhrase (outphrase.h)  */
 
   /*
   **  Statistics collected in the Despair process for the current block
@@ -139,6 +208,8 @@ typedef struct block_info {
 
   R_UINT total_phrase_length;
   R_UINT max_longest_phrase_length;
+  PHASE_STATS phases[NUM_DESPAIR_PHASES];    /*  Time spent in each phase  */
+  MEM_STATS memory[NUM_DESPAIR_MEMORY];        /*  Memory of the block  */
 
 } BLOCK_INFO;
     
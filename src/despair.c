@@ -24,71 +24,95 @@
 
 
 #include <stdio.h>
+#include <errno.h>
 #include <string.h>
 #include <stdlib.h>
-#include <limits.h>                   /*  UINT_MAX, UCHAR_MAX, USHRT_MAX  */
-#include <getopt.h>                                           /*  getopt  */
+#include <limits.h>                                         /*  UINT_MAX  */
+#include <sys/types.h>                                         /*  off_t  */
+#include <sys/stat.h>
+#include <sys/mman.h>                         /*  mmap, madvise, munmap  */
+#include <pthread.h>
+#include <assert.h>
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
 #include "despair-defn.h"
 #include "outphrase.h"
 #include "despair.h"
 #include "bitin.h"
 #include "phrase-slide-decode.h"
+#include "blockindex.h"
+#include "extract.h"
+#include "stream.h"
+#include "container.h"
+#include "seqformat.h"
+#include "librepair.h"
+#include "librepair-defn.h"
+#include "huffman-decode.h"
+#include "packed-decode.h"
+
+/*  Names of the phases in the statistics file; see R_DESPAIR_PHASE  */
+static const R_CHAR *phase_names[NUM_DESPAIR_PHASES] = {
+  "decode_hierarchy", "decode_sequence", "write"
+};
+
+/*  Names of the structures whose memory is counted; see R_DESPAIR_MEMORY  */
+static const R_CHAR *memory_names[NUM_DESPAIR_MEMORY] = {
+  "total", "phrase_table", "sequence", "io_buffers", "expansions"
+};
 
-static void usage (ARGS_INFO *args_info);
 static void intDecodeHierarchy (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT a, R_UINT b, R_ULL_INT lo, R_ULL_INT hi);
-static void initDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
-static void uninitDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 static void executeDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
-static void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void fillSequenceBuffer (PROG_INFO *prog_struct);
 static void decodeSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void decodeCodedSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void addStats_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void displayStats_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void writeStatsJSON_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void writeStatsJSON_Totals (PROG_INFO *prog_struct);
+static void flushOutput_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void initBlockInfo (BLOCK_INFO *block_struct);
+static R_CHAR *makeFilename (R_CHAR *base_filename, const R_CHAR *suffix);
+static FILE *openFile (R_CHAR *base_filename, const R_CHAR *suffix, const R_CHAR *mode);
+static void seekFile (FILE *fp, R_ULL_INT offset);
+static void *mapFile (FILE *fp, size_t *map_size, R_INT advice);
+static void initDespairWorker (DESPAIR_POOL *pool, DESPAIR_WORKER *worker);
+static void uninitDespairWorker (DESPAIR_WORKER *worker);
+static void *despairWorker (void *arg);
+static void executeDespair_FileParallel (PROG_INFO *prog_struct);
+static void executeDespair_Container (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void openContainer (PROG_INFO *prog_struct);
+
+
+/*
+**  Write out the first num symbols of the output buffer, which are
+**  already of the output datatype
+*/
+void writeOutputFile (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT num) {
+  PHASE_STATS start;
 
+  startPhase (&start);
+  if (prog_struct -> out_stream != NULL) {
+    writeStreamBytes (prog_struct -> out_stream, (const R_UCHAR*) block_struct -> out_buf, (size_t) num * prog_struct -> base_datatype);
+  }
+  else {
+    (void) fwrite (block_struct -> out_buf, (size_t) prog_struct -> base_datatype, (size_t) num, prog_struct -> out_file);
+  }
+  endPhase (&start, &(block_struct -> phases[PHASE_WRITE]));
 
-static void usage (ARGS_INFO *args_struct) {
-  fprintf (stderr, "Des-Pair\n");
-  fprintf (stderr, "========\n\n");
-  fprintf (stderr, "Usage:  %s [options]\n\n", args_struct -> progname);
-  fprintf (stderr, "Options:\n");
-  fprintf (stderr, "-i <file> :  Input filename  [Required]\n");
-  fprintf (stderr, "-t <type> :  Input data type [1 (default), 2, or 4]\n");
-  fprintf (stderr, "-v        :  Verbose output\n");
-  fprintf (stderr, "Des-Pair version:  %s (%s)\n\n", __DATE__, __TIME__);
-  exit (EXIT_FAILURE);
+  return;
 }
 
 
-void writeOutputFile (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT num) {
-  R_UINT i = 0;
-  R_UCHAR *temp_c = prog_struct -> out_buf_c;
-  R_USHRT *temp_s = prog_struct -> out_buf_s;
-  R_UINT *src = block_struct -> out_buf;
-
-  if (prog_struct -> base_datatype == (R_UINT) sizeof (R_UCHAR)) {
-    for (i = 0; i < num; i++) {
-      if (src[i] > (R_UINT) UCHAR_MAX) {
-        fprintf (stderr, "Symbol %u encountered.\n", src[i]);
-        fprintf (stderr, "Symbol value exceeds limit of data type.");
-        exit (EXIT_FAILURE);
-      }
-      temp_c[i] = (R_UCHAR) src[i];
-    }
-    (void) fwrite (temp_c, sizeof (R_UCHAR), (size_t) num, prog_struct -> out_file);
-  }
-  else if (prog_struct -> base_datatype == (R_UINT) sizeof (R_USHRT)) {
-    for (i = 0; i < num; i++) {
-      if (src[i] > USHRT_MAX) {
-        fprintf (stderr, "Symbol %u encountered.\n", src[i]);
-        fprintf (stderr, "Symbol value exceeds limit of data type.");
-        exit (EXIT_FAILURE);
-      }
-      temp_s[i] = (R_USHRT) src[i];
-    }
-    (void) fwrite (temp_s, sizeof (R_USHRT), (size_t) num, prog_struct -> out_file);
-  }
-  else {
-    (void) fwrite (src, sizeof (R_UINT), (size_t) num, prog_struct -> out_file);
+/*
+**  Write out what remains in the output buffer of the block
+*/
+static void flushOutput_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  if ((block_struct -> prims_buf != NULL) && (block_struct -> out_buf != block_struct -> out_buf_p)) {
+    writeOutputFile (prog_struct, block_struct, (R_UINT) (((R_UCHAR*) block_struct -> out_buf_p - (R_UCHAR*) block_struct -> out_buf) / prog_struct -> base_datatype));
+    block_struct -> out_buf_p = block_struct -> out_buf;
   }
 
   return;
@@ -117,7 +141,7 @@ static void intDecodeHierarchy (PROG_INFO *prog_struct, BLOCK_INFO *block_struct
 }
 
 
-static void initDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+void initDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   uninitDespair_OneBlock (prog_struct, block_struct);
 
   block_struct -> buffer_num = 1;
@@ -127,7 +151,10 @@ static void initDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_stru
 }
 
 
-static void uninitDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+/*
+**  Add the statistics of one block to the totals across all blocks
+*/
+static void addStats_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_UINT num_prims_and_phrases;
 
   num_prims_and_phrases = block_struct -> num_prims + block_struct -> num_phrases;
@@ -146,19 +173,72 @@ static void uninitDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_st
     prog_struct -> maximum_primitives = block_struct -> num_prims;
   }
 
-  /*  Flush output buffer  */
-  if ((block_struct -> prims_buf != NULL) && (block_struct -> out_buf != block_struct -> out_buf_p)) {
-    writeOutputFile (prog_struct, block_struct, (R_UINT) (block_struct -> out_buf_p - block_struct -> out_buf));
+  addPhases (prog_struct -> total_phases, block_struct -> phases, NUM_DESPAIR_PHASES);
+  mergeMemory (prog_struct -> memory, block_struct -> memory, NUM_DESPAIR_MEMORY);
+
+  return;
+}
+
+
+void uninitDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+#ifdef FAVOUR_TIME_EXPAND
+  R_UINT i = 0;
+  size_t size = 0;
+#endif
+
+  flushOutput_OneBlock (prog_struct, block_struct);
+  addStats_OneBlock (prog_struct, block_struct);
+
+#ifdef FAVOUR_TIME_EXPAND
+  /*  Free the expansion of each phrase; those of the primitives are
+  **  in prims_buf  */
+  if (block_struct -> phrases_array != NULL) {
+    for (i = block_struct -> num_prims; i < (block_struct -> num_prims + block_struct -> num_phrases); i++) {
+      if (block_struct -> phrases_array[i].pos != NULL) {
+        size = (size_t) block_struct -> phrases_array[i].len * prog_struct -> base_datatype;
+        wfree (block_struct -> phrases_array[i].pos);
+        changeMemory (block_struct -> memory, MEM_EXPANSIONS, size, 0);
+      }
+      block_struct -> phrases_array[i].pos = NULL;
+    }
   }
+#endif
 
   if (block_struct -> prims_buf != NULL) {
     wfree (block_struct -> prims_buf);
+    changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, (size_t) prog_struct -> base_datatype * block_struct -> num_prims, 0);
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, (size_t) prog_struct -> base_datatype * OUT_BUF_SIZE, 0);
   }
   block_struct -> prims_buf = NULL;
   block_struct -> out_buf = NULL;
   block_struct -> out_buf_end = NULL;
   block_struct -> out_buf_p = NULL;
 
+  if (block_struct -> phrases_array != NULL) {
+    wfree (block_struct -> phrases_array);
+    changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, (block_struct -> num_phrases + block_struct -> num_prims) * sizeof (PAIR), 0);
+  }
+  block_struct -> phrases_array = NULL;
+
+  /*  The generation array is only shrunk to num_generation once the  */
+                          /*  whole hierarchy, with expand_stack, is read  */
+  if (block_struct -> expand_stack != NULL) {
+    wfree (block_struct -> expand_stack);
+    changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, sizeof (R_UINT) * EXPAND_STACK_SIZE (block_struct -> num_generation), 0);
+    if (block_struct -> generation_array != NULL) {
+      wfree (block_struct -> generation_array);
+      changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, sizeof (GENNODE) * block_struct -> num_generation, 0);
+    }
+  }
+  else {
+    if (block_struct -> generation_array != NULL) {
+      wfree (block_struct -> generation_array);
+      changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, sizeof (GENNODE) * MAX_GEN, 0);
+    }
+  }
+  block_struct -> expand_stack = NULL;
+  block_struct -> generation_array = NULL;
+
   block_struct -> num_prims = 0;
   block_struct -> num_phrases = 0;
   block_struct -> num_symbols = 0;
@@ -166,24 +246,24 @@ static void uninitDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_st
   block_struct -> num_seq_blocks = 0;
   block_struct -> total_phrase_length = 0;
   block_struct -> max_longest_phrase_length = 0;
+  clearPhases (block_struct -> phases, NUM_DESPAIR_PHASES);
 
-  if (block_struct -> generation_array != NULL) {
-    wfree (block_struct -> generation_array);
-  }
-  block_struct -> generation_array = NULL;
-
-  if (block_struct -> phrases_array != NULL) {
-    wfree (block_struct -> phrases_array);
-  }
-  block_struct -> phrases_array = NULL;
+  /*  Everything allocated for the block has been freed; only the
+  **  peaks are left to be cleared for the next block  */
+  assert (block_struct -> memory[MEM_TOTAL].current == 0);
+  clearMemory (block_struct -> memory, NUM_DESPAIR_MEMORY);
 
   return;
 }
 
 
 static void executeDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  PHASE_STATS start;
+  PHASE_STATS write_before;
 
+  startPhase (&start);
   decodeHierarchy_OneBlock (prog_struct, block_struct);
+  endPhase (&start, &(block_struct -> phases[PHASE_DECODE_HIERARCHY]));
   if (block_struct -> num_phrases + block_struct -> num_prims == 0) {
     return;
   }
@@ -200,13 +280,19 @@ static void executeDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_s
     }
 #endif
 
+  /*  The output buffer is written out as it fills; that is counted
+  **  as writing  */
+  write_before = block_struct -> phases[PHASE_WRITE];
+  startPhase (&start);
   decodeSequence_OneBlock (prog_struct, block_struct);
+  endPhase (&start, &(block_struct -> phases[PHASE_DECODE_SEQUENCE]));
+  excludePhase (&(block_struct -> phases[PHASE_DECODE_SEQUENCE]), &write_before, &(block_struct -> phases[PHASE_WRITE]));
 
   return;
 }
 
 
-static void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct)
+void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct)
 {
   R_ULL_INT kpsqr;
   R_ULL_INT kppsqr = 0;
@@ -217,6 +303,7 @@ static void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_
   R_UINT i = 0;
    
   block_struct -> generation_array = wmalloc (sizeof (GENNODE) * MAX_GEN);
+  changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, 0, sizeof (GENNODE) * MAX_GEN);
 
   /*  Total number of phrases + primitives */
   block_struct -> num_phrases = deltaDecode (0, prog_struct -> bit_in_rec);
@@ -228,17 +315,23 @@ static void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_
   block_struct -> num_prims = deltaDecode (1, prog_struct -> bit_in_rec);
 
   /*  Remove the number of primitives from the count of phrases  */
+  if (block_struct -> num_prims > block_struct -> num_phrases) {
+    raiseError ("Error:  Input is corrupt.\n");
+  }
   block_struct -> num_phrases -= block_struct -> num_prims;
 
 #ifdef DEBUG
   fprintf (stderr, "Prims / phrases:  %u / %u\n", block_struct -> num_prims, block_struct -> num_phrases);
 #endif
 
-  block_struct -> prims_buf = wmalloc (sizeof (R_UINT) * (block_struct -> num_prims + OUT_BUF_SIZE));
-  block_struct -> out_buf = block_struct -> prims_buf + block_struct -> num_prims;
+  /*  Both hold symbols of the output datatype  */
+  block_struct -> prims_buf = wmalloc ((size_t) prog_struct -> base_datatype * (block_struct -> num_prims + OUT_BUF_SIZE));
+  changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, 0, (size_t) prog_struct -> base_datatype * block_struct -> num_prims);
+  changeMemory (block_struct -> memory, MEM_IO_BUFFERS, 0, (size_t) prog_struct -> base_datatype * OUT_BUF_SIZE);
+  block_struct -> out_buf = (R_UCHAR*) block_struct -> prims_buf + (size_t) prog_struct -> base_datatype * block_struct -> num_prims;
 
   /*  Need OUT_BUF_SIZE or else we would access out of the array  */
-  block_struct -> out_buf_end = block_struct -> out_buf + OUT_BUF_SIZE;
+  block_struct -> out_buf_end = (R_UCHAR*) block_struct -> out_buf + (size_t) prog_struct -> base_datatype * OUT_BUF_SIZE;
   block_struct -> out_buf_p = block_struct -> out_buf;
 
   generation_size = block_struct -> num_prims;
@@ -250,10 +343,11 @@ static void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_
   curr_gen++;
 
   block_struct -> phrases_array = wmalloc ((block_struct -> num_phrases + block_struct -> num_prims) * sizeof (PAIR));
+  changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, 0, (block_struct -> num_phrases + block_struct -> num_prims) * sizeof (PAIR));
 
   /*  Decode the primitives  */
   intDecodeHierarchy (prog_struct, block_struct, 0, block_struct -> num_prims, 0, 1ull << gammaDecode (0, prog_struct -> bit_in_rec));
-  setUnitPrimitives (block_struct);
+  setUnitPrimitives (prog_struct, block_struct);
 
   /*  Initialize generation to 1 to include the primitives, decoded
   **  earlier.  */
@@ -263,6 +357,9 @@ static void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_
   for (kp = generation_size; kp < block_struct -> num_phrases + block_struct -> num_prims; kp += generation_size, ++block_struct -> num_generation) {
     /*  size of generation  */
     generation_size = gammaDecode (1, prog_struct -> bit_in_rec);
+    if ((curr_gen == MAX_GEN) || (kp + generation_size > block_struct -> num_phrases + block_struct -> num_prims)) {
+      raiseError ("Error:  Input is corrupt.\n");
+    }
 
     block_struct -> generation_array[curr_gen].size = generation_size;
 #ifdef DEBUG
@@ -286,6 +383,203 @@ static void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_
   }
 
   block_struct -> generation_array = wrealloc (block_struct -> generation_array, sizeof (GENNODE) * (curr_gen));
+  changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, sizeof (GENNODE) * MAX_GEN, sizeof (GENNODE) * (curr_gen));
+
+  block_struct -> expand_stack = wmalloc (sizeof (R_UINT) * EXPAND_STACK_SIZE (block_struct -> num_generation));
+  changeMemory (block_struct -> memory, MEM_PHRASE_TABLE, 0, sizeof (R_UINT) * EXPAND_STACK_SIZE (block_struct -> num_generation));
+
+  return;
+}
+
+
+/*
+**  Read the next words of the sequence file into the empty sequence
+**  buffer
+*/
+static void fillSequenceBuffer (PROG_INFO *prog_struct) {
+  R_UINT bytes_read;
+
+  /*  A mapped file is all in the buffer already  */
+  if ((prog_struct -> seq_map != NULL) || (feof (prog_struct -> seq_file) != R_FALSE)) {
+    raiseError ("ERROR:  Unexpected EOF. %s: %u.\n", __FILE__, __LINE__);
+  }
+
+  bytes_read = (R_UINT) fread (prog_struct -> seq_buf, sizeof (*(prog_struct -> seq_buf)), SEQ_BUF_SIZE, prog_struct -> seq_file);
+  prog_struct -> seq_buf_end = prog_struct -> seq_buf + bytes_read;
+  if (ferror (prog_struct -> seq_file) != R_FALSE) {
+    raiseError ("ERROR:  Reading input sequence file.\n");
+  }
+  if (bytes_read == 0) {
+    raiseError ("ERROR:  Unexpected EOF. %s: %u.\n", __FILE__, __LINE__);
+  }
+  prog_struct -> seq_buf_p = prog_struct -> seq_buf;
+
+  return;
+}
+
+
+/*
+**  Copy the next n words of the sequence file to dest; first those
+**  already in the sequence buffer, then straight from the file
+**  (unless it is mapped, in which case they are all in the buffer)
+*/
+void readSequenceWords (PROG_INFO *prog_struct, R_UINT *dest, size_t n) {
+  size_t avail = (size_t) (prog_struct -> seq_buf_end - prog_struct -> seq_buf_p);
+
+  if (avail > n) {
+    avail = n;
+  }
+  memcpy (dest, prog_struct -> seq_buf_p, avail * sizeof (R_UINT));
+  prog_struct -> seq_buf_p += avail;
+  n -= avail;
+  if (n > 0) {
+    if ((prog_struct -> seq_map != NULL) || fread (dest + avail, sizeof (R_UINT), n, prog_struct -> seq_file) != n) {
+      raiseError ("ERROR:  Unexpected EOF. %s: %u.\n", __FILE__, __LINE__);
+    }
+  }
+
+  return;
+}
+
+
+/*
+**  Continue reading the sequence from the given offset, in bytes, of
+**  the sequence file
+*/
+void seekSequence (PROG_INFO *prog_struct, R_ULL_INT offset) {
+  if (prog_struct -> seq_map != NULL) {
+    if (offset / sizeof (R_UINT) > (R_ULL_INT) prog_struct -> seq_map_size) {
+      raiseError ("ERROR:  Seek past the end of the sequence file. %s: %u.\n", __FILE__, __LINE__);
+    }
+    prog_struct -> seq_buf_p = prog_struct -> seq_map + offset / sizeof (R_UINT);
+    prog_struct -> seq_buf_end = prog_struct -> seq_map + prog_struct -> seq_map_size;
+    return;
+  }
+
+  seekFile (prog_struct -> seq_file, offset);
+  prog_struct -> seq_buf_p = prog_struct -> seq_buf_end;
+
+  return;
+}
+
+
+/*
+**  Read the rest of the header and the coded data of a coded block
+**  whose SEQ_CODED_MARKER has just been read, and return a decoder
+**  for it.  The hierarchy of the block must have been decoded.
+*/
+SEQDECODER *openCodedSequence (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  R_UINT header[SEQ_CODED_HEADER_WORDS - 1];
+  R_UINT alphabet_size = block_struct -> num_prims + block_struct -> num_phrases;
+  SEQDECODER *d = NULL;
+  R_UINT *data = NULL;
+  size_t slack = PACKED_SLACK_BYTES / sizeof (R_UINT);
+  size_t i = 0;
+
+  readSequenceWords (prog_struct, header, SEQ_CODED_HEADER_WORDS - 1);
+  if ((header[0] != SEQ_CODING_HUFFMAN) && (header[0] != SEQ_CODING_PACKED)) {
+    raiseError ("Error:  Sequence coding %u not known.\n", header[0]);
+  }
+
+  /*  The bit-packed decoder reads a little past the end of the data  */
+  data = wmalloc (((size_t) header[2] + slack) * sizeof (R_UINT));
+  readSequenceWords (prog_struct, data, (size_t) header[2]);
+  for (i = 0; i < slack; i++) {
+    data[header[2] + i] = 0;
+  }
+
+  d = wmalloc (sizeof (SEQDECODER));
+  d -> coding = header[0];
+  d -> huffman = NULL;
+  d -> packed = NULL;
+  d -> size = ((size_t) header[2] + slack) * sizeof (R_UINT);
+  d -> mem = block_struct -> memory;
+  changeMemory (d -> mem, MEM_SEQUENCE, 0, d -> size);
+  if (d -> coding == SEQ_CODING_HUFFMAN) {
+    d -> huffman = newHuffDecoder ((R_UCHAR*) data, (size_t) header[2] * sizeof (R_UINT), header[1], alphabet_size);
+  }
+  else {
+    d -> packed = newPackDecoder ((R_UCHAR*) data, (size_t) header[2] * sizeof (R_UINT), header[1], alphabet_size);
+  }
+
+  return (d);
+}
+
+
+/*
+**  Decode up to max symbols of a coded block into out.  Returns the
+**  number of symbols decoded; 0 once the block is done.
+*/
+R_UINT readCodedSequence (SEQDECODER *d, R_UINT *out, R_UINT max) {
+  if (d -> coding == SEQ_CODING_HUFFMAN) {
+    return (huffmanDecode (d -> huffman, out, max));
+  }
+
+  return (packedDecode (d -> packed, out, max));
+}
+
+
+/*
+**  Continue decoding a coded block that was just opened from its
+**  n-th symbol, whose code starts bits bits into the coded data (as
+**  sampled in the block index).  Symbols of a bit-packed block are
+**  found directly.
+*/
+void seekCodedSequence (SEQDECODER *d, R_UINT n, R_ULL_INT bits) {
+  if (d -> coding == SEQ_CODING_PACKED) {
+    packedSkip (d -> packed, n);
+  }
+  else {
+    seekHuffDecoder (d -> huffman, bits, n);
+  }
+
+  return;
+}
+
+
+void closeCodedSequence (SEQDECODER *d) {
+  if (d -> huffman != NULL) {
+    deleteHuffDecoder (d -> huffman);
+  }
+  if (d -> packed != NULL) {
+    deletePackDecoder (d -> packed);
+  }
+  changeMemory (d -> mem, MEM_SEQUENCE, d -> size, 0);
+  wfree (d);
+
+  return;
+}
+
+
+/*
+**  Decode the sequence of a coded block, a buffer of symbols at a
+**  time
+*/
+static void decodeCodedSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  SEQDECODER *decoder = NULL;
+  R_UINT *symbols = NULL;
+  R_UINT symbol_count = 0;
+  R_UINT n = 0;
+  R_UINT i = 0;
+
+  decoder = openCodedSequence (prog_struct, block_struct);
+  symbols = wmalloc (SEQ_BUF_SIZE * sizeof (R_UINT));
+  changeMemory (block_struct -> memory, MEM_SEQUENCE, 0, SEQ_BUF_SIZE * sizeof (R_UINT));
+  while ((n = readCodedSequence (decoder, symbols, SEQ_BUF_SIZE)) > 0) {
+    for (i = 0; i < n; i++) {
+      if (symbols[i] >= block_struct -> num_prims + block_struct -> num_phrases) {
+        raiseError ("Error:  Input is corrupt.\n");
+      }
+      outPhrase (prog_struct, block_struct, symbols[i]);
+    }
+    symbol_count += n;
+  }
+  wfree (symbols);
+  changeMemory (block_struct -> memory, MEM_SEQUENCE, SEQ_BUF_SIZE * sizeof (R_UINT), 0);
+  closeCodedSequence (decoder);
+
+  /*  Counted as if ended by a 0, like a block of 4-byte integers  */
+  block_struct -> num_symbols = symbol_count + 1;
 
   return;
 }
@@ -293,43 +587,40 @@ static void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_
 
 static void decodeSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_UINT x = 0;
-  R_UINT bytes_read;
   R_UINT symbol_count = 0;
 
 #ifdef FAVOUR_TIME_EXPAND
   R_UINT i = 0;
-  R_UINT j = 0;
-  R_UINT k = 0;
+  size_t left_size = 0;
+  size_t right_size = 0;
 #endif
 
 #ifdef FAVOUR_TIME_EXPAND
-  for (; i < (block_struct -> num_prims + block_struct -> num_phrases); i++) {
+  /*  Expansions are kept as symbols of the output datatype; those of
+  **  the primitives are in prims_buf already  */
+  for (i = block_struct -> num_prims; i < (block_struct -> num_prims + block_struct -> num_phrases); i++) {
     block_struct -> phrases_array[i].len = block_struct -> phrases_array[block_struct -> phrases_array[i].left].len + block_struct -> phrases_array[block_struct -> phrases_array[i].right].len;
-    block_struct -> phrases_array[i].pos = wmalloc (block_struct -> phrases_array[i].len * sizeof (R_UINT));
-    for (j = 0; j < block_struct -> phrases_array[block_struct -> phrases_array[i].left].len; j++) {
-      block_struct -> phrases_array[i].pos[j] = block_struct -> phrases_array[block_struct -> phrases_array[i].left].pos[j];
-    }
-    for (k = 0; k < block_struct -> phrases_array[block_struct -> phrases_array[i].right].len; k++) {
-      block_struct -> phrases_array[i].pos[j] = block_struct -> phrases_array[block_struct -> phrases_array[i].right].pos[k];
-      j++;
-    }
+    left_size = (size_t) block_struct -> phrases_array[block_struct -> phrases_array[i].left].len * prog_struct -> base_datatype;
+    right_size = (size_t) block_struct -> phrases_array[block_struct -> phrases_array[i].right].len * prog_struct -> base_datatype;
+    block_struct -> phrases_array[i].pos = wmalloc (left_size + right_size);
+    changeMemory (block_struct -> memory, MEM_EXPANSIONS, 0, left_size + right_size);
+    memcpy (block_struct -> phrases_array[i].pos, block_struct -> phrases_array[block_struct -> phrases_array[i].left].pos, left_size);
+    memcpy ((R_UCHAR*) block_struct -> phrases_array[i].pos + left_size, block_struct -> phrases_array[block_struct -> phrases_array[i].right].pos, right_size);
   }
 #endif
 
+  if (prog_struct -> seq_buf_p == prog_struct -> seq_buf_end) {
+    fillSequenceBuffer (prog_struct);
+  }
+  if (*(prog_struct -> seq_buf_p) == SEQ_CODED_MARKER) {
+    prog_struct -> seq_buf_p++;
+    decodeCodedSequence_OneBlock (prog_struct, block_struct);
+    return;
+  }
+
   while (R_TRUE) {
     if (prog_struct -> seq_buf_p  == prog_struct -> seq_buf_end) {
-      if (feof (prog_struct -> seq_file) != R_FALSE) {
-        fprintf(stderr, "ERROR:  Unexpected EOF. %s: %u.\n", __FILE__, __LINE__);
-        exit (EXIT_FAILURE);
-      }
-
-      bytes_read = (R_UINT) fread (prog_struct -> seq_buf, sizeof (*(prog_struct -> seq_buf)), SEQ_BUF_SIZE, prog_struct -> seq_file);
-      prog_struct -> seq_buf_end = prog_struct -> seq_buf + bytes_read;
-      if (ferror (prog_struct -> seq_file) != R_FALSE) {
-	fprintf (stderr, "ERROR:  Reading input sequence file.\n");
-	exit (EXIT_FAILURE);
-      }
-      prog_struct -> seq_buf_p = prog_struct -> seq_buf;
+      fillSequenceBuffer (prog_struct);
     }
     x = (*(prog_struct -> seq_buf_p)) - 1;
     prog_struct -> seq_buf_p++;
@@ -337,10 +628,13 @@ static void decodeSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_s
 
     /*
     **  Loop exits when x >= num_phrases; since x is an unsigned int,
-    **  exits when x == -1
+    **  exits when x == -1.  Any other such symbol is not in the block.
     */
-    if (x == UINT_MAX) {
-      break;
+    if (x >= block_struct -> num_prims + block_struct -> num_phrases) {
+      if (x == UINT_MAX) {
+        break;
+      }
+      raiseError ("Error:  Input is corrupt.\n");
     }
 
     outPhrase (prog_struct, block_struct, x);
@@ -368,93 +662,473 @@ static void displayStats_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_str
 
   if (prog_struct -> verbose_level == R_TRUE) {
     fprintf (stdout, "%u\t%u\t%u\t\t%u\t\t%u\t\t%u\n", prog_struct -> total_blocks, block_struct -> num_prims, block_struct -> num_phrases, block_struct -> num_prims + block_struct -> num_phrases, block_struct -> num_generation, block_struct -> num_symbols);
+    if (prog_struct -> perf_counters == R_TRUE) {
+      printPhasesCounters (stdout, phase_names, block_struct -> phases, NUM_DESPAIR_PHASES);
+    }
+    printMemory (stdout, memory_names, block_struct -> memory, NUM_DESPAIR_MEMORY);
   }
 
   return;
 }
 
-void executeDespair_File (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+
+/*
+**  Add the block to the "blocks" array of the statistics file
+**  (--stats-json).  Its output must have been written out.
+*/
+static void writeStatsJSON_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  FILE *fp = prog_struct -> stats_file;
+
+  if (fp == NULL) {
+    return;
+  }
+
+  fprintf (fp, "%s\n    {\"block\": %u, \"prims\": %u, \"phrases\": %u, \"generations\": %u, \"symbols\": %u,\n     \"phases\": ", (prog_struct -> total_blocks == 1) ? "" : ",", prog_struct -> total_blocks, block_struct -> num_prims, block_struct -> num_phrases, block_struct -> num_generation, block_struct -> num_symbols);
+  writePhasesJSON (fp, phase_names, block_struct -> phases, NUM_DESPAIR_PHASES);
+  fprintf (fp, ",\n     \"memory\": ");
+  writeMemoryJSON (fp, memory_names, block_struct -> memory, NUM_DESPAIR_MEMORY);
+  fprintf (fp, "}");
+
+  return;
+}
+
+
+/*
+**  End the "blocks" array of the statistics file with the totals
+**  across all blocks.  The time of each phase is summed over the
+**  blocks, so with -j it can be more than the time of the whole run.
+*/
+static void writeStatsJSON_Totals (PROG_INFO *prog_struct) {
+  FILE *fp = prog_struct -> stats_file;
+  R_UINT num_blocks = prog_struct -> total_blocks;
+
+  /*  Unless extracting, the empty block at the end of the prelude
+  **  was counted too  */
+  if ((prog_struct -> extract == R_FALSE) && (num_blocks > 0)) {
+    num_blocks--;
+  }
+
+  fprintf (fp, "\n  ],\n  \"total\": {\"blocks\": %u, \"prims\": %llu, \"phrases\": %llu, \"max_generations\": %u, \"symbols\": %llu,\n    \"phases\": ", num_blocks, prog_struct -> total_num_prims, prog_struct -> total_num_phrases, prog_struct -> maximum_generations, prog_struct -> total_num_symbols);
+  writePhasesJSON (fp, phase_names, prog_struct -> total_phases, NUM_DESPAIR_PHASES);
+  fprintf (fp, ",\n    \"memory\": ");
+  writeMemoryJSON (fp, memory_names, prog_struct -> memory, NUM_DESPAIR_MEMORY);
+  fprintf (fp, "},\n  \"run\": {\"wall_s\": %.6f, \"cpu_s\": %.6f, \"threads\": %u}\n", prog_struct -> run_time.wall, prog_struct -> run_time.cpu, prog_struct -> num_threads);
+
+  return;
+}
+
+/*
+**  Return base_filename with suffix appended
+*/
+static R_CHAR *makeFilename (R_CHAR *base_filename, const R_CHAR *suffix) {
+  R_CHAR *filename = NULL;
+
+  filename = wmalloc ((strlen (base_filename) + strlen (suffix) + 1) * sizeof (R_CHAR));
+  strcpy (filename, base_filename);
+  strcat (filename, suffix);
+
+  return (filename);
+}
+
+
+static FILE *openFile (R_CHAR *base_filename, const R_CHAR *suffix, const R_CHAR *mode) {
+  R_CHAR *filename = NULL;
+  FILE *fp = NULL;
+
+  filename = makeFilename (base_filename, suffix);
+  fp = fopen (filename, mode);
+  if (fp == NULL) {
+    raiseError ("%s: %s\n", filename, strerror (errno));
+  }
+  wfree (filename);
+
+  return (fp);
+}
+
+
+static void seekFile (FILE *fp, R_ULL_INT offset) {
+  if (fseeko (fp, (off_t) offset, SEEK_SET) != 0) {
+    raiseError ("%s: %s\n", __FILE__, strerror (errno));
+  }
+
+  return;
+}
+
+
+/*
+**  Map all of a regular file into memory for reading, and tell the
+**  kernel how it will be read.  Returns NULL if the file cannot be
+**  mapped (such as a pipe, an empty file, or a file larger than the
+**  address space), in which case it is read with fread instead.
+*/
+static void *mapFile (FILE *fp, size_t *map_size, R_INT advice) {
+  struct stat statbuffer;
+  void *map = NULL;
+
+  if ((fp == NULL) || (fstat (fileno (fp), &statbuffer) != 0) || (! S_ISREG (statbuffer.st_mode)) || (statbuffer.st_size <= 0)) {
+    return (NULL);
+  }
+  if ((off_t) (size_t) statbuffer.st_size != statbuffer.st_size) {
+    return (NULL);
+  }
+
+  map = mmap (NULL, (size_t) statbuffer.st_size, PROT_READ, MAP_PRIVATE, fileno (fp), 0);
+  if (map == MAP_FAILED) {
+    return (NULL);
+  }
+  (void) madvise (map, (size_t) statbuffer.st_size, advice);
+  *map_size = (size_t) statbuffer.st_size;
+
+  return (map);
+}
+
+
+/*
+**  Give a worker its own copy of PROG_INFO, with its own files and
+**  buffers, and an empty BLOCK_INFO.  Mapped input files are shared
+**  by all of the workers.
+*/
+static void initDespairWorker (DESPAIR_POOL *pool, DESPAIR_WORKER *worker) {
+  PROG_INFO *prog_struct = &(worker -> prog);
+
+  *prog_struct = *(pool -> prog_struct);
+  worker -> pool = pool;
+
+  prog_struct -> prel_file = NULL;
+  prog_struct -> seq_file = NULL;
+  if (prog_struct -> prel_map != NULL) {
+    prog_struct -> bit_in_rec = newBitinMap (prog_struct -> prel_map, prog_struct -> prel_map_size);
+  }
+  else {
+    prog_struct -> prel_file = openFile (prog_struct -> base_filename, ".prel", "r");
+    prog_struct -> bit_in_rec = newBitin (prog_struct -> prel_file);
+  }
+  if (prog_struct -> seq_map == NULL) {
+    prog_struct -> seq_file = openFile (prog_struct -> base_filename, ".seq", "r");
+  }
+  prog_struct -> out_file = openFile (prog_struct -> base_filename, ".u", "r+");
+
+  /*  Blocks are added to the statistics file by the main thread  */
+  prog_struct -> stats_file = NULL;
+
+  prog_struct -> seq_buf = wmalloc (SEQ_BUF_SIZE * sizeof (R_UINT));
+  prog_struct -> seq_buf_end = prog_struct -> seq_buf;
+  prog_struct -> seq_buf_p = prog_struct -> seq_buf;
+
+  initBlockInfo (&(worker -> block));
+
+  return;
+}
+
+
+static void uninitDespairWorker (DESPAIR_WORKER *worker) {
+  PROG_INFO *prog_struct = &(worker -> prog);
+
+  if (prog_struct -> prel_file != NULL) {
+    FCLOSE (prog_struct -> prel_file);
+  }
+  if (prog_struct -> seq_file != NULL) {
+    FCLOSE (prog_struct -> seq_file);
+  }
+  FCLOSE (prog_struct -> out_file);
+
+  deleteBitin (prog_struct -> bit_in_rec);
+  wfree (prog_struct -> seq_buf);
+
+  return;
+}
+
+
+/*
+**  Decode blocks, taken in order from the pool, until none are left
+*/
+static void *despairWorker (void *arg) {
+  DESPAIR_WORKER *worker = (DESPAIR_WORKER*) arg;
+  DESPAIR_POOL *pool = worker -> pool;
+  PROG_INFO *prog_struct = &(worker -> prog);
+  BLOCK_INFO *block_struct = &(worker -> block);
+  BLOCKINDEXENTRY *entry = NULL;
+  R_UINT curr_block = 0;
+
   while (R_TRUE) {
+    (void) pthread_mutex_lock (&pool -> lock);
+    curr_block = pool -> next_job;
+    pool -> next_job++;
+    (void) pthread_mutex_unlock (&pool -> lock);
+    if (curr_block >= prog_struct -> block_index_size) {
+      break;
+    }
+
+    entry = &(prog_struct -> block_index[curr_block]);
+    checkContainerBlock (prog_struct, entry);
+    seekBitin (prog_struct -> bit_in_rec, entry -> prel_offset);
+    seekSequence (prog_struct, entry -> seq_offset);
+    seekFile (prog_struct -> out_file, pool -> out_offsets[curr_block]);
+
     initDespair_OneBlock (prog_struct, block_struct);
     executeDespair_OneBlock (prog_struct, block_struct);
     if (block_struct -> num_phrases + block_struct -> num_prims == 0) {
-      break;
+      raiseError ("Error:  Block %u not found where the block index says it is.\n", curr_block + 1);
+    }
+    /*  Write out what remains of the block  */
+    flushOutput_OneBlock (prog_struct, block_struct);
+    pool -> results[curr_block] = *block_struct;
+
+    uninitDespair_OneBlock (prog_struct, block_struct);
+  }
+
+  return (NULL);
+}
+
+
+/*
+**  Decode the blocks listed in the block index on several threads.
+**  Each block is written to its own position in the output file, so
+**  the output is the same as if the blocks were decoded one by one.
+*/
+static void executeDespair_FileParallel (PROG_INFO *prog_struct) {
+  DESPAIR_POOL *pool = NULL;
+  pthread_t *threads = NULL;
+  R_ULL_INT out_pos = 0;
+  R_UINT i = 0;
+
+  pool = wmalloc (sizeof (DESPAIR_POOL));
+  pool -> prog_struct = prog_struct;
+  pool -> next_job = 0;
+  pool -> num_workers = prog_struct -> num_threads;
+  if (pool -> num_workers > prog_struct -> block_index_size) {
+    pool -> num_workers = prog_struct -> block_index_size;
+  }
+  (void) pthread_mutex_init (&pool -> lock, NULL);
+
+  /*  Find the position of each block in the output file  */
+  pool -> out_offsets = wmalloc ((prog_struct -> block_index_size + 1) * sizeof (R_ULL_INT));
+  pool -> results = wmalloc ((prog_struct -> block_index_size + 1) * sizeof (BLOCK_INFO));
+  for (i = 0; i < prog_struct -> block_index_size; i++) {
+    pool -> out_offsets[i] = out_pos;
+    out_pos += prog_struct -> block_index[i].length * (R_ULL_INT) prog_struct -> base_datatype;
+  }
+
+  pool -> workers = wmalloc ((pool -> num_workers + 1) * sizeof (DESPAIR_WORKER));
+  threads = wmalloc ((pool -> num_workers + 1) * sizeof (pthread_t));
+  for (i = 0; i < pool -> num_workers; i++) {
+    initDespairWorker (pool, &(pool -> workers[i]));
+    if (pthread_create (&threads[i], NULL, despairWorker, &(pool -> workers[i])) != 0) {
+      raiseError ("Error creating thread %u in %s, line %u.\n", i, __FILE__, __LINE__);
     }
+  }
+  for (i = 0; i < pool -> num_workers; i++) {
+    (void) pthread_join (threads[i], NULL);
+    uninitDespairWorker (&(pool -> workers[i]));
+  }
+
+  /*  Report the blocks in order, as if they were decoded one by one  */
+  for (i = 0; i < prog_struct -> block_index_size; i++) {
+    prog_struct -> total_blocks = i + 1;
+    displayStats_OneBlock (prog_struct, &(pool -> results[i]));
+    writeStatsJSON_OneBlock (prog_struct, &(pool -> results[i]));
+    addStats_OneBlock (prog_struct, &(pool -> results[i]));
+  }
+  /*  Count the empty block which marks the end of the prelude  */
+  prog_struct -> total_blocks = prog_struct -> block_index_size + 1;
+
+  (void) pthread_mutex_destroy (&pool -> lock);
+  wfree (threads);
+  wfree (pool -> workers);
+  wfree (pool -> results);
+  wfree (pool -> out_offsets);
+  wfree (pool);
+
+  return;
+}
+
+
+/*
+**  Decode the blocks of a container one at a time, in the order of its
+**  frames.  Each frame is checked as it is read, so a container can be
+**  decoded as it arrives on a pipe.
+*/
+static void executeDespair_Container (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  const R_UCHAR *prel = NULL;
+  const R_UINT *seq = NULL;
+  size_t prel_length = 0;
+  size_t seq_words = 0;
+
+  while (readContainerBlock (prog_struct -> container_in, &prel, &prel_length, &seq, &seq_words) == R_TRUE) {
+    if (prog_struct -> bit_in_rec != NULL) {
+      deleteBitin (prog_struct -> bit_in_rec);
+    }
+    prog_struct -> bit_in_rec = newBitinMap (prel, prel_length);
+    prog_struct -> seq_map = (R_UINT*) seq;
+    prog_struct -> seq_map_size = seq_words;
+    seekSequence (prog_struct, 0);
+
+    initDespair_OneBlock (prog_struct, block_struct);
+    executeDespair_OneBlock (prog_struct, block_struct);
+    if (block_struct -> num_phrases + block_struct -> num_prims == 0) {
+      raiseError ("Error:  Container is corrupt.\n");
+    }
+    flushOutput_OneBlock (prog_struct, block_struct);
     displayStats_OneBlock (prog_struct, block_struct);
+    writeStatsJSON_OneBlock (prog_struct, block_struct);
   }
 
+  /*  The frames are not mapped on their own.  There is no empty block
+  **  at the end, but it is counted as for the .prel file.  */
+  prog_struct -> seq_map = NULL;
+  prog_struct -> seq_map_size = 0;
+  prog_struct -> total_blocks++;
   uninitDespair_OneBlock (prog_struct, block_struct);
 
   return;
-}   
+}
 
 
-ARGS_INFO *parseArguments (int argc, char *argv[], ARGS_INFO *args_struct) {
-  /*  Declarations required for getopt  */
-  R_INT c;
+/*
+**  Check the checksums of the frames of a block found through the
+**  index of a container; other inputs have none
+*/
+void checkContainerBlock (PROG_INFO *prog_struct, BLOCKINDEXENTRY *entry) {
+  if (prog_struct -> container_in == NULL) {
+    return;
+  }
+
+  if (entry -> prel_offset % 8 != 0) {
+    raiseError ("Error:  Container is corrupt.\n");
+  }
+  (void) checkContainerFrame (prog_struct -> prel_map, prog_struct -> prel_map_size, entry -> prel_offset / 8, CONTAINER_FRAME_PREL);
+  (void) checkContainerFrame (prog_struct -> prel_map, prog_struct -> prel_map_size, entry -> seq_offset, CONTAINER_FRAME_SEQ);
+
+  return;
+}
+
+
+/*
+**  Check the checksums of all of the frames of a container, without
+**  decoding it (--check)
+*/
+void checkDespair (PROG_INFO *prog_struct) {
+  const R_UCHAR *prel = NULL;
+  const R_UINT *seq = NULL;
+  size_t prel_length = 0;
+  size_t seq_words = 0;
+  R_UINT num_blocks = 0;
 
-  args_struct -> progname = argv[0];
-  args_struct -> base_filename = NULL;
-  args_struct -> base_datatype = (R_UINT) sizeof (R_UCHAR);
-  args_struct -> verbose_level = R_FALSE;
+  if (prog_struct -> container_in == NULL) {
+    raiseError ("Error:  Only containers (repair --container) have checksums.\n");
+  }
 
-  /*  Print usage information if no arguments  */
-  if (argc == 1) {
-    usage (args_struct);
+  while (readContainerBlock (prog_struct -> container_in, &prel, &prel_length, &seq, &seq_words) == R_TRUE) {
+    num_blocks++;
+  }
+  fprintf (stdout, "%u blocks checked; all checksums match.\n", num_blocks);
+
+  return;
+}
+
+
+void executeDespair_File (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  if (prog_struct -> extract == R_TRUE) {
+    extractRange (prog_struct, block_struct);
+    return;
+  }
+
+  if ((prog_struct -> block_index != NULL) && (prog_struct -> num_threads > 1)) {
+    executeDespair_FileParallel (prog_struct);
+    return;
+  }
+
+  if (prog_struct -> container_in != NULL) {
+    executeDespair_Container (prog_struct, block_struct);
+    return;
   }
 
-  /*  Check arguments  */
   while (R_TRUE) {
-    c = getopt (argc, argv, "i:t:v?");
-    if (c == EOF) {
+    initDespair_OneBlock (prog_struct, block_struct);
+    executeDespair_OneBlock (prog_struct, block_struct);
+    if (block_struct -> num_phrases + block_struct -> num_prims == 0) {
       break;
     }
+    flushOutput_OneBlock (prog_struct, block_struct);
+    displayStats_OneBlock (prog_struct, block_struct);
+    writeStatsJSON_OneBlock (prog_struct, block_struct);
+  }
+
+  uninitDespair_OneBlock (prog_struct, block_struct);
+
+  return;
+}   
 
-    switch (c) {
-    case 0:
-      break;
-    case 'i':
-      args_struct -> base_filename = optarg;
-      break;
-    case 't':
-      args_struct -> base_datatype = (R_UINT) atoi (optarg);
-      if ((args_struct -> base_datatype != (R_UINT) sizeof (R_UCHAR)) && 
-          (args_struct -> base_datatype != (R_UINT) sizeof (R_USHRT)) &&
-          (args_struct -> base_datatype != (R_UINT) sizeof (R_UINT))) {
-        fprintf (stderr, "Input data type (-t) not valid.\n");
-        exit (EXIT_FAILURE);
-      }
-      break;
-    case 'v':
-      args_struct -> verbose_level = R_TRUE;
-      break;
-    case '?':
-      usage (args_struct);
-      break;
-    default:
-      fprintf (stderr, "Unexpected error:  getopt returned character code 0%d.\n", c);
-      exit (EXIT_FAILURE);
-    }
 
-  }  /*  while  */
+/*
+**  Read the header of a container which was opened as the prelude
+**  file.  Its blocks are read in order from its frames; to decode
+**  several at once or to extract from it, they are found through its
+**  index instead, which needs the container to be mapped.
+*/
+static void openContainer (PROG_INFO *prog_struct) {
+  R_ULL_INT index_pos = 0;
+  R_ULL_INT index_length = 0;
 
-  if (optind < argc) {
-    fprintf (stderr, "The following arguments were not valid:  ");
-    while (optind < argc) {
-      fprintf (stderr, "%s ", argv[optind++]);
+  if (prog_struct -> prel_map != NULL) {
+    prog_struct -> container_in = newContainerIn (NULL, prog_struct -> prel_map, prog_struct -> prel_map_size);
+  }
+  else {
+    if (readStreamMagic (prog_struct -> prel_file) != CONTAINER_MAGIC) {
+      raiseError ("Error:  Input is not a Re-Pair container.\n");
     }
-    fprintf (stderr, "\nRun %s with the -? option for help.\n", args_struct -> progname);
-    exit (EXIT_FAILURE);
+    prog_struct -> container_in = newContainerIn (prog_struct -> prel_file, NULL, 0);
   }
+  prog_struct -> base_datatype = (prog_struct -> container_in) -> base_datatype;
 
-  /*  Check for input filename  */
-  if (args_struct -> base_filename == NULL) {
-    fprintf (stderr, "Error.  Input filename required with the -i option.\n");
-    fprintf (stderr, "\nRun %s with the -? option for help.\n", args_struct -> progname);
-    exit (EXIT_FAILURE);
+  if ((prog_struct -> check == R_TRUE) || ((prog_struct -> num_threads == 1) && (prog_struct -> extract == R_FALSE))) {
+    return;
+  }
+  if (prog_struct -> prel_map == NULL) {
+    if (prog_struct -> extract == R_TRUE) {
+      raiseError ("Error:  Symbols can only be extracted from a container which can be mapped into memory.\n");
+    }
+    fprintf (stderr, "Warning:  Container could not be mapped into memory; blocks will be decoded one at a time.\n");
+    return;
   }
 
-  return (args_struct);
+  index_pos = findContainerIndex (prog_struct -> prel_map, prog_struct -> prel_map_size, &index_length);
+  prog_struct -> index_file = openFile (prog_struct -> base_filename, CONTAINER_SUFFIX, "r");
+  seekFile (prog_struct -> index_file, index_pos);
+  prog_struct -> block_index = readBlockIndex (prog_struct -> index_file, index_pos + index_length, &(prog_struct -> block_index_size), &(prog_struct -> sample_rate));
+
+  /*  The sequences are read from the same mapping  */
+  prog_struct -> seq_map = (R_UINT*) prog_struct -> prel_map;
+  prog_struct -> seq_map_size = prog_struct -> prel_map_size / sizeof (R_UINT);
+
+  return;
+}
+
+
+/*
+**  Initialize values in BLOCK_INFO.
+**  Assumes that initDespair_OneBlock will be run soon.
+*/
+static void initBlockInfo (BLOCK_INFO *block_struct) {
+  block_struct -> phrases_array = NULL;
+  block_struct -> generation_array = NULL;
+  block_struct -> buffer_num = 0;
+  block_struct -> prims_buf = NULL;
+  block_struct -> out_buf = NULL;
+  block_struct -> out_buf_end = NULL;
+  block_struct -> out_buf_p = NULL;
+  block_struct -> expand_stack = NULL;
+  block_struct -> num_prims = 0;
+  block_struct -> num_phrases = 0;
+  block_struct -> num_symbols = 0;
+  block_struct -> num_generation = 0;
+  block_struct -> num_seq_blocks = 0;
+  block_struct -> total_phrase_length = 0;
+  block_struct -> max_longest_phrase_length = 0;
+  clearPhases (block_struct -> phases, NUM_DESPAIR_PHASES);
+  clearMemory (block_struct -> memory, NUM_DESPAIR_MEMORY);
+
+  return;
 }
 
 
@@ -462,19 +1136,44 @@ void initDespair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_CHAR *prelName = NULL;
   R_CHAR *seqName = NULL;
   R_CHAR *outName = NULL;
+  R_CHAR *indexName = NULL;
+  R_INT advice = 0;
+  R_UINT magic = 0;
+  R_INT prel_errno = 0;
+  R_BOOLEAN is_container = R_FALSE;
+
+  startRun (&(prog_struct -> run_start));
 
   /*  Initialize values in PROG_INFO  */
   prog_struct -> progname = NULL;
   prog_struct -> out_file = NULL;
+  prog_struct -> out_stream = NULL;
   prog_struct -> seq_file = NULL;
   prog_struct -> prel_file = NULL;
+  prog_struct -> prel_map = NULL;
+  prog_struct -> prel_map_size = 0;
+  prog_struct -> seq_map = NULL;
+  prog_struct -> seq_map_size = 0;
+  prog_struct -> in_buffer = R_FALSE;
+  prog_struct -> container_in = NULL;
   prog_struct -> base_filename = NULL;
   prog_struct -> base_datatype = (R_UINT) sizeof (R_UCHAR);
 
   prog_struct -> seq_buf = NULL;
   prog_struct -> seq_buf_end = NULL;
   prog_struct -> seq_buf_p = NULL;
+  prog_struct -> seq_decoder = NULL;
   prog_struct -> verbose_level = R_FALSE;
+  prog_struct -> perf_counters = R_FALSE;
+  prog_struct -> num_threads = 1;
+  prog_struct -> index_file = NULL;
+  prog_struct -> block_index = NULL;
+  prog_struct -> block_index_size = 0;
+  prog_struct -> sample_rate = 0;
+  prog_struct -> extract = R_FALSE;
+  prog_struct -> extract_offset = 0;
+  prog_struct -> extract_length = 0;
+  prog_struct -> check = R_FALSE;
   prog_struct -> maximum_total_num_phrases = 0;
   prog_struct -> total_num_prims = 0;
   prog_struct -> total_num_phrases = 0;
@@ -483,75 +1182,160 @@ void initDespair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   prog_struct -> maximum_primitives = 0;
   prog_struct -> bit_in_rec = NULL;
   prog_struct -> total_blocks = 0;
+  prog_struct -> stats_file = NULL;
+  clearPhases (prog_struct -> total_phases, NUM_DESPAIR_PHASES);
+  clearPhases (&(prog_struct -> run_time), 1);
+  clearMemory (prog_struct -> memory, NUM_DESPAIR_MEMORY);
 
-  /*  Initialize values in BLOCK_INFO  */
-  /*  Assumes that initDespair_OneBlock will be run soon  */
-  block_struct -> phrases_array = NULL;
-  block_struct -> prims_buf = NULL;
-  block_struct -> num_prims = 0;
-  block_struct -> num_phrases = 0;
-  block_struct -> num_symbols = 0;
-  block_struct -> num_generation = 0;
-  block_struct -> num_seq_blocks = 0;
-  block_struct -> total_phrase_length = 0;
-  block_struct -> max_longest_phrase_length = 0;
+  initBlockInfo (block_struct);
 
   if (prog_struct -> args_struct != NULL) {
     prog_struct -> progname = (prog_struct -> args_struct) -> progname;
     prog_struct -> base_filename = (prog_struct -> args_struct) -> base_filename;
     prog_struct -> verbose_level = (prog_struct -> args_struct) -> verbose_level;
     prog_struct -> base_datatype = (prog_struct -> args_struct) -> base_datatype;
+    prog_struct -> num_threads = (prog_struct -> args_struct) -> num_threads;
+    prog_struct -> extract = (prog_struct -> args_struct) -> extract;
+    prog_struct -> extract_offset = (prog_struct -> args_struct) -> extract_offset;
+    prog_struct -> extract_length = (prog_struct -> args_struct) -> extract_length;
+    prog_struct -> check = (prog_struct -> args_struct) -> check;
+    if ((prog_struct -> args_struct) -> stats_filename != NULL) {
+      prog_struct -> stats_file = openStatsJSON ((prog_struct -> args_struct) -> stats_filename, "despair");
+    }
+    if ((prog_struct -> args_struct) -> perf_counters == R_TRUE) {
+      prog_struct -> perf_counters = enablePerfCounters ();
+    }
+  }
+
+  /*  Extracted symbols are written to stdout, without statistics;
+  **  checking a container writes nothing  */
+  if ((prog_struct -> extract == R_TRUE) || (prog_struct -> check == R_TRUE)) {
+    prog_struct -> verbose_level = R_FALSE;
   }
 
-  if (prog_struct -> base_filename != NULL) {
+  if ((prog_struct -> base_filename != NULL) && (strcmp (prog_struct -> base_filename, STDIO_FILENAME) == 0)) {
+    magic = readStreamMagic (stdin);
+    if (magic == CONTAINER_MAGIC) {
+      /*  A container is decoded as its frames arrive  */
+      prog_struct -> container_in = newContainerIn (stdin, NULL, 0);
+      prog_struct -> base_datatype = (prog_struct -> container_in) -> base_datatype;
+    }
+    else if (magic != STREAM_MAGIC) {
+      raiseError ("Error:  Input is not a Re-Pair stream.\n");
+    }
+    else if (prog_struct -> check == R_FALSE) {
+      /*  Both parts of the stream are needed at once, so they are
+      **  first copied to temporary files  */
+      prog_struct -> prel_file = tmpfile ();
+      prog_struct -> seq_file = tmpfile ();
+      if ((prog_struct -> prel_file == NULL) || (prog_struct -> seq_file == NULL)) {
+        raiseError ("tmpfile: %s\n", strerror (errno));
+      }
+      splitStream (stdin, prog_struct -> prel_file, prog_struct -> seq_file);
+      rewind (prog_struct -> prel_file);
+      rewind (prog_struct -> seq_file);
+    }
+    prog_struct -> out_file = stdout;
+  }
+  else if (prog_struct -> base_filename != NULL) {
+    /*  Without a .prel file, the input is the container <file>.rp,
+    **  which is opened as the prelude file  */
     prelName = wmalloc ((strlen (prog_struct -> base_filename) + 6) * sizeof (R_CHAR));
     strcpy (prelName, prog_struct -> base_filename);
     strcat (prelName, ".prel");
     prog_struct -> prel_file = fopen (prelName, "r");
     if (! prog_struct -> prel_file) {
-      perror (prelName);
-      exit (EXIT_FAILURE);
+      prel_errno = errno;
+      seqName = makeFilename (prog_struct -> base_filename, CONTAINER_SUFFIX);
+      prog_struct -> prel_file = fopen (seqName, "r");
+      wfree (seqName);
+      if (! prog_struct -> prel_file) {
+        raiseError ("%s: %s\n", prelName, strerror (prel_errno));
+      }
+      is_container = R_TRUE;
     }
     wfree (prelName);
 
-    seqName = wmalloc ((strlen (prog_struct -> base_filename) + 5) * sizeof (R_CHAR));
-    strcpy (seqName, prog_struct -> base_filename);
-    strcat (seqName, ".seq");
-    prog_struct -> seq_file = fopen (seqName, "r");
-    if (! prog_struct -> seq_file) {
-      perror (seqName);
-      exit (EXIT_FAILURE);
+    if (is_container == R_FALSE) {
+      seqName = wmalloc ((strlen (prog_struct -> base_filename) + 5) * sizeof (R_CHAR));
+      strcpy (seqName, prog_struct -> base_filename);
+      strcat (seqName, ".seq");
+      prog_struct -> seq_file = fopen (seqName, "r");
+      if (! prog_struct -> seq_file) {
+        raiseError ("%s: %s\n", seqName, strerror (errno));
+      }
+      wfree (seqName);
     }
-    wfree (seqName);
 
-    outName = wmalloc ((strlen (prog_struct -> base_filename) + 3) * sizeof (R_CHAR));
-    strcpy (outName, prog_struct -> base_filename);
-    strcat (outName, ".u");
-    prog_struct -> out_file = fopen (outName, "w");
-    if (! prog_struct -> out_file) {
-      perror (outName);
-      exit (EXIT_FAILURE);
+    if ((prog_struct -> extract == R_TRUE) || (prog_struct -> check == R_TRUE)) {
+      prog_struct -> out_file = stdout;
+    }
+    else {
+      outName = wmalloc ((strlen (prog_struct -> base_filename) + 3) * sizeof (R_CHAR));
+      strcpy (outName, prog_struct -> base_filename);
+      strcat (outName, ".u");
+      prog_struct -> out_file = fopen (outName, "w");
+      if (! prog_struct -> out_file) {
+        raiseError ("%s: %s\n", outName, strerror (errno));
+      }
+      wfree (outName);
     }
-    wfree (outName);
 
+    /*  Blocks can only be decoded at once or extracted if they can
+    **  be found  */
+    if (((prog_struct -> num_threads > 1) || (prog_struct -> extract == R_TRUE)) && (is_container == R_FALSE)) {
+      indexName = makeFilename (prog_struct -> base_filename, ".idx");
+      prog_struct -> index_file = fopen (indexName, "r");
+      if (prog_struct -> index_file != NULL) {
+        prog_struct -> block_index = readBlockIndex (prog_struct -> index_file, 0, &(prog_struct -> block_index_size), &(prog_struct -> sample_rate));
+      }
+      else if (prog_struct -> extract == R_TRUE) {
+        raiseError ("%s: %s\n", indexName, strerror (errno));
+      }
+      else {
+        fprintf (stderr, "Warning:  %s not found; blocks will be decoded one at a time.\n", indexName);
+      }
+      wfree (indexName);
+    }
   }
   else {
   }
 
-  prog_struct -> bit_in_rec = newBitin (prog_struct -> prel_file);
-  prog_struct -> seq_buf = wmalloc (SEQ_BUF_SIZE * sizeof (R_UINT));
+  /*  Map both input files, if possible, so that they are decoded in
+  **  place.  Blocks are extracted from here and there; otherwise, each
+  **  file is read from start to end (by each thread, with -j).  */
+  advice = (prog_struct -> extract == R_TRUE) ? MADV_RANDOM : MADV_SEQUENTIAL;
+  prog_struct -> prel_map = (R_UCHAR*) mapFile (prog_struct -> prel_file, &(prog_struct -> prel_map_size), advice);
+  prog_struct -> seq_map = (R_UINT*) mapFile (prog_struct -> seq_file, &(prog_struct -> seq_map_size), advice);
+  prog_struct -> seq_map_size /= sizeof (R_UINT);
+  if (is_container == R_TRUE) {
+    openContainer (prog_struct);
+  }
 
-  prog_struct -> out_buf_c = NULL;
-  prog_struct -> out_buf_s = NULL;
-  if (prog_struct -> base_datatype == (R_UINT) sizeof (R_UCHAR)) {
-    prog_struct -> out_buf_c = wmalloc (sizeof (R_UCHAR) * OUT_BUF_SIZE);
+  if (prog_struct -> prel_map != NULL) {
+    prog_struct -> bit_in_rec = newBitinMap (prog_struct -> prel_map, prog_struct -> prel_map_size);
+  }
+  else if ((prog_struct -> prel_file != NULL) && (prog_struct -> container_in == NULL)) {
+    prog_struct -> bit_in_rec = newBitin (prog_struct -> prel_file);
+  }
+  prog_struct -> seq_buf = wmalloc (SEQ_BUF_SIZE * sizeof (R_UINT));
+  changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, 0, SEQ_BUF_SIZE * sizeof (R_UINT));
+  if (prog_struct -> seq_map != NULL) {
+    seekSequence (prog_struct, 0);
   }
-  else if (prog_struct -> base_datatype == (R_UINT) sizeof (R_USHRT)) {
-    prog_struct -> out_buf_s = wmalloc (sizeof (R_USHRT) * OUT_BUF_SIZE);
+
+  /*  The data type of a container is known once it is opened  */
+  if (prog_struct -> stats_file != NULL) {
+    fprintf (prog_struct -> stats_file, "  \"input\": ");
+    writeStringJSON (prog_struct -> stats_file, prog_struct -> base_filename);
+    fprintf (prog_struct -> stats_file, ",\n  \"type\": %u,\n  \"blocks\": [", prog_struct -> base_datatype);
   }
 
   if (prog_struct -> verbose_level == R_TRUE) {
     fprintf (stdout, "Block\tPrims\tPhrases\t\tPrims + Phrases\tGenerations\tSymbols\n");
+    if (prog_struct -> perf_counters == R_TRUE) {
+      printCountersHeader (stdout);
+    }
   }
 
   return;
@@ -563,9 +1347,9 @@ void uninitDespair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
 #ifdef DEBUG
     fprintf (stderr, "Overall Statistics:\n\n");
     fprintf (stderr, "Input filename:  %s\n", prog_struct -> base_filename != NULL ? prog_struct -> base_filename : "N/A");
-    fprintf (stderr, "Total number of primitives:  %u\n", prog_struct -> total_num_prims);
-    fprintf (stderr, "Total number of phrases:  %u\n", prog_struct -> total_num_phrases);
-    fprintf (stderr, "Total sequence length (symbols):  %u\n", prog_struct -> total_num_symbols);
+    fprintf (stderr, "Total number of primitives:  %llu\n", prog_struct -> total_num_prims);
+    fprintf (stderr, "Total number of phrases:  %llu\n", prog_struct -> total_num_phrases);
+    fprintf (stderr, "Total sequence length (symbols):  %llu\n", prog_struct -> total_num_symbols);
     fprintf (stderr, "\nMaximum for one phrase hierarchy:\n");
     fprintf (stderr, "\tNumber of primitives and phrases:  %u\n", prog_struct -> maximum_total_num_phrases);
     fprintf (stderr, "\tGeneration:  %u\n", prog_struct -> maximum_generations);
@@ -574,7 +1358,11 @@ void uninitDespair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
 
   if (prog_struct -> verbose_level == R_TRUE) {
     fprintf (stdout, "---------------------------------------------------------------------------\n");
-    fprintf (stdout, "%u\t%u\t%u\t\t%u\t\t%u\t\t%u\n", prog_struct -> total_blocks - 1, prog_struct -> total_num_prims, prog_struct -> total_num_phrases, prog_struct -> total_num_prims + prog_struct -> total_num_phrases, prog_struct -> maximum_generations, prog_struct -> total_num_symbols);
+    fprintf (stdout, "%u\t%llu\t%llu\t\t%llu\t\t%u\t\t%llu\n", prog_struct -> total_blocks - 1, prog_struct -> total_num_prims, prog_struct -> total_num_phrases, prog_struct -> total_num_prims + prog_struct -> total_num_phrases, prog_struct -> maximum_generations, prog_struct -> total_num_symbols);
+    if (prog_struct -> perf_counters == R_TRUE) {
+      printPhasesCounters (stdout, phase_names, prog_struct -> total_phases, NUM_DESPAIR_PHASES);
+    }
+    printMemory (stdout, memory_names, prog_struct -> memory, NUM_DESPAIR_MEMORY);
   }
 
   if (prog_struct -> prel_file != NULL) {
@@ -587,30 +1375,73 @@ void uninitDespair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   }
   prog_struct -> seq_file = NULL;
 
-  if (prog_struct -> out_file != NULL) {
+  if ((prog_struct -> out_file != NULL) && (prog_struct -> out_file != stdout)) {
     FCLOSE (prog_struct -> out_file);
   }
   prog_struct -> out_file = NULL;
 
+  if (prog_struct -> stats_file != NULL) {
+    endRun (&(prog_struct -> run_start), &(prog_struct -> run_time));
+    writeStatsJSON_Totals (prog_struct);
+    closeStatsJSON (prog_struct -> stats_file);
+  }
+  prog_struct -> stats_file = NULL;
+
+  if (prog_struct -> perf_counters == R_TRUE) {
+    disablePerfCounters ();
+    prog_struct -> perf_counters = R_FALSE;
+  }
+
+  if (prog_struct -> index_file != NULL) {
+    FCLOSE (prog_struct -> index_file);
+  }
+  prog_struct -> index_file = NULL;
+
   if (prog_struct -> seq_buf != NULL) {
     wfree (prog_struct -> seq_buf);
+    changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, SEQ_BUF_SIZE * sizeof (R_UINT), 0);
   }
   prog_struct -> seq_buf = NULL;
   prog_struct -> seq_buf_end = NULL;
   prog_struct -> seq_buf_p = NULL;
 
   if (prog_struct -> bit_in_rec != NULL) {
-    wfree ((prog_struct -> bit_in_rec) -> buffer);
-    wfree (prog_struct -> bit_in_rec);
+    deleteBitin (prog_struct -> bit_in_rec);
   }
   prog_struct -> bit_in_rec = NULL;
 
-  if (prog_struct -> out_buf_c != NULL) {
-    wfree (prog_struct -> out_buf_c);
+  if (prog_struct -> in_buffer == R_TRUE) {
+    wfree (prog_struct -> prel_map);
+    wfree (prog_struct -> seq_map);
+    changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, prog_struct -> prel_map_size + 1 + (prog_struct -> seq_map_size + 1) * sizeof (R_UINT), 0);
+  }
+  else {
+    /*  The sequences of a container are read from its prelude's map  */
+    if (prog_struct -> prel_map != NULL) {
+      (void) munmap (prog_struct -> prel_map, prog_struct -> prel_map_size);
+    }
+    if ((prog_struct -> seq_map != NULL) && ((R_UCHAR*) prog_struct -> seq_map != prog_struct -> prel_map)) {
+      (void) munmap (prog_struct -> seq_map, prog_struct -> seq_map_size * sizeof (R_UINT));
+    }
+  }
+  prog_struct -> prel_map = NULL;
+  prog_struct -> seq_map = NULL;
+  prog_struct -> in_buffer = R_FALSE;
+
+  if (prog_struct -> out_stream != NULL) {
+    deleteStreamOut (prog_struct -> out_stream);
   }
-  else if (prog_struct -> out_buf_s != NULL) {
-    wfree (prog_struct -> out_buf_s);
+  prog_struct -> out_stream = NULL;
+
+  if (prog_struct -> container_in != NULL) {
+    deleteContainerIn (prog_struct -> container_in);
+  }
+  prog_struct -> container_in = NULL;
+
+  if (prog_struct -> block_index != NULL) {
+    wfree (prog_struct -> block_index);
   }
+  prog_struct -> block_index = NULL;
 
   if (block_struct -> phrases_array != NULL) {
     wfree (block_struct -> phrases_array);
@@ -628,3 +1459,54 @@ void uninitDespair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
 }
 
 
+/*
+**  Decode the interleaved stream or the container of in_length bytes
+**  at in, written by Re-Pair, to sink (see librepair.c)
+*/
+void despairBuffer (const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, STREAM_SINK sink, void *sink_arg) {
+  PROG_INFO *prog_struct = NULL;
+  BLOCK_INFO *block_struct = NULL;
+  R_UCHAR *prel = NULL;
+  R_UINT *seq = NULL;
+  size_t prel_length = 0;
+  size_t seq_words = 0;
+
+  if ((options -> base_datatype != (R_UINT) sizeof (R_UCHAR)) &&
+      (options -> base_datatype != (R_UINT) sizeof (R_USHRT)) &&
+      (options -> base_datatype != (R_UINT) sizeof (R_UINT))) {
+    raiseError ("Input data type (-t) not valid.\n");
+  }
+
+  prog_struct = wmalloc (sizeof (PROG_INFO));
+  block_struct = wmalloc (sizeof (BLOCK_INFO));
+  prog_struct -> args_struct = NULL;
+  initDespair (prog_struct, block_struct);
+  prog_struct -> base_datatype = options -> base_datatype;
+
+  if ((in_length >= 4) && (((R_UINT) in[0] | (R_UINT) in[1] << 8 | (R_UINT) in[2] << 16 | (R_UINT) in[3] << 24) == CONTAINER_MAGIC)) {
+    /*  A container is decoded in place, frame by frame  */
+    prog_struct -> container_in = newContainerIn (NULL, in, in_length);
+    prog_struct -> base_datatype = (prog_struct -> container_in) -> base_datatype;
+  }
+  else {
+    /*  Both parts of the stream are needed at once  */
+    splitStreamBuffer (in, in_length, &prel, &prel_length, &seq, &seq_words);
+    changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, 0, prel_length + 1 + (seq_words + 1) * sizeof (R_UINT));
+    prog_struct -> in_buffer = R_TRUE;
+    prog_struct -> prel_map = prel;
+    prog_struct -> prel_map_size = prel_length;
+    prog_struct -> seq_map = seq;
+    prog_struct -> seq_map_size = seq_words;
+    prog_struct -> bit_in_rec = newBitinMap (prog_struct -> prel_map, prog_struct -> prel_map_size);
+    seekSequence (prog_struct, 0);
+  }
+  prog_struct -> out_stream = newStreamOut (NULL, sink, sink_arg);
+
+  executeDespair_File (prog_struct, block_struct);
+
+  uninitDespair (prog_struct, block_struct);
+  wfree (prog_struct);
+  wfree (block_struct);
+
+  return;
+}
@@ -32,6 +32,12 @@ Definitions
 #define OUT_BUF_SIZE (0x40000)  /*  262144  */
 #define SEQ_BUF_SIZE (0x40000)  /*  262144  */
 
+#define STDIO_FILENAME "-"          /*  Filename for an interleaved stream  */
+                                                 /*  read from stdin (-i)  */
+
+#define MAX_NUM_THREADS 256u
+                       /*  Maximum number of blocks decoded at once (-j)  */
+
 /******************************
 Structure definitions
 ******************************/
@@ -39,16 +45,64 @@ typedef struct pair {
   R_UINT left;                                            /*  Left child  */
   R_UINT right;                                          /*  Right child  */
   R_UINT len;                                       /*  Length of phrase  */
-  R_UINT *pos;                    /*  Last position in the output buffer  */
-                                              /*  Must be signed integer  */
+  void *pos;                      /*  Last position in the output buffer  */
   R_ULL_INT buffer_num;             /*  Last buffer number phrase was in  */
   R_ULL_INT chiastic;                                 /*  Chiastic slide  */
 } PAIR;
 
-ARGS_INFO *parseArguments (R_INT argc, R_CHAR *argv[], ARGS_INFO *args_struct);
+/*
+**  Decoder of a coded block of the sequence file (see seqformat.h);
+**  only the decoder of its coding is set
+*/
+typedef struct seqdecoder {
+  R_UINT coding;
+  struct huffdecoder *huffman;
+  struct packdecoder *packed;
+  size_t size;                    /*  Bytes of the block held in memory  */
+  struct mem_stats *mem;          /*  Memory counters of the block  */
+} SEQDECODER;
+
+struct despair_pool;
+
+/*
+**  Each worker thread decodes blocks with its own copy of PROG_INFO,
+**  which has its own input and output files, buffers and statistics.
+*/
+typedef struct despair_worker {
+  struct despair_pool *pool;
+  PROG_INFO prog;
+  BLOCK_INFO block;
+} DESPAIR_WORKER;
+
+/*
+**  Blocks are taken in order by the worker threads, which find them
+**  through the block index and write their output directly to its
+**  position in the output file.
+*/
+typedef struct despair_pool {
+  PROG_INFO *prog_struct;
+  DESPAIR_WORKER *workers;
+  R_UINT num_workers;
+  R_ULL_INT *out_offsets;   /*  Position of each block in the output file  */
+  BLOCK_INFO *results;        /*  Statistics of each block, once decoded  */
+  R_UINT next_job;             /*  Number of the next block to decode  */
+  pthread_mutex_t lock;
+} DESPAIR_POOL;
+
 void executeDespair_File (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+void checkDespair (PROG_INFO *prog_struct);
+void checkContainerBlock (PROG_INFO *prog_struct, struct blockindexentry *entry);
 void initDespair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 void uninitDespair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 void writeOutputFile (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT num);
+void initDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+void uninitDespair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+void decodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+void readSequenceWords (PROG_INFO *prog_struct, R_UINT *dest, size_t n);
+void seekSequence (PROG_INFO *prog_struct, R_ULL_INT offset);
+SEQDECODER *openCodedSequence (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+R_UINT readCodedSequence (SEQDECODER *d, R_UINT *out, R_UINT max);
+void seekCodedSequence (SEQDECODER *d, R_UINT n, R_ULL_INT bits);
+void closeCodedSequence (SEQDECODER *d);
 
 #endif
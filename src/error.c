@@ -0,0 +1,101 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <setjmp.h>
+#include <pthread.h>                  /*  pthread_key_t, per thread  */
+
+#include "common-def.h"
+#include "error.h"
+
+static pthread_key_t error_key;
+static pthread_once_t error_once = PTHREAD_ONCE_INIT;
+static R_BOOLEAN error_key_created = R_FALSE;
+
+static void createErrorKey (void);
+
+
+static void createErrorKey (void) {
+  if (pthread_key_create (&error_key, NULL) == 0) {
+    error_key_created = R_TRUE;
+  }
+
+  return;
+}
+
+
+/*
+**  Give errors raised by this thread to error, or print them and
+**  exit if error is NULL.  Returns R_FALSE if the context could not
+**  be set.
+*/
+R_BOOLEAN setErrorContext (ERROR_CONTEXT *error) {
+  (void) pthread_once (&error_once, createErrorKey);
+  if (error_key_created == R_FALSE) {
+    return (R_FALSE);
+  }
+  if (error != NULL) {
+    error -> message[0] = '\0';
+  }
+
+  return (pthread_setspecific (error_key, error) == 0);
+}
+
+
+/*
+**  Report an error, with a message in the manner of printf; does not
+**  return
+*/
+void raiseError (const R_CHAR *format, ...) {
+  ERROR_CONTEXT *error = NULL;
+  size_t length = 0;
+  va_list args;
+
+  (void) pthread_once (&error_once, createErrorKey);
+  if (error_key_created == R_TRUE) {
+    error = (ERROR_CONTEXT*) pthread_getspecific (error_key);
+  }
+
+  va_start (args, format);
+  if (error == NULL) {
+    (void) vfprintf (stderr, format, args);
+    va_end (args);
+    exit (EXIT_FAILURE);
+  }
+  (void) vsnprintf (error -> message, ERROR_MESSAGE_SIZE, format, args);
+  va_end (args);
+
+  /*  The message is returned without the newline printed at its end  */
+  length = strlen (error -> message);
+  while ((length > 0) && (error -> message[length - 1] == '\n')) {
+    length--;
+    error -> message[length] = '\0';
+  }
+
+  longjmp (*((jmp_buf*) error -> env), 1);
+}
@@ -0,0 +1,60 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef ERROR_H
+#define ERROR_H
+
+/******************************
+Definitions
+******************************/
+#define ERROR_MESSAGE_SIZE 256
+
+/******************************
+Structure definitions
+******************************/
+/*
+**  Errors are raised with raiseError.  If the thread has an error
+**  context (as during a call to the library; see librepair.c), the
+**  message is kept in it and control returns to the jmp_buf that
+**  env points to.  Otherwise, the message is printed to stderr and
+**  the program exits.
+*/
+typedef struct error_context {
+  void *env;                            /*  jmp_buf to return to  */
+  R_CHAR message[ERROR_MESSAGE_SIZE];
+                                 /*  Message of the error, if any  */
+} ERROR_CONTEXT;
+
+/******************************
+Function prototypes
+******************************/
+R_BOOLEAN setErrorContext (ERROR_CONTEXT *error);
+#if defined (__GNUC__)
+void raiseError (const R_CHAR *format, ...) __attribute__ ((noreturn, format (printf, 1, 2)));
+#else
+void raiseError (const R_CHAR *format, ...);
+#endif
+
+#endif
@@ -0,0 +1,296 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>                                         /*  UINT_MAX  */
+#include <sys/types.h>                                         /*  off_t  */
+#include <pthread.h>
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
+#include "despair-defn.h"
+#include "despair.h"
+#include "bitin.h"
+#include "blockindex.h"
+#include "seqformat.h"
+#include "extract.h"
+
+static void emitSymbol (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i);
+static void extractPhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i, R_UINT skip, R_UINT count);
+static R_UINT readSymbol (PROG_INFO *prog_struct, R_UINT chunk);
+static void extractBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, BLOCKINDEXENTRY *entry, R_UINT offset, R_UINT count);
+
+
+/*
+**  Write primitive i to the output buffer, as the output datatype
+*/
+static void emitSymbol (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i) {
+  memcpy (block_struct -> out_buf_p, (R_UCHAR*) block_struct -> prims_buf + (size_t) i * prog_struct -> base_datatype, (size_t) prog_struct -> base_datatype);
+  block_struct -> out_buf_p = (R_UCHAR*) block_struct -> out_buf_p + prog_struct -> base_datatype;
+  if (block_struct -> out_buf_p == block_struct -> out_buf_end) {
+    writeOutputFile (prog_struct, block_struct, OUT_BUF_SIZE);
+    block_struct -> out_buf_p = block_struct -> out_buf;
+  }
+
+  return;
+}
+
+
+/*
+**  Emit count symbols of the expansion of phrase i, after skipping
+**  its first skip symbols.  Only the paths down to the first and last
+**  symbols of the range are followed, plus the subtrees in between.
+*/
+static void extractPhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i, R_UINT skip, R_UINT count) {
+  PAIR *phrases = block_struct -> phrases_array;
+  R_UINT left_len = 0;
+
+  while (i >= block_struct -> num_prims) {
+    left_len = phrases[phrases[i].left].len;
+    if (skip >= left_len) {                       /*  Only in the right  */
+      skip -= left_len;
+      i = phrases[i].right;
+    }
+    else if (skip + count <= left_len) {           /*  Only in the left  */
+      i = phrases[i].left;
+    }
+    else {                                   /*  Starts in the left  */
+      extractPhrase (prog_struct, block_struct, phrases[i].left, skip, left_len - skip);
+      count -= left_len - skip;
+      skip = 0;
+      i = phrases[i].right;
+    }
+  }
+  emitSymbol (prog_struct, block_struct, i);
+
+  return;
+}
+
+
+/*
+**  Read the next symbol of the sequence, reading (or decoding, for a
+**  coded block) at most chunk symbols at a time.
+*/
+static R_UINT readSymbol (PROG_INFO *prog_struct, R_UINT chunk) {
+  R_UINT symbols_read = 0;
+  R_UINT x = 0;
+
+  if (prog_struct -> seq_buf_p == prog_struct -> seq_buf_end) {
+    if (chunk > SEQ_BUF_SIZE) {
+      chunk = SEQ_BUF_SIZE;
+    }
+    if (prog_struct -> seq_decoder != NULL) {
+      symbols_read = readCodedSequence (prog_struct -> seq_decoder, prog_struct -> seq_buf, chunk);
+      if (symbols_read == 0) {
+        raiseError ("ERROR:  Unexpected end of block. %s: %u.\n", __FILE__, __LINE__);
+      }
+    }
+    else if (prog_struct -> seq_map == NULL) {
+      symbols_read = (R_UINT) fread (prog_struct -> seq_buf, sizeof (*(prog_struct -> seq_buf)), (size_t) chunk, prog_struct -> seq_file);
+    }
+    if ((prog_struct -> seq_file != NULL) && (ferror (prog_struct -> seq_file) != R_FALSE)) {
+      raiseError ("ERROR:  Reading input sequence file.\n");
+    }
+    if (symbols_read == 0) {
+      raiseError ("ERROR:  Unexpected EOF. %s: %u.\n", __FILE__, __LINE__);
+    }
+    prog_struct -> seq_buf_p = prog_struct -> seq_buf;
+    prog_struct -> seq_buf_end = prog_struct -> seq_buf + symbols_read;
+  }
+  x = *(prog_struct -> seq_buf_p);
+  prog_struct -> seq_buf_p++;
+  if (prog_struct -> seq_decoder != NULL) {
+    return (x);
+  }
+
+  x = x - 1;
+  if (x == UINT_MAX) {
+    raiseError ("ERROR:  Unexpected end of block. %s: %u.\n", __FILE__, __LINE__);
+  }
+
+  return (x);
+}
+
+
+/*
+**  Emit count symbols of one block, starting at the given offset in
+**  the block.  Only the block's hierarchy is decoded; the position
+**  samples in the index are used to start reading the sequence close
+**  to the offset.
+*/
+static void extractBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, BLOCKINDEXENTRY *entry, R_UINT offset, R_UINT count) {
+  R_ULL_INT position = 0;
+  R_ULL_INT sample = 0;
+  R_ULL_INT bits = 0;
+  R_UINT chunk = 0;
+  R_UINT skip = 0;
+  R_UINT n = 0;
+  R_UINT i = 0;
+  R_UINT x = 0;
+  R_UINT marker = 0;
+  PHASE_STATS start;
+  PHASE_STATS write_before;
+
+  initDespair_OneBlock (prog_struct, block_struct);
+  checkContainerBlock (prog_struct, entry);
+  seekBitin (prog_struct -> bit_in_rec, entry -> prel_offset);
+  startPhase (&start);
+  decodeHierarchy_OneBlock (prog_struct, block_struct);
+  endPhase (&start, &(block_struct -> phases[PHASE_DECODE_HIERARCHY]));
+  if (block_struct -> num_phrases + block_struct -> num_prims == 0) {
+    raiseError ("Error:  Block not found where the block index says it is.\n");
+  }
+
+  /*  Lengths of the phrases; children always come before parents  */
+  for (i = block_struct -> num_prims; i < block_struct -> num_prims + block_struct -> num_phrases; i++) {
+    block_struct -> phrases_array[i].len = block_struct -> phrases_array[block_struct -> phrases_array[i].left].len + block_struct -> phrases_array[block_struct -> phrases_array[i].right].len;
+  }
+
+  write_before = block_struct -> phases[PHASE_WRITE];
+  startPhase (&start);
+
+  /*  Find the last sample at or before the offset  */
+  position = findBlockSample (prog_struct -> index_file, entry, (R_ULL_INT) offset, &sample, &bits);
+
+  /*  A coded block is read from its start; its decoder then moves on
+  **  to the sample's code  */
+  seekSequence (prog_struct, entry -> seq_offset);
+  readSequenceWords (prog_struct, &marker, 1);
+  if (marker == SEQ_CODED_MARKER) {
+    prog_struct -> seq_decoder = openCodedSequence (prog_struct, block_struct);
+    seekCodedSequence (prog_struct -> seq_decoder, (R_UINT) (sample * prog_struct -> sample_rate), bits);
+    prog_struct -> seq_buf_p = prog_struct -> seq_buf_end;
+  }
+  else {
+    seekSequence (prog_struct, entry -> seq_offset + (sample * prog_struct -> sample_rate * sizeof (R_UINT)));
+  }
+
+  /*  At most sample_rate symbols are skipped, and every symbol
+  **  after them expands to at least one symbol  */
+  chunk = prog_struct -> sample_rate + count;
+  if (chunk < prog_struct -> sample_rate) {
+    chunk = UINT_MAX;
+  }
+
+  /*  Skip the symbols of the sequence that end before the offset  */
+  while (R_TRUE) {
+    x = readSymbol (prog_struct, chunk);
+    if (position + block_struct -> phrases_array[x].len > (R_ULL_INT) offset) {
+      break;
+    }
+    position += block_struct -> phrases_array[x].len;
+  }
+
+  skip = (R_UINT) ((R_ULL_INT) offset - position);
+  while (R_TRUE) {
+    n = block_struct -> phrases_array[x].len - skip;
+    if (n > count) {
+      n = count;
+    }
+    extractPhrase (prog_struct, block_struct, x, skip, n);
+    count -= n;
+    if (count == 0) {
+      break;
+    }
+    skip = 0;
+    x = readSymbol (prog_struct, chunk);
+  }
+
+  if (prog_struct -> seq_decoder != NULL) {
+    closeCodedSequence (prog_struct -> seq_decoder);
+    prog_struct -> seq_decoder = NULL;
+  }
+  endPhase (&start, &(block_struct -> phases[PHASE_DECODE_SEQUENCE]));
+  excludePhase (&(block_struct -> phases[PHASE_DECODE_SEQUENCE]), &write_before, &(block_struct -> phases[PHASE_WRITE]));
+
+  /*  Write out what remains of the block  */
+  uninitDespair_OneBlock (prog_struct, block_struct);
+
+  return;
+}
+
+
+/*
+**  Write the symbols [extract_offset, extract_offset + extract_length)
+**  of the original file to the output file.  Blocks are found with
+**  the block index; only those holding the range are decoded.
+*/
+void extractRange (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  BLOCKINDEXENTRY *index = prog_struct -> block_index;
+  R_ULL_INT *block_start = NULL;
+  R_ULL_INT offset = prog_struct -> extract_offset;
+  R_ULL_INT remaining = prog_struct -> extract_length;
+  R_ULL_INT n = 0;
+  R_UINT lo = 0;
+  R_UINT hi = 0;
+  R_UINT mid = 0;
+  R_UINT i = 0;
+
+  /*  Position of each block in the original file  */
+  block_start = wmalloc ((prog_struct -> block_index_size + 1) * sizeof (R_ULL_INT));
+  block_start[0] = 0;
+  for (i = 0; i < prog_struct -> block_index_size; i++) {
+    block_start[i + 1] = block_start[i] + index[i].length;
+  }
+
+  if (offset > block_start[prog_struct -> block_index_size]) {
+    raiseError ("Error:  Offset %llu is beyond the end of the file (%llu).\n", offset, block_start[prog_struct -> block_index_size]);
+  }
+  if (remaining > block_start[prog_struct -> block_index_size] - offset) {
+    remaining = block_start[prog_struct -> block_index_size] - offset;
+  }
+
+  /*  Find the block holding the offset  */
+  lo = 0;
+  hi = prog_struct -> block_index_size;
+  while (hi - lo > 1) {
+    mid = lo + ((hi - lo) >> 1);
+    if (block_start[mid] <= offset) {
+      lo = mid;
+    }
+    else {
+      hi = mid;
+    }
+  }
+
+  for (i = lo; (i < prog_struct -> block_index_size) && (remaining > 0); i++) {
+    n = block_start[i + 1] - offset;
+    if (n > remaining) {
+      n = remaining;
+    }
+    extractBlock (prog_struct, block_struct, &index[i], (R_UINT) (offset - block_start[i]), (R_UINT) n);
+    offset += n;
+    remaining -= n;
+  }
+
+  wfree (block_start);
+
+  return;
+}
+
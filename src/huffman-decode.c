@@ -0,0 +1,373 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "seqformat.h"
+#include "huffman-decode.h"
+
+#define HUFFMAN_REFILL_BITS 56
+               /*  Bits held after a refill; enough for any two codes  */
+
+static void refillHuffBits (HUFFDECODER *d);
+static R_UINT readHuffBits (HUFFDECODER *d, R_UINT bits);
+static R_UINT gammaDecodeHuff (HUFFDECODER *d);
+static void readCodeLengths (HUFFDECODER *d, R_UCHAR *code_len);
+static R_BOOLEAN matchCode (HUFFDECODER *d, R_ULL_INT bits, R_UINT avail, R_UINT *symbol, R_UINT *length);
+static void buildHuffTable (HUFFDECODER *d);
+static R_UINT decodeLongCode (HUFFDECODER *d);
+
+
+/*
+**  Top up the bit buffer to more than HUFFMAN_REFILL_BITS bits.  Past
+**  the end of the data, 0's are read.
+*/
+static void refillHuffBits (HUFFDECODER *d) {
+  while (d -> bitCount <= HUFFMAN_REFILL_BITS) {
+    if (d -> data_p < d -> data_end) {
+      d -> bitBuffer |= (R_ULL_INT) *(d -> data_p) << (HUFFMAN_REFILL_BITS - d -> bitCount);
+      d -> data_p++;
+    }
+    d -> bitCount += 8;
+  }
+
+  return;
+}
+
+
+/*  Read 1 to 32 bits  */
+static R_UINT readHuffBits (HUFFDECODER *d, R_UINT bits) {
+  R_UINT x;
+
+  refillHuffBits (d);
+  x = (R_UINT) (d -> bitBuffer >> (64 - bits));
+  d -> bitBuffer <<= bits;
+  d -> bitCount -= bits;
+
+  return (x);
+}
+
+
+/*  Read a gamma code, as written by gammaEncode with lo = 1  */
+static R_UINT gammaDecodeHuff (HUFFDECODER *d) {
+  R_UINT zeros = 0;
+
+  refillHuffBits (d);
+  while ((d -> bitBuffer >> 63) == 0) {
+    zeros++;
+    if (zeros > 31) {
+      raiseError ("Error:  Huffman code lengths are not valid.\n");
+    }
+    d -> bitBuffer <<= 1;
+    d -> bitCount--;
+  }
+
+  return (readHuffBits (d, zeros + 1));
+}
+
+
+/*  Read the length of the code of each symbol  */
+static void readCodeLengths (HUFFDECODER *d, R_UCHAR *code_len) {
+  R_UINT run = 0;
+  R_UINT len = 0;
+  R_UINT i = 0;
+
+  while (i < d -> alphabet_size) {
+    len = readHuffBits (d, HUFFMAN_LEN_BITS);
+    if (len > HUFFMAN_LONGEST_CODE) {
+      raiseError ("Error:  Huffman code lengths are not valid.\n");
+    }
+    if (len != 0) {
+      code_len[i] = (R_UCHAR) len;
+      i++;
+      continue;
+    }
+    run = gammaDecodeHuff (d);
+    if (run > d -> alphabet_size - i) {
+      raiseError ("Error:  Huffman code lengths are not valid.\n");
+    }
+    while (run > 0) {
+      code_len[i] = 0;
+      i++;
+      run--;
+    }
+  }
+
+  return;
+}
+
+
+/*
+**  Find the code at the top of bits, among the codes of at most avail
+**  bits.  Returns R_FALSE if it is longer.
+*/
+static R_BOOLEAN matchCode (HUFFDECODER *d, R_ULL_INT bits, R_UINT avail, R_UINT *symbol, R_UINT *length) {
+  R_UINT code = 0;
+  R_UINT len = 0;
+
+  if (avail > d -> longest_code) {
+    avail = d -> longest_code;
+  }
+  for (len = 1; len <= avail; len++) {
+    code = (R_UINT) (bits >> (64 - len));
+    if (code - d -> first_code[len] < d -> len_count[len]) {
+      *symbol = d -> sorted[d -> first_index[len] + (code - d -> first_code[len])];
+      *length = len;
+      return (R_TRUE);
+    }
+  }
+
+  return (R_FALSE);
+}
+
+
+/*
+**  Fill the decoding table.  Each entry holds as many whole codes, up
+**  to HUFFMAN_TABLE_SYMBOLS, as fit in its HUFFMAN_TABLE_BITS bits.
+*/
+static void buildHuffTable (HUFFDECODER *d) {
+  HUFFENTRY *e = NULL;
+  R_ULL_INT bits = 0;
+  R_UINT used = 0;
+  R_UINT symbol = 0;
+  R_UINT length = 0;
+  R_UINT i = 0;
+
+  d -> table = wmalloc (sizeof (HUFFENTRY) * (1u << HUFFMAN_TABLE_BITS));
+  for (i = 0; i < (1u << HUFFMAN_TABLE_BITS); i++) {
+    e = &(d -> table[i]);
+    e -> num_symbols = 0;
+    e -> first_bits = 0;
+    e -> num_bits = 0;
+    for (symbol = 0; symbol < HUFFMAN_TABLE_SYMBOLS; symbol++) {
+      e -> symbol[symbol] = 0;
+    }
+    bits = (R_ULL_INT) i << (64 - HUFFMAN_TABLE_BITS);
+    used = 0;
+    while ((e -> num_symbols < HUFFMAN_TABLE_SYMBOLS) &&
+           (matchCode (d, bits << used, HUFFMAN_TABLE_BITS - used, &symbol, &length) == R_TRUE)) {
+      if (e -> num_symbols == 0) {
+        e -> first_bits = (R_UCHAR) length;
+      }
+      e -> symbol[e -> num_symbols] = symbol;
+      e -> num_symbols++;
+      used += length;
+    }
+    e -> num_bits = (R_UCHAR) used;
+  }
+
+  return;
+}
+
+
+/*  Decode a code longer than HUFFMAN_TABLE_BITS  */
+static R_UINT decodeLongCode (HUFFDECODER *d) {
+  R_ULL_INT top = d -> bitBuffer >> 32;
+  R_UINT len = HUFFMAN_TABLE_BITS + 1;
+  R_UINT code = 0;
+
+  while ((len <= d -> longest_code) && (top >= d -> limit[len])) {
+    len++;
+  }
+  if (len > d -> longest_code) {
+    raiseError ("Error:  Huffman coded sequence is not valid.\n");
+  }
+  code = (R_UINT) (top >> (32 - len));
+  d -> bitBuffer <<= len;
+  d -> bitCount -= len;
+
+  return (d -> sorted[d -> first_index[len] + (code - d -> first_code[len])]);
+}
+
+
+/*
+**  Create a decoder for the length bytes of coded data of a block of
+**  num_symbols symbols, each less than alphabet_size.  The decoder
+**  takes over data, which must have been allocated with wmalloc.
+*/
+HUFFDECODER *newHuffDecoder (R_UCHAR *data, size_t length, R_UINT num_symbols, R_UINT alphabet_size) {
+  HUFFDECODER *d = NULL;
+  R_UCHAR *code_len = NULL;
+  R_UINT *next_index = NULL;
+  R_UINT i = 0;
+
+  d = wmalloc (sizeof (HUFFDECODER));
+  d -> data = data;
+  d -> data_p = data;
+  d -> data_end = data + length;
+  d -> bitBuffer = 0;
+  d -> bitCount = 0;
+  d -> remaining = num_symbols;
+  d -> alphabet_size = alphabet_size;
+  d -> longest_code = 0;
+  d -> sorted = NULL;
+  d -> table = NULL;
+
+  code_len = wmalloc (sizeof (R_UCHAR) * (alphabet_size + 1));
+  readCodeLengths (d, code_len);
+
+  /*  Rebuild the canonical code from the lengths  */
+  for (i = 0; i <= HUFFMAN_LONGEST_CODE; i++) {
+    d -> len_count[i] = 0;
+  }
+  for (i = 0; i < alphabet_size; i++) {
+    d -> len_count[code_len[i]]++;
+    if (code_len[i] > d -> longest_code) {
+      d -> longest_code = code_len[i];
+    }
+  }
+  d -> len_count[0] = 0;
+  d -> first_code[0] = 0;
+  d -> first_index[0] = 0;
+  d -> limit[0] = 0;
+  for (i = 1; i <= HUFFMAN_LONGEST_CODE; i++) {
+    d -> first_code[i] = (d -> first_code[i - 1] + d -> len_count[i - 1]) << 1;
+    d -> first_index[i] = d -> first_index[i - 1] + d -> len_count[i - 1];
+    d -> limit[i] = ((R_ULL_INT) d -> first_code[i] + d -> len_count[i]) << (32 - i);
+  }
+
+  /*  Symbols in the order of their codes  */
+  next_index = wmalloc (sizeof (R_UINT) * (HUFFMAN_LONGEST_CODE + 1));
+  for (i = 0; i <= HUFFMAN_LONGEST_CODE; i++) {
+    next_index[i] = d -> first_index[i];
+  }
+  d -> sorted = wmalloc (sizeof (R_UINT) * (d -> first_index[HUFFMAN_LONGEST_CODE] + d -> len_count[HUFFMAN_LONGEST_CODE] + 1));
+  for (i = 0; i < alphabet_size; i++) {
+    if (code_len[i] != 0) {
+      d -> sorted[next_index[code_len[i]]++] = i;
+    }
+  }
+  wfree (next_index);
+  wfree (code_len);
+
+  if ((num_symbols > 0) && (d -> longest_code == 0)) {
+    raiseError ("Error:  Huffman coded sequence is not valid.\n");
+  }
+
+  buildHuffTable (d);
+
+  return (d);
+}
+
+
+void deleteHuffDecoder (HUFFDECODER *d) {
+  wfree (d -> table);
+  wfree (d -> sorted);
+  wfree (d -> data);
+  wfree (d);
+
+  return;
+}
+
+
+/*
+**  Decode up to max of the remaining symbols of the block into out.
+**  Returns the number of symbols decoded; 0 once the block is done.
+*/
+R_UINT huffmanDecode (HUFFDECODER *d, R_UINT *out, R_UINT max) {
+  const HUFFENTRY *e = NULL;
+  R_UINT n = 0;
+
+  if (max > d -> remaining) {
+    max = d -> remaining;
+  }
+
+  /*  Two look ups per refill, each of up to HUFFMAN_TABLE_SYMBOLS
+  **  symbols; codes longer than the table are at most
+  **  HUFFMAN_LONGEST_CODE bits  */
+  while (n + (HUFFMAN_TABLE_SYMBOLS << 1) <= max) {
+    refillHuffBits (d);
+
+    e = &(d -> table[d -> bitBuffer >> (64 - HUFFMAN_TABLE_BITS)]);
+    if (e -> num_symbols == 0) {
+      out[n++] = decodeLongCode (d);
+    }
+    else {
+      out[n] = e -> symbol[0];
+      out[n + 1] = e -> symbol[1];
+      n += e -> num_symbols;
+      d -> bitBuffer <<= e -> num_bits;
+      d -> bitCount -= e -> num_bits;
+    }
+
+    if (d -> bitCount < HUFFMAN_LONGEST_CODE) {
+      continue;
+    }
+    e = &(d -> table[d -> bitBuffer >> (64 - HUFFMAN_TABLE_BITS)]);
+    if (e -> num_symbols == 0) {
+      out[n++] = decodeLongCode (d);
+    }
+    else {
+      out[n] = e -> symbol[0];
+      out[n + 1] = e -> symbol[1];
+      n += e -> num_symbols;
+      d -> bitBuffer <<= e -> num_bits;
+      d -> bitCount -= e -> num_bits;
+    }
+  }
+
+  /*  Last few symbols, one at a time  */
+  while (n < max) {
+    refillHuffBits (d);
+    e = &(d -> table[d -> bitBuffer >> (64 - HUFFMAN_TABLE_BITS)]);
+    if (e -> num_symbols == 0) {
+      out[n++] = decodeLongCode (d);
+    }
+    else {
+      out[n++] = e -> symbol[0];
+      d -> bitBuffer <<= e -> first_bits;
+      d -> bitCount -= e -> first_bits;
+    }
+  }
+  d -> remaining -= n;
+
+  return (n);
+}
+
+
+/*
+**  Continue decoding at the code which starts bits bits into the
+**  coded data, that of symbol n of the block.  No symbol may have been
+**  decoded yet.
+*/
+void seekHuffDecoder (HUFFDECODER *d, R_ULL_INT bits, R_UINT n) {
+  if ((n > d -> remaining) || ((bits >> 3) > (R_ULL_INT) (d -> data_end - d -> data))) {
+    raiseError ("Error:  Huffman coded sequence is not valid.\n");
+  }
+
+  d -> data_p = d -> data + (bits >> 3);
+  d -> bitBuffer = 0;
+  d -> bitCount = 0;
+  if ((bits & 7) != 0) {
+    (void) readHuffBits (d, (R_UINT) (bits & 7));
+  }
+  d -> remaining -= n;
+
+  return;
+}
@@ -0,0 +1,84 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef HUFFMAN_DECODE_H
+#define HUFFMAN_DECODE_H
+
+/******************************
+Definitions
+******************************/
+#define HUFFMAN_TABLE_BITS 12
+                   /*  Bits looked up at once in the decoding table  */
+#define HUFFMAN_TABLE_SYMBOLS 2
+                  /*  Most symbols decoded with one table look up  */
+
+/******************************
+Structure definitions
+******************************/
+/*
+**  One entry of the decoding table, for the next HUFFMAN_TABLE_BITS
+**  bits of the input:  the symbols whose codes fit entirely in them,
+**  and the number of bits of the first and of all those codes.  If
+**  num_symbols is 0, the next code is longer than the table.
+*/
+typedef struct huffentry {
+  R_UINT symbol[HUFFMAN_TABLE_SYMBOLS];
+  R_UCHAR num_symbols;
+  R_UCHAR first_bits;
+  R_UCHAR num_bits;
+} HUFFENTRY;
+
+/*
+**  State of the decoder of one Huffman coded block.  The codes of
+**  length l are first_code[l] .. first_code[l] + len_count[l] - 1,
+**  for the symbols sorted[first_index[l]] onwards.  limit[l] is the
+**  end of the codes of length l, left-justified to 32 bits; a code
+**  is of length l if the next 32 bits are below limit[l] but not
+**  below limit[l - 1].
+*/
+typedef struct huffdecoder {
+  R_UCHAR *data;                       /*  Coded data of the block  */
+  const R_UCHAR *data_p;
+  const R_UCHAR *data_end;
+  R_ULL_INT bitBuffer;
+                /*  Next bits of the data, from the most significant bit  */
+  R_UINT bitCount;
+  R_UINT remaining;             /*  Number of symbols still to decode  */
+  R_UINT alphabet_size;
+  R_UINT longest_code;
+  R_UINT len_count[HUFFMAN_LONGEST_CODE + 1];
+  R_UINT first_code[HUFFMAN_LONGEST_CODE + 1];
+  R_UINT first_index[HUFFMAN_LONGEST_CODE + 1];
+  R_ULL_INT limit[HUFFMAN_LONGEST_CODE + 1];
+  R_UINT *sorted;
+  HUFFENTRY *table;
+} HUFFDECODER;
+
+HUFFDECODER *newHuffDecoder (R_UCHAR *data, size_t length, R_UINT num_symbols, R_UINT alphabet_size);
+void deleteHuffDecoder (HUFFDECODER *d);
+R_UINT huffmanDecode (HUFFDECODER *d, R_UINT *out, R_UINT max);
+void seekHuffDecoder (HUFFDECODER *d, R_ULL_INT bits, R_UINT n);
+
+#endif
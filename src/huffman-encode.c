@@ -0,0 +1,297 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "bitout.h"
+#include "seqformat.h"
+#include "huffman-encode.h"
+
+/*  A symbol used in the block, with its frequency  */
+typedef struct huffsymbol {
+  R_UINT freq;
+  R_UINT symbol;
+} HUFFSYMBOL;
+
+static R_INT huffSymbolComparison (const void *a, const void *b);
+static void calculateCodeLengths (R_UINT *lengths, R_UINT n);
+static void limitCodeLengths (R_UINT *lengths, R_UINT n, R_UINT limit);
+static void writeCodeLengths (BITOUTREC *w, const R_UCHAR *code_len, R_UINT alphabet_size);
+
+
+/*
+**  Order symbols by increasing frequency; ties by symbol, so that the
+**  output does not depend on qsort
+*/
+static R_INT huffSymbolComparison (const void *a, const void *b) {
+  const HUFFSYMBOL *x = (const HUFFSYMBOL*) a;
+  const HUFFSYMBOL *y = (const HUFFSYMBOL*) b;
+
+  if (x -> freq != y -> freq) {
+    return ((x -> freq < y -> freq) ? -1 : 1);
+  }
+  if (x -> symbol != y -> symbol) {
+    return ((x -> symbol < y -> symbol) ? -1 : 1);
+  }
+
+  return (0);
+}
+
+
+/*
+**  Replace the n frequencies in lengths, sorted in increasing order,
+**  by the lengths of a minimum-redundancy code for them.  In-place
+**  calculation of Moffat and Katajainen (WADS 1995).  The lengths are
+**  in decreasing order.
+*/
+static void calculateCodeLengths (R_UINT *lengths, R_UINT n) {
+  R_UINT root = 0;
+  R_UINT leaf = 2;
+  R_UINT next = 0;
+  R_UINT avbl = 1;
+  R_UINT used = 0;
+  R_UINT dpth = 0;
+  R_INT i = 0;
+
+  if (n == 1) {
+    lengths[0] = 1;
+    return;
+  }
+
+  /*  First pass:  left to right, set parent pointers  */
+  lengths[0] += lengths[1];
+  for (next = 1; next < n - 1; next++) {
+    if ((leaf >= n) || (lengths[root] < lengths[leaf])) {
+      lengths[next] = lengths[root];
+      lengths[root++] = next;
+    }
+    else {
+      lengths[next] = lengths[leaf++];
+    }
+    if ((leaf >= n) || ((root < next) && (lengths[root] < lengths[leaf]))) {
+      lengths[next] += lengths[root];
+      lengths[root++] = next;
+    }
+    else {
+      lengths[next] += lengths[leaf++];
+    }
+  }
+
+  /*  Second pass:  right to left, set internal depths  */
+  lengths[n - 2] = 0;
+  for (i = (R_INT) n - 3; i >= 0; i--) {
+    lengths[i] = lengths[lengths[i]] + 1;
+  }
+
+  /*  Third pass:  right to left, set leaf depths  */
+  i = (R_INT) n - 2;
+  next = n - 1;
+  while (avbl > 0) {
+    while ((i >= 0) && (lengths[i] == dpth)) {
+      used++;
+      i--;
+    }
+    while (avbl > used) {
+      lengths[next--] = dpth;
+      avbl--;
+    }
+    avbl = used << 1;
+    dpth++;
+    used = 0;
+  }
+
+  return;
+}
+
+
+/*
+**  Limit the code lengths, in decreasing order, to limit bits.  Long
+**  codes are cut short, then the longest codes that are still below
+**  the limit are made longer until the Kraft sum is at most 1.  The
+**  lengths stay in decreasing order.
+*/
+static void limitCodeLengths (R_UINT *lengths, R_UINT n, R_UINT limit) {
+  R_ULL_INT kraft = 0;
+  R_UINT i = 0;
+
+  if (lengths[0] <= limit) {
+    return;
+  }
+
+  for (i = 0; i < n; i++) {
+    if (lengths[i] > limit) {
+      lengths[i] = limit;
+    }
+    kraft += 1ull << (limit - lengths[i]);
+  }
+
+  i = 0;
+  while (kraft > (1ull << limit)) {
+    while (lengths[i] == limit) {
+      i++;
+    }
+    lengths[i]++;
+    kraft -= 1ull << (limit - lengths[i]);
+  }
+
+  return;
+}
+
+
+/*
+**  Write the length of the code of each symbol, with runs of unused
+**  symbols shortened
+*/
+static void writeCodeLengths (BITOUTREC *w, const R_UCHAR *code_len, R_UINT alphabet_size) {
+  R_UINT run = 0;
+  R_UINT i = 0;
+
+  while (i < alphabet_size) {
+    writeBits (w, (R_UINT) code_len[i], HUFFMAN_LEN_BITS, R_FALSE);
+    if (code_len[i] != 0) {
+      i++;
+      continue;
+    }
+    run = 1;
+    while ((i + run < alphabet_size) && (code_len[i + run] == 0)) {
+      run++;
+    }
+    gammaEncode (w, run, 1);
+    i += run;
+  }
+
+  return;
+}
+
+
+/*
+**  Most bytes that huffmanEncode allocates for itself for an alphabet
+**  of alphabet_size symbols; the output is not included
+*/
+size_t huffmanScratchSize (R_UINT alphabet_size) {
+  return ((size_t) alphabet_size * (sizeof (R_UINT) + sizeof (HUFFSYMBOL) + sizeof (R_UCHAR) + sizeof (R_UINT)));
+}
+
+
+/*
+**  Write num_symbols symbols, each less than alphabet_size, with a
+**  canonical minimum-redundancy code for their frequencies.  The
+**  code is written first.  If sample_bits is not NULL, the offset in
+**  bits from the start of the output of the code of every
+**  sample_rate-th symbol is recorded in it.
+*/
+void huffmanEncode (BITOUTREC *w, const R_UINT *symbols, R_UINT num_symbols, R_UINT alphabet_size, R_UINT sample_rate, R_ULL_INT *sample_bits) {
+  R_ULL_INT start = w -> bitsWritten;
+  HUFFSYMBOL *used = NULL;
+  R_UINT *lengths = NULL;
+  R_UINT *codes = NULL;
+  R_UCHAR *code_len = NULL;
+  R_UINT len_count[HUFFMAN_LONGEST_CODE + 1];
+  R_UINT next_code[HUFFMAN_LONGEST_CODE + 1];
+  R_UINT num_used = 0;
+  R_UINT limit = HUFFMAN_MAX_CODE_LEN;
+  R_UINT code = 0;
+  R_UINT i = 0;
+
+  /*  Count the symbols; codes holds the frequencies for now  */
+  codes = wmalloc (sizeof (R_UINT) * alphabet_size);
+  for (i = 0; i < alphabet_size; i++) {
+    codes[i] = 0;
+  }
+  for (i = 0; i < num_symbols; i++) {
+    codes[symbols[i]]++;
+  }
+
+  used = wmalloc (sizeof (HUFFSYMBOL) * alphabet_size);
+  for (i = 0; i < alphabet_size; i++) {
+    if (codes[i] != 0) {
+      used[num_used].freq = codes[i];
+      used[num_used].symbol = i;
+      num_used++;
+    }
+  }
+
+  code_len = wmalloc (sizeof (R_UCHAR) * alphabet_size);
+  for (i = 0; i < alphabet_size; i++) {
+    code_len[i] = 0;
+  }
+
+  if (num_used > 0) {
+    qsort (used, (size_t) num_used, sizeof (HUFFSYMBOL), huffSymbolComparison);
+
+    lengths = wmalloc (sizeof (R_UINT) * num_used);
+    for (i = 0; i < num_used; i++) {
+      lengths[i] = used[i].freq;
+    }
+    calculateCodeLengths (lengths, num_used);
+    /*  There must be room for a code for each symbol used  */
+    while ((limit < HUFFMAN_LONGEST_CODE) && ((R_ULL_INT) num_used > (1ull << limit))) {
+      limit++;
+    }
+    limitCodeLengths (lengths, num_used, limit);
+    for (i = 0; i < num_used; i++) {
+      code_len[used[i].symbol] = (R_UCHAR) lengths[i];
+    }
+    wfree (lengths);
+  }
+  wfree (used);
+
+  /*  Assign the canonical codes:  shorter codes first, and in order
+  **  of symbol for codes of the same length  */
+  for (i = 0; i <= HUFFMAN_LONGEST_CODE; i++) {
+    len_count[i] = 0;
+  }
+  for (i = 0; i < alphabet_size; i++) {
+    len_count[code_len[i]]++;
+  }
+  len_count[0] = 0;
+  code = 0;
+  next_code[0] = 0;
+  for (i = 1; i <= HUFFMAN_LONGEST_CODE; i++) {
+    code = (code + len_count[i - 1]) << 1;
+    next_code[i] = code;
+  }
+  for (i = 0; i < alphabet_size; i++) {
+    if (code_len[i] != 0) {
+      codes[i] = next_code[code_len[i]]++;
+    }
+  }
+
+  writeCodeLengths (w, code_len, alphabet_size);
+  for (i = 0; i < num_symbols; i++) {
+    if ((sample_bits != NULL) && (i % sample_rate == 0)) {
+      sample_bits[i / sample_rate] = w -> bitsWritten - start;
+    }
+    writeBits (w, codes[symbols[i]], (R_UINT) code_len[symbols[i]], R_FALSE);
+  }
+
+  wfree (code_len);
+  wfree (codes);
+
+  return;
+}
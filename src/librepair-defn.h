@@ -0,0 +1,54 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef LIBREPAIR_DEFN_H
+#define LIBREPAIR_DEFN_H
+
+/******************************
+Structure definitions
+******************************/
+/*
+**  Context of the calls to the library (see librepair.h).  The thread
+**  making a call is given its error and allocation contexts for as
+**  long as the call lasts.
+*/
+struct librepair_context {
+  ERROR_CONTEXT error;
+  WMCONTEXT wm;
+};
+
+/*
+**  A call of the library into Re-Pair (repair.c) or Des-Pair
+**  (despair.c)
+*/
+typedef void (*LIBREPAIR_CALL) (const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, STREAM_SINK sink, void *sink_arg);
+
+/******************************
+Function prototypes
+******************************/
+void repairBuffer (const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, STREAM_SINK sink, void *sink_arg);
+void despairBuffer (const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, STREAM_SINK sink, void *sink_arg);
+
+#endif
@@ -0,0 +1,197 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "stream.h"
+#include "librepair.h"
+#include "librepair-defn.h"
+
+/*
+**  Output of repairToBuffer and despairToBuffer, which is given to
+**  the caller and so is allocated with malloc rather than wmalloc
+*/
+typedef struct librepair_buffer {
+  R_UCHAR *data;
+  size_t length;
+  size_t size;
+} LIBREPAIR_BUFFER;
+
+static R_INT runLibRepairCall (LIBREPAIR_CONTEXT *context, LIBREPAIR_CALL call, const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, STREAM_SINK sink, void *sink_arg);
+static R_INT writeLibRepairBuffer (void *sink_arg, const R_UCHAR *data, size_t length);
+static R_INT runLibRepairCallToBuffer (LIBREPAIR_CONTEXT *context, LIBREPAIR_CALL call, const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, R_UCHAR **out, size_t *out_length);
+
+
+/*
+**  Make a call with the thread's errors and allocations kept in the
+**  context.  Errors raised during the call return here, and whatever
+**  the call had allocated is freed.
+*/
+static R_INT runLibRepairCall (LIBREPAIR_CONTEXT *context, LIBREPAIR_CALL call, const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, STREAM_SINK sink, void *sink_arg) {
+  jmp_buf env;
+  R_INT result = LIBREPAIR_ERROR;
+
+  if (context == NULL) {
+    return (LIBREPAIR_ERROR);
+  }
+  if ((options == NULL) || ((in == NULL) && (in_length > 0)) || (sink == NULL)) {
+    strcpy (context -> error.message, "Error:  Options, input and output are required.");
+    return (LIBREPAIR_ERROR);
+  }
+
+  initWMContext (&(context -> wm));
+  context -> error.env = (void*) &env;
+  if ((setErrorContext (&(context -> error)) == R_FALSE) || (setWMContext (&(context -> wm)) == R_FALSE)) {
+    (void) setErrorContext (NULL);
+    strcpy (context -> error.message, "Error:  The context of the thread could not be set.");
+    return (LIBREPAIR_ERROR);
+  }
+
+  if (setjmp (env) == 0) {
+    call (options, in, in_length, sink, sink_arg);
+    result = LIBREPAIR_OK;
+  }
+
+  releaseWMContext (&(context -> wm));
+  (void) setWMContext (NULL);
+  (void) setErrorContext (NULL);
+  context -> error.env = NULL;
+
+  return (result);
+}
+
+
+static R_INT writeLibRepairBuffer (void *sink_arg, const R_UCHAR *data, size_t length) {
+  LIBREPAIR_BUFFER *buffer = (LIBREPAIR_BUFFER*) sink_arg;
+  R_UCHAR *grown = NULL;
+  size_t new_size = 0;
+
+  if (length > buffer -> size - buffer -> length) {
+    new_size = (buffer -> size > 0) ? buffer -> size : 4096;
+    while (new_size - buffer -> length < length) {
+      if (new_size > ((size_t) -1 >> 1)) {
+        return (1);
+      }
+      new_size <<= 1;
+    }
+    grown = realloc (buffer -> data, new_size);
+    if (grown == NULL) {
+      return (1);
+    }
+    buffer -> data = grown;
+    buffer -> size = new_size;
+  }
+  memcpy (buffer -> data + buffer -> length, data, length);
+  buffer -> length += length;
+
+  return (0);
+}
+
+
+static R_INT runLibRepairCallToBuffer (LIBREPAIR_CONTEXT *context, LIBREPAIR_CALL call, const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, R_UCHAR **out, size_t *out_length) {
+  LIBREPAIR_BUFFER buffer;
+  R_INT result = LIBREPAIR_ERROR;
+
+  buffer.data = NULL;
+  buffer.length = 0;
+  buffer.size = 0;
+  if ((out == NULL) || (out_length == NULL)) {
+    return (runLibRepairCall (context, call, options, in, in_length, NULL, NULL));
+  }
+
+  result = runLibRepairCall (context, call, options, in, in_length, writeLibRepairBuffer, &buffer);
+  if (result != LIBREPAIR_OK) {
+    free (buffer.data);
+    buffer.data = NULL;
+    buffer.length = 0;
+  }
+  *out = buffer.data;
+  *out_length = buffer.length;
+
+  return (result);
+}
+
+
+/*
+**  Contexts are made outside of any call, so they are allocated with
+**  malloc; returns NULL if there is no memory
+*/
+LIBREPAIR_CONTEXT *newLibRepairContext (void) {
+  LIBREPAIR_CONTEXT *context = malloc (sizeof (LIBREPAIR_CONTEXT));
+
+  if (context != NULL) {
+    context -> error.env = NULL;
+    context -> error.message[0] = '\0';
+    initWMContext (&(context -> wm));
+  }
+
+  return (context);
+}
+
+
+void deleteLibRepairContext (LIBREPAIR_CONTEXT *context) {
+  free (context);
+
+  return;
+}
+
+
+/*
+**  Return the message of the error of the last call with context, or
+**  an empty string if it succeeded
+*/
+const char *getLibRepairError (const LIBREPAIR_CONTEXT *context) {
+  if (context == NULL) {
+    return ("Error:  No context.");
+  }
+
+  return (context -> error.message);
+}
+
+
+int repairToSink (LIBREPAIR_CONTEXT *context, const LIBREPAIR_OPTIONS *options, const unsigned char *in, size_t in_length, LIBREPAIR_SINK sink, void *sink_arg) {
+  return (runLibRepairCall (context, repairBuffer, options, in, in_length, sink, sink_arg));
+}
+
+
+int repairToBuffer (LIBREPAIR_CONTEXT *context, const LIBREPAIR_OPTIONS *options, const unsigned char *in, size_t in_length, unsigned char **out, size_t *out_length) {
+  return (runLibRepairCallToBuffer (context, repairBuffer, options, in, in_length, out, out_length));
+}
+
+
+int despairToSink (LIBREPAIR_CONTEXT *context, const LIBREPAIR_OPTIONS *options, const unsigned char *in, size_t in_length, LIBREPAIR_SINK sink, void *sink_arg) {
+  return (runLibRepairCall (context, despairBuffer, options, in, in_length, sink, sink_arg));
+}
+
+
+int despairToBuffer (LIBREPAIR_CONTEXT *context, const LIBREPAIR_OPTIONS *options, const unsigned char *in, size_t in_length, unsigned char **out, size_t *out_length) {
+  return (runLibRepairCallToBuffer (context, despairBuffer, options, in, in_length, out, out_length));
+}
@@ -0,0 +1,114 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef LIBREPAIR_H
+#define LIBREPAIR_H
+
+/*
+**  Re-Pair and Des-Pair as a library (librepair), which compresses
+**  and decompresses data in memory.  Unlike the other headers, this
+**  one is given to programs which use the library, so it only uses
+**  the types of C itself.
+**
+**  Compressed data is the interleaved stream that Re-Pair writes to
+**  stdout (see stream.h), so "despair -i -" decompresses what the
+**  library compresses, and the library decompresses what "repair -i
+**  <file> -o -" writes.  With the container option, it is instead
+**  the container of "repair --container" (see container.h); either
+**  is decompressed.
+**
+**  Every call is given a context, which keeps the message of its
+**  error, if any.  A context is used by one thread at a time; calls
+**  made at once by several threads need a context each.  Blocks are
+**  compressed and decompressed one at a time by each call.
+**
+**  Calls return LIBREPAIR_OK, or LIBREPAIR_ERROR if an option is not
+**  valid, the compressed data is not valid, the sink did not take the
+**  output, or memory ran out.  All of the memory allocated by a call
+**  is freed when it returns, even after an error.
+*/
+
+#include <stddef.h>                                          /*  size_t  */
+
+/******************************
+Definitions
+******************************/
+#define LIBREPAIR_OK 0
+#define LIBREPAIR_ERROR (-1)
+
+/******************************
+Structure definitions
+******************************/
+typedef struct librepair_context LIBREPAIR_CONTEXT;
+
+/*
+**  Options of Re-Pair, with their command line option; those of
+**  Des-Pair must have the same base_datatype.  The defaults are set by
+**  initLibRepairOptions.
+*/
+typedef struct librepair_options {
+  unsigned int base_datatype;     /*  Bytes per symbol:  1, 2 or 4 (-t)  */
+  unsigned int max_buffer_size;                /*  Blocksize (-b)  */
+  unsigned int max_length;            /*  Length limit on phrases (-l)  */
+  unsigned int max_phrases;        /*  Maximum number of phrases (-p)  */
+  unsigned int max_keep_count;
+          /*  Minimum number of occurrences before replacement (-x)  */
+  unsigned int apply_heuristics;              /*  Pairing heuristic (-e)  */
+  unsigned int seq_coding;              /*  Coding of the sequence (-c)  */
+  int add_prims;           /*  Add primitives to generation 0 (-a)  */
+  int container;                     /*  Write a container (--container)  */
+} LIBREPAIR_OPTIONS;
+
+/*
+**  A sink is given the output of a call, in order, in pieces.  It
+**  returns 0 if it took all of the piece; otherwise, the call stops
+**  with an error.
+*/
+typedef int (*LIBREPAIR_SINK) (void *sink_arg, const unsigned char *data, size_t length);
+
+/******************************
+Function prototypes
+******************************/
+void initLibRepairOptions (LIBREPAIR_OPTIONS *options);
+LIBREPAIR_CONTEXT *newLibRepairContext (void);
+void deleteLibRepairContext (LIBREPAIR_CONTEXT *context);
+const char *getLibRepairError (const LIBREPAIR_CONTEXT *context);
+
+/*
+**  Compress in_length bytes at in, which must be aligned for the data
+**  type; any partial symbol at the end is ignored.  As with Re-Pair,
+**  empty input (in_length of 0) is an error.
+*/
+int repairToSink (LIBREPAIR_CONTEXT *context, const LIBREPAIR_OPTIONS *options, const unsigned char *in, size_t in_length, LIBREPAIR_SINK sink, void *sink_arg);
+int repairToBuffer (LIBREPAIR_CONTEXT *context, const LIBREPAIR_OPTIONS *options, const unsigned char *in, size_t in_length, unsigned char **out, size_t *out_length);
+
+/*
+**  Decompress the stream or container of in_length bytes at in.  The
+**  data type of a container is that of its header, not base_datatype.
+*/
+int despairToSink (LIBREPAIR_CONTEXT *context, const LIBREPAIR_OPTIONS *options, const unsigned char *in, size_t in_length, LIBREPAIR_SINK sink, void *sink_arg);
+int despairToBuffer (LIBREPAIR_CONTEXT *context, const LIBREPAIR_OPTIONS *options, const unsigned char *in, size_t in_length, unsigned char **out, size_t *out_length);
+
+#endif
@@ -25,13 +25,184 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <getopt.h>                                      /*  getopt_long  */
+#include <pthread.h>
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "stats.h"
 #include "despair-defn.h"
 #include "despair.h"
 #include "main-despair.h"
 
+/*  Long options, which have no single-letter equivalent  */
+#define OPT_STATS_JSON 0x100
+#define OPT_PERF_COUNTERS 0x101
+#define OPT_CHECK 0x102
+
+static struct option long_options[] = {
+  {"stats-json", required_argument, NULL, OPT_STATS_JSON},
+  {"perf-counters", no_argument, NULL, OPT_PERF_COUNTERS},
+  {"check", no_argument, NULL, OPT_CHECK},
+  {NULL, 0, NULL, 0}
+};
+
+static void usage (ARGS_INFO *args_struct);
+
+
+/*
+**  Print out usage information
+*/
+static void usage (ARGS_INFO *args_struct) {
+  fprintf (stderr, "Des-Pair\n");
+  fprintf (stderr, "========\n\n");
+  fprintf (stderr, "Usage:  %s [options]\n\n", args_struct -> progname);
+  fprintf (stderr, "Options:\n");
+  fprintf (stderr, "-i <file>    :  Input filename; - for the interleaved output\n");
+  fprintf (stderr, "                or container of Re-Pair on stdin  [Required]\n");
+  fprintf (stderr, "-j <threads> :  Number of blocks decoded at once, using the\n");
+  fprintf (stderr, "                .idx file written by Re-Pair  [default:  1]\n");
+  fprintf (stderr, "-l <length>  :  Extract only length symbols to standard output,\n");
+  fprintf (stderr, "                using the .idx file written by Re-Pair\n");
+  fprintf (stderr, "-o <offset>  :  Position of the first symbol extracted  [default:  0]\n");
+  fprintf (stderr, "-t <type>    :  Input data type [1 (default), 2, or 4]\n");
+  fprintf (stderr, "-v           :  Verbose output\n");
+  fprintf (stderr, "--stats-json <file> :  Write the time of each phase and other\n");
+  fprintf (stderr, "                statistics of each block to file, in JSON\n");
+  fprintf (stderr, "--perf-counters :  Count cycles, instructions, cache and TLB misses\n");
+  fprintf (stderr, "                and branch misses of each phase (with -v or --stats-json)\n");
+  fprintf (stderr, "--check      :  Check the checksums of a container (<file.rp>,\n");
+  fprintf (stderr, "                written by repair --container) without decoding it\n");
+  fprintf (stderr, "\nIf <file.prel> is not found, the container <file.rp> is read instead.\n\n");
+  fprintf (stderr, "Des-Pair version:  %s (%s)\n\n", __DATE__, __TIME__);
+  exit (EXIT_FAILURE);
+}
+
+
+ARGS_INFO *parseArguments (int argc, char *argv[], ARGS_INFO *args_struct) {
+  /*  Declarations required for getopt  */
+  R_INT c;
+  R_INT option_index = 0;
+
+  args_struct -> progname = argv[0];
+  args_struct -> base_filename = NULL;
+  args_struct -> stats_filename = NULL;
+  args_struct -> base_datatype = (R_UINT) sizeof (R_UCHAR);
+  args_struct -> verbose_level = R_FALSE;
+  args_struct -> perf_counters = R_FALSE;
+  args_struct -> num_threads = 1;
+  args_struct -> extract = R_FALSE;
+  args_struct -> extract_offset = 0;
+  args_struct -> extract_length = 0;
+  args_struct -> check = R_FALSE;
+
+  /*  Print usage information if no arguments  */
+  if (argc == 1) {
+    usage (args_struct);
+  }
+
+  /*  Check arguments  */
+  while (R_TRUE) {
+    c = getopt_long (argc, argv, "i:j:l:o:t:v?", long_options, &option_index);
+    if (c == EOF) {
+      break;
+    }
+
+    switch (c) {
+    case 0:
+      break;
+    case 'i':
+      args_struct -> base_filename = optarg;
+      break;
+    case 'j':
+      args_struct -> num_threads = (R_UINT) atoi (optarg);
+      if ((args_struct -> num_threads < 1) || (args_struct -> num_threads > MAX_NUM_THREADS)) {
+        fprintf (stderr, "Number of threads (-j) must be between 1 and %u.\n", MAX_NUM_THREADS);
+        exit (EXIT_FAILURE);
+      }
+      break;
+    case 'l':
+      args_struct -> extract = R_TRUE;
+      args_struct -> extract_length = strtoull (optarg, NULL, 10);
+      break;
+    case 'o':
+      args_struct -> extract_offset = strtoull (optarg, NULL, 10);
+      break;
+    case 't':
+      args_struct -> base_datatype = (R_UINT) atoi (optarg);
+      if ((args_struct -> base_datatype != (R_UINT) sizeof (R_UCHAR)) && 
+          (args_struct -> base_datatype != (R_UINT) sizeof (R_USHRT)) &&
+          (args_struct -> base_datatype != (R_UINT) sizeof (R_UINT))) {
+        fprintf (stderr, "Input data type (-t) not valid.\n");
+        exit (EXIT_FAILURE);
+      }
+      break;
+    case 'v':
+      args_struct -> verbose_level = R_TRUE;
+      break;
+    case OPT_STATS_JSON:
+      args_struct -> stats_filename = optarg;
+      break;
+    case OPT_PERF_COUNTERS:
+      args_struct -> perf_counters = R_TRUE;
+      break;
+    case OPT_CHECK:
+      args_struct -> check = R_TRUE;
+      break;
+    case '?':
+      usage (args_struct);
+      break;
+    default:
+      fprintf (stderr, "Unexpected error:  getopt returned character code 0%d.\n", c);
+      exit (EXIT_FAILURE);
+    }
+
+  }  /*  while  */
+
+  if (optind < argc) {
+    fprintf (stderr, "The following arguments were not valid:  ");
+    while (optind < argc) {
+      fprintf (stderr, "%s ", argv[optind++]);
+    }
+    fprintf (stderr, "\nRun %s with the -? option for help.\n", args_struct -> progname);
+    exit (EXIT_FAILURE);
+  }
+
+  /*  Check for input filename  */
+  if (args_struct -> base_filename == NULL) {
+    fprintf (stderr, "Error.  Input filename required with the -i option.\n");
+    fprintf (stderr, "\nRun %s with the -? option for help.\n", args_struct -> progname);
+    exit (EXIT_FAILURE);
+  }
+
+  if ((args_struct -> check == R_TRUE) && (args_struct -> extract == R_TRUE)) {
+    fprintf (stderr, "Error.  Containers can not be checked (--check) while extracting (-l).\n");
+    exit (EXIT_FAILURE);
+  }
+
+  /*  An interleaved stream has no index and is decoded to stdout  */
+  if (strcmp (args_struct -> base_filename, STDIO_FILENAME) == 0) {
+    if (args_struct -> extract == R_TRUE) {
+      fprintf (stderr, "Error.  Symbols can not be extracted from stdin (-l).\n");
+      exit (EXIT_FAILURE);
+    }
+    args_struct -> num_threads = 1;
+    args_struct -> verbose_level = R_FALSE;
+  }
+
+#ifdef COUNT_MALLOC
+  /*  The malloc counters in wmalloc.c are not thread-safe  */
+  if (args_struct -> num_threads > 1) {
+    fprintf (stderr, "Blocks decoded one at a time due to COUNT_MALLOC.\n");
+    args_struct -> num_threads = 1;
+  }
+#endif
+
+  return (args_struct);
+}
+
+
 R_INT main (R_INT argc, R_CHAR *argv[]) {
   PROG_INFO *prog_struct = NULL;
   BLOCK_INFO *block_struct = NULL;
@@ -60,7 +231,12 @@ R_INT main (R_INT argc, R_CHAR *argv[]) {
 
   initDespair (prog_struct, block_struct);
 
-  executeDespair_File (prog_struct, block_struct);
+  if (args_struct -> check == R_TRUE) {
+    checkDespair (prog_struct);
+  }
+  else {
+    executeDespair_File (prog_struct, block_struct);
+  }
 
   uninitDespair (prog_struct, block_struct);
 
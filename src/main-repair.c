@@ -25,13 +25,300 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>                                         /*  UINT_MAX  */
+#include <string.h>
+#include <getopt.h>                                      /*  getopt_long  */
+#include <sys/stat.h>
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
 #include "repair-defn.h"
+#include "seqformat.h"
 #include "repair.h"
 #include "main-repair.h"
 
+/*  Long options, which have no single-letter equivalent  */
+#define OPT_STATS_JSON 0x100
+#define OPT_PERF_COUNTERS 0x101
+#define OPT_CONTAINER 0x102
+
+static struct option long_options[] = {
+  {"stats-json", required_argument, NULL, OPT_STATS_JSON},
+  {"perf-counters", no_argument, NULL, OPT_PERF_COUNTERS},
+  {"container", no_argument, NULL, OPT_CONTAINER},
+  {NULL, 0, NULL, 0}
+};
+
+static void usage (ARGS_INFO *args_struct);
+
+
+/*
+**  Print out usage information
+*/
+static void usage (ARGS_INFO *args_struct) {
+  fprintf (stderr, "Re-Pair (Recursive Pairing)\n");
+  fprintf (stderr, "===========================\n\n");
+  fprintf (stderr, "Usage:  %s [options]\n\n", args_struct -> progname);
+  fprintf (stderr, "Options:\n");
+  fprintf (stderr, "-a           :  Add primitives to generation 0.\n");
+  fprintf (stderr, "-b <size>    :  Blocksize\t\t\t[default:  %u]\n", args_struct -> max_buffer_size);
+  fprintf (stderr, "-c <coding>  :  Coding of the sequence.\t[default:  0]\n");
+  fprintf (stderr, "           0  : 4-byte integers\n");
+  fprintf (stderr, "           1  : Canonical Huffman code per block\n");
+  fprintf (stderr, "           2  : Bit-packed, sized to each block\n");
+  fprintf (stderr, "-f           :  Use punctuation flags for word-based parsing.\n");
+  fprintf (stderr, "-i <file>    :  Input filename; - for stdin\t[Required]\n");
+  fprintf (stderr, "-j <threads> :  Number of blocks compressed at once\t[default:  %u]\n", args_struct -> num_threads);
+  fprintf (stderr, "-e <level>   :  Pairing heuristic.\t\t[default:  0]\n");
+  fprintf (stderr, "           0  : No heuristic\n");
+  fprintf (stderr, "           1  : Word-aligned Re-Pair\n");
+  fprintf (stderr, "           2  : Obey which side symbol is on\n");
+  fprintf (stderr, "           3  : No recursion\n");
+  fprintf (stderr, "-l <length>  :  Length limit on phrases.\t[default:  %u]\n", args_struct -> max_length);
+  fprintf (stderr, "-o <file>    :  Base filename of the output; - for stdout\n");
+  fprintf (stderr, "-p <phrases> :  Maximum number of phrases\t[default:  %u]\n", args_struct -> max_phrases);
+  fprintf (stderr, "-t <type>    :  Input data type \t\t[1 (default), 2, or 4]\n");
+  fprintf (stderr, "-v           :  Verbose output\n");
+  fprintf (stderr, "-w           :  Do word length counting to .wl file.\n");
+  fprintf (stderr, "-x <count>   :  Minimum number of occurances before replacement\n\t\t\t\t\t[default:  %u]\n", args_struct -> max_keep_count);
+  fprintf (stderr, "--stats-json <file> :  Write the time of each phase and other\n\t\t\t\tstatistics of each block to file, in JSON.\n");
+  fprintf (stderr, "--perf-counters :  Count cycles, instructions, cache and TLB misses\n\t\t\t\tand branch misses of each phase (with -v or\n\t\t\t\t--stats-json).\n");
+  fprintf (stderr, "--container  :  Write one file, <filename.rp>, with checksums,\n\t\t\t\tin place of the .prel, .seq and .idx files.\n");
+  fprintf (stderr, "\nDefault sequence file is <filename.seq>.\n");
+  fprintf (stderr, "Default phrase hierarchy file is <filename.prel>.\n");
+  fprintf (stderr, "With stdin and no -o, both are interleaved to stdout\n(or the container is written to stdout, with --container).\n\n");
+
+  fprintf (stderr, "Re-Pair version:  %s (%s)\n\n", __DATE__, __TIME__);
+
+  exit (EXIT_SUCCESS);
+}
+
+
+/*
+**  Parse arguments and use them to set numerous variables in the
+**  structures.
+*/
+ARGS_INFO *parseArguments (R_INT argc, R_CHAR *argv[], ARGS_INFO *args_struct) {
+  /*  Declarations required for getopt  */
+  R_INT c;
+  R_INT option_index = 0;
+  R_UINT i = 0;
+  R_UINT *buf = NULL;
+  FILE *fp = NULL;
+  R_UINT items = 0;
+  R_UINT maxsym = 0;
+  struct stat statbuffer;
+
+  args_struct -> base_filename = NULL;
+
+  if (args_struct == NULL) {
+    fprintf (stderr, "Structure ARGS_INFO needs to be malloc'ed in [%s] on line %d.\n", __FILE__, __LINE__);
+    exit (EXIT_FAILURE);
+  }
+
+  /*  Initialize variables  */
+  args_struct -> progname = NULL;
+  args_struct -> max_buffer_size = MAX_BUFFER_SIZE;
+  args_struct -> prel_text_file = NULL;
+  args_struct -> base_filename = NULL;
+  args_struct -> out_filename = NULL;
+  args_struct -> stats_filename = NULL;
+  args_struct -> apply_heuristics = HEUR_NONE;
+  args_struct -> word_flags = UW_NO;
+  args_struct -> add_prims = R_FALSE;
+  args_struct -> max_length = UINT_MAX;
+  args_struct -> max_phrases = UINT_MAX;
+  args_struct -> verbose_level = R_FALSE;
+  args_struct -> perf_counters = R_FALSE;
+  args_struct -> container = R_FALSE;
+  args_struct -> max_keep_count = MIN_KEEP_COUNT;
+  args_struct -> base_datatype = (R_UINT) sizeof (R_UCHAR);
+  args_struct -> max_prims = MIN_PRIMS_ARRAY;
+  args_struct -> dowordlen = R_FALSE;
+  args_struct -> num_threads = 1;
+  args_struct -> seq_coding = SEQ_CODING_RAW;
+
+  /*
+  **  Initialize to the name of the program
+  */
+  args_struct -> progname = argv[0];
+
+  /*  Print usage information if no arguments  */
+  if (argc == 1) {
+    usage (args_struct);
+  }
+
+  while (R_TRUE) {
+    c = getopt_long (argc, argv, "ab:c:fe:i:j:l:o:p:t:vwx:?", long_options, &option_index);
+    if (c == EOF) {
+      break;
+    }
+
+    switch (c) {
+    case 'a':
+      args_struct -> add_prims = R_TRUE;
+      break;
+    case 'b':
+      if (strtoull (optarg, NULL, 10) > (R_ULL_INT) MAX_BUFFER_SIZE) {
+        fprintf (stderr, "Option with -b must be less than or equal to MAX_BUFFER_SIZE\n");
+        exit (EXIT_FAILURE);
+      }
+      args_struct -> max_buffer_size = (R_UINT) strtoull (optarg, NULL, 10);
+      break;
+    case 'c':
+      args_struct -> seq_coding = (R_UINT) atoi (optarg);
+      if ((args_struct -> seq_coding != SEQ_CODING_RAW) && (args_struct -> seq_coding != SEQ_CODING_HUFFMAN) && (args_struct -> seq_coding != SEQ_CODING_PACKED)) {
+        fprintf (stderr, "Sequence coding (-c) not valid.\n");
+        exit (EXIT_FAILURE);
+      }
+      break;
+    case 'f':
+      args_struct -> word_flags = UW_YES;
+      break;
+    case 'e':
+      args_struct -> apply_heuristics = atoi (optarg);
+      break;
+    case 'i':
+      args_struct -> base_filename = optarg;
+      break;
+    case 'j':
+      args_struct -> num_threads = (R_UINT) atoi (optarg);
+      if ((args_struct -> num_threads < 1) || (args_struct -> num_threads > MAX_NUM_THREADS)) {
+        fprintf (stderr, "The value for -j must be between 1 and %u.\n", MAX_NUM_THREADS);
+        exit (EXIT_FAILURE);
+      }
+      break;
+    case 'l':
+      args_struct -> max_length = (R_UINT) atoi (optarg);
+      break;
+    case 'o':
+      args_struct -> out_filename = optarg;
+      break;
+    case 'p':
+      args_struct -> max_phrases = (R_UINT) atoi (optarg);
+      break;
+    case 't':
+      args_struct -> base_datatype = (R_UINT) atoi (optarg);
+      if ((args_struct -> base_datatype != (R_UINT) sizeof (R_UCHAR)) && 
+          (args_struct -> base_datatype != (R_UINT) sizeof (R_USHRT)) &&
+          (args_struct -> base_datatype != (R_UINT) sizeof (R_UINT))) {
+        fprintf (stderr, "Input data type (-t) not valid.\n");
+        exit (EXIT_FAILURE);
+      }
+      break;
+    case 'v':
+      args_struct -> verbose_level = R_TRUE;
+      break;
+    case 'w':
+      args_struct -> dowordlen = R_TRUE;
+      break;
+    case 'x':
+      args_struct -> max_keep_count = (R_UINT) atoi (optarg);
+      if (args_struct -> max_keep_count < MIN_KEEP_COUNT) {
+        fprintf (stderr, "The value for -x can not be less than MIN_KEEP_COUNT.\n");
+        exit (EXIT_FAILURE);
+      }
+      break;
+    case OPT_STATS_JSON:
+      args_struct -> stats_filename = optarg;
+      break;
+    case OPT_PERF_COUNTERS:
+      args_struct -> perf_counters = R_TRUE;
+      break;
+    case OPT_CONTAINER:
+      args_struct -> container = R_TRUE;
+      break;
+    case '?':
+      usage (args_struct);
+      break;
+    default:
+      fprintf (stderr, "getopt returned erroneous character code.\n");
+      exit (EXIT_FAILURE);
+    }
+  }
+
+  if (optind < argc) {
+    fprintf (stderr, "The following arguments were not valid:  ");
+    while (optind < argc) {
+      fprintf (stderr, "%s ", argv[optind++]);
+    }
+    fprintf (stderr, "Run program with the -? option for help.\n");
+    exit (EXIT_FAILURE);
+  }
+
+  if (args_struct -> base_filename == NULL) {
+    fprintf (stderr, "Input filename required with the -i option.");
+    exit (EXIT_FAILURE);
+  }
+
+  if ((args_struct -> apply_heuristics == HEUR_WA) && (args_struct -> base_datatype != (R_UINT) sizeof (R_UCHAR))) {
+    fprintf (stderr, "Word-aligned parsing with the specified data type is not possible.");
+    exit (EXIT_FAILURE);
+  }
+
+  if ((args_struct -> word_flags == UW_YES) && (args_struct -> base_datatype != (R_UINT) sizeof (R_UINT))) {
+    fprintf (stderr, "Word-based parsing with punctuation flags not possible with the specified data type.");
+    exit (EXIT_FAILURE);
+  }
+
+  /*  Punctuation flags are kept in the top bit of the 4-byte integers  */
+  if ((args_struct -> word_flags == UW_YES) && (args_struct -> seq_coding != SEQ_CODING_RAW)) {
+    fprintf (stderr, "Punctuation flags (-f) can only be used with 4-byte integers in the sequence (-c 0).\n");
+    exit (EXIT_FAILURE);
+  }
+
+  /*  Every block rewrites the same .wl file, so blocks must be done in turn  */
+  if ((args_struct -> dowordlen == R_TRUE) && (args_struct -> num_threads > 1)) {
+    fprintf (stderr, "Word length counting (-w) can not be used with more than one thread (-j).\n");
+    exit (EXIT_FAILURE);
+  }
+
+#ifdef COUNT_MALLOC
+  /*  The allocation records in wmalloc.c are not thread-safe  */
+  if (args_struct -> num_threads > 1) {
+    fprintf (stderr, "Memory counting (COUNT_MALLOC) enabled; using only one thread.\n");
+    args_struct -> num_threads = 1;
+  }
+#endif
+
+  /*  Every block rewrites the same .wl file, which needs a name  */
+  if ((args_struct -> dowordlen == R_TRUE) && (strcmp (args_struct -> base_filename, STDIO_FILENAME) == 0) && (args_struct -> out_filename == NULL)) {
+    fprintf (stderr, "Word length counting (-w) requires an output filename (-o) when reading from stdin.\n");
+    exit (EXIT_FAILURE);
+  }
+  if ((args_struct -> dowordlen == R_TRUE) && (args_struct -> out_filename != NULL) && (strcmp (args_struct -> out_filename, STDIO_FILENAME) == 0)) {
+    fprintf (stderr, "Word length counting (-w) can not be used with output to stdout.\n");
+    exit (EXIT_FAILURE);
+  }
+
+  /*  Determine the largest symbol.  A stream can only be read once, so
+  **  its primitives array grows as symbols arrive instead.  */
+  if ((args_struct -> base_datatype == (R_UINT) sizeof (R_UINT)) &&
+      (strcmp (args_struct -> base_filename, STDIO_FILENAME) != 0) &&
+      (stat (args_struct -> base_filename, &statbuffer) == 0) && (S_ISREG (statbuffer.st_mode))) {
+    FOPEN (args_struct -> base_filename, fp, "r");
+    buf = wmalloc (sizeof (R_UINT) * INPUT_BUFFER_SIZE);
+    maxsym = 0;
+    do {
+      items = (R_UINT) fread (buf, sizeof (R_UINT), (size_t) INPUT_BUFFER_SIZE, fp);
+      for (i = 0; i < items; i++) {
+	buf[i] = buf[i] & NO_FLAGS;
+        if (buf[i] > maxsym) {
+	  maxsym = buf[i];
+	}
+      }
+    } while (feof (fp) == R_FALSE);
+    wfree (buf);
+    FCLOSE (fp);
+    args_struct -> max_prims = maxsym + 1;
+  }
+
+  return (args_struct);
+}
+
+
 R_INT main (R_INT argc, R_CHAR *argv[]) {
   PROG_INFO *prog_struct = NULL;
   BLOCK_INFO *block_struct = NULL;
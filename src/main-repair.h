@@ -26,6 +26,10 @@
 #ifndef MAIN_REPAIR_H
 #define MAIN_REPAIR_H
 
+/******************************
+Function prototypes
+******************************/
+ARGS_INFO *parseArguments (R_INT argc, R_CHAR *argv[], ARGS_INFO *args_struct);
 
 #endif
 
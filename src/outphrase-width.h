@@ -0,0 +1,168 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+/*
+**  Expansion of phrases into an output buffer of one width.  This file
+**  has no include guard; outphrase.c includes it once for each output
+**  datatype, with OUT_TYPE set to the type of a symbol and OUT_NAME(F)
+**  giving the name of function F for that type.
+*/
+
+/*
+**  Copy n symbols from pos into the output buffer at out_p, and return
+**  the new position.  The buffer is written out only when a symbol
+**  does not fit, so a phrase that ends exactly at the end of the
+**  buffer is still there afterwards.
+*/
+static OUT_TYPE *OUT_NAME (copyPhrase) (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, OUT_TYPE *out_p, const OUT_TYPE *pos, R_UINT n) {
+  OUT_TYPE *out_end = block_struct -> out_buf_end;
+  R_UINT symbols_to_copy = 0;
+
+  symbols_to_copy = (R_UINT) (out_end - out_p);
+  while (n > symbols_to_copy) {
+    memcpy (out_p, pos, sizeof (OUT_TYPE) * symbols_to_copy);
+    writeOutputFile (prog_struct, block_struct, OUT_BUF_SIZE);
+    n = n - symbols_to_copy;
+    pos = pos + symbols_to_copy;
+    out_p = block_struct -> out_buf;
+    block_struct -> buffer_num++;
+    symbols_to_copy = (R_UINT) (out_end - out_p);
+  }
+  memcpy (out_p, pos, sizeof (OUT_TYPE) * n);
+
+  return (out_p + n);
+}
+
+
+#ifdef FAVOUR_TIME_EXPAND
+static void OUT_NAME (outPhrase) (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i) {
+  /*  Expand from buffer  */
+  block_struct -> out_buf_p = OUT_NAME (copyPhrase) (prog_struct, block_struct, block_struct -> out_buf_p, block_struct -> phrases_array[i].pos, block_struct -> phrases_array[i].len);
+
+  return;
+}
+#endif
+
+
+#if defined (NORMAL_EXPAND) || defined (FAVOUR_MEMORY_EXPAND)
+
+#ifndef RECURSIVE_EXPAND
+/*
+**  Expand phrase i with an explicit stack instead of recursion, so
+**  that the depth of the hierarchy does not matter.  Each phrase that
+**  is not in the output buffer is replaced on the stack by its right
+**  child, its left child (on top), and a marker to finish the phrase
+**  once both have been written.  Finishing records its length and,
+**  if all of it is still in the buffer, its buffer number so that
+**  later occurrences are copied.  This visits the phrases in the same
+**  order as the recursive version.
+*/
+static void OUT_NAME (outPhrase) (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i) {
+  PAIR *phrases = block_struct -> phrases_array;
+  R_UINT *stack = block_struct -> expand_stack;
+  R_UINT top = 0;
+  R_UINT num_prims = block_struct -> num_prims;
+  const OUT_TYPE *prims = block_struct -> prims_buf;
+  OUT_TYPE *out_p = block_struct -> out_buf_p;
+  OUT_TYPE *out_end = block_struct -> out_buf_end;
+  PAIR *ph;
+
+  stack[top++] = i;
+  while (top != 0) {
+    i = stack[--top];
+
+    /*  Both children written; finish the phrase  */
+    if ((i & EXPAND_FINISH) != 0) {
+      ph = &phrases[i & ~EXPAND_FINISH];
+      if (ph -> len == 0) {
+        ph -> len = phrases[ph -> left].len + phrases[ph -> right].len;
+      }
+      if ((out_end - (OUT_TYPE*) ph -> pos) >= ph -> len) {
+        ph -> buffer_num = block_struct -> buffer_num;
+      }
+      continue;
+    }
+
+    /*  Primitive; write it straight into the buffer  */
+    if (i < num_prims) {
+      if (out_p == out_end) {
+        writeOutputFile (prog_struct, block_struct, OUT_BUF_SIZE);
+        out_p = block_struct -> out_buf;
+        block_struct -> buffer_num++;
+      }
+      *out_p = prims[i];
+      out_p++;
+      continue;
+    }
+
+    ph = &phrases[i];
+    if (ISBUFFERED (ph)) {
+      /*  Expand from buffer  */
+      if ((R_UINT) (out_end - out_p) >= ph -> len) {
+        memcpy (out_p, ph -> pos, sizeof (OUT_TYPE) * ph -> len);
+        out_p += ph -> len;
+      }
+      else {
+        out_p = OUT_NAME (copyPhrase) (prog_struct, block_struct, out_p, ph -> pos, ph -> len);
+      }
+    }
+    else {
+      ph -> pos = out_p;
+      stack[top++] = i | EXPAND_FINISH;
+      stack[top++] = ph -> right;
+      stack[top++] = ph -> left;
+    }
+  }
+  block_struct -> out_buf_p = out_p;
+
+  return;
+}
+
+#else
+static void OUT_NAME (outPhrase) (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i) {
+  PAIR *ph = &(block_struct -> phrases_array[i]);
+
+  /*  Expand from buffer  */
+  if (ISBUFFERED (ph)) {
+    block_struct -> out_buf_p = OUT_NAME (copyPhrase) (prog_struct, block_struct, block_struct -> out_buf_p, ph -> pos, ph -> len);
+  }
+  /*  Not found in buffer; recursively decode  */
+  else {
+    ph -> pos = block_struct -> out_buf_p;
+    OUT_NAME (outPhrase) (prog_struct, block_struct, ph -> left);
+    OUT_NAME (outPhrase) (prog_struct, block_struct, ph -> right);
+    /*  Calculate length of phrase  */
+    if (ph -> len == 0) {
+      ph -> len = block_struct -> phrases_array[ph -> left].len + block_struct -> phrases_array[ph -> right].len;
+    }
+    if (((OUT_TYPE*) block_struct -> out_buf_end - (OUT_TYPE*) ph -> pos) >= ph -> len) {
+      ph -> buffer_num = block_struct -> buffer_num;
+    }
+  }
+
+  return;
+}
+#endif
+
+#endif
@@ -27,120 +27,62 @@
 #include <string.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include "common-def.h"
+#include "stats.h"
 #include "despair-defn.h"
 #include "despair.h"
 #include "outphrase.h"
 
-#ifdef FAVOUR_TIME_EXPAND
-void outPhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i) {
-  R_UINT *pos;
-  R_UINT n;
-  R_UINT bytes_to_copy = 0;
-
-  /*  Expand from buffer  */
-  pos = block_struct -> phrases_array[i].pos;
-  n = block_struct -> phrases_array[i].len;
-  bytes_to_copy = block_struct -> out_buf_end - block_struct -> out_buf_p;
-  while (n > bytes_to_copy) {
-    memcpy (block_struct -> out_buf_p, pos, sizeof (R_UINT) * bytes_to_copy);
-    writeOutputFile (prog_struct, block_struct, OUT_BUF_SIZE);
-    n = n - bytes_to_copy;
-    pos = pos + bytes_to_copy;
-    block_struct -> out_buf_p = block_struct -> out_buf;
-    block_struct -> buffer_num++;
-    bytes_to_copy = block_struct -> out_buf_end - block_struct -> out_buf_p;
-  }
-  memcpy (block_struct -> out_buf_p, pos, (sizeof (R_UINT) * n));
-  block_struct -> out_buf_p += n;
-
-  return;
-}
-#endif
-
-
-#ifdef FAVOUR_MEMORY_EXPAND
-void outPhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i) {
-  R_UINT *pos;
-  R_UINT n;
-  R_UINT bytes_to_copy = 0;
-
-  /*  Expand from buffer  */
-  if (block_struct -> phrases_array[i].buffer_num == UINT_MAX) {
-    pos = block_struct -> phrases_array[i].pos;
-    n = block_struct -> phrases_array[i].len;
-    bytes_to_copy = block_struct -> out_buf_end - block_struct -> out_buf_p;
-    while (n > bytes_to_copy) {
-      memcpy (block_struct -> out_buf_p, pos, sizeof (R_UINT) * bytes_to_copy);
-      writeOutputFile (prog_struct, block_struct, OUT_BUF_SIZE);
-      n = n - bytes_to_copy;
-      pos = pos + bytes_to_copy;
-      block_struct -> out_buf_p = block_struct -> out_buf;
-      block_struct -> buffer_num++;
-      bytes_to_copy = block_struct -> out_buf_end - block_struct -> out_buf_p;
-    }
-    memcpy (block_struct -> out_buf_p, pos, (sizeof (R_UINT) * n));
-    block_struct -> out_buf_p += n;
-  }
-  /*  Not found in buffer; recursively decode  */
-  else {
-    block_struct -> phrases_array[i].pos = block_struct -> out_buf_p;
-    outPhrase (prog_struct, block_struct, block_struct -> phrases_array[i].left);
-    outPhrase (prog_struct, block_struct, block_struct -> phrases_array[i].right);
-    /*  Calculate length of phrase  */
-    if (block_struct -> phrases_array[i].len == 0) {
-      block_struct -> phrases_array[i].len = block_struct -> phrases_array[block_struct -> phrases_array[i].left].len + block_struct -> phrases_array[block_struct -> phrases_array[i].right].len;
-    }
-    if ((block_struct -> out_buf_end - block_struct -> phrases_array[i].pos) >= block_struct -> phrases_array[i].len) {
-      block_struct -> phrases_array[i].buffer_num = block_struct -> buffer_num;
-    }
-  }
+static void outPhrase_c (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i);
+static void outPhrase_s (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i);
+static void outPhrase_i (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i);
+static R_UCHAR *copyPhrase_c (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UCHAR *out_p, const R_UCHAR *pos, R_UINT n);
+static R_USHRT *copyPhrase_s (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_USHRT *out_p, const R_USHRT *pos, R_UINT n);
+static R_UINT *copyPhrase_i (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT *out_p, const R_UINT *pos, R_UINT n);
 
-  return;
-}
+/*  Can phrase P be copied from where it was last expanded?  */
+#ifdef NORMAL_EXPAND
+#define ISBUFFERED(P) ((P) -> buffer_num >= block_struct -> buffer_num)
+#else
+#define ISBUFFERED(P) ((P) -> buffer_num == UINT_MAX)
 #endif
 
+/*
+**  Phrases are expanded straight into a buffer of the output datatype
+**  (-t), so that nothing has to be narrowed before it is written out.
+**  The expansion is compiled once for each datatype.
+*/
+#define OUT_TYPE R_UCHAR
+#define OUT_NAME(F) F ## _c
+#include "outphrase-width.h"
+#undef OUT_TYPE
+#undef OUT_NAME
+
+#define OUT_TYPE R_USHRT
+#define OUT_NAME(F) F ## _s
+#include "outphrase-width.h"
+#undef OUT_TYPE
+#undef OUT_NAME
+
+#define OUT_TYPE R_UINT
+#define OUT_NAME(F) F ## _i
+#include "outphrase-width.h"
+#undef OUT_TYPE
+#undef OUT_NAME
 
 
-#ifdef NORMAL_EXPAND
 void outPhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i) {
-  R_UINT *pos;
-  R_UINT n;
-  R_UINT bytes_to_copy = 0;
-
-  /*  Expand from buffer  */
-  if (block_struct -> phrases_array[i].buffer_num >= block_struct -> buffer_num) {
-    pos = block_struct -> phrases_array[i].pos;
-    n = block_struct -> phrases_array[i].len;
-    bytes_to_copy = block_struct -> out_buf_end - block_struct -> out_buf_p;
-    while (n > bytes_to_copy) {
-      memcpy (block_struct -> out_buf_p, pos, sizeof (R_UINT) * bytes_to_copy);
-      writeOutputFile (prog_struct, block_struct, OUT_BUF_SIZE);
-      n = n - bytes_to_copy;
-      pos = pos + bytes_to_copy;
-      block_struct -> out_buf_p = block_struct -> out_buf;
-      block_struct -> buffer_num++;
-      bytes_to_copy = block_struct -> out_buf_end - block_struct -> out_buf_p;
-    }
-    memcpy (block_struct -> out_buf_p, pos, (sizeof (R_UINT) * n));
-    block_struct -> out_buf_p += n;
+  if (prog_struct -> base_datatype == (R_UINT) sizeof (R_UCHAR)) {
+    outPhrase_c (prog_struct, block_struct, i);
+  }
+  else if (prog_struct -> base_datatype == (R_UINT) sizeof (R_USHRT)) {
+    outPhrase_s (prog_struct, block_struct, i);
   }
-  /*  Not found in buffer; recursively decode  */
   else {
-    block_struct -> phrases_array[i].pos = block_struct -> out_buf_p;
-    outPhrase (prog_struct, block_struct, block_struct -> phrases_array[i].left);
-    outPhrase (prog_struct, block_struct, block_struct -> phrases_array[i].right);
-    /*  Calculate length of phrase  */
-    if (block_struct -> phrases_array[i].len == 0) {
-      block_struct -> phrases_array[i].len = block_struct -> phrases_array[block_struct -> phrases_array[i].left].len + block_struct -> phrases_array[block_struct -> phrases_array[i].right].len;
-    }
-    if ((block_struct -> out_buf_end - block_struct -> phrases_array[i].pos) >= block_struct -> phrases_array[i].len) {
-      block_struct -> phrases_array[i].buffer_num = block_struct -> buffer_num;
-    }
+    outPhrase_i (prog_struct, block_struct, i);
   }
 
   return;
 }
-#endif
-
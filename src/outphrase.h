@@ -26,6 +26,12 @@
 #ifndef OUTPHRASE_H
 #define OUTPHRASE_H
 
+#define EXPAND_FINISH 0x80000000u
+         /*  Marks a phrase on the expansion stack whose children are done  */
+#define EXPAND_STACK_SIZE(G) (((G) << 1) + 1)
+    /*  Entries needed on the expansion stack for G generations; each  */
+                        /*  level down the hierarchy adds at most two  */
+
 void outPhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT i);
 
 #endif
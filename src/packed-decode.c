@@ -0,0 +1,186 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>                                           /*  memcpy  */
+
+#if defined (__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "utils.h"
+#include "seqformat.h"
+#include "packed-decode.h"
+
+static void unpackFrame (const PACKDECODER *d, const R_UCHAR *frame, R_UINT *out);
+
+
+/*
+**  Unpack the PACKED_FRAME_SYMBOLS symbols of one frame into out.  Up
+**  to PACKED_SLACK_BYTES bytes past the end of the frame may be read.
+*/
+static void unpackFrame (const PACKDECODER *d, const R_UCHAR *frame, R_UINT *out) {
+  R_ULL_INT mask = (1ull << d -> width) - 1;
+  R_ULL_INT x = 0;
+  R_UINT bit = 0;
+  R_UINT i = 0;
+#if defined (__AVX2__)
+  __m256i v;
+  __m256i lanes;
+
+  if (d -> use_simd == R_TRUE) {
+    lanes = _mm256_set1_epi32 ((int) mask);
+    for (i = 0; i < PACKED_FRAME_SYMBOLS / 8; i++) {
+      v = _mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i*) (frame + d -> group_offset[2 * i])));
+      v = _mm256_inserti128_si256 (v, _mm_loadu_si128 ((const __m128i*) (frame + d -> group_offset[2 * i + 1])), 1);
+      v = _mm256_shuffle_epi8 (v, _mm256_loadu_si256 ((const __m256i*) d -> shuffle[i]));
+      v = _mm256_srlv_epi32 (v, _mm256_loadu_si256 ((const __m256i*) d -> shift[i]));
+      _mm256_storeu_si256 ((__m256i*) (out + 8 * i), _mm256_and_si256 (v, lanes));
+    }
+    return;
+  }
+#endif
+
+  /*  Little-endian hosts, as for the 4-byte integers of the .seq file  */
+  for (i = 0; i < PACKED_FRAME_SYMBOLS; i++) {
+    memcpy (&x, frame + (bit >> 3), sizeof (R_ULL_INT));
+    out[i] = (R_UINT) ((x >> (bit & 7)) & mask);
+    bit += d -> width;
+  }
+
+  return;
+}
+
+
+/*
+**  Create a decoder for the length bytes of packed data of a block of
+**  num_symbols symbols, each less than alphabet_size.  The decoder
+**  takes over data, which must have been allocated with wmalloc and
+**  be followed by PACKED_SLACK_BYTES bytes.
+*/
+PACKDECODER *newPackDecoder (R_UCHAR *data, size_t length, R_UINT num_symbols, R_UINT alphabet_size) {
+  PACKDECODER *d = NULL;
+  R_UINT bit = 0;
+  R_UINT g = 0;
+  R_UINT k = 0;
+  R_UINT b = 0;
+
+  d = wmalloc (sizeof (PACKDECODER));
+  d -> data = data;
+  d -> width = ceilLog (alphabet_size);
+  if (d -> width == 0) {
+    d -> width = 1;
+  }
+  d -> frame_bytes = d -> width * (R_UINT) sizeof (R_UINT);
+  d -> num_symbols = num_symbols;
+  d -> next = 0;
+
+  if (length != ((size_t) num_symbols + PACKED_FRAME_SYMBOLS - 1) / PACKED_FRAME_SYMBOLS * d -> frame_bytes) {
+    raiseError ("Error:  Bit-packed sequence is not valid.\n");
+  }
+
+  d -> use_simd = R_FALSE;
+#if defined (__AVX2__)
+  if (d -> width <= PACKED_SIMD_MAX_WIDTH) {
+    d -> use_simd = R_TRUE;
+  }
+#endif
+
+  /*  Set up the shuffles and shifts for each group of four symbols  */
+  for (g = 0; g < PACKED_FRAME_SYMBOLS / 4; g++) {
+    bit = 4 * g * d -> width;
+    d -> group_offset[g] = bit >> 3;
+    for (k = 0; k < 4; k++) {
+      for (b = 0; b < 4; b++) {
+        d -> shuffle[g >> 1][16 * (g & 1) + 4 * k + b] = (R_UCHAR) ((bit >> 3) - d -> group_offset[g] + b);
+      }
+      d -> shift[g >> 1][4 * (g & 1) + k] = bit & 7;
+      bit += d -> width;
+    }
+  }
+
+  return (d);
+}
+
+
+void deletePackDecoder (PACKDECODER *d) {
+  wfree (d -> data);
+  wfree (d);
+
+  return;
+}
+
+
+/*
+**  Decode up to max of the remaining symbols of the block into out.
+**  Returns the number of symbols decoded; 0 once the block is done.
+**  Whole frames are unpacked straight into out.
+*/
+R_UINT packedDecode (PACKDECODER *d, R_UINT *out, R_UINT max) {
+  const R_UCHAR *frame = NULL;
+  R_UINT pos = 0;
+  R_UINT k = 0;
+  R_UINT n = 0;
+
+  if (max > d -> num_symbols - d -> next) {
+    max = d -> num_symbols - d -> next;
+  }
+
+  while (n < max) {
+    frame = d -> data + (size_t) (d -> next / PACKED_FRAME_SYMBOLS) * d -> frame_bytes;
+    pos = d -> next % PACKED_FRAME_SYMBOLS;
+    if ((pos == 0) && (max - n >= PACKED_FRAME_SYMBOLS)) {
+      unpackFrame (d, frame, out + n);
+      k = PACKED_FRAME_SYMBOLS;
+    }
+    else {
+      unpackFrame (d, frame, d -> frame);
+      k = PACKED_FRAME_SYMBOLS - pos;
+      if (k > max - n) {
+        k = max - n;
+      }
+      memcpy (out + n, d -> frame + pos, k * sizeof (R_UINT));
+    }
+    n += k;
+    d -> next += k;
+  }
+
+  return (n);
+}
+
+
+/*  Skip the next n symbols of the block  */
+void packedSkip (PACKDECODER *d, R_UINT n) {
+  if (n > d -> num_symbols - d -> next) {
+    n = d -> num_symbols - d -> next;
+  }
+  d -> next += n;
+
+  return;
+}
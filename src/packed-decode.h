@@ -0,0 +1,67 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef PACKED_DECODE_H
+#define PACKED_DECODE_H
+
+/******************************
+Definitions
+******************************/
+#define PACKED_SLACK_BYTES 16
+        /*  Bytes that must be readable after the end of the packed data  */
+#define PACKED_SIMD_MAX_WIDTH 25
+                  /*  Widest symbols unpacked four to a 16-byte load  */
+
+/******************************
+Structure definitions
+******************************/
+/*
+**  State of the decoder of one bit-packed block.  With AVX2, frames of
+**  symbols of at most PACKED_SIMD_MAX_WIDTH bits are unpacked eight
+**  symbols at a time:  each 128-bit half is loaded from the byte where
+**  its first symbol starts, the bytes of each symbol are shuffled into
+**  its 32-bit lane, and the lanes are shifted and masked.  The shuffles
+**  and shifts depend only on the width, so they are set up once.
+*/
+typedef struct packdecoder {
+  R_UCHAR *data;                       /*  Packed frames of the block  */
+  R_UINT width;                             /*  Number of bits a symbol  */
+  R_UINT frame_bytes;
+  R_UINT num_symbols;
+  R_UINT next;                    /*  Index of the next symbol to decode  */
+  R_UINT frame[PACKED_FRAME_SYMBOLS];
+                                      /*  Frame being decoded in parts  */
+  R_BOOLEAN use_simd;
+  R_UINT group_offset[PACKED_FRAME_SYMBOLS / 4];
+                   /*  Byte where each group of four symbols starts  */
+  R_UCHAR shuffle[PACKED_FRAME_SYMBOLS / 8][32];
+  R_UINT shift[PACKED_FRAME_SYMBOLS / 8][8];
+} PACKDECODER;
+
+PACKDECODER *newPackDecoder (R_UCHAR *data, size_t length, R_UINT num_symbols, R_UINT alphabet_size);
+void deletePackDecoder (PACKDECODER *d);
+R_UINT packedDecode (PACKDECODER *d, R_UINT *out, R_UINT max);
+void packedSkip (PACKDECODER *d, R_UINT n);
+
+#endif
@@ -0,0 +1,70 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "common-def.h"
+#include "seqformat.h"
+#include "packed-encode.h"
+
+
+/*  Number of bytes taken by num_symbols symbols of width bits  */
+size_t packedSize (R_UINT num_symbols, R_UINT width) {
+  size_t num_frames = ((size_t) num_symbols + PACKED_FRAME_SYMBOLS - 1) / PACKED_FRAME_SYMBOLS;
+
+  return (num_frames * width * sizeof (R_UINT));
+}
+
+
+/*
+**  Pack num_symbols symbols, each less than 2^width, into out in
+**  frames of PACKED_FRAME_SYMBOLS symbols (see seqformat.h).  out
+**  must have room for packedSize (num_symbols, width) bytes.
+*/
+void packedEncode (R_UCHAR *out, const R_UINT *symbols, R_UINT num_symbols, R_UINT width) {
+  R_ULL_INT bitBuffer = 0;
+  R_UINT bitCount = 0;
+  R_UINT i = 0;
+  R_UINT j = 0;
+  R_UINT x = 0;
+
+  for (i = 0; i < num_symbols; i += PACKED_FRAME_SYMBOLS) {
+    for (j = 0; j < PACKED_FRAME_SYMBOLS; j++) {
+      x = (i + j < num_symbols) ? symbols[i + j] : 0;
+      bitBuffer |= (R_ULL_INT) x << bitCount;
+      bitCount += width;
+      while (bitCount >= 8) {
+        *out = (R_UCHAR) (bitBuffer & 255);
+        out++;
+        bitBuffer >>= 8;
+        bitCount -= 8;
+      }
+    }
+    /*  A frame is a whole number of words, so no bits are left  */
+  }
+
+  return;
+}
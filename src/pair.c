@@ -25,12 +25,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>                                    /*  alnum function  */
 #include <errno.h>
 #include <limits.h>                                         /*  UINT_MAX  */
+#include <pthread.h>
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
 #include "repair-defn.h"
 #include "seq.h"
 #include "phrase.h"
@@ -65,123 +67,430 @@ R_UINT hashCode (R_UINT left, R_UINT right) {
 }
 
 
-R_BOOLEAN isValidPair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, SEQ_NODE *back, SEQ_NODE *front) {
-  enum R_PHRASE_TYPE before_back_type = PT_NONE;
-  enum R_PHRASE_TYPE back_type = block_struct -> temp_phrases[back -> value].mytype;
-  enum R_PHRASE_TYPE front_type = block_struct -> temp_phrases[front -> value].mytype;
-  enum R_PHRASE_TYPE after_front_type = PT_NONE;
+/*
+**  Given a pair, its home slot in a table of 2^bits slots is
+**  returned.  Multiply-shift hashing of the 64-bit key (left, right);
+**  the top bits bits of the product select the slot.
+*/
+static R_UINT pairHome (R_UINT left, R_UINT right, R_UINT bits) {
+  R_ULL_INT key = ((R_ULL_INT) left << 32) | (R_ULL_INT) right;
 
-  enum R_PHRASE_SIDE left_side = block_struct -> temp_phrases[back -> value].myside;
-  enum R_PHRASE_SIDE right_side = block_struct -> temp_phrases[front -> value].myside;
+  return ((R_UINT) ((key * PAIRTABLE_MULTIPLIER) >> (64 - bits)));
+}
 
-  enum R_WORDPOS_TYPE before_back_ptype = WT_NONE;
-  enum R_WORDPOS_TYPE back_ptype = back -> punc_type;
-  enum R_WORDPOS_TYPE front_ptype = front -> punc_type;
 
-  SEQ_NODE *seqentry = NULL;
-  R_UINT temp_value;
-  SEQ_NODE *temp_seq = NULL;
+/*  Home slot of a pair in the tentative phrase table  */
+static R_UINT pairSlot (BLOCK_INFO *block_struct, R_UINT left, R_UINT right) {
+  return (pairHome (left, right, block_struct -> tent_phrases_bits));
+}
 
-  if (block_struct -> temp_phrases[front -> value].length + block_struct -> temp_phrases[back -> value].length > prog_struct -> max_length) {
-    return (R_FALSE);
+
+/*
+**  Place a tphrase in the first free slot at or after its home slot.
+**  The table must have at least one free slot.
+*/
+static void placePair (BLOCK_INFO *block_struct, TPHRASE *tph) {
+  R_UINT mask = block_struct -> tent_phrases_size - 1;
+  R_UINT slot = pairSlot (block_struct, tph -> left, tph -> right);
+
+  while (block_struct -> tent_phrases[slot] != NULL) {
+    slot = (slot + 1) & mask;
   }
+  block_struct -> tent_phrases[slot] = tph;
 
-  /*  Punctuation-aligned Re-Pair  */
-  if (prog_struct -> word_flags == UW_YES) {
-    /*  (W + P) and (W + W) are fine */
-    if (back_ptype == WT_WORD) {
-      return (R_TRUE);
+  return;
+}
+
+
+/*  Double the size of the tentative phrase table and rehash  */
+static void growPairTable (BLOCK_INFO *block_struct) {
+  TPHRASE **old_table = block_struct -> tent_phrases;
+  R_UINT old_size = block_struct -> tent_phrases_size;
+  R_UINT i;
+
+  if (block_struct -> tent_phrases_bits >= 31) {
+    raiseError ("ERROR.  Tentative phrase table cannot grow beyond %u slots.\n", old_size);
+  }
+
+  block_struct -> tent_phrases_bits++;
+  block_struct -> tent_phrases_size = old_size << 1;
+  block_struct -> tent_phrases = wmalloc (block_struct -> tent_phrases_size * sizeof (TPHRASE*));
+  changeMemory (block_struct -> memory, MEM_TPHRASES, 0, block_struct -> tent_phrases_size * sizeof (TPHRASE*));
+  for (i = 0; i < block_struct -> tent_phrases_size; i++) {
+    block_struct -> tent_phrases[i] = NULL;
+  }
+
+  for (i = 0; i < old_size; i++) {
+    if (old_table[i] != NULL) {
+      placePair (block_struct, old_table[i]);
     }
+  }
+  wfree (old_table);
+  changeMemory (block_struct -> memory, MEM_TPHRASES, old_size * sizeof (TPHRASE*), 0);
 
-    /*  (P + W) is not fine  */
-    if (front_ptype == WT_WORD) {
-      return (R_FALSE);
+  return;
+}
+
+
+/*
+**  Allocate the tentative phrase table for a sequence of the given
+**  length.  A sequence of n symbols has at most n - 1 distinct pairs,
+**  but most inputs have far fewer, so start at a fraction of that and
+**  let insertPair grow the table when it becomes half full.
+*/
+void initPairTable (BLOCK_INFO *block_struct, R_UINT length) {
+  R_UINT old_size = block_struct -> tent_phrases_size;
+  R_UINT i;
+
+  block_struct -> tent_phrases_bits = PAIRTABLE_MIN_BITS;
+  while ((block_struct -> tent_phrases_bits < 30) && ((1u << block_struct -> tent_phrases_bits) < (length >> 2))) {
+    block_struct -> tent_phrases_bits++;
+  }
+  block_struct -> tent_phrases_size = 1u << block_struct -> tent_phrases_bits;
+  block_struct -> tent_phrases_used = 0;
+
+  if (block_struct -> tent_phrases != NULL) {
+    wfree (block_struct -> tent_phrases);
+    changeMemory (block_struct -> memory, MEM_TPHRASES, old_size * sizeof (TPHRASE*), 0);
+  }
+  block_struct -> tent_phrases = wmalloc (block_struct -> tent_phrases_size * sizeof (TPHRASE*));
+  changeMemory (block_struct -> memory, MEM_TPHRASES, 0, block_struct -> tent_phrases_size * sizeof (TPHRASE*));
+  for (i = 0; i < block_struct -> tent_phrases_size; i++) {
+    block_struct -> tent_phrases[i] = NULL;
+  }
+
+  return;
+}
+
+
+/*  Return the tphrase for (left, right), or NULL if there is none  */
+TPHRASE *findPair (BLOCK_INFO *block_struct, R_UINT left, R_UINT right) {
+  R_UINT mask = block_struct -> tent_phrases_size - 1;
+  R_UINT slot = pairSlot (block_struct, left, right);
+  TPHRASE *tph;
+
+  while ((tph = block_struct -> tent_phrases[slot]) != NULL) {
+    if ((tph -> left == left) && (tph -> right == right)) {
+      return (tph);
     }
+    slot = (slot + 1) & mask;
+  }
+
+  return (NULL);
+}
 
-    /*  Only remaining case is (P + P); need to check the preceeding
-    **  one because P (P + P) is fine, but W (P + P) is not.  */
 
-    /*  First two pairs -- no preceeding one to check, so fine.  */
-    if (back == block_struct -> seq_buf) {
-      return (R_TRUE);
+/*  Add a tphrase that is not yet in the table  */
+void insertPair (BLOCK_INFO *block_struct, TPHRASE *tph) {
+  if (((block_struct -> tent_phrases_used + 1) << 1) > block_struct -> tent_phrases_size) {
+    growPairTable (block_struct);
+  }
+  placePair (block_struct, tph);
+  block_struct -> tent_phrases_used++;
+
+  return;
+}
+
+
+/*
+**  Remove a tphrase from the table.  Entries after the freed slot
+**  in the same probe run are shifted back so that no tombstones are
+**  needed and lookups can stop at the first empty slot.
+*/
+void removePair (BLOCK_INFO *block_struct, TPHRASE *tph) {
+  R_UINT mask = block_struct -> tent_phrases_size - 1;
+  R_UINT hole = pairSlot (block_struct, tph -> left, tph -> right);
+  R_UINT next;
+  R_UINT home;
+
+  while (block_struct -> tent_phrases[hole] != tph) {
+    if (block_struct -> tent_phrases[hole] == NULL) {
+      raiseError ("Unexpected error:  tphrase (%u, %u) not in table in %s, line %u.\n", tph -> left, tph -> right, __FILE__, __LINE__);
     }
-    else {
-      seqentry = back;
-      temp_seq = PREVSEQ;
-      before_back_ptype = temp_seq -> punc_type;
-      if (before_back_ptype == WT_PUNC) {
-	return (R_TRUE);
-      }
-      else {
-	return (R_FALSE);
-      }
+    hole = (hole + 1) & mask;
+  }
+
+  next = hole;
+  while (R_TRUE) {
+    next = (next + 1) & mask;
+    if (block_struct -> tent_phrases[next] == NULL) {
+      break;
     }
+    home = pairSlot (block_struct, block_struct -> tent_phrases[next] -> left, block_struct -> tent_phrases[next] -> right);
+    /*  Move the entry only if its home is not cyclically in (hole, next]  */
+    if (((hole <= next) && ((home <= hole) || (home > next))) ||
+        ((hole > next) && (home <= hole) && (home > next))) {
+      block_struct -> tent_phrases[hole] = block_struct -> tent_phrases[next];
+      hole = next;
+    }
+  }
+  block_struct -> tent_phrases[hole] = NULL;
+  block_struct -> tent_phrases_used--;
+
+  return;
+}
+
+
+/*
+**  Allocate an empty table of the pairs which have already been
+**  replaced in this block.  Like the tentative phrase table, it is
+**  open addressing with multiply-shift hashing and linear probing,
+**  and it is doubled when it becomes half full.  Pairs are never
+**  removed from it.
+*/
+void initPairedTable (BLOCK_INFO *block_struct) {
+  R_UINT i;
+
+  block_struct -> paired_bits = PAIRTABLE_MIN_BITS;
+  block_struct -> paired_size = 1u << block_struct -> paired_bits;
+  block_struct -> paired_used = 0;
+  block_struct -> paired = wmalloc (block_struct -> paired_size * sizeof (R_ULL_INT));
+  changeMemory (block_struct -> memory, MEM_PAIRED, 0, block_struct -> paired_size * sizeof (R_ULL_INT));
+  for (i = 0; i < block_struct -> paired_size; i++) {
+    block_struct -> paired[i] = PAIRED_EMPTY;
+  }
+
+  return;
+}
+
+
+void uninitPairedTable (BLOCK_INFO *block_struct) {
+  if (block_struct -> paired != NULL) {
+    wfree (block_struct -> paired);
+    changeMemory (block_struct -> memory, MEM_PAIRED, block_struct -> paired_size * sizeof (R_ULL_INT), 0);
   }
+  block_struct -> paired = NULL;
+  block_struct -> paired_size = 0;
+  block_struct -> paired_bits = 0;
+  block_struct -> paired_used = 0;
+
+  return;
+}
+
+
+/*  Place a key in the first free slot at or after its home slot  */
+static void placePaired (BLOCK_INFO *block_struct, R_ULL_INT key) {
+  R_UINT mask = block_struct -> paired_size - 1;
+  R_UINT slot = pairHome ((R_UINT) (key >> 32), (R_UINT) key, block_struct -> paired_bits);
+
+  while (block_struct -> paired[slot] != PAIRED_EMPTY) {
+    slot = (slot + 1) & mask;
+  }
+  block_struct -> paired[slot] = key;
+
+  return;
+}
+
+
+/*  Has the pair (left, right) already been replaced?  */
+R_BOOLEAN findPaired (BLOCK_INFO *block_struct, R_UINT left, R_UINT right) {
+  R_ULL_INT key = ((R_ULL_INT) left << 32) | (R_ULL_INT) right;
+  R_UINT mask = block_struct -> paired_size - 1;
+  R_UINT slot = pairHome (left, right, block_struct -> paired_bits);
 
-  /*  Word-aligned Re-Pair  */
-  if (prog_struct -> apply_heuristics == HEUR_WA) {
-    if (back_type == front_type) {
+  while (block_struct -> paired[slot] != PAIRED_EMPTY) {
+    if (block_struct -> paired[slot] == key) {
       return (R_TRUE);
     }
+    slot = (slot + 1) & mask;
+  }
 
-    if (back == block_struct -> seq_buf) {
-      if ((back_type == PT_WORD) && (front_type == PT_NON_WORD)) {
-        seqentry = front;
-        temp_value = NEXTSEQVALUE;
-        after_front_type = block_struct -> temp_phrases[temp_value].mytype;
-        if (after_front_type != PT_NON_WORD) {
-          return (R_TRUE);
-        }
-      }
-      return (R_FALSE);
+  return (R_FALSE);
+}
+
+
+/*  Record that the pair (left, right) has been replaced  */
+void insertPaired (BLOCK_INFO *block_struct, R_UINT left, R_UINT right) {
+  R_ULL_INT *old_table = block_struct -> paired;
+  R_UINT old_size = block_struct -> paired_size;
+  R_UINT i;
+
+  if (((block_struct -> paired_used + 1) << 1) > block_struct -> paired_size) {
+    if (block_struct -> paired_bits >= 31) {
+      raiseError ("ERROR.  Table of replaced pairs cannot grow beyond %u slots.\n", old_size);
     }
-    else if (front == block_struct -> seq_buf_end) {
-      if ((back_type == PT_WORD) && (front_type == PT_NON_WORD)) {
-        seqentry = back;
-        temp_value = PREVSEQVALUE;
-        before_back_type = block_struct -> temp_phrases[temp_value].mytype;
-        if (before_back_type != PT_WORD) {
-          return (R_TRUE);
-        }
-      }
-      return (R_FALSE);
+    block_struct -> paired_bits++;
+    block_struct -> paired_size = old_size << 1;
+    block_struct -> paired = wmalloc (block_struct -> paired_size * sizeof (R_ULL_INT));
+    changeMemory (block_struct -> memory, MEM_PAIRED, 0, block_struct -> paired_size * sizeof (R_ULL_INT));
+    for (i = 0; i < block_struct -> paired_size; i++) {
+      block_struct -> paired[i] = PAIRED_EMPTY;
     }
-    else if ((back_type == PT_WORD) && (front_type == PT_NON_WORD)) {
-      seqentry = back;
-      temp_value = PREVSEQVALUE;
-      before_back_type = block_struct -> temp_phrases[temp_value].mytype;
-      seqentry = front;
-      temp_value = NEXTSEQVALUE;
-      after_front_type = block_struct -> temp_phrases[temp_value].mytype;
-      if ((before_back_type != PT_WORD) && (after_front_type != PT_NON_WORD)) {
-        return (R_TRUE);
+    for (i = 0; i < old_size; i++) {
+      if (old_table[i] != PAIRED_EMPTY) {
+        placePaired (block_struct, old_table[i]);
       }
     }
+    wfree (old_table);
+    changeMemory (block_struct -> memory, MEM_PAIRED, old_size * sizeof (R_ULL_INT), 0);
+  }
+  placePaired (block_struct, ((R_ULL_INT) left << 32) | (R_ULL_INT) right);
+  block_struct -> paired_used++;
+
+  return;
+}
+
+
+/*
+**  Is the pair longer than the limit on phrase lengths (-l)?
+*/
+#define PAIRTOOLONG(P,B,BACK,FRONT) (((P) -> max_length != UINT_MAX) && ((B) -> temp_phrases[(FRONT) -> value].length + (B) -> temp_phrases[(BACK) -> value].length > (P) -> max_length))
+
+
+/*
+**  Only the length of phrases is limited
+*/
+static R_BOOLEAN validPairLength (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, SEQ_NODE *back, SEQ_NODE *front) {
+  return (PAIRTOOLONG (prog_struct, block_struct, back, front) ? R_FALSE : R_TRUE);
+}
+
+
+/*
+**  Punctuation-aligned Re-Pair (-f)
+*/
+static R_BOOLEAN validPairPunc (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, SEQ_NODE *back, SEQ_NODE *front) {
+  SEQ_NODE *seqentry = NULL;
+
+  if (PAIRTOOLONG (prog_struct, block_struct, back, front)) {
     return (R_FALSE);
   }
-  else if (prog_struct -> apply_heuristics == HEUR_SIDE) {
-    if ((left_side == SIDE_RIGHT ) || (right_side == SIDE_LEFT)) {
-      return (R_FALSE);
-    }
+
+  /*  (W + P) and (W + W) are fine */
+  if (SEQPUNC (back) == WT_WORD) {
     return (R_TRUE);
   }
-  else if (prog_struct -> apply_heuristics == HEUR_NORECUR) {
-    if ((block_struct -> temp_phrases[back -> value].generation != 0) || (block_struct -> temp_phrases[front -> value].generation != 0)) {
-      return (R_FALSE);
-    }
+
+  /*  (P + W) is not fine  */
+  if (SEQPUNC (front) == WT_WORD) {
+    return (R_FALSE);
+  }
+
+  /*  Only remaining case is (P + P); need to check the preceeding
+  **  one because P (P + P) is fine, but W (P + P) is not.  */
+
+  /*  First two pairs -- no preceeding one to check, so fine.  */
+  if (back == block_struct -> seq_buf) {
     return (R_TRUE);
   }
+  seqentry = back;
+  if (SEQPUNC (PREVSEQ) == WT_PUNC) {
+    return (R_TRUE);
+  }
+
+  return (R_FALSE);
+}
+
+
+/*
+**  Word-aligned Re-Pair (-e 1)
+*/
+static R_BOOLEAN validPairWordAligned (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, SEQ_NODE *back, SEQ_NODE *front) {
+  R_UCHAR *tags = block_struct -> phrase_tags;
+  enum R_PHRASE_TYPE back_type = TAGTYPE (tags[back -> value]);
+  enum R_PHRASE_TYPE front_type = TAGTYPE (tags[front -> value]);
+  enum R_PHRASE_TYPE before_back_type = PT_NONE;
+  enum R_PHRASE_TYPE after_front_type = PT_NONE;
+  SEQ_NODE *seqentry = NULL;
+
+  if (PAIRTOOLONG (prog_struct, block_struct, back, front)) {
+    return (R_FALSE);
+  }
+
+  if (back_type == front_type) {
+    return (R_TRUE);
+  }
+  if ((back_type != PT_WORD) || (front_type != PT_NON_WORD)) {
+    return (R_FALSE);
+  }
+
+  if (back == block_struct -> seq_buf) {
+    seqentry = front;
+    after_front_type = TAGTYPE (tags[NEXTSEQVALUE]);
+    return ((after_front_type != PT_NON_WORD) ? R_TRUE : R_FALSE);
+  }
+  if (front == block_struct -> seq_buf_end) {
+    seqentry = back;
+    before_back_type = TAGTYPE (tags[PREVSEQVALUE]);
+    return ((before_back_type != PT_WORD) ? R_TRUE : R_FALSE);
+  }
+
+  seqentry = back;
+  before_back_type = TAGTYPE (tags[PREVSEQVALUE]);
+  seqentry = front;
+  after_front_type = TAGTYPE (tags[NEXTSEQVALUE]);
+  if ((before_back_type != PT_WORD) && (after_front_type != PT_NON_WORD)) {
+    return (R_TRUE);
+  }
+
+  return (R_FALSE);
+}
+
+
+/*
+**  Obey which side symbols are on (-e 2)
+*/
+static R_BOOLEAN validPairSide (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, SEQ_NODE *back, SEQ_NODE *front) {
+  if (PAIRTOOLONG (prog_struct, block_struct, back, front)) {
+    return (R_FALSE);
+  }
+  if ((TAGSIDE (block_struct -> phrase_tags[back -> value]) == SIDE_RIGHT) || (TAGSIDE (block_struct -> phrase_tags[front -> value]) == SIDE_LEFT)) {
+    return (R_FALSE);
+  }
 
   return (R_TRUE);
 }
 
 
+/*
+**  No recursion; only pairs of primitives (-e 3)
+*/
+static R_BOOLEAN validPairNoRecur (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, SEQ_NODE *back, SEQ_NODE *front) {
+  if (PAIRTOOLONG (prog_struct, block_struct, back, front)) {
+    return (R_FALSE);
+  }
+  if (((block_struct -> phrase_tags[back -> value] | block_struct -> phrase_tags[front -> value]) & TAG_PHRASE) != 0) {
+    return (R_FALSE);
+  }
+
+  return (R_TRUE);
+}
+
+
+/*
+**  Choose, once for the block, the check of which pairs may be
+**  replaced.  With no heuristic, no word flags and no limit on the
+**  length of phrases, every pair may be, and there is no check at
+**  all (see ISVALIDPAIR).
+*/
+void selectPairCheck (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  block_struct -> valid_pair = NULL;
+
+  if (prog_struct -> word_flags == UW_YES) {
+    block_struct -> valid_pair = validPairPunc;
+  }
+  else if (prog_struct -> apply_heuristics == HEUR_WA) {
+    block_struct -> valid_pair = validPairWordAligned;
+  }
+  else if (prog_struct -> apply_heuristics == HEUR_SIDE) {
+    block_struct -> valid_pair = validPairSide;
+  }
+  else if (prog_struct -> apply_heuristics == HEUR_NORECUR) {
+    block_struct -> valid_pair = validPairNoRecur;
+  }
+  else if (prog_struct -> max_length != UINT_MAX) {
+    block_struct -> valid_pair = validPairLength;
+  }
+
+  return;
+}
+
+
 /*
 **  scanPairs looks at the seq array and checks two characters a time.  Two
 **  characters form a pair.  First, if the current pair matches the previous
 **  pair, then an overlapping pair has been found, so nothing is done.
 **
-**  Otherwise, the pair is hashed and looked up in the tentPhrases hash
+**  Otherwise, the pair is looked up in the tent_phrases hash
 **  table.  If this is a new pair, then a new tphrase is created with a
 **  pointer to the seq_node of the first character.  If this is not a new
 **  pair, then the seq_node of the first character is added to the
@@ -194,15 +503,17 @@ R_BOOLEAN isValidPair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, SEQ_NOD
 **  by advancing one character
 */
 void scanPairs (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
-  R_UINT hashcode;
   SEQ_NODE *front;
   SEQ_NODE *back = block_struct -> seq_buf;
   SEQ_NODE *old_front;
   SEQ_NODE *old_back;
   TPHRASE *currentphrase;
-  TPHRASE *headphrase = NULL;
-  R_BOOLEAN found = R_FALSE;
   SEQ_NODE *dummy;
+  R_BOOLEAN (*valid_pair) (PROG_INFO *, BLOCK_INFO *, SEQ_NODE *, SEQ_NODE *);
+
+  initPairTable (block_struct, (R_UINT) (block_struct -> seq_buf_end - block_struct -> seq_buf) + 1);
+  selectPairCheck (prog_struct, block_struct);
+  valid_pair = block_struct -> valid_pair;
 
   /*  seq is of length one, so just return  */
   if (block_struct -> seq_buf == block_struct -> seq_buf_end) {
@@ -237,34 +548,16 @@ void scanPairs (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
       **    1    0    1        1            0
       **    1    1    0        0            1
       */
-      if (isValidPair (prog_struct, block_struct, back, front)) {
-        hashcode = hashCode (back -> value, front -> value);
-                                       /*  Calculate hashcode for pair  */
-        headphrase = block_struct -> tent_phrases[hashcode];
-        currentphrase = headphrase;
-        if (headphrase != NULL) {
-          found = R_FALSE;
-          do {
-            if ((currentphrase -> left != back -> value) || (currentphrase -> right != front -> value)) {
-              currentphrase = currentphrase -> next;
-  	    }
-            else {
-              found = R_TRUE;
-              insertSeqPtrLast (back, currentphrase);
+      if ((valid_pair == NULL) || (valid_pair (prog_struct, block_struct, back, front))) {
+        currentphrase = findPair (block_struct, back -> value, front -> value);
+        if (currentphrase != NULL) {
+          insertSeqPtrLast (back, currentphrase, block_struct);
     			              /*  Insert back into currentphrase  */
-              break;
-            }
-          } while (currentphrase != headphrase);
         }
         else {
-          found = R_FALSE;
-        }
-
-        if (found == R_FALSE) {
  	                               /*  New tphrase has to be created  */
-          currentphrase = initTPhrase (prog_struct, back -> value, front -> value, back);
-          headphrase = insertTPhraseLast (currentphrase, &(block_struct -> tent_phrases[hashcode]));
-          currentphrase = headphrase;
+          currentphrase = initTPhrase (prog_struct, block_struct, back -> value, front -> value, back);
+          insertPair (block_struct, currentphrase);
           block_struct -> tphrase_in_use += 1;
         }
 
@@ -281,6 +574,9 @@ void scanPairs (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
                                  /*  Continue until end of array reached  */
   wfree (dummy);
 
+  /*  No tentative phrases are removed while the pairs are scanned  */
+  block_struct -> max_tphrase_in_use = block_struct -> tphrase_in_use;
+
   return;
 }
 
@@ -26,12 +26,31 @@
 #ifndef PAIR_H
 #define PAIR_H
 
-#define TENTPHRASE_SIZE 65521ull /*  Size of Tentative Phrase hash table  */
+#define TENTPHRASE_SIZE 65521ull  /*  Size of hashCode's range; used for  */
+                                         /*  the initial queue order  */
 #define LEFT_HASHCODE 131071ull
 #define RIGHT_HASHCODE 262139ull
 
+#define PAIRTABLE_MIN_BITS 10u
+                 /*  log2 of smallest tentative phrase table capacity  */
+#define PAIRTABLE_MULTIPLIER 0x9E3779B97F4A7C15ull
+                        /*  Odd multiplier for multiply-shift hashing  */
+#define PAIRED_EMPTY (~0ull)
+                      /*  Free slot in the table of replaced pairs  */
+
+/*  May the pair (BACK, FRONT) be replaced?  See selectPairCheck.  */
+#define ISVALIDPAIR(P,B,BACK,FRONT) (((B) -> valid_pair == NULL) || ((B) -> valid_pair ((P), (B), (BACK), (FRONT)) == R_TRUE))
+
 R_UINT hashCode (R_UINT left, R_UINT right);
-R_BOOLEAN isValidPair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, SEQ_NODE *back, SEQ_NODE *front);
+void initPairTable (BLOCK_INFO *block_struct, R_UINT length);
+struct tphrase *findPair (BLOCK_INFO *block_struct, R_UINT left, R_UINT right);
+void insertPair (BLOCK_INFO *block_struct, struct tphrase *tph);
+void removePair (BLOCK_INFO *block_struct, struct tphrase *tph);
+void initPairedTable (BLOCK_INFO *block_struct);
+void uninitPairedTable (BLOCK_INFO *block_struct);
+R_BOOLEAN findPaired (BLOCK_INFO *block_struct, R_UINT left, R_UINT right);
+void insertPaired (BLOCK_INFO *block_struct, R_UINT left, R_UINT right);
+void selectPairCheck (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 void scanPairs (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 
 #endif
@@ -24,20 +24,56 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include "common-def.h"
+#include "error.h"
+#include "stats.h"
 #include "despair-defn.h"
 #include "despair.h"
 #include "phrase-slide-decode.h"
 
-void setUnitPrimitives (BLOCK_INFO *block_struct) {
+/*
+**  Store the value of each primitive in prims_buf, as the output
+**  datatype, and make each primitive a phrase of length 1 found
+**  there.  Values are checked against the datatype here, once, since
+**  everything written out is a copy of a primitive.
+*/
+void setUnitPrimitives (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  R_UCHAR *prims_c = block_struct -> prims_buf;
+  R_USHRT *prims_s = block_struct -> prims_buf;
+  R_UINT *prims_i = block_struct -> prims_buf;
+  R_ULL_INT x = 0;
+  R_ULL_INT limit = UINT_MAX;
   R_UINT i;
 
+  if (prog_struct -> base_datatype == (R_UINT) sizeof (R_UCHAR)) {
+    limit = UCHAR_MAX;
+  }
+  else if (prog_struct -> base_datatype == (R_UINT) sizeof (R_USHRT)) {
+    limit = USHRT_MAX;
+  }
+
   for (i = 0; i < block_struct -> num_prims; i++) {
-    block_struct -> prims_buf[i] = (R_UINT) block_struct -> phrases_array[i].chiastic;
+    x = block_struct -> phrases_array[i].chiastic;
+    if (x > limit) {
+      raiseError ("Symbol %llu encountered.\nSymbol value exceeds limit of data type.", x);
+    }
+    if (prog_struct -> base_datatype == (R_UINT) sizeof (R_UCHAR)) {
+      prims_c[i] = (R_UCHAR) x;
+      block_struct -> phrases_array[i].pos = prims_c + i;
+    }
+    else if (prog_struct -> base_datatype == (R_UINT) sizeof (R_USHRT)) {
+      prims_s[i] = (R_USHRT) x;
+      block_struct -> phrases_array[i].pos = prims_s + i;
+    }
+    else {
+      prims_i[i] = (R_UINT) x;
+      block_struct -> phrases_array[i].pos = prims_i + i;
+    }
     block_struct -> phrases_array[i].buffer_num = UINT_MAX;
-    block_struct -> phrases_array[i].pos = block_struct -> prims_buf + i;
     block_struct -> phrases_array[i].len = 1;
   }
 
@@ -26,7 +26,7 @@
 #ifndef PHRASE_SLIDE_DECODE_H
 #define PHRASE_SLIDE_DECODE_H
 
-void setUnitPrimitives(BLOCK_INFO *block_struct);
+void setUnitPrimitives (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 void setUnitPhrasesHorizontal (R_ULL_INT kp, R_ULL_INT kpp, R_ULL_INT kpsqr, R_ULL_INT kppsqr, R_UINT s, PAIR *units);
 void setUnitPhrasesChiastic (R_ULL_INT k1, R_ULL_INT k2, R_ULL_INT k1sqr, R_ULL_INT k2sqr, R_UINT s, PAIR *units);
 
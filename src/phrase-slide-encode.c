@@ -25,8 +25,10 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "common-def.h"
+#include "stats.h"
 #include "repair-defn.h"
 #include "seq.h"
 #include "phrase.h"
@@ -73,29 +75,89 @@ R_ULL_INT chiasticSlide (R_ULL_INT left, R_ULL_INT right, R_ULL_INT kp, R_ULL_IN
 
 
 /*
-**  Comparison function used by C library qsort function to compare
-**  two phrases using their generations
+**  Sorts the units of the phrases of one generation, carrying the
+**  position of each phrase along with it, with a least significant
+**  digit radix sort of RADIX_BITS bits per pass.  Passes over digits
+**  which are the same in every unit are skipped, so small units take
+**  few passes.  The sort is stable; phrases with the same unit keep
+**  the order of their positions.  units_tmp and indexes_tmp are
+**  scratch arrays of size values each.  Sorted units and positions
+**  are left in units and indexes.
 */
-R_INT genComparison (const PHRASE *first, const PHRASE *second) {
-    return ((R_INT) (first -> generation) - (R_INT) (second -> generation));
-}
+void radixSortUnits (R_ULL_INT *units, R_UINT *indexes, R_ULL_INT *units_tmp, R_UINT *indexes_tmp, R_UINT size) {
+  R_UINT counts[RADIX_PASSES][RADIX_SIZE];
+  R_ULL_INT *from_units = units;
+  R_ULL_INT *to_units = units_tmp;
+  R_UINT *from_indexes = indexes;
+  R_UINT *to_indexes = indexes_tmp;
+  R_ULL_INT *swap_units;
+  R_UINT *swap_indexes;
+  R_ULL_INT unit;
+  R_UINT index;
+  R_UINT i, j;
+  R_UINT pass;
+  R_UINT shift;
+  R_UINT sum;
+  R_UINT count;
 
+  /*  Small generations (the most common) are sorted by insertion  */
+  if (size < RADIX_MIN) {
+    for (i = 1; i < size; i++) {
+      unit = units[i];
+      index = indexes[i];
+      for (j = i; (j > 0) && (units[j - 1] > unit); j--) {
+        units[j] = units[j - 1];
+        indexes[j] = indexes[j - 1];
+      }
+      units[j] = unit;
+      indexes[j] = index;
+    }
+    return;
+  }
 
-/*
-**  Comparison function used by C library qsort function to compare
-**  two phrases using their units
-*/
-R_INT unitComparison (const PHRASE *first, const PHRASE *second) {
-  if (first -> unit > second -> unit) {
-    return (1);
+  /*  Count the digits of every pass at once  */
+  (void) memset (counts, 0, sizeof (counts));
+  for (i = 0; i < size; i++) {
+    unit = units[i];
+    for (pass = 0; pass < RADIX_PASSES; pass++) {
+      counts[pass][unit & (RADIX_SIZE - 1)]++;
+      unit = unit >> RADIX_BITS;
+    }
   }
-  else {
-    if (first -> unit < second -> unit) {
-      return (-1);
+
+  for (pass = 0; pass < RADIX_PASSES; pass++) {
+    shift = pass * RADIX_BITS;
+    if (counts[pass][(from_units[0] >> shift) & (RADIX_SIZE - 1)] == size) {
+      continue;                       /*  Digit is the same in every unit  */
     }
-    else {
-      return (0);
+
+    /*  Turn the counts into the first position of each digit  */
+    sum = 0;
+    for (i = 0; i < RADIX_SIZE; i++) {
+      count = counts[pass][i];
+      counts[pass][i] = sum;
+      sum += count;
+    }
+
+    for (i = 0; i < size; i++) {
+      j = counts[pass][(from_units[i] >> shift) & (RADIX_SIZE - 1)]++;
+      to_units[j] = from_units[i];
+      to_indexes[j] = from_indexes[i];
     }
+
+    swap_units = from_units;
+    from_units = to_units;
+    to_units = swap_units;
+    swap_indexes = from_indexes;
+    from_indexes = to_indexes;
+    to_indexes = swap_indexes;
+  }
+
+  if (from_units != units) {
+    (void) memcpy (units, from_units, size * sizeof (R_ULL_INT));
+    (void) memcpy (indexes, from_indexes, size * sizeof (R_UINT));
   }
+
+  return;
 }
 
@@ -26,10 +26,17 @@
 #ifndef PHRASE_SLIDE_ENCODE_H
 #define PHRASE_SLIDE_ENCODE_H
 
+#define RADIX_BITS 8
+                         /*  Bits of the units sorted in each radix pass  */
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_PASSES 8
+                              /*  Passes to sort all 64 bits of the units  */
+#define RADIX_MIN 32
+             /*  Generations smaller than this are sorted by insertion  */
+
 R_ULL_INT horizontalSlide (R_ULL_INT left, R_ULL_INT right, R_ULL_INT kp, R_ULL_INT kpp, R_ULL_INT kppSqr);
 R_ULL_INT chiasticSlide (R_ULL_INT left, R_ULL_INT right, R_ULL_INT kp, R_ULL_INT kpp, R_ULL_INT kppSqr);
-R_INT genComparison (const PHRASE *first, const PHRASE *second);
-R_INT unitComparison (const PHRASE *first, const PHRASE *second);
+void radixSortUnits (R_ULL_INT *units, R_UINT *indexes, R_ULL_INT *units_tmp, R_UINT *indexes_tmp, R_UINT size);
 
 #endif
 
@@ -28,12 +28,14 @@
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
+#include "smalloc.h"
+#include "stats.h"
 #include "repair-defn.h"
 #include "seq.h"
 #include "pair.h"
 #include "phrase.h"
 
-static TPHRASE *insertTPhraseNode (TPHRASE *node, TPHRASE *prevnode, TPHRASE *nextnode);
 static TPHRASE *insertTPhraseNodeQueue (TPHRASE *oldnode, TPHRASE *prevnode, TPHRASE *nextnode);
 
 /*
@@ -41,26 +43,25 @@ static TPHRASE *insertTPhraseNodeQueue (TPHRASE *oldnode, TPHRASE *prevnode, TPH
 **  it is the last node for that tphrase.  If so, makes the tphrase's
 **  pointer NULL.
 */
-void unlinkSeqPtr (SEQ_NODE *deletenode, TPHRASE *tph) {
-  if ((tph -> position == deletenode) && ((tph -> position) -> next_ptr == deletenode)) {
+void unlinkSeqPtr (SEQ_NODE *deletenode, TPHRASE *tph, BLOCK_INFO *block_struct) {
+  if ((tph -> position == deletenode) && (SEQNEXT (block_struct, tph -> position) == deletenode)) {
     tph -> position = NULL;
   }
   tph -> count -= 1;
-  (deletenode -> prev_ptr) -> next_ptr = deletenode -> next_ptr;
-  (deletenode -> next_ptr) -> prev_ptr = deletenode -> prev_ptr;
-  deletenode -> prev_ptr = NULL;
-  deletenode -> next_ptr = NULL;
+  SETSEQNEXT (block_struct, SEQPREV (block_struct, deletenode), SEQNEXT (block_struct, deletenode));
+  SETSEQPREV (block_struct, SEQNEXT (block_struct, deletenode), SEQPREV (block_struct, deletenode));
+  CLEARSEQPTRS (deletenode);
   return;
 }
 
 
 /*  Inserts a seq_node after the node pointed to by list  */
-void insertSeqPtrFirst (SEQ_NODE *newnode, TPHRASE *tph) {
+void insertSeqPtrFirst (SEQ_NODE *newnode, TPHRASE *tph, BLOCK_INFO *block_struct) {
   if ((tph -> position) != NULL) {
-    insertSeqPtr (newnode, (tph -> position), (tph -> position) -> next_ptr);
+    insertSeqPtr (newnode, (tph -> position), SEQNEXT (block_struct, tph -> position), block_struct);
   }
   else {
-    insertSeqPtr (newnode, newnode, newnode);
+    insertSeqPtr (newnode, newnode, newnode, block_struct);
     (tph -> position) = newnode;
   }
   (tph -> count)++;
@@ -69,12 +70,12 @@ void insertSeqPtrFirst (SEQ_NODE *newnode, TPHRASE *tph) {
 }
 
 /*  Inserts a seq_node before the node pointed to by list  */
-void insertSeqPtrLast (SEQ_NODE *newnode, TPHRASE *tph) {
+void insertSeqPtrLast (SEQ_NODE *newnode, TPHRASE *tph, BLOCK_INFO *block_struct) {
   if ((tph -> position) != NULL) {
-    insertSeqPtr (newnode, (tph -> position) -> prev_ptr, (tph -> position));
+    insertSeqPtr (newnode, SEQPREV (block_struct, tph -> position), (tph -> position), block_struct);
   }
   else {
-    insertSeqPtr (newnode, newnode, newnode);
+    insertSeqPtr (newnode, newnode, newnode, block_struct);
     (tph -> position) = newnode;
   }
   (tph -> count)++;
@@ -83,13 +84,11 @@ void insertSeqPtrLast (SEQ_NODE *newnode, TPHRASE *tph) {
 }
 
 /*  Given two integers and a seq_node, a tentativephrase is returned  */
-TPHRASE *initTPhrase (PROG_INFO *prog_struct, R_UINT left, R_UINT right, SEQ_NODE *ptrnode) {
+TPHRASE *initTPhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT left, R_UINT right, SEQ_NODE *ptrnode) {
   TPHRASE *tph = NULL;
 
-  tph = wmalloc (sizeof (TPHRASE));
+  tph = smalloc (block_struct -> tphrase_root);
 
-  tph -> prev = tph;
-  tph -> next = tph;
   tph -> prev_queue = tph;
   tph -> next_queue = tph;
   tph -> left = left;
@@ -98,48 +97,35 @@ TPHRASE *initTPhrase (PROG_INFO *prog_struct, R_UINT left, R_UINT right, SEQ_NOD
   tph -> position = NULL;
   /*  tph -> position must be NULL for insertSeqPtrLast to work  */
 
-  insertSeqPtrLast (ptrnode, tph);
+  insertSeqPtrLast (ptrnode, tph, block_struct);
 
   return (tph);
 }
 
 
 /*
-**  Given a node, inserted it into a list between prevnode and
-**  nextnode
+**  Deletes a tphrase node from the hash table and priority queue
+**  and deallocate memory
 */
-static TPHRASE *insertTPhraseNode (TPHRASE *node, TPHRASE *prevnode, TPHRASE *nextnode) {
-  node -> prev = prevnode;
-  node -> next = nextnode;
-  prevnode -> next = node;
-  nextnode -> prev = node;
-  return (node);
-}
-
-/*
-**  Deletes a tphrase node from a doubly linked list and deallocat
-**  memory
-*/
-void deleteTPhraseNode (PROG_INFO *prog_struct, TPHRASE *tph) {
+void deleteTPhraseNode (BLOCK_INFO *block_struct, TPHRASE *tph) {
   R_UINT i;
   SEQ_NODE *current = tph -> position;
   R_UINT tphrasecount = tph -> count;
 
-  if (tph -> count > prog_struct -> seq_nodelist_size) {
-    while (tph -> count > prog_struct -> seq_nodelist_size) {
-      prog_struct -> seq_nodelist_size = prog_struct -> seq_nodelist_size << 1;
+  if (tph -> count > block_struct -> seq_nodelist_size) {
+    changeMemory (block_struct -> memory, MEM_SEQUENCE, block_struct -> seq_nodelist_size * sizeof (SEQ_NODE*), 0);
+    while (tph -> count > block_struct -> seq_nodelist_size) {
+      block_struct -> seq_nodelist_size = block_struct -> seq_nodelist_size << 1;
     }
 #ifdef DEBUG
-    fprintf (stderr, "Enlarging to %u\n", prog_struct -> seq_nodelist_size);
+    fprintf (stderr, "Enlarging to %u\n", block_struct -> seq_nodelist_size);
 #endif
-    prog_struct -> seq_nodelist = wrealloc (prog_struct -> seq_nodelist, prog_struct -> seq_nodelist_size * sizeof (SEQ_NODE*));
+    block_struct -> seq_nodelist = wrealloc (block_struct -> seq_nodelist, block_struct -> seq_nodelist_size * sizeof (SEQ_NODE*));
+    changeMemory (block_struct -> memory, MEM_SEQUENCE, 0, block_struct -> seq_nodelist_size * sizeof (SEQ_NODE*));
   }
 
-  /*  Unlink node from hash table  */
-  (tph -> prev) -> next = tph -> next;
-  (tph -> next) -> prev = tph -> prev;
-  tph -> prev = NULL;
-  tph -> next = NULL;
+  /*  Remove node from hash table  */
+  removePair (block_struct, tph);
 
   /*  Unlink node from queue  */
   (tph -> prev_queue) -> next_queue = tph -> next_queue;
@@ -149,65 +135,27 @@ void deleteTPhraseNode (PROG_INFO *prog_struct, TPHRASE *tph) {
 
   /*  Place all of the seq_nodes into an array  */
   for (i = 0; i < tph -> count; i++) {
-    prog_struct -> seq_nodelist[i] = current;
-    current = current -> next_ptr;
+    block_struct -> seq_nodelist[i] = current;
+    current = SEQNEXT (block_struct, current);
   }
 
   /*  Integrity check  */
   if (current != tph -> position) {
-    fprintf (stderr, "Unexpected error:  current != tph -> position in deleteTPhraseNode in %s, line %u.", __FILE__, __LINE__);
-    exit (EXIT_FAILURE);
+    raiseError ("Unexpected error:  current != tph -> position in deleteTPhraseNode in %s, line %u.", __FILE__, __LINE__);
   }
 
   /*  Unlink seq_nodes  */
   for (i = 0; i < tphrasecount; i++) {
-    unlinkSeqPtr (prog_struct -> seq_nodelist[i], tph);
+    unlinkSeqPtr (block_struct -> seq_nodelist[i], tph, block_struct);
   }
 
-  /*  Deallocate memory  */
-  wfree (tph);
+  /*  Return memory to the block's pool  */
+  sfree (block_struct -> tphrase_root, tph);
 
   return;
 }
 
 
-/*  Insert given node before the node pointed to by list  */
-TPHRASE *insertTPhraseLast (TPHRASE *node, TPHRASE **list) {
-  TPHRASE *newnode;
-
-  if ((*list) != NULL) {
-    newnode = insertTPhraseNode (node, (*list) -> prev, (*list));
-  }
-  else {
-    newnode = node;
-    (*list) = newnode;
-  }
-
-  return (newnode);
-}
-
-
-/*  Detach node from hash table's doubly-linked list  */
-TPHRASE *unlinkTPhraseList (TPHRASE *unlinknode, TPHRASE **arr) {
-  if ((arr != NULL) && ((*arr) != NULL)) {
-    if ((*arr) == unlinknode) {
-      if (((*arr) == (*arr) -> prev) && ((*arr) == (*arr) -> next)) {
-        (*arr) = NULL;
-      }
-      else {
-        (*arr) = (*arr) -> prev;
-      }
-    }
-  }
-
-  (unlinknode -> prev) -> next = unlinknode -> next;
-  (unlinknode -> next) -> prev = unlinknode -> prev;
-  unlinknode -> next = unlinknode;
-  unlinknode -> prev = unlinknode;
-  return (unlinknode);
-}
-
-
 /*  Attach a node to the priority queue between prevnode and nextnode  */
 static TPHRASE *insertTPhraseNodeQueue (TPHRASE *oldnode, TPHRASE *prevnode, TPHRASE *nextnode) {
 
@@ -259,9 +207,11 @@ TPHRASE *unlinkTPhraseQueue (TPHRASE *unlinknode, TPHRASE **queue) {
 /*  Transfer a tphrase's information into a phrase  */
 R_UINT transferTPhraseNode (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT pos, SEQ_NODE *firstnode, SEQ_NODE *secondnode, R_UINT generation) {
   PHRASE *ph = &block_struct -> temp_phrases[pos];
+  R_UCHAR *tags = block_struct -> phrase_tags;
 
   enum R_PHRASE_TYPE first_type;
   enum R_PHRASE_TYPE second_type;
+  enum R_PHRASE_TYPE my_type;
 
   ph -> left = firstnode -> value;
   ph -> left_chiastic = 0;                           /*  Used later  */
@@ -273,30 +223,36 @@ R_UINT transferTPhraseNode (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_
   ph -> temp_index = pos;
   ph -> final_index = 0;                             /*  Used later  */
 
+  /*  Only the heuristics need the type and side  */
+  if (tags == NULL) {
+    return (pos);
+  }
+
+  my_type = PT_NONE;
   if (prog_struct -> apply_heuristics == HEUR_WA) {
-    first_type = block_struct -> temp_phrases[ph -> left].mytype;
-    second_type = block_struct -> temp_phrases[ph -> right].mytype;
+    first_type = TAGTYPE (tags[ph -> left]);
+    second_type = TAGTYPE (tags[ph -> right]);
 
-    ph -> mytype = PT_WORD;
+    my_type = PT_WORD;
     if ((first_type == PT_NON_WORD) && (second_type == PT_NON_WORD)) {
-      ph -> mytype = PT_NON_WORD;
+      my_type = PT_NON_WORD;
     }
 
     if ((first_type == PT_MIXED) || (second_type == PT_MIXED) || 
         first_type != second_type) {
-      ph -> mytype = PT_MIXED;
+      my_type = PT_MIXED;
     }
   }
 
-  if (block_struct -> temp_phrases[ph -> left].myside != SIDE_NONE) {
+  if (TAGSIDE (tags[ph -> left]) != SIDE_NONE) {
   } 
-  else if (block_struct -> temp_phrases[ph -> right].myside != SIDE_NONE) {
+  else if (TAGSIDE (tags[ph -> right]) != SIDE_NONE) {
   }
   else {
-    block_struct -> temp_phrases[ph -> left].myside = SIDE_LEFT;
-    block_struct -> temp_phrases[ph -> right].myside = SIDE_RIGHT;
+    SETTAGSIDE (tags[ph -> left], SIDE_LEFT);
+    SETTAGSIDE (tags[ph -> right], SIDE_RIGHT);
   }
-  block_struct -> temp_phrases[pos].myside = SIDE_NONE;
+  tags[pos] = (R_UCHAR) (MAKETAG (my_type, SIDE_NONE) | TAG_PHRASE);
 
   return (pos);
 }
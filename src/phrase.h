@@ -31,8 +31,6 @@
 Structure definitions
 ******************************/
 typedef struct tphrase {
-  struct tphrase *prev;                   /*  Pointers for hash table  */
-  struct tphrase *next;
   struct tphrase *prev_queue;         /*  Pointers for priority queue  */
   struct tphrase *next_queue;
   struct seq_node *position;               /*  Pointers for seq_nodes  */
@@ -57,22 +55,18 @@ typedef struct phrase {
   R_UINT length;                                   /*  Phrase's length  */
   R_UINT temp_index;                         /*  Temporary index value  */
   R_UINT final_index;                            /*  Final index value  */
-  enum R_PHRASE_TYPE mytype;
-  enum R_PHRASE_SIDE myside;
 } PHRASE;
 
 
 /*  Functions for manipulating tphrases with seq nodes  */
-void unlinkSeqPtr (SEQ_NODE *deletenode, TPHRASE *tph);
-void insertSeqPtrFirst (SEQ_NODE *newnode, TPHRASE *tph);
-void insertSeqPtrLast (SEQ_NODE *newnode, TPHRASE *tph);
+void unlinkSeqPtr (SEQ_NODE *deletenode, TPHRASE *tph, BLOCK_INFO *block_struct);
+void insertSeqPtrFirst (SEQ_NODE *newnode, TPHRASE *tph, BLOCK_INFO *block_struct);
+void insertSeqPtrLast (SEQ_NODE *newnode, TPHRASE *tph, BLOCK_INFO *block_struct);
 
-TPHRASE *initTPhrase (PROG_INFO *prog_struct, R_UINT left, R_UINT right, SEQ_NODE *ptrnode);
+TPHRASE *initTPhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT left, R_UINT right, SEQ_NODE *ptrnode);
 
-/*  Functions for manipulating tphrases with hash table linked list  */
-void deleteTPhraseNode (PROG_INFO *prog_struct, TPHRASE *deletenode);
-TPHRASE *insertTPhraseLast (TPHRASE *node, TPHRASE **list);
-TPHRASE *unlinkTPhraseList (TPHRASE *unlinknode, TPHRASE **arr);
+/*  Functions for removing tphrases from the hash table  */
+void deleteTPhraseNode (BLOCK_INFO *block_struct, TPHRASE *deletenode);
 
 /*  Functions for manipulating tphrases with queues  */
 void insertTPhraseLastQueue (TPHRASE *node, TPHRASE **list);
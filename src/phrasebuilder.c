@@ -30,6 +30,8 @@
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
 #include "repair-defn.h"
 #include "seq.h"
 #include "pair.h"
@@ -37,30 +39,18 @@
 #include "phrase-slide-encode.h"
 #include "phrasebuilder.h"
 
-static void removeTentativePhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, TPHRASE *deletenode, TPHRASE **queue, TPHRASE **arr);
+static void removeTentativePhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, TPHRASE *deletenode, TPHRASE **queue);
+static R_INT queueOrderComparison (const QUEUE_ORDER *first, const QUEUE_ORDER *second);
 static void decrCount (SEQ_NODE *seqentry, PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
-static void incrCount (SEQ_NODE *seqentry, PROG_INFO *prog_struct, BLOCK_INFO *block_struct, PAIRED **alreadypaired);
+static void incrCount (SEQ_NODE *seqentry, PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 
 /*
 **  Delete a tentative phrase from the priority queue and the
 **  hash table.  Performs checks to make sure the tentative
 **  phrase is not the first on the list.
 */
-static void removeTentativePhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, TPHRASE *deletenode, TPHRASE **queue, TPHRASE **arr) {
+static void removeTentativePhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, TPHRASE *deletenode, TPHRASE **queue) {
   block_struct -> tphrase_in_use -= 1;
-  if ((arr != NULL) && ((*arr) != NULL)) {
-    if ((*arr) == deletenode) {
-      if (((*arr) == (*arr) -> prev) && ((*arr) == (*arr) -> next)) {
-	 (*arr) = NULL;  
-                          /*  tphrase is last in slot; make slot NULL  */
-      }
-      else {
-        (*arr) = (*arr) -> next;
-		   /*  tphrase is first in the slot; move to next one  */
-      }
-    }
-  }
-
   if ((queue != NULL) && ((*queue) != NULL)) {
     if ((*queue) == deletenode) {
       if (((*queue) == (*queue) -> prev_queue) && ((*queue) == (*queue) -> next_queue)) {
@@ -74,52 +64,69 @@ static void removeTentativePhrase (PROG_INFO *prog_struct, BLOCK_INFO *block_str
     }
   }
 
-  deleteTPhraseNode (prog_struct, deletenode);
+  deleteTPhraseNode (block_struct, deletenode);
 
   return;
 }
 
 
+/*
+**  Comparison function used by qsort to order tphrases for initQueue:
+**  by hashCode, then by first occurrence in the sequence.  This is
+**  the order the tphrases were chained in when the hash table was a
+**  fixed array of TENTPHRASE_SIZE lists, and ties in the priority
+**  queue are broken by it, so it must be kept for identical output.
+**  The hash codes are computed once, before sorting.
+*/
+static R_INT queueOrderComparison (const QUEUE_ORDER *first, const QUEUE_ORDER *second) {
+  if (first -> hash != second -> hash) {
+    return (first -> hash > second -> hash ? 1 : -1);
+  }
+  if (first -> position != second -> position) {
+    return (first -> position > second -> position ? 1 : -1);
+  }
+  return (0);
+}
+
+
 /*
 **  Initialize the priority queue by going through the hash table
-**  looking for non-NULL entries.  If a non-NULL entry is found, then
-**  the entire list is processed by first counting the length of the
-**  list and then processing everything.
+**  and collecting its tphrases.  They are put in a fixed order and
+**  then each is either queued or, if it occurs fewer than
+**  max_keep_count times, removed.
 */
 void initQueue (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
-  R_UINT i, k;
-  TPHRASE *currentphrase;
-  TPHRASE *headphrase;
-  TPHRASE *deletephrase = NULL;
+  R_UINT i;
   R_UINT phrase_count = 0;
+  QUEUE_ORDER *phraselist;
+  TPHRASE *tph;
+  size_t phraselist_size = (block_struct -> tent_phrases_used + 1) * sizeof (QUEUE_ORDER);
 
+  phraselist = wmalloc (phraselist_size);
+  changeMemory (block_struct -> memory, MEM_QUEUE, 0, phraselist_size);
   for (i = 0; i < block_struct -> tent_phrases_size; i++) {
-    headphrase = block_struct -> tent_phrases[i];
-    currentphrase = headphrase;
-    if (headphrase != NULL) {
-      phrase_count = 0;
-      deletephrase = NULL;
-      /*  Count the number of phrases  */
-      do {
-	phrase_count++;
-	currentphrase = currentphrase -> next;
-      } while (headphrase != currentphrase);
-
-      /*  Process each phrase  */
-      currentphrase = headphrase;
-      for (k = 0; k < phrase_count; k++) {
-        if (currentphrase -> count >= (prog_struct -> max_keep_count)) {
-          insertTPhraseLastQueue (currentphrase, &(block_struct -> pqueue[currentphrase -> count]));
-	  currentphrase = currentphrase -> next;
-        }
-	else {
-	  deletephrase = currentphrase;
-	  currentphrase = currentphrase -> next;
-	  removeTentativePhrase (prog_struct, block_struct, deletephrase, NULL, &(block_struct -> tent_phrases[i]));
-	}
-      }
+    tph = block_struct -> tent_phrases[i];
+    if (tph != NULL) {
+      phraselist[phrase_count].hash = hashCode (tph -> left, tph -> right);
+      phraselist[phrase_count].position = tph -> position;
+      phraselist[phrase_count].tph = tph;
+      phrase_count++;
+    }
+  }
+  qsort (phraselist, (size_t) phrase_count, sizeof (QUEUE_ORDER), (R_INT (*)(const void *,const void *))queueOrderComparison);
+
+  /*  Process each phrase  */
+  for (i = 0; i < phrase_count; i++) {
+    tph = phraselist[i].tph;
+    if (tph -> count >= (prog_struct -> max_keep_count)) {
+      insertTPhraseLastQueue (tph, &(block_struct -> pqueue[tph -> count]));
+    }
+    else {
+      removeTentativePhrase (prog_struct, block_struct, tph, NULL);
     }
   }
+  wfree (phraselist);
+  changeMemory (block_struct -> memory, MEM_QUEUE, phraselist_size, 0);
 
   return;
 }
@@ -131,38 +138,26 @@ void initQueue (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
 **  phrase count becomes 0.
 */
 static void decrCount (SEQ_NODE *seqentry, PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
-  R_UINT hashcode;
   TPHRASE *currentphrase;
-  TPHRASE *headphrase;
 
-  if ((seqentry -> prev_ptr != NULL) && (seqentry -> next_ptr != NULL)) {
-    hashcode = hashCode (seqentry -> value, NEXTSEQVALUE);
-    headphrase = block_struct -> tent_phrases[hashcode];
-    currentphrase = headphrase;
+  if ((SEQPREV (block_struct, seqentry) != NULL) && (SEQNEXT (block_struct, seqentry) != NULL)) {
+    currentphrase = findPair (block_struct, seqentry -> value, NEXTSEQVALUE);
 
-    if (headphrase != NULL) {
-      do {
-        if ((currentphrase -> left != seqentry -> value) || (currentphrase -> right != NEXTSEQVALUE)) {
-          currentphrase = currentphrase -> next;
-        }
-        else {
-          /*  Check if this seq_node is the first on the position list  */
-          if ((currentphrase -> position) == seqentry) {
-            currentphrase -> position = (currentphrase -> position) -> next_ptr;
-          }
-          (void) unlinkTPhraseQueue (currentphrase, &(block_struct -> pqueue[currentphrase -> count]));
-          unlinkSeqPtr (seqentry, currentphrase);
+    if (currentphrase != NULL) {
+      /*  Check if this seq_node is the first on the position list  */
+      if ((currentphrase -> position) == seqentry) {
+        currentphrase -> position = SEQNEXT (block_struct, currentphrase -> position);
+      }
+      (void) unlinkTPhraseQueue (currentphrase, &(block_struct -> pqueue[currentphrase -> count]));
+      unlinkSeqPtr (seqentry, currentphrase, block_struct);
 
 		  /*  Decide if tphrase should be deleted or reinserted  */
-          if (currentphrase -> count == 0) {
-            removeTentativePhrase (prog_struct, block_struct, currentphrase, NULL, &(block_struct -> tent_phrases[hashcode]));
-          }
-          else {
-            insertTPhraseLastQueue (currentphrase, &(block_struct -> pqueue[currentphrase -> count]));
-          }
-          return;
-        }
-      } while (currentphrase != headphrase);
+      if (currentphrase -> count == 0) {
+        removeTentativePhrase (prog_struct, block_struct, currentphrase, NULL);
+      }
+      else {
+        insertTPhraseLastQueue (currentphrase, &(block_struct -> pqueue[currentphrase -> count]));
+      }
     }
   }
 
@@ -175,68 +170,41 @@ static void decrCount (SEQ_NODE *seqentry, PROG_INFO *prog_struct, BLOCK_INFO *b
 **  tentative phrase and add it to the hash table and priority queue
 **  if necessary.
 */
-static void incrCount (SEQ_NODE *seqentry, PROG_INFO *prog_struct, BLOCK_INFO *block_struct, PAIRED **alreadypaired) {
-  R_UINT hashcode;
+static void incrCount (SEQ_NODE *seqentry, PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   TPHRASE *currentphrase;
-  TPHRASE *headphrase;
-  PAIRED *headpaired;
-  PAIRED *currentpaired;
 
-  if (!isValidPair (prog_struct, block_struct, seqentry, NEXTSEQ)) {
+  if (!ISVALIDPAIR (prog_struct, block_struct, seqentry, NEXTSEQ)) {
     return;
   }
 
-  hashcode = hashCode (seqentry -> value, NEXTSEQVALUE);
-
-  headpaired = alreadypaired[hashcode];
-  currentpaired = headpaired;
-  if (currentpaired != NULL) {
-    while (currentpaired != NULL) {
-      if ((currentpaired -> left == seqentry -> value) && (currentpaired -> right == NEXTSEQVALUE)) {
+  if (findPaired (block_struct, seqentry -> value, NEXTSEQVALUE) == R_TRUE) {
 #ifdef DEBUG
-        fprintf (stderr, "Previous pair (%d, %d) found.\n", currentpaired -> left, currentpaired -> right);
+    fprintf (stderr, "Previous pair (%d, %d) found.\n", seqentry -> value, NEXTSEQVALUE);
 #endif
-        return;
-      }
-      currentpaired = currentpaired -> next;
-    }
+    return;
   }
 
-  headphrase = block_struct -> tent_phrases[hashcode];
-  currentphrase = headphrase;
+  currentphrase = findPair (block_struct, seqentry -> value, NEXTSEQVALUE);
 
-  /*  Hash table slot is NULL  */
-  if (currentphrase == NULL) {
-    currentphrase = initTPhrase (prog_struct, seqentry -> value, NEXTSEQVALUE, seqentry);
-    block_struct -> tent_phrases[hashcode] = currentphrase;
-    block_struct -> tphrase_in_use += 1;
-    currentphrase = block_struct -> tent_phrases[hashcode];
+  if (currentphrase != NULL) {
+    /*  Check neighbouring seq_nodes to see if they will be replaced */
+    if ((SEQPREV (block_struct, currentphrase -> position) == NEXTSEQ) || (SEQPREV (block_struct, currentphrase -> position) == PREVSEQ)) {
+      return;
+    }
+    insertSeqPtrLast (seqentry, currentphrase, block_struct);
+	               /*  Insert seqentry into tphrase's position list  */
+    currentphrase = unlinkTPhraseQueue (currentphrase, &(block_struct -> pqueue[(currentphrase -> count) - 1]));
     insertTPhraseLastQueue (currentphrase, &(block_struct -> pqueue[currentphrase -> count]));
     return;
   }
 
-  do {
-    if ((currentphrase -> left != seqentry -> value) || (currentphrase -> right != NEXTSEQVALUE)) {
-      currentphrase = currentphrase -> next;
-    }
-    else {
-      /*  Check neighbouring seq_nodes to see if they will be replaced */
-      if (((currentphrase -> position) -> prev_ptr == NEXTSEQ) || ((currentphrase -> position) -> prev_ptr == PREVSEQ)) {
-        return;
-      }
-      insertSeqPtrLast (seqentry, currentphrase);
-	               /*  Insert seqentry into tphrase's position list  */
-      currentphrase = unlinkTPhraseQueue (currentphrase, &(block_struct -> pqueue[(currentphrase -> count) - 1]));
-      insertTPhraseLastQueue (currentphrase, &(block_struct -> pqueue[currentphrase -> count]));
-      return;
-      }  /*  else  */
-  } while (currentphrase != headphrase);
-
-     /*  Hash table slot is not NULL, but this pair was not found.  So  */
-                                             /*  create a new tphrase.  */
-  currentphrase = initTPhrase (prog_struct, seqentry -> value, NEXTSEQVALUE, seqentry);
-  (void) insertTPhraseLast (currentphrase, &(block_struct -> tent_phrases[hashcode]));
+                   /*  This pair was not found, so create a new tphrase  */
+  currentphrase = initTPhrase (prog_struct, block_struct, seqentry -> value, NEXTSEQVALUE, seqentry);
+  insertPair (block_struct, currentphrase);
   block_struct -> tphrase_in_use += 1;
+  if (block_struct -> tphrase_in_use > block_struct -> max_tphrase_in_use) {
+    block_struct -> max_tphrase_in_use = block_struct -> tphrase_in_use;
+  }
   insertTPhraseLastQueue (currentphrase, &(block_struct -> pqueue[currentphrase -> count]));
 
   return;
@@ -267,15 +235,11 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_UINT oldvalue;
 
   SEQ_NODE **seqentrylist;
-  R_UINT seqentrylist_count = (prog_struct -> max_buffer_size >> 1);
+  R_UINT seqentrylist_count = (block_struct -> in_length >> 1) + 1;
 
   R_UINT tphrasecount;
   R_UINT leftunit, rightunit, generation;
 
-  PAIRED **alreadypaired;
-  PAIRED *prevpaired;
-  PAIRED *currpaired;
-  R_UINT hashvalue;
 
   enum R_HEURISTICS apply_heuristics = prog_struct -> apply_heuristics;
   enum R_PHRASE_SIDE leftside = SIDE_NONE;
@@ -290,11 +254,9 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   FOPEN ("numpairs.data", numpairs_fp, "w");
 #endif
 
-  alreadypaired = wmalloc (((R_UINT) TENTPHRASE_SIZE) * (sizeof (PAIRED*)));
-  for (i = 0; i < (R_UINT) TENTPHRASE_SIZE; i++) {
-    alreadypaired[i] = NULL;
-  }
+  initPairedTable (block_struct);
   seqentrylist = wmalloc (seqentrylist_count * (sizeof (SEQ_NODE*)));
+  changeMemory (block_struct -> memory, MEM_SEQUENCE, 0, seqentrylist_count * (sizeof (SEQ_NODE*)));
 
   block_struct -> num_phrases = 0;
 
@@ -303,8 +265,10 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
     current = block_struct -> pqueue[block_struct -> max_count];
     if (current != NULL) {
       do {
-        leftside = block_struct -> temp_phrases[(current -> position) -> value].myside;
-        rightside = block_struct -> temp_phrases[CURRENTPOSNEXTSEQ -> value].myside;
+        if (block_struct -> phrase_tags != NULL) {
+          leftside = TAGSIDE (block_struct -> phrase_tags[(current -> position) -> value]);
+          rightside = TAGSIDE (block_struct -> phrase_tags[CURRENTPOSNEXTSEQ -> value]);
+        }
 
         /*  Obtain generation of the two nodes  */
         leftunit = block_struct -> temp_phrases[(current -> position) -> value].generation;
@@ -318,11 +282,15 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
 
         if ((block_struct -> num_phrases + block_struct -> prims_array_size) > block_struct -> temp_phrases_size) {
           if (block_struct -> temp_phrases_size > (UINT_MAX >> 1)) {
-            fprintf (stderr, "ERROR.  Maximum number of phrases of %u exceeded!\n", block_struct -> num_phrases + block_struct -> prims_array_size);
-            exit (EXIT_FAILURE);
+            raiseError ("ERROR.  Maximum number of phrases of %u exceeded!\n", block_struct -> num_phrases + block_struct -> prims_array_size);
 	  }
           block_struct -> temp_phrases_size = block_struct -> temp_phrases_size << 1;
           block_struct -> temp_phrases = wrealloc (block_struct -> temp_phrases, (block_struct -> temp_phrases_size) * (sizeof (PHRASE)));
+          changeMemory (block_struct -> memory, MEM_PHRASES, (block_struct -> temp_phrases_size >> 1) * (sizeof (PHRASE)), (block_struct -> temp_phrases_size) * (sizeof (PHRASE)));
+          if (block_struct -> phrase_tags != NULL) {
+            block_struct -> phrase_tags = wrealloc (block_struct -> phrase_tags, (block_struct -> temp_phrases_size) * (sizeof (R_UCHAR)));
+            changeMemory (block_struct -> memory, MEM_PHRASES, (block_struct -> temp_phrases_size >> 1) * (sizeof (R_UCHAR)), (block_struct -> temp_phrases_size) * (sizeof (R_UCHAR)));
+          }
         }
 
         /*  Calculate generation of phrase  */
@@ -337,21 +305,24 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
         y = transferTPhraseNode (prog_struct, block_struct, (block_struct -> prims_array_size - 1) + replacements, current -> position, CURRENTPOSNEXTSEQ, generation);
 
         if (seqentrylist_count < current -> count) {
+          changeMemory (block_struct -> memory, MEM_SEQUENCE, seqentrylist_count * (sizeof (SEQ_NODE*)), 0);
           while (seqentrylist_count < current -> count) {
             /*  Increase number of SEQ_NODEs  */
             seqentrylist_count = seqentrylist_count << 1;
 	  }
           seqentrylist = wrealloc (seqentrylist, seqentrylist_count * (sizeof (SEQ_NODE*)));
+          changeMemory (block_struct -> memory, MEM_SEQUENCE, 0, seqentrylist_count * (sizeof (SEQ_NODE*)));
         }
 
         dlist = current -> position;
         for (replacecount = 0; replacecount < current -> count; replacecount++) {
           seqentrylist[replacecount] = dlist;
-          dlist = dlist -> next_ptr;
+          dlist = SEQNEXT (block_struct, dlist);
         }
 
 		/*  Get count since recursive pairing will change it  */
         tphrasecount = current -> count;
+        block_struct -> num_replacements += tphrasecount;
         for (replacecount = 0; replacecount < tphrasecount; replacecount++) {
 
  		                   /*  Get the seq_entry to be replaced  */
@@ -365,8 +336,8 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
             decrCount (NEXTSEQ, prog_struct, block_struct);
 	  }
 
-	  if (seqentry -> punc_type != NEXTSEQ -> punc_type) {
-            seqentry -> punc_type = WT_PUNC;
+	  if (SEQPUNC (seqentry) != SEQPUNC (NEXTSEQ)) {
+            SETSEQPUNC (seqentry, WT_PUNC);
 	  }
 	  else {
 	    /*  No change to punctuation type  */
@@ -374,16 +345,16 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
 
 		        /*  Delete the second of the two to be replaced  */
           deleteSeqNode (NEXTSEQ, block_struct);
-          unlinkSeqPtr (seqentry, current);
+          unlinkSeqPtr (seqentry, current, block_struct);
           oldvalue = seqentry -> value;
           seqentry -> value = y;                    /*  Replace character  */
 
 		              /*  Increment count of neighbouring nodes  */
           if (seqentry != block_struct -> seq_buf) {
-            incrCount (PREVSEQ, prog_struct, block_struct, alreadypaired);
+            incrCount (PREVSEQ, prog_struct, block_struct);
 	  }
           if ((seqentry != block_struct -> seq_buf_end) && (NEXTSEQ != block_struct -> seq_buf)) {
-            incrCount (seqentry, prog_struct, block_struct, alreadypaired);
+            incrCount (seqentry, prog_struct, block_struct);
 	  }
 
 	/*  
@@ -400,16 +371,16 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   	  if (seqentry != block_struct -> seq_buf_end) {
             alpha = NEXTSEQ;
             if (alpha != block_struct -> seq_buf_end) {
-              beta = ((alpha + 1) -> value == SEQ_NODE_DELETED ? (alpha + 1) -> next_ptr : (alpha + 1));
+              beta = ((alpha + 1) -> value == SEQ_NODE_DELETED ? SEQNEXT (block_struct, alpha + 1) : (alpha + 1));
               if (beta != block_struct -> seq_buf_end) {
   	      /*  If seqentry, alpha, and beta have the same values 
 	      **  and alpha is not the left side of a pair  */
-                if ((oldvalue == alpha -> value) && (alpha -> value == beta -> value) && (alpha -> next_ptr == NULL)) {
-                  gamma = ((beta + 1) -> value == SEQ_NODE_DELETED ? (beta + 1) -> next_ptr : (beta + 1));
+                if ((oldvalue == alpha -> value) && (alpha -> value == beta -> value) && (SEQNEXT (block_struct, alpha) == NULL)) {
+                  gamma = ((beta + 1) -> value == SEQ_NODE_DELETED ? SEQNEXT (block_struct, beta + 1) : (beta + 1));
                   /*  If gamma is a pair and beta and gamma have different values  */
-                  if ((gamma -> next_ptr != NULL) && (beta -> value != gamma -> value)) {
+                  if ((SEQNEXT (block_struct, gamma) != NULL) && (beta -> value != gamma -> value)) {
 	          /*  Make alpha into a pair  */
-	            incrCount (alpha, prog_struct, block_struct, alreadypaired);
+	            incrCount (alpha, prog_struct, block_struct);
 		  }
 	        }
 	      }
@@ -418,17 +389,12 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
         }
 
 	/*  Record pair  */
-	currpaired = wmalloc (sizeof (PAIRED));
-	currpaired -> left = current -> left;
-	currpaired -> right = current -> right;
-        hashvalue = hashCode (current -> left, current -> right);
-        currpaired -> next = alreadypaired[hashvalue];
-	alreadypaired[hashvalue] = currpaired;
+        insertPaired (block_struct, current -> left, current -> right);
 	}
         current = current -> next_queue;
 
  		                /*  Remove the current tentative phrase  */
-        removeTentativePhrase (prog_struct, block_struct, current -> prev_queue, &(block_struct -> pqueue[block_struct -> max_count]), &(block_struct -> tent_phrases[hashCode ((current -> prev_queue) -> left, (current -> prev_queue) -> right)]));
+        removeTentativePhrase (prog_struct, block_struct, current -> prev_queue, &(block_struct -> pqueue[block_struct -> max_count]));
         if ((block_struct -> pqueue[block_struct -> max_count]) == NULL) {
           current = NULL;
         } 
@@ -441,7 +407,7 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
 	  if (block_struct -> pqueue[i] != NULL) {
 	    for (temp_remove = (block_struct -> pqueue[i]) -> next_queue; block_struct -> pqueue[i] != NULL;) {
               temp_remove = temp_remove -> next_queue;
-              removeTentativePhrase (prog_struct, block_struct, temp_remove -> prev_queue, &(block_struct -> pqueue[i]), &(block_struct -> tent_phrases[hashCode ((temp_remove -> prev_queue) -> left, (temp_remove -> prev_queue) -> right)]));
+              removeTentativePhrase (prog_struct, block_struct, temp_remove -> prev_queue, &(block_struct -> pqueue[i]));
 	    }
           }
         }
@@ -465,20 +431,9 @@ void rePairPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   fprintf (stderr, "::: total number of replacements:  %d\n", replacements);
 #endif
 
-  /*  Clear the alreadypaired hash table  */
-  for (i = 0; i < (R_UINT) TENTPHRASE_SIZE; i++) {
-    if (alreadypaired[i] != NULL) {
-      currpaired = alreadypaired[i];
-      prevpaired = currpaired;
-      do {
-        currpaired = currpaired -> next;
-        wfree (prevpaired);
-        prevpaired = currpaired;
-      } while (currpaired != NULL);
-    }
-  }
-  wfree (alreadypaired);
+  uninitPairedTable (block_struct);
   wfree (seqentrylist);
+  changeMemory (block_struct -> memory, MEM_SEQUENCE, seqentrylist_count * (sizeof (SEQ_NODE*)), 0);
 
 #ifdef TPHRASE_IN_USE
   fprintf (stderr, "Maximum difference in pairs under consideration between two replacements:  %d\n", max_pairs_diff);
@@ -513,12 +468,14 @@ void sortPrimitives (BLOCK_INFO *block_struct) {
 
 
 /*
-**  Copies the phrases from a linked list to an array.  Then, it
-**  sorts the array by generation.  Afterwards, for each phrase in
-**  each generation, a unit is assigned to it.  A sort on unit is
-**  done on that generation and then finally, a final_index is
-**  assigned to each phrase.  This final_index is reassigned to all
-**  of the seq_nodes in the seq array.
+**  Orders the phrases by generation, with a counting sort of their
+**  positions in temp_phrases.  Afterwards, for each phrase in each
+**  generation, a unit is assigned to it.  The units of that
+**  generation are radix sorted and then finally, a final_index is
+**  assigned to each phrase and it is copied to that index of
+**  sort_phrases.  This final_index is also kept in new_index,
+**  through which the seq_nodes are translated when the sequence is
+**  written out.  The phrases are not moved in temp_phrases.
 */
 void sortPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_UINT i, j;
@@ -527,129 +484,152 @@ void sortPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_ULL_INT kpp = 0;
   R_ULL_INT kppSqr = 0;
   R_UINT number_of_prims = (block_struct -> sizelist) -> value;
-  R_UINT tempnPhrases = block_struct -> num_phrases;
   R_UINT currentsize;
   R_UINT currentgen;
   R_UINT leftarray;
-  R_UINT rightarray;
   R_UINT generations = 0;
                                /*  Start at 0, to include the primitives  */
   R_UINT *new_index;
+  R_UINT max_generation = 0;
+  R_UINT max_size = 0;
+  R_UINT *gen_start;
+              /*  Counts of each generation, then where each one starts  */
+  R_UINT *order;
+           /*  Positions of the phrases in temp_phrases, by generation  */
+  R_UINT *order_tmp;
+  R_ULL_INT *units;
+                           /*  Units of the generation being sorted  */
+  R_ULL_INT *units_tmp;
+  size_t scratch_size;
+  PHRASE *ph;
 
-  SEQ_NODE *seqentry;
   FILE *wordlen_fp = NULL;
   R_CHAR *wordlen_fname = NULL;
   R_UINT *wordlen = NULL;
   R_UINT maxwordlen = 0;
 
   new_index = wmalloc ((block_struct -> prims_array_size + block_struct -> num_phrases) * sizeof (R_UINT));
+  changeMemory (block_struct -> memory, MEM_PHRASES, 0, (block_struct -> prims_array_size + block_struct -> num_phrases) * sizeof (R_UINT));
 
-  /*  Keep track of the final_index for the primitives  */
+  /*
+  **  Keep track of the final_index for the primitives and copy them
+  **  to block_struct -> sort_phrases, omitting primitives that have
+  **  never been seen.
+  */
+  j = 0;
   for (i = 0; i < block_struct -> prims_array_size; i++) {
     new_index[i] = block_struct -> prims_array[i];
+    if (block_struct -> temp_phrases[i].generation != UNINITIALIZED_GENERATION) {
+      block_struct -> sort_phrases[j] = block_struct -> temp_phrases[i];
+      j++;
+    }
   }
 
   kp = number_of_prims;
-    
-  j = number_of_prims;
+
   for (i = block_struct -> prims_array_size; i < (block_struct -> prims_array_size + block_struct -> num_phrases); i++) {
+    ph = &block_struct -> temp_phrases[i];
 
                /*  If either the left or right value of the phrase is a  */
 	                      /*  primitive, then assign the unit value  */
-    if (block_struct -> temp_phrases[i].left < block_struct -> prims_array_size) {
-      block_struct -> temp_phrases[i].left_chiastic = block_struct -> temp_phrases[block_struct -> temp_phrases[i].left].final_index;
+    if (ph -> left < block_struct -> prims_array_size) {
+      ph -> left_chiastic = block_struct -> temp_phrases[ph -> left].final_index;
     }
-    if (block_struct -> temp_phrases[i].right < block_struct -> prims_array_size) {
-      block_struct -> temp_phrases[i].right_chiastic = block_struct -> temp_phrases[block_struct -> temp_phrases[i].right].final_index;
+    if (ph -> right < block_struct -> prims_array_size) {
+      ph -> right_chiastic = block_struct -> temp_phrases[ph -> right].final_index;
     }
 
-    block_struct -> temp_phrases[i].temp_index = i;
+    ph -> temp_index = i;
 	          /*  Store the phrase's old position for faster lookup  */
+    if (ph -> generation > max_generation) {
+      max_generation = ph -> generation;
+    }
   }
 
-    /*  Quicksort all of the phrases using their generations  */
-  qsort (&block_struct -> temp_phrases[block_struct -> prims_array_size], (size_t) block_struct -> num_phrases, sizeof (PHRASE), (R_INT (*)(const void *,const void *))genComparison);
+  /*  Count the phrases of each generation in gen_start[g + 1]  */
+  gen_start = wmalloc ((max_generation + 2) * sizeof (R_UINT));
+  (void) memset (gen_start, 0, (max_generation + 2) * sizeof (R_UINT));
+  for (i = block_struct -> prims_array_size; i < (block_struct -> prims_array_size + block_struct -> num_phrases); i++) {
+    gen_start[block_struct -> temp_phrases[i].generation + 1]++;
+  }
+  for (i = 1; i <= max_generation + 1; i++) {
+    if (gen_start[i] > max_size) {
+      max_size = gen_start[i];
+    }
+    gen_start[i] += gen_start[i - 1];
+  }
 
-    /*  Start from the first phrase  */
-  leftarray = rightarray = block_struct -> prims_array_size;
+  scratch_size = (max_generation + 2) * sizeof (R_UINT) + ((size_t) block_struct -> num_phrases + 1) * sizeof (R_UINT) + ((size_t) max_size + 1) * (sizeof (R_UINT) + 2 * sizeof (R_ULL_INT));
+  changeMemory (block_struct -> memory, MEM_PHRASES, 0, scratch_size);
+  order = wmalloc (((size_t) block_struct -> num_phrases + 1) * sizeof (R_UINT));
+  order_tmp = wmalloc (((size_t) max_size + 1) * sizeof (R_UINT));
+  units = wmalloc (((size_t) max_size + 1) * sizeof (R_ULL_INT));
+  units_tmp = wmalloc (((size_t) max_size + 1) * sizeof (R_ULL_INT));
 
-  while (tempnPhrases > 0) {
-    currentsize = 0;
-    generations++;
-    currentgen = block_struct -> temp_phrases[leftarray].generation;
- 	                                    /*  Get current generation  */
-
-      /*  Obtain all phrases from current generation  */
-    while (block_struct -> temp_phrases[rightarray].generation == currentgen) {
-      rightarray++;
-      currentsize++;
+  /*
+  **  Counting sort of the positions by generation.  It is stable, so
+  **  each generation is in the order of the positions.  Afterwards,
+  **  gen_start[g] is where generation g + 1 starts in order.
+  */
+  for (i = block_struct -> prims_array_size; i < (block_struct -> prims_array_size + block_struct -> num_phrases); i++) {
+    order[gen_start[block_struct -> temp_phrases[i].generation]++] = i;
+  }
 
-	/*  Prevent rightarray from going pass the array size  */
-      if (rightarray - leftarray == tempnPhrases) {
-        break;
-      }
+  j = number_of_prims;
+  for (currentgen = 1; currentgen <= max_generation; currentgen++) {
+    leftarray = gen_start[currentgen - 1];
+    currentsize = gen_start[currentgen] - leftarray;
+    if (currentsize == 0) {
+      continue;
     }
+    generations++;
+
         /*  Add size to sizeList for later retrieval  */
     endsizeList -> next = initSListNode (currentsize);
     endsizeList = endsizeList -> next;
 
         /*  Assign left and right unit to phrases of the current generation  */
-                         /*  if the left and right value are not primitives  */
+     /*  if the left and right value are not primitives, then calculate  */
+                           /*  Horizontal or Chiastic slide on phrases  */
     for (i = 0; i < currentsize; i++) {
-      if (block_struct -> temp_phrases[leftarray + i].left >= block_struct -> prims_array_size) {
-        block_struct -> temp_phrases[leftarray + i].left_chiastic = new_index[block_struct -> temp_phrases[leftarray + i].left];
+      ph = &block_struct -> temp_phrases[order[leftarray + i]];
+      if (ph -> left >= block_struct -> prims_array_size) {
+        ph -> left_chiastic = new_index[ph -> left];
       }
-      if (block_struct -> temp_phrases[leftarray + i].right >= block_struct -> prims_array_size) {
-        block_struct -> temp_phrases[leftarray + i].right_chiastic = new_index[block_struct -> temp_phrases[leftarray + i].right];
+      if (ph -> right >= block_struct -> prims_array_size) {
+        ph -> right_chiastic = new_index[ph -> right];
       }
+      ph -> unit = chiasticSlide (ph -> left_chiastic, ph -> right_chiastic, kp, kpp, kppSqr);
+      units[i] = ph -> unit;
     }
 
-    /*  Calculate Horizontal or Chiastic slide on phrases  */
-    for (i = 0; i < currentsize; i++) {
-      block_struct -> temp_phrases[leftarray + i].unit = chiasticSlide (block_struct -> temp_phrases[leftarray + i].left_chiastic, block_struct -> temp_phrases[leftarray + i].right_chiastic, kp, kpp, kppSqr);
-    }
-
-        /*  Quicksort phrases in current generation on unit  */
-    qsort (&block_struct -> temp_phrases[leftarray], (size_t) currentsize, sizeof (PHRASE), (R_INT (*)(const void *,const void *))unitComparison);
+        /*  Sort phrases in current generation on unit  */
+    radixSortUnits (units, &order[leftarray], units_tmp, order_tmp, currentsize);
 
         /*  Assign final index  */
     for (i = 0; i < currentsize; i++) {
-      new_index[block_struct -> temp_phrases[leftarray + i].temp_index] = j;
-      block_struct -> temp_phrases[leftarray + i].final_index = j;
+      ph = &block_struct -> temp_phrases[order[leftarray + i]];
+      new_index[ph -> temp_index] = j;
+      ph -> final_index = j;
+      block_struct -> sort_phrases[j] = *ph;
       j++;
     }
 
-        /*  Move the left array to the right array  */
-    leftarray = rightarray;
     kpp = kp;
     kppSqr = kpp * kpp;
     kp += currentsize;
-    tempnPhrases -= currentsize;
   }
 
-  /*  Update seq_nodes with new index values  */
-  seqentry = block_struct -> seq_buf;
-  do {
-    seqentry -> value = new_index[seqentry -> value];
-    if (seqentry == block_struct -> seq_buf_end) {
-      break;
-    }
-    seqentry = NEXTSEQ;
-  } while ((seqentry <= block_struct -> seq_buf_end) && (seqentry != block_struct -> seq_buf));
-
+  wfree (gen_start);
+  wfree (order);
+  wfree (order_tmp);
+  wfree (units);
+  wfree (units_tmp);
+  changeMemory (block_struct -> memory, MEM_PHRASES, scratch_size, 0);
 
-  /*
-  **  Copy block_struct -> temp_phrases to
-  **  block_struct -> sort_phrases, omitting primitives that have
-  **  never been seen.
-  */
-  j = 0;
-  for (i = 0; i < (block_struct -> prims_array_size + block_struct -> num_phrases); i++) {
-    if (block_struct -> temp_phrases[i].generation != UNINITIALIZED_GENERATION) {
-      block_struct -> sort_phrases[j] = block_struct -> temp_phrases[i];
-      j++;
-    }
-  }
+  /*  The seq_nodes are given their new index values as the sequence
+  **  is written out (encodeSequence_OneBlock)  */
+  block_struct -> new_index = new_index;
 
   block_struct -> num_generation = generations;
 
@@ -672,8 +652,6 @@ void sortPhrases (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
     FCLOSE (wordlen_fp);
   }
 
-  wfree (new_index);
-
   return;
 }
 
@@ -26,14 +26,12 @@
 #ifndef PHRASEBUILDER_H
 #define PHRASEBUILDER_H
 
-#define INIT_PAIRED_ARRAY_SIZE 65536
-
-/*  Symbol pairs that have already been paired  */
-typedef struct paired {
-  R_UINT left;
-  R_UINT right;
-  struct paired *next;
-} PAIRED;
+/*  A tphrase with the keys that initQueue orders it by  */
+typedef struct queueorder {
+  R_UINT hash;                                  /*  hashCode of the pair  */
+  struct seq_node *position;          /*  First occurrence in the sequence  */
+  struct tphrase *tph;
+} QUEUE_ORDER;
 
 /*  Initialization  */
 void initQueue (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
@@ -35,6 +35,9 @@ struct phrase;                                              /*  phrase.h  */
 struct tphrase;                                             /*  phrase.h  */
 struct memroot;                                            /*  smalloc.h  */
 struct memindex;                                           /*  smalloc.h  */
+struct bitoutrec;                                          /*  bitout.h  */
+struct stream_out;                                         /*  stream.h  */
+struct container_out;                                   /*  container.h  */
 
 /******************************
 Redefine common primitive data types
@@ -63,10 +66,28 @@ enum R_USE_WORDFLAGS { UW_NO = 0, UW_YES = 1 };
 
 enum R_HEURISTICS { HEUR_NONE = 0, HEUR_WA = 1, HEUR_SIDE = 2, HEUR_NORECUR = 3 };
 
+/*  Phases of each block which are timed (see stats.h)  */
+enum R_REPAIR_PHASE { PHASE_FILL = 0, PHASE_SCAN_PAIRS = 1, PHASE_INIT_QUEUE = 2, PHASE_REPAIR_PHRASES = 3, PHASE_SORT_PHRASES = 4, PHASE_ENCODE_HIERARCHY = 5, PHASE_ENCODE_SEQUENCE = 6, NUM_REPAIR_PHASES = 7 };
+
+/*  Structures whose memory is counted (see stats.h); 0 is the total  */
+enum R_REPAIR_MEMORY { MEM_SEQUENCE = 1, MEM_TPHRASES = 2, MEM_QUEUE = 3, MEM_PHRASES = 4, MEM_PAIRED = 5, MEM_IO_BUFFERS = 6, NUM_REPAIR_MEMORY = 7 };
+
 /*  Has the current phrase been used as a left phrase or 
 **  a right phrase?  */
 enum R_PHRASE_SIDE { SIDE_NONE = 0, SIDE_LEFT = 1, SIDE_RIGHT = 2 };
 
+/*
+**  The pairing heuristics (-e) look at one byte per primitive and
+**  phrase (BLOCK_INFO's phrase_tags), holding its R_PHRASE_TYPE, its
+**  R_PHRASE_SIDE and whether it is a phrase (generation above 0)
+*/
+#define TAG_SIDE_SHIFT 2
+#define TAG_PHRASE 0x10
+#define MAKETAG(TYPE,SIDE) ((R_UCHAR) ((TYPE) | ((SIDE) << TAG_SIDE_SHIFT)))
+#define TAGTYPE(T) ((enum R_PHRASE_TYPE) ((T) & 0x03))
+#define TAGSIDE(T) ((enum R_PHRASE_SIDE) (((T) >> TAG_SIDE_SHIFT) & 0x03))
+#define SETTAGSIDE(T,SIDE) ((T) = (R_UCHAR) (((T) & ~(0x03 << TAG_SIDE_SHIFT)) | ((SIDE) << TAG_SIDE_SHIFT)))
+
 /******************************
 Structure definitions
 ******************************/
@@ -79,8 +100,12 @@ typedef struct args_info {
   R_CHAR *progname;
   FILE *prel_text_file;
   R_CHAR *base_filename;
+  R_CHAR *out_filename;
+  R_CHAR *stats_filename;
 
   R_BOOLEAN verbose_level;
+  R_BOOLEAN perf_counters;
+  R_BOOLEAN container;
   R_UINT max_buffer_size;
   R_UINT max_length;
   R_UINT max_phrases;
@@ -91,6 +116,8 @@ typedef struct args_info {
   R_UINT max_prims;
   R_UINT base_datatype;
   R_BOOLEAN dowordlen;
+  R_UINT num_threads;
+  R_UINT seq_coding;
 } ARGS_INFO;
 
 
@@ -98,12 +125,43 @@ typedef struct prog_info {
   R_CHAR *progname;                                     /*  Program name  */
 
   FILE *in_file;                                          /*  Input file  */
-  R_UINT in_file_size;                            /*  Size of input file  */
+  R_BOOLEAN in_stream;
+           /*  Input is a pipe or other stream whose size is not known  */
+  R_ULL_INT in_file_size;       /*  Size of input file; 0 for a stream  */
+  R_ULL_INT in_file_read;      /*  Number of bytes read so far with fread  */
+  const R_UCHAR *in_map;
+          /*  Input file mapped into memory, or the input of repairBuffer;  */
+                                                /*  NULL if read instead  */
+  size_t in_map_size;
+  size_t in_map_pos;           /*  Position of the next symbol, in bytes  */
   FILE *seq_file;                               /*  Output sequence file  */
   FILE *prel_file;                               /*  Output prelude file  */
+  struct bitoutrec *prel_rec;          /*  Bit stream of the prelude file  */
   FILE *prel_text_file;             /*  Output of prelude in text format  */
   FILE *shuff_file;                                       /*  Shuff file  */
-  R_CHAR *base_filename;                               /*  Base filename  */
+  FILE *index_file;                      /*  Output block index (.idx)  */
+  struct stream_out *stream_out;
+          /*  Interleaved output, if not written to .prel and .seq files  */
+                                            /*  (or that of the container)  */
+  struct container_out *container_out;
+                    /*  Single-file output (--container); NULL if not used  */
+  R_ULL_INT index_prel_pos;          /*  Position in bits and bytes of  */
+  R_ULL_INT index_seq_pos;          /*  the next block in the prel and  */
+                                                    /*  seq files  */
+  R_UINT sample_rate;
+                /*  Number of sequence symbols between position samples  */
+  FILE *stats_file;
+                /*  Statistics in JSON (--stats-json); NULL if not kept  */
+  R_CHAR *in_filename;                    /*  Input filename; "-" for stdin  */
+  R_CHAR *base_filename;
+            /*  Base filename of the output files; NULL if interleaved  */
+
+  R_UINT *input_buffer;                                 /*  Input buffer  */
+  R_UINT *input_buffer_p;
+                 /*  Pointer to the current position in the input buffer  */
+  R_UINT *input_buffer_end;        /*  Pointer just off the input buffer  */
+  R_UCHAR *input_buffer_c;              /*  Input buffers for 1- and 2-  */
+  R_USHRT *input_buffer_s;                           /*  byte data types  */
 
   FILE **seq_file_list;
   R_UINT **seq_buf_list;                             /*  Sequence buffer  */
@@ -114,6 +172,8 @@ typedef struct prog_info {
   **  Variables that the user can change at the command line  
   */
   R_BOOLEAN verbose_level;
+  R_BOOLEAN perf_counters;
+                 /*  Count hardware events of each phase (--perf-counters)  */
   R_UINT max_buffer_size;                 /*  Maximum size of the buffer  */
   R_UINT max_length;                       /*  Maximum length of phrases  */
   R_UINT max_phrases;                      /*  Maximum number of phrases  */
@@ -125,38 +185,46 @@ typedef struct prog_info {
   R_UINT max_prims;
   R_UINT base_datatype;
   R_BOOLEAN dowordlen;
+  R_UINT num_threads;         /*  Number of blocks compressed at once  */
+  R_UINT seq_coding;
+                   /*  Coding of the sequence; one of R_SEQ_CODING  */
 
   /*
   **  Statistics collected in the Re-Pairing process across all blocks
   */
   R_UINT maximum_total_num_phrases;
-  R_UINT total_num_prims;
-  R_UINT total_num_phrases;
-  R_UINT total_num_symbols;
+  R_ULL_INT total_num_prims;
+  R_ULL_INT total_num_phrases;
+  R_ULL_INT total_num_symbols;
   R_UINT maximum_generations;
                                    /*  Need to add 1 since it is 0-based  */
   R_UINT maximum_primitives;
   R_UINT total_blocks;
-  R_UINT total_sum_phrase_length;
+  R_ULL_INT total_sum_phrase_length;
   R_UINT max_longest_phrase_block;
   R_UINT max_longest_phrase_num;
   R_UINT max_longest_phrase_length;
-
-  /*  Memory management data structures -- remved 2004/11/23 */
-  /*  struct memroot *tphrase_root; */
+  R_ULL_INT total_in_length;
+  R_ULL_INT total_replacements;
+  R_UINT maximum_tphrase_in_use;
+  PHASE_STATS total_phases[NUM_REPAIR_PHASES];
+  MEM_STATS memory[NUM_REPAIR_MEMORY];
+         /*  Memory kept across blocks, with the peaks of any one block  */
+  PHASE_STATS run_start;            /*  When Re-Pair started, and the  */
+  PHASE_STATS run_time;             /*  whole time it took, once done  */
 
   ARGS_INFO *args_struct;
                      /*  Structure of arguments passed from command line  */
                        /*  Should be NULL if no arguments were passed in  */
-
-  /*  Used by deleteTPhraseNode in phrase.c  */
-  R_UINT seq_nodelist_size;
-  struct seq_node **seq_nodelist;
 } PROG_INFO;
 
 
 typedef struct block_info {
+  R_UINT block_num;              /*  Position of this block in the file  */
+  R_UINT in_length;            /*  Number of input symbols in this block  */
+
   R_UINT seq_buf_len;                      /*  Length of sequence buffer  */
+  R_UINT seq_buf_size;          /*  Number of nodes allocated for seq_buf  */
   struct seq_node *seq_buf;                          /*  Sequence buffer  */
   struct seq_node *seq_buf_end;     
                                /*  Pointer to the end of sequence buffer  */
@@ -178,9 +246,22 @@ typedef struct block_info {
           /*  Size of primitives array.  Note:  Not necessarily equal to  */
                   /*  the number of primitives due to gaps in the array.  */
   struct tphrase **tent_phrases;
-                                              /*  Tentative phrase array  */
+               /*  Tentative phrase table; open addressing, linear probe  */
   R_UINT tent_phrases_size;
-               /*  Size of tentative phrase array -- #define'd elsewhere  */
+             /*  Capacity of tentative phrase table; a power of two  */
+  R_UINT tent_phrases_bits;
+                                      /*  log2 of tent_phrases_size  */
+  R_UINT tent_phrases_used;
+                         /*  Number of tphrases in tentative phrase table  */
+  struct memroot *tphrase_root;
+                  /*  Pool for this block's tentative phrases (smalloc.h)  */
+  R_ULL_INT *paired;
+        /*  Table of the pairs already replaced; open addressing, linear  */
+                    /*  probe, with keys (left << 32) | right (pair.h)  */
+  R_UINT paired_size;
+                  /*  Capacity of the table of replaced pairs; a power of two  */
+  R_UINT paired_bits;                             /*  log2 of paired_size  */
+  R_UINT paired_used;                 /*  Number of pairs in the table  */
   struct tphrase **pqueue;
                                                       /*  Priority queue  */
   R_UINT pqueue_size;
@@ -190,6 +271,7 @@ typedef struct block_info {
   R_UINT tphrase_in_use;
         /*  The number of tentative phrases still under consideration 
 	**  for replacement  */
+  R_UINT max_tphrase_in_use;                  /*  Peak of tphrase_in_use  */
   R_UINT max_count;
                      /*  Current maximum number of replacements required  */
                        /*  Value decreases during the Re-Pairing process  */
@@ -199,7 +281,35 @@ typedef struct block_info {
   */
   struct phrase *temp_phrases;
   R_UINT temp_phrases_size;
+  R_UCHAR *phrase_tags;
+               /*  Type and side of each entry of temp_phrases, for the  */
+                  /*  heuristics (see MAKETAG); NULL if none are used  */
+  R_BOOLEAN (*valid_pair) (struct prog_info *prog_struct, struct block_info *block_struct, struct seq_node *back, struct seq_node *front);
+          /*  Which pairs may be replaced, as chosen for the block by  */
+                   /*  selectPairCheck (pair.c); NULL if all of them  */
   struct phrase *sort_phrases;
+  R_UINT *new_index;
+          /*  Final index of each primitive and phrase, by its position  */
+      /*  in temp_phrases; the sequence is translated as it is written  */
+
+  /*  Used by deleteTPhraseNode in phrase.c  */
+  R_UINT seq_nodelist_size;
+  struct seq_node **seq_nodelist;
+
+  /*
+  **  Encoded output of the current block
+  */
+  struct bitoutrec *prel_rec;
+           /*  Prelude bit stream; either the file's or a private one  */
+  R_UCHAR *seq_out;                           /*  Encoded sequence  */
+  size_t seq_out_len;
+  size_t seq_out_size;
+  R_ULL_INT *samples;      /*  Position in the block of every sample_rate  */
+                                /*  symbols of the sequence; for the .idx  */
+  R_ULL_INT *sample_bits;
+               /*  Offset in bits of each sample's code in the coded data  */
+  R_UINT num_samples;
+  R_UINT samples_size;
 
   /*
   **  Statistics collected in the Re-Pairing process for the current block
@@ -212,6 +322,10 @@ typedef struct block_info {
   R_UINT sum_phrase_length;
                           /*  Length of all phrases in the current block  */
   R_UINT num_symbols;
+  R_UINT num_replacements;
+                    /*  Number of pairs replaced by phrases in the sequence  */
+  PHASE_STATS phases[NUM_REPAIR_PHASES];      /*  Time spent in each phase  */
+  MEM_STATS memory[NUM_REPAIR_MEMORY];         /*  Memory of the block  */
 } BLOCK_INFO;
     
 
@@ -27,14 +27,19 @@
 #include <stdio.h>
 #include <limits.h>                                         /*  UINT_MAX  */
 #include <string.h>
-#include <getopt.h>                                  /*  getopt function  */
 #include <errno.h>
 #include <math.h>                                      /*  ceil function  */
 #include <ctype.h>                                  /*  isalnum function  */
 #include <sys/stat.h>
+#include <sys/mman.h>                                  /*  mmap, madvise  */
+#include <pthread.h>
+#include <assert.h>
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
+#include "smalloc.h"
+#include "stats.h"
 #include "repair-defn.h"
 #include "seq.h"
 #include "phrase.h"
@@ -42,135 +47,176 @@
 #include "phrasebuilder.h"
 #include "writeout.h"
 #include "bitout.h"
+#include "blockindex.h"
+#include "stream.h"
+#include "container.h"
+#include "seqformat.h"
 #include "repair.h"
+#include "librepair.h"
+#include "librepair-defn.h"
+
+/*  Names of the phases in the statistics file; see R_REPAIR_PHASE  */
+static const R_CHAR *phase_names[NUM_REPAIR_PHASES] = {
+  "fill", "scan_pairs", "init_queue", "repair_phrases", "sort_phrases", "encode_hierarchy", "encode_sequence"
+};
+
+/*  Names of the structures whose memory is counted; see R_REPAIR_MEMORY  */
+static const R_CHAR *memory_names[NUM_REPAIR_MEMORY] = {
+  "total", "sequence", "tentative_phrases", "priority_queue", "phrases", "paired", "io_buffers"
+};
 
 /*  Static functions  */
-static void usage (ARGS_INFO *args_struct);
 static void initRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 static void uninitRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 static void executeRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 static void displayStats_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
-
-/*
-**  Print out usage information
-*/
-static void usage (ARGS_INFO *args_struct) {
-  fprintf (stderr, "Re-Pair (Recursive Pairing)\n");
-  fprintf (stderr, "===========================\n\n");
-  fprintf (stderr, "Usage:  %s [options]\n\n", args_struct -> progname);
-  fprintf (stderr, "Options:\n");
-  fprintf (stderr, "-a           :  Add primitives to generation 0.\n");
-  fprintf (stderr, "-b <size>    :  Blocksize\t\t\t[default:  %u]\n", args_struct -> max_buffer_size);
-  fprintf (stderr, "-f           :  Use punctuation flags for word-based parsing.\n");
-  fprintf (stderr, "-i <file>    :  Input filename\t\t\t[Required]\n");
-  fprintf (stderr, "-e <level>   :  Pairing heuristic.\t\t[default:  0]\n");
-  fprintf (stderr, "           0  : No heuristic\n");
-  fprintf (stderr, "           1  : Word-aligned Re-Pair\n");
-  fprintf (stderr, "           2  : Obey which side symbol is on\n");
-  fprintf (stderr, "           3  : No recursion\n");
-  fprintf (stderr, "-l <length>  :  Length limit on phrases.\t[default:  %u]\n", args_struct -> max_length);
-  fprintf (stderr, "-p <phrases> :  Maximum number of phrases\t[default:  %u]\n", args_struct -> max_phrases);
-  fprintf (stderr, "-t <type>    :  Input data type \t\t[1 (default), 2, or 4]\n");
-  fprintf (stderr, "-v           :  Verbose output\n");
-  fprintf (stderr, "-w           :  Do word length counting to .wl file.\n");
-  fprintf (stderr, "-x <count>   :  Minimum number of occurances before replacement\n\t\t\t\t\t[default:  %u]\n", args_struct -> max_keep_count);
-  fprintf (stderr, "\nDefault sequence file is <filename.seq>.\n");
-  fprintf (stderr, "Default phrase hierarchy file is <filename.prel>.\n\n");
-
-  fprintf (stderr, "Re-Pair version:  %s (%s)\n\n", __DATE__, __TIME__);
-
-  exit (EXIT_SUCCESS);
-}
-
+static void writeStatsJSON_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void writeStatsJSON_Totals (PROG_INFO *prog_struct);
+static void initBlockInfo (BLOCK_INFO *block_struct);
+static void initPrimitive (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT prim);
+static void growPrimsArray (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT prim);
+static void addInputSymbol (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT x, R_UINT pos);
+static R_UINT readInputBuffer (PROG_INFO *prog_struct);
+static R_BOOLEAN moreInput (PROG_INFO *prog_struct);
+static void growSeqBuf (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static R_UINT fillFromMap (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT curr_seq_buf_len);
+static R_BOOLEAN mapInput (PROG_INFO *prog_struct);
+static void fillRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void writeRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
+static void *repairWorker (void *arg);
+static void drainRepairSlot (PROG_INFO *prog_struct, REPAIR_POOL *pool, REPAIR_SLOT *slot);
+static void executeRepair_FileParallel (PROG_INFO *prog_struct);
 
 /*
 **  Perform Re-Pair on one block
 */
 static void executeRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
     R_UINT i;
+    PHASE_STATS start;
 
     /*  Perform scanPairs  */
+    startPhase (&start);
     scanPairs (prog_struct, block_struct);
+    endPhase (&start, &(block_struct -> phases[PHASE_SCAN_PAIRS]));
 
     /*  Allocate queue and initialize to NULL  */
     /*  Make the priority queue bigger by one since position 0 is
     **  unused.  */
     block_struct -> pqueue_size = block_struct -> max_count + 1;
     block_struct -> pqueue = wmalloc ((block_struct -> pqueue_size) * (sizeof (TPHRASE*)));
+    changeMemory (block_struct -> memory, MEM_QUEUE, 0, (block_struct -> pqueue_size) * (sizeof (TPHRASE*)));
     for (i = 0; i < block_struct -> pqueue_size; i++) {
         block_struct -> pqueue[i] = NULL;
     }
 
     /*  Populate queue with tentative phrases  */
+    startPhase (&start);
     initQueue (prog_struct, block_struct);
+    endPhase (&start, &(block_struct -> phases[PHASE_INIT_QUEUE]));
 
     /*  Recursively pair phrases  */
+    startPhase (&start);
     rePairPhrases (prog_struct, block_struct);
+    endPhase (&start, &(block_struct -> phases[PHASE_REPAIR_PHRASES]));
 
     /*  Sort primitives  */
-
+    startPhase (&start);
     sortPrimitives (block_struct);
 
     block_struct -> sort_phrases = wmalloc (((block_struct -> num_prims) + (block_struct -> num_phrases)) * (sizeof (PHRASE)));
+    changeMemory (block_struct -> memory, MEM_PHRASES, 0, ((block_struct -> num_prims) + (block_struct -> num_phrases)) * (sizeof (PHRASE)));
 
     /*  Sort phrases  */
     sortPhrases (prog_struct, block_struct);
+    endPhase (&start, &(block_struct -> phases[PHASE_SORT_PHRASES]));
+
+    /*  Encode the block in memory; it is written out in order later  */
+    startPhase (&start);
+    encodeHierarchy_OneBlock (prog_struct, block_struct);
+    endPhase (&start, &(block_struct -> phases[PHASE_ENCODE_HIERARCHY]));
+
+    startPhase (&start);
+    encodeSequence_OneBlock (prog_struct, block_struct);
+    endPhase (&start, &(block_struct -> phases[PHASE_ENCODE_SEQUENCE]));
 
     return;
 }
 
 
+/*
+**  Initialize primitive prim in the temp_phrases and primitives arrays
+*/
+static void initPrimitive (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT prim) {
+  block_struct -> temp_phrases[prim].left = prim;
+                                            /*  prim is the ASCII value  */
+  block_struct -> temp_phrases[prim].left_chiastic = 0;
+  block_struct -> temp_phrases[prim].right = prim;
+  block_struct -> temp_phrases[prim].right_chiastic = 0;
+  block_struct -> temp_phrases[prim].unit = prim;
+                             /*  Unit = ASCII value for primitives only  */
+  block_struct -> temp_phrases[prim].generation = 0;
+                                                    /*  Generation of 0  */
+  block_struct -> temp_phrases[prim].length = 1;
+  block_struct -> temp_phrases[prim].temp_index = prim;
+  if (block_struct -> phrase_tags != NULL) {
+    block_struct -> phrase_tags[prim] = MAKETAG (PT_NONE, SIDE_NONE);
+    if (prog_struct -> apply_heuristics == HEUR_WA) {
+      if (ISWORD (prim)) {
+        block_struct -> phrase_tags[prim] = MAKETAG (PT_WORD, SIDE_NONE);
+      }
+      else {
+        block_struct -> phrase_tags[prim] = MAKETAG (PT_NON_WORD, SIDE_NONE);
+      }
+    }
+  }
+
+  if (prog_struct -> add_prims == R_TRUE) {
+    block_struct -> num_prims += 1;
+    block_struct -> prims_array[prim] = 1;
+  }
+  else {
+    block_struct -> prims_array[prim] = UNINITIALIZED_GENERATION;
+  }
+
+  return;
+}
+
+
 static void initRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_UINT i = 0;
 
   uninitRepair_OneBlock (prog_struct, block_struct);
 
-  /*  Initialize sequence buffer  */
+  /*  Initialize sequence buffer; for a stream, it starts small and
+  **  grows as symbols arrive  */
   block_struct -> seq_buf_len = prog_struct -> max_buffer_size;
+  if ((prog_struct -> in_stream == R_TRUE) && (block_struct -> seq_buf_len > INIT_STREAM_BUFFER_SIZE)) {
+    block_struct -> seq_buf_len = INIT_STREAM_BUFFER_SIZE;
+    if (block_struct -> seq_buf_len < block_struct -> input_stack_size) {
+      block_struct -> seq_buf_len = block_struct -> input_stack_size;
+    }
+  }
   block_struct -> seq_buf = wmalloc ((block_struct -> seq_buf_len) * sizeof (SEQ_NODE));
+  block_struct -> seq_buf_size = block_struct -> seq_buf_len;
   block_struct -> seq_buf_end = (block_struct -> seq_buf) + (block_struct -> seq_buf_len - 1);
+  changeMemory (block_struct -> memory, MEM_SEQUENCE, 0, (block_struct -> seq_buf_len) * sizeof (SEQ_NODE));
 
   /*  Create and initialize array for primitives  */
   block_struct -> prims_array_size = prog_struct -> max_prims;
   block_struct -> prims_array = wmalloc (block_struct -> prims_array_size * sizeof (R_UINT));
+  changeMemory (block_struct -> memory, MEM_PHRASES, 0, block_struct -> prims_array_size * sizeof (R_UINT));
 
   block_struct -> temp_phrases_size = prog_struct -> max_prims;
   block_struct -> temp_phrases = wmalloc ((block_struct -> temp_phrases_size) * (sizeof (PHRASE)));
+  changeMemory (block_struct -> memory, MEM_PHRASES, 0, (block_struct -> temp_phrases_size) * (sizeof (PHRASE)));
+  if (prog_struct -> apply_heuristics != HEUR_NONE) {
+    block_struct -> phrase_tags = wmalloc ((block_struct -> temp_phrases_size) * (sizeof (R_UCHAR)));
+    changeMemory (block_struct -> memory, MEM_PHRASES, 0, (block_struct -> temp_phrases_size) * (sizeof (R_UCHAR)));
+  }
 
   /*  Initialize all primitives in the temp_phrases array  */
   for (i = 0; i < block_struct -> prims_array_size; i++) {
-    block_struct -> temp_phrases[i].left = i;  
-                                               /*  i is the ASCII value  */
-    block_struct -> temp_phrases[i].left_chiastic = 0;
-    block_struct -> temp_phrases[i].right = i;
-    block_struct -> temp_phrases[i].right_chiastic = 0;
-    block_struct -> temp_phrases[i].unit = i;
- 	                     /*  Unit = ASCII value for primitives only  */
-    block_struct -> temp_phrases[i].generation = 0;
-                                                      /*  Generation of 0  */
-    block_struct -> temp_phrases[i].length = 1;
-    block_struct -> temp_phrases[i].temp_index = i;
-    if (prog_struct -> apply_heuristics == HEUR_WA) {
-      if (ISWORD (i)) {
-        block_struct -> temp_phrases[i].mytype = PT_WORD;
-      }
-      else {
-        block_struct -> temp_phrases[i].mytype = PT_NON_WORD;
-      }
-    }
-    block_struct -> temp_phrases[i].myside = SIDE_NONE;
-  }
-
-  if (prog_struct -> add_prims == R_TRUE) {
-    for (i = 0; i < block_struct -> prims_array_size; i++) {
-      block_struct -> num_prims += 1;
-      block_struct -> prims_array[i] = 1;
-    }
-  }
-  else {
-    for (i = 0; i < block_struct -> prims_array_size; i++) {
-      block_struct -> prims_array[i] = UNINITIALIZED_GENERATION;
-    }
+    initPrimitive (prog_struct, block_struct, i);
   }
 
   /*  Ensure that the zero-length word is always accounted for  */
@@ -195,14 +241,21 @@ static void initRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struc
   }
   block_struct -> input_stack = NULL;
 
-  /*  Initialize tent_phrases hash table  */
-  block_struct -> tent_phrases_size = (R_UINT) TENTPHRASE_SIZE;
-  block_struct -> tent_phrases = wmalloc (block_struct -> tent_phrases_size * sizeof (TPHRASE*));
-  for (i = 0; i < block_struct -> tent_phrases_size; i++) {
-    block_struct -> tent_phrases[i] = NULL;
-  }
+  /*  tent_phrases hash table is sized by scanPairs from the sequence length  */
+  block_struct -> tent_phrases = NULL;
+  block_struct -> tent_phrases_size = 0;
+  block_struct -> tent_phrases_bits = 0;
+  block_struct -> tent_phrases_used = 0;
+
+  /*  Pool for the tentative phrases created while pairing  */
+  block_struct -> tphrase_root = initMemRoot (sizeof (TPHRASE), SMALLOC_SLAB_ITEMS, block_struct -> memory, MEM_TPHRASES);
+
+  block_struct -> seq_nodelist_size = INIT_NODELIST_SIZE;
+  block_struct -> seq_nodelist = wmalloc (block_struct -> seq_nodelist_size * sizeof (SEQ_NODE*));
+  changeMemory (block_struct -> memory, MEM_SEQUENCE, 0, block_struct -> seq_nodelist_size * sizeof (SEQ_NODE*));
 
   prog_struct -> total_blocks++;
+  block_struct -> block_num = prog_struct -> total_blocks;
 
   return;
 }
@@ -213,25 +266,30 @@ static void uninitRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_str
 
   if (block_struct -> seq_buf != NULL) {
     wfree (block_struct -> seq_buf);
+    changeMemory (block_struct -> memory, MEM_SEQUENCE, block_struct -> seq_buf_size * sizeof (SEQ_NODE), 0);
   }
   block_struct -> seq_buf = NULL;
   block_struct -> seq_buf_end = NULL;
   block_struct -> seq_buf_len = 0;
-
-  if (block_struct -> prims_array != NULL) {
-    wfree (block_struct -> prims_array);
-  }
-  block_struct -> prims_array = NULL;
-  block_struct -> prims_array_size = 0;
+  block_struct -> seq_buf_size = 0;
 
   if (block_struct -> tent_phrases != NULL) {
     wfree (block_struct -> tent_phrases);
+    changeMemory (block_struct -> memory, MEM_TPHRASES, block_struct -> tent_phrases_size * sizeof (TPHRASE*), 0);
   }
   block_struct -> tent_phrases = NULL;
-  block_struct -> tent_phrases_size = (R_UINT) TENTPHRASE_SIZE;
+  block_struct -> tent_phrases_size = 0;
+  block_struct -> tent_phrases_bits = 0;
+  block_struct -> tent_phrases_used = 0;
+
+  /*  Release all tentative phrases at once  */
+  uninitMemRoot (block_struct -> tphrase_root);
+  block_struct -> tphrase_root = NULL;
+  uninitPairedTable (block_struct);
 
   if (block_struct -> pqueue != NULL) {
     wfree (block_struct -> pqueue);
+    changeMemory (block_struct -> memory, MEM_QUEUE, block_struct -> pqueue_size * sizeof (TPHRASE*), 0);
   }
   block_struct -> pqueue = NULL;
   block_struct -> pqueue_size = 0;
@@ -243,14 +301,65 @@ static void uninitRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_str
 
   if (block_struct -> temp_phrases != NULL) {
     wfree (block_struct -> temp_phrases);
+    changeMemory (block_struct -> memory, MEM_PHRASES, block_struct -> temp_phrases_size * sizeof (PHRASE), 0);
   }
   block_struct -> temp_phrases = NULL;
 
+  if (block_struct -> phrase_tags != NULL) {
+    wfree (block_struct -> phrase_tags);
+    changeMemory (block_struct -> memory, MEM_PHRASES, block_struct -> temp_phrases_size * sizeof (R_UCHAR), 0);
+  }
+  block_struct -> phrase_tags = NULL;
+  block_struct -> valid_pair = NULL;
+  block_struct -> temp_phrases_size = 0;
+
+  /*  sort_phrases and new_index are allocated once the block has its
+  **  final number of phrases  */
   if (block_struct -> sort_phrases != NULL) {
     wfree (block_struct -> sort_phrases);
+    changeMemory (block_struct -> memory, MEM_PHRASES, (block_struct -> num_prims + block_struct -> num_phrases) * sizeof (PHRASE), 0);
   }
   block_struct -> sort_phrases = NULL;
 
+  if (block_struct -> new_index != NULL) {
+    wfree (block_struct -> new_index);
+    changeMemory (block_struct -> memory, MEM_PHRASES, (block_struct -> prims_array_size + block_struct -> num_phrases) * sizeof (R_UINT), 0);
+  }
+  block_struct -> new_index = NULL;
+
+  if (block_struct -> prims_array != NULL) {
+    wfree (block_struct -> prims_array);
+    changeMemory (block_struct -> memory, MEM_PHRASES, block_struct -> prims_array_size * sizeof (R_UINT), 0);
+  }
+  block_struct -> prims_array = NULL;
+  block_struct -> prims_array_size = 0;
+
+  if (block_struct -> seq_nodelist != NULL) {
+    wfree (block_struct -> seq_nodelist);
+    changeMemory (block_struct -> memory, MEM_SEQUENCE, block_struct -> seq_nodelist_size * sizeof (SEQ_NODE*), 0);
+  }
+  block_struct -> seq_nodelist = NULL;
+  block_struct -> seq_nodelist_size = 0;
+
+  /*  The output buffers are counted by encodeSequence_OneBlock, once
+  **  they are complete  */
+  if (block_struct -> seq_out != NULL) {
+    wfree (block_struct -> seq_out);
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, block_struct -> seq_out_size, 0);
+  }
+  block_struct -> seq_out = NULL;
+  block_struct -> seq_out_len = 0;
+  block_struct -> seq_out_size = 0;
+
+  if (block_struct -> samples != NULL) {
+    wfree (block_struct -> samples);
+    wfree (block_struct -> sample_bits);
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, 2 * block_struct -> samples_size * sizeof (R_ULL_INT), 0);
+  }
+  block_struct -> samples = NULL;
+  block_struct -> sample_bits = NULL;
+  block_struct -> num_samples = 0;
+  block_struct -> samples_size = 0;
 
   num_prims_and_phrases = block_struct -> num_prims + block_struct -> num_phrases;
   if (block_struct -> num_prims > prog_struct -> maximum_primitives) {
@@ -269,13 +378,21 @@ static void uninitRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_str
 
   prog_struct -> total_sum_phrase_length += block_struct -> sum_phrase_length;
   if (block_struct -> longest_phrase_length > prog_struct -> max_longest_phrase_length) {
-    prog_struct -> max_longest_phrase_block = prog_struct -> total_blocks;
+    prog_struct -> max_longest_phrase_block = block_struct -> block_num;
     prog_struct -> max_longest_phrase_num = block_struct -> longest_phrase;
     prog_struct -> max_longest_phrase_length = block_struct -> longest_phrase_length;
   }
 
   prog_struct -> total_num_symbols += block_struct -> num_symbols;
 
+  prog_struct -> total_in_length += (R_ULL_INT) block_struct -> in_length;
+  prog_struct -> total_replacements += block_struct -> num_replacements;
+  if (block_struct -> max_tphrase_in_use > prog_struct -> maximum_tphrase_in_use) {
+    prog_struct -> maximum_tphrase_in_use = block_struct -> max_tphrase_in_use;
+  }
+  addPhases (prog_struct -> total_phases, block_struct -> phases, NUM_REPAIR_PHASES);
+  mergeMemory (prog_struct -> memory, block_struct -> memory, NUM_REPAIR_MEMORY);
+
   block_struct -> num_prims = 0;
   block_struct -> num_phrases = 0;
   block_struct -> num_generation = 0;
@@ -283,6 +400,15 @@ static void uninitRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_str
   block_struct -> longest_phrase_length = 0;
   block_struct -> sum_phrase_length = 0;
   block_struct -> num_symbols = 0;
+  block_struct -> in_length = 0;
+  block_struct -> num_replacements = 0;
+  block_struct -> max_tphrase_in_use = 0;
+  clearPhases (block_struct -> phases, NUM_REPAIR_PHASES);
+
+  /*  Everything allocated for the block has been freed; only the
+  **  peaks are left to be cleared for the next block  */
+  assert (block_struct -> memory[MEM_TOTAL].current == 0);
+  clearMemory (block_struct -> memory, NUM_REPAIR_MEMORY);
 
   return;
 }
@@ -292,7 +418,7 @@ static void displayStats_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_str
 
 #ifdef DEBUG
   fprintf (stderr, "Statistics for current block:\n");
-  fprintf (stderr, "\tBlock number:  %d\n", prog_struct -> total_blocks);
+  fprintf (stderr, "\tBlock number:  %d\n", block_struct -> block_num);
   fprintf (stderr, "\tNumber of primitives:  %d\n", block_struct -> num_prims);
   fprintf (stderr, "\tNumber of phrases:  %d\n", block_struct -> num_phrases);
   fprintf (stderr, "\tLength of sequence:  %d\n", block_struct -> num_symbols);
@@ -300,354 +426,735 @@ static void displayStats_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_str
 
   /*  Must add 1 to num_generations since it is 0-based  */
   if (prog_struct -> verbose_level == R_TRUE) {
-    fprintf (stderr, "%5u\t%5u\t%7u\t  %15u\t%11u\t%7u\n", prog_struct -> total_blocks, block_struct -> num_prims, block_struct -> num_phrases, block_struct -> num_prims + block_struct -> num_phrases, block_struct -> num_generation + 1, block_struct -> num_symbols);
+    fprintf (stderr, "%5u\t%5u\t%7u\t  %15u\t%11u\t%7u\n", block_struct -> block_num, block_struct -> num_prims, block_struct -> num_phrases, block_struct -> num_prims + block_struct -> num_phrases, block_struct -> num_generation + 1, block_struct -> num_symbols);
+    if (prog_struct -> perf_counters == R_TRUE) {
+      printPhasesCounters (stderr, phase_names, block_struct -> phases, NUM_REPAIR_PHASES);
+    }
+    printMemory (stderr, memory_names, block_struct -> memory, NUM_REPAIR_MEMORY);
   }
 
   return;
 }
 
+
 /*
-**  Parse arguments and use them to set numerous variables in the
-**  structures.
+**  Add the block to the "blocks" array of the statistics file
+**  (--stats-json).  Blocks are written in order.
 */
-ARGS_INFO *parseArguments (R_INT argc, R_CHAR *argv[], ARGS_INFO *args_struct) {
-  /*  Declarations required for getopt  */
-  R_INT c;
-  R_UINT i = 0;
-  R_UINT *buf = NULL;
-  FILE *fp = NULL;
-  R_UINT items = 0;
-  R_UINT maxsym = 0;
+static void writeStatsJSON_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  FILE *fp = prog_struct -> stats_file;
 
-  args_struct -> base_filename = NULL;
-
-  if (args_struct == NULL) {
-    fprintf (stderr, "Structure ARGS_INFO needs to be malloc'ed in [%s] on line %d.\n", __FILE__, __LINE__);
-    exit (EXIT_FAILURE);
-  }
-
-  /*  Initialize variables  */
-  args_struct -> progname = NULL;
-  args_struct -> max_buffer_size = MAX_BUFFER_SIZE;
-  args_struct -> prel_text_file = NULL;
-  args_struct -> base_filename = NULL;
-  args_struct -> apply_heuristics = HEUR_NONE;
-  args_struct -> word_flags = UW_NO;
-  args_struct -> add_prims = R_FALSE;
-  args_struct -> max_length = UINT_MAX;
-  args_struct -> max_phrases = UINT_MAX;
-  args_struct -> verbose_level = R_FALSE;
-  args_struct -> max_keep_count = MIN_KEEP_COUNT;
-  args_struct -> base_datatype = (R_UINT) sizeof (R_UCHAR);
-  args_struct -> max_prims = MIN_PRIMS_ARRAY;
-  args_struct -> dowordlen = R_FALSE;
+  if (fp == NULL) {
+    return;
+  }
 
-  /*
-  **  Initialize to the name of the program
-  */
-  args_struct -> progname = argv[0];
+  fprintf (fp, "%s\n    {\"block\": %u, \"length\": %u, \"prims\": %u, \"phrases\": %u, \"generations\": %u, \"symbols\": %u, \"replacements\": %u, \"peak_tphrase_in_use\": %u,\n     \"phases\": ", (block_struct -> block_num == 1) ? "" : ",", block_struct -> block_num, block_struct -> in_length, block_struct -> num_prims, block_struct -> num_phrases, block_struct -> num_generation + 1, block_struct -> num_symbols, block_struct -> num_replacements, block_struct -> max_tphrase_in_use);
+  writePhasesJSON (fp, phase_names, block_struct -> phases, NUM_REPAIR_PHASES);
+  fprintf (fp, ",\n     \"memory\": ");
+  writeMemoryJSON (fp, memory_names, block_struct -> memory, NUM_REPAIR_MEMORY);
+  fprintf (fp, "}");
 
-  /*  Print usage information if no arguments  */
-  if (argc == 1) {
-    usage (args_struct);
-  }
+  return;
+}
 
-  while (R_TRUE) {
-    c = getopt (argc, argv, "ab:fe:i:l:p:t:vwx:?");
-    if (c == EOF) {
-      break;
-    }
 
-    switch (c) {
-    case 'a':
-      args_struct -> add_prims = R_TRUE;
-      break;
-    case 'b':
-      args_struct -> max_buffer_size = (R_UINT) atoi (optarg);
-      if (args_struct -> max_buffer_size > MAX_BUFFER_SIZE) {
-        fprintf (stderr, "Option with -b must be less than or equal to MAX_BUFFER_SIZE\n");
-        exit (EXIT_FAILURE);
-      }
-      break;
-    case 'f':
-      args_struct -> word_flags = UW_YES;
-      break;
-    case 'e':
-      args_struct -> apply_heuristics = atoi (optarg);
-      break;
-    case 'i':
-      args_struct -> base_filename = optarg;
-      break;
-    case 'l':
-      args_struct -> max_length = (R_UINT) atoi (optarg);
-      break;
-    case 'p':
-      args_struct -> max_phrases = (R_UINT) atoi (optarg);
-      break;
-    case 't':
-      args_struct -> base_datatype = (R_UINT) atoi (optarg);
-      if ((args_struct -> base_datatype != (R_UINT) sizeof (R_UCHAR)) && 
-          (args_struct -> base_datatype != (R_UINT) sizeof (R_USHRT)) &&
-          (args_struct -> base_datatype != (R_UINT) sizeof (R_UINT))) {
-        fprintf (stderr, "Input data type (-t) not valid.\n");
-        exit (EXIT_FAILURE);
+/*
+**  End the "blocks" array of the statistics file with the totals
+**  across all blocks.  The time of each phase is summed over the
+**  blocks, so with -j it can be more than the time of the whole run.
+*/
+static void writeStatsJSON_Totals (PROG_INFO *prog_struct) {
+  FILE *fp = prog_struct -> stats_file;
+
+  fprintf (fp, "\n  ],\n  \"total\": {\"blocks\": %u, \"length\": %llu, \"prims\": %llu, \"phrases\": %llu, \"max_generations\": %u, \"symbols\": %llu, \"replacements\": %llu, \"peak_tphrase_in_use\": %u,\n    \"phases\": ", prog_struct -> total_blocks, prog_struct -> total_in_length, prog_struct -> total_num_prims, prog_struct -> total_num_phrases, prog_struct -> maximum_generations + 1, prog_struct -> total_num_symbols, prog_struct -> total_replacements, prog_struct -> maximum_tphrase_in_use);
+  writePhasesJSON (fp, phase_names, prog_struct -> total_phases, NUM_REPAIR_PHASES);
+  fprintf (fp, ",\n    \"memory\": ");
+  writeMemoryJSON (fp, memory_names, prog_struct -> memory, NUM_REPAIR_MEMORY);
+  fprintf (fp, "},\n  \"run\": {\"wall_s\": %.6f, \"cpu_s\": %.6f, \"threads\": %u}\n", prog_struct -> run_time.wall, prog_struct -> run_time.cpu, prog_struct -> num_threads);
+
+  return;
+}
+
+/*
+**  Read the next symbols of the input into the input buffer.  Returns
+**  the number of symbols read, which is 0 only at the end of the
+**  input.  A partial symbol at the end of the input is ignored.
+*/
+static R_UINT readInputBuffer (PROG_INFO *prog_struct) {
+  R_UINT items_read = 0;
+  R_UINT i = 0;
+  R_UINT *input_buffer = prog_struct -> input_buffer;
+  R_UCHAR *input_buffer_c = prog_struct -> input_buffer_c;
+  R_USHRT *input_buffer_s = prog_struct -> input_buffer_s;
+
+  switch (prog_struct -> base_datatype) {
+    case 1:
+      items_read = (R_UINT) fread (input_buffer_c, sizeof (R_UCHAR), (size_t) INPUT_BUFFER_SIZE, prog_struct -> in_file);
+      for (i = 0; i < items_read; i++) {
+        input_buffer[i] = (R_UINT) input_buffer_c[i];
       }
       break;
-    case 'v':
-      args_struct -> verbose_level = R_TRUE;
-      break;
-    case 'w':
-      args_struct -> dowordlen = R_TRUE;
-      break;
-    case 'x':
-      args_struct -> max_keep_count = (R_UINT) atoi (optarg);
-      if (args_struct -> max_keep_count < MIN_KEEP_COUNT) {
-        fprintf (stderr, "The value for -x can not be less than MIN_KEEP_COUNT.\n");
-        exit (EXIT_FAILURE);
+    case 2:
+      items_read = (R_UINT) fread (input_buffer_s, sizeof (R_USHRT), (size_t) INPUT_BUFFER_SIZE, prog_struct -> in_file);
+      for (i = 0; i < items_read; i++) {
+        input_buffer[i] = (R_UINT) input_buffer_s[i];
       }
       break;
-    case '?':
-      usage (args_struct);
+    case 4:
+      items_read = (R_UINT) fread (input_buffer, sizeof (R_UINT), (size_t) INPUT_BUFFER_SIZE, prog_struct -> in_file);
       break;
-    default:
-      fprintf (stderr, "getopt returned erroneous character code.\n");
-      exit (EXIT_FAILURE);
-    }
   }
+  if (ferror (prog_struct -> in_file) != R_FALSE) {
+    raiseError ("Fatal error in reading from input file!\n");
+  }
+  prog_struct -> in_file_read += (R_ULL_INT) items_read * prog_struct -> base_datatype;
+  prog_struct -> input_buffer_p = input_buffer;
+  prog_struct -> input_buffer_end = input_buffer + items_read;
+
+  return (items_read);
+}
+
+
+/*
+**  Check if there are any more symbols to be read from the input.
+**  The size of a stream is not known, so the next symbols are read
+**  ahead into the input buffer, waiting for them if need be.
+*/
+static R_BOOLEAN moreInput (PROG_INFO *prog_struct) {
+  if (prog_struct -> in_map != NULL) {
+    return (prog_struct -> in_map_size - prog_struct -> in_map_pos >= (size_t) prog_struct -> base_datatype);
+  }
+  if (prog_struct -> input_buffer_p < prog_struct -> input_buffer_end) {
+    return (R_TRUE);
+  }
+  if ((feof (prog_struct -> in_file) == R_FALSE) && (readInputBuffer (prog_struct) != 0)) {
+    return (R_TRUE);
+  }
+
+  return (R_FALSE);
+}
 
-  if (optind < argc) {
-    fprintf (stderr, "The following arguments were not valid:  ");
-    while (optind < argc) {
-      fprintf (stderr, "%s ", argv[optind++]);
+
+/*
+**  Enlarge the primitives array of the block so that it holds prim.
+**  Needed when the largest symbol was not found in advance, as for
+**  streams, which can only be read once.
+*/
+static void growPrimsArray (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT prim) {
+  R_UINT new_size = block_struct -> prims_array_size;
+  R_UINT i = 0;
+
+  while (new_size <= prim) {
+    new_size = (new_size > (MAX_PRIMS_ARRAY >> 1)) ? MAX_PRIMS_ARRAY : (new_size << 1);
+  }
+
+  block_struct -> prims_array = wrealloc (block_struct -> prims_array, new_size * sizeof (R_UINT));
+  changeMemory (block_struct -> memory, MEM_PHRASES, block_struct -> prims_array_size * sizeof (R_UINT), new_size * sizeof (R_UINT));
+  if (block_struct -> temp_phrases_size < new_size) {
+    block_struct -> temp_phrases = wrealloc (block_struct -> temp_phrases, new_size * sizeof (PHRASE));
+    changeMemory (block_struct -> memory, MEM_PHRASES, block_struct -> temp_phrases_size * sizeof (PHRASE), new_size * sizeof (PHRASE));
+    if (block_struct -> phrase_tags != NULL) {
+      block_struct -> phrase_tags = wrealloc (block_struct -> phrase_tags, new_size * sizeof (R_UCHAR));
+      changeMemory (block_struct -> memory, MEM_PHRASES, block_struct -> temp_phrases_size * sizeof (R_UCHAR), new_size * sizeof (R_UCHAR));
     }
-    fprintf (stderr, "Run program with the -? option for help.\n");
-    exit (EXIT_FAILURE);
+    block_struct -> temp_phrases_size = new_size;
+  }
+  for (i = block_struct -> prims_array_size; i < new_size; i++) {
+    initPrimitive (prog_struct, block_struct, i);
   }
+  block_struct -> prims_array_size = new_size;
+
+  /*  Later blocks start with the larger array  */
+  prog_struct -> max_prims = new_size;
+
+  return;
+}
+
 
-  if (args_struct -> base_filename == NULL) {
-    fprintf (stderr, "Input filename required with the -i option.");
-    exit (EXIT_FAILURE);
+/*
+**  Double the block's sequence buffer, up to max_buffer_size, while
+**  a stream is being read into it
+*/
+static void growSeqBuf (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  R_UINT old_len = block_struct -> seq_buf_len;
+
+  if (block_struct -> seq_buf_len > (prog_struct -> max_buffer_size >> 1)) {
+    block_struct -> seq_buf_len = prog_struct -> max_buffer_size;
   }
+  else {
+    block_struct -> seq_buf_len = block_struct -> seq_buf_len << 1;
+  }
+  block_struct -> seq_buf = wrealloc (block_struct -> seq_buf, block_struct -> seq_buf_len * sizeof (SEQ_NODE));
+  block_struct -> seq_buf_size = block_struct -> seq_buf_len;
+  block_struct -> seq_buf_end = block_struct -> seq_buf + (block_struct -> seq_buf_len - 1);
+  changeMemory (block_struct -> memory, MEM_SEQUENCE, old_len * sizeof (SEQ_NODE), block_struct -> seq_buf_len * sizeof (SEQ_NODE));
 
-  if ((args_struct -> apply_heuristics == HEUR_WA) && (args_struct -> base_datatype != (R_UINT) sizeof (R_UCHAR))) {
-    fprintf (stderr, "Word-aligned parsing with the specified data type is not possible.");
-    exit (EXIT_FAILURE);
+  return;
+}
+
+
+/*
+**  Append one symbol of the input to the block's sequence buffer at
+**  position pos and count it in the primitives array
+*/
+static void addInputSymbol (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT x, R_UINT pos) {
+  R_UINT prim = x & NO_FLAGS;
+
+  if (prim >= block_struct -> prims_array_size) {
+    growPrimsArray (prog_struct, block_struct, prim);
   }
 
-  if ((args_struct -> word_flags == UW_YES) && (args_struct -> base_datatype != (R_UINT) sizeof (R_UINT))) {
-    fprintf (stderr, "Word-based parsing with punctuation flags not possible with the specified data type.");
-    exit (EXIT_FAILURE);
+  /*  New primitive found  */
+  if (block_struct -> prims_array[prim] == UNINITIALIZED_GENERATION) {
+    block_struct -> num_prims += 1;
+    block_struct -> prims_array[prim] = 0;
   }
 
-  /*  Determine the largest symbol  */
-  if (args_struct -> base_datatype == (R_UINT) sizeof (R_UINT)) {
-    FOPEN (args_struct -> base_filename, fp, "r");
-    buf = wmalloc (sizeof (R_UINT) * INPUT_BUFFER_SIZE);
-    maxsym = 0;
-    do {
-      items = (R_UINT) fread (buf, sizeof (R_UINT), (size_t) INPUT_BUFFER_SIZE, fp);
-      for (i = 0; i < items; i++) {
-	buf[i] = buf[i] & NO_FLAGS;
-        if (buf[i] > maxsym) {
-	  maxsym = buf[i];
-	}
+  /*  Do not increment if maximum number of primitives is reached;
+  **  basically prevents counter from overflowing back to 0.  */
+  if (block_struct -> prims_array[prim] != UNINITIALIZED_GENERATION - 1) {
+    block_struct -> prims_array[prim] += 1;
+  }
+
+  initSeqNode (x, &(block_struct -> seq_buf[pos]));
+
+  return;
+}
+
+
+/*
+**  Fill the block's sequence buffer, from position curr_seq_buf_len,
+**  directly from the memory-mapped input file.  Returns the new
+**  length of the sequence.
+*/
+static R_UINT fillFromMap (PROG_INFO *prog_struct, BLOCK_INFO *block_struct, R_UINT curr_seq_buf_len) {
+  const R_UCHAR *src_c = NULL;
+  const R_USHRT *src_s = NULL;
+  const R_UINT *src_i = NULL;
+  size_t avail = 0;
+  R_UINT n = 0;
+  R_UINT i = 0;
+
+  avail = (prog_struct -> in_map_size - prog_struct -> in_map_pos) / prog_struct -> base_datatype;
+  n = block_struct -> seq_buf_len - curr_seq_buf_len;
+  if (avail < (size_t) n) {
+    n = (R_UINT) avail;
+  }
+
+  switch (prog_struct -> base_datatype) {
+    case 1:
+      src_c = prog_struct -> in_map + prog_struct -> in_map_pos;
+      for (i = 0; i < n; i++) {
+        addInputSymbol (prog_struct, block_struct, (R_UINT) src_c[i], curr_seq_buf_len + i);
+      }
+      break;
+    case 2:
+      src_s = (const R_USHRT*) (prog_struct -> in_map + prog_struct -> in_map_pos);
+      for (i = 0; i < n; i++) {
+        addInputSymbol (prog_struct, block_struct, (R_UINT) src_s[i], curr_seq_buf_len + i);
+      }
+      break;
+    case 4:
+      src_i = (const R_UINT*) (prog_struct -> in_map + prog_struct -> in_map_pos);
+      for (i = 0; i < n; i++) {
+        addInputSymbol (prog_struct, block_struct, src_i[i], curr_seq_buf_len + i);
       }
-    } while (feof (fp) == R_FALSE);
-    wfree (buf);
-    FCLOSE (fp);
-    args_struct -> max_prims = maxsym + 1;
+      break;
   }
+  prog_struct -> in_map_pos += (size_t) n * prog_struct -> base_datatype;
 
-  return (args_struct);
+  return (curr_seq_buf_len + n);
 }
 
 
+/*
+**  Map the whole input file into memory, so that blocks can be built
+**  from it without copying.  Returns R_FALSE if the file can not be
+**  mapped, in which case it is read with fread instead.
+*/
+static R_BOOLEAN mapInput (PROG_INFO *prog_struct) {
+  void *map = NULL;
+
+  if ((prog_struct -> in_file == NULL) || (prog_struct -> in_file_size == 0)) {
+    return (R_FALSE);
+  }
+  /*  On 32-bit systems, a large file does not fit in the address space  */
+  if ((R_ULL_INT) (size_t) prog_struct -> in_file_size != prog_struct -> in_file_size) {
+    return (R_FALSE);
+  }
+
+  map = mmap (NULL, (size_t) prog_struct -> in_file_size, PROT_READ, MAP_PRIVATE, fileno (prog_struct -> in_file), 0);
+  if (map == MAP_FAILED) {
+    return (R_FALSE);
+  }
+  /*  The file is read once, from start to end  */
+  (void) madvise (map, (size_t) prog_struct -> in_file_size, MADV_SEQUENTIAL);
+
+  prog_struct -> in_map = (const R_UCHAR*) map;
+  prog_struct -> in_map_size = (size_t) prog_struct -> in_file_size;
+  prog_struct -> in_map_pos = 0;
+
+  return (R_TRUE);
+}
+
 
 /*
-**  Perform Re-Pair on a file
+**  Read the next block of the input file into the block's sequence
+**  buffer.  Any symbols in block_struct -> input_stack (left over
+**  from the previous block) are placed at the front.
 */
-void executeRepair_File (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+static void fillRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_UINT curr_seq_buf_len = 0;
-  R_UINT items_read = 0;
   R_UINT k = 0;
   R_UINT m = 0;
-  R_UINT i = 0;
+  PHASE_STATS start;
+
+  startPhase (&start);
+  initRepair_OneBlock (prog_struct, block_struct);
+  curr_seq_buf_len = 0;
+  curr_seq_buf_len += block_struct -> input_stack_size;
+  block_struct -> input_stack_size = 0;
+
+  /*  Fill one sequence  */
+  if (prog_struct -> in_map != NULL) {
+    curr_seq_buf_len = fillFromMap (prog_struct, block_struct, curr_seq_buf_len);
+  }
+  while ((curr_seq_buf_len < prog_struct -> max_buffer_size) && (moreInput (prog_struct))) {
+    if (curr_seq_buf_len == block_struct -> seq_buf_len) {
+      growSeqBuf (prog_struct, block_struct);
+    }
+
+    addInputSymbol (prog_struct, block_struct, *(prog_struct -> input_buffer_p), curr_seq_buf_len);
+    curr_seq_buf_len++;
+    prog_struct -> input_buffer_p++;
+  }
+
+  if (curr_seq_buf_len < block_struct -> seq_buf_len) {
+    block_struct -> seq_buf_len = curr_seq_buf_len;
+    block_struct -> seq_buf_end = block_struct -> seq_buf + (block_struct -> seq_buf_len - 1);
+  }
 
-  /*  Declare various buffers, depending on which data type is used as input  */
-  R_UINT input_buffer[INPUT_BUFFER_SIZE];
-  /*  input_buffer_end points just off array  */
-  R_UINT *input_buffer_end = input_buffer + INPUT_BUFFER_SIZE;
-  R_UINT *input_buffer_p = input_buffer_end;
-  R_UCHAR *input_buffer_c = NULL;
-  R_USHRT *input_buffer_s = NULL;
-
-  if (prog_struct -> base_datatype == (R_UINT) sizeof (R_UCHAR)) {
-    input_buffer_c = wmalloc (sizeof (R_UCHAR) * INPUT_BUFFER_SIZE);
-  }
-  else if (prog_struct -> base_datatype == (R_UINT) sizeof (R_USHRT)) {
-    input_buffer_s = wmalloc (sizeof (R_USHRT) * INPUT_BUFFER_SIZE);
-  }
-
-  /*  Fill one block  */
-  while ((block_struct -> input_stack_size != 0) || (input_buffer_p < input_buffer_end) || (ftell (prog_struct -> in_file) < (R_L_INT) prog_struct -> in_file_size)) {
-    initRepair_OneBlock (prog_struct, block_struct);
-    curr_seq_buf_len = 0;
-    curr_seq_buf_len += block_struct -> input_stack_size;
-    block_struct -> input_stack_size = 0;
-
-    /*  Fill one sequence  */
-    while (curr_seq_buf_len < block_struct -> seq_buf_len && ((ftell (prog_struct -> in_file) < (R_L_INT) prog_struct -> in_file_size) || (input_buffer_p < input_buffer_end))) {
-      if (input_buffer_p == input_buffer_end) {
-        switch (prog_struct -> base_datatype) {
-          case 1:
-            items_read = (R_UINT) fread (input_buffer_c, sizeof (R_UCHAR), (size_t) INPUT_BUFFER_SIZE, prog_struct -> in_file);
-            for (i = 0; i < items_read; i++) {
-              input_buffer[i] = (R_UINT) input_buffer_c[i];
-            }
-            break;
-          case 2:
-            items_read = (R_UINT) fread (input_buffer_s, sizeof (R_USHRT), (size_t) INPUT_BUFFER_SIZE, prog_struct -> in_file);
-            for (i = 0; i < items_read; i++) {
-              input_buffer[i] = (R_UINT) input_buffer_s[i];
-            }
-            break;
-          case 4:
-            items_read = (R_UINT) fread (input_buffer, sizeof (R_UINT), (size_t) INPUT_BUFFER_SIZE, prog_struct -> in_file);
-            break;
+  /*  Rollback sequence  */
+  if ((prog_struct -> apply_heuristics == HEUR_WA) && (moreInput (prog_struct))) {
+    k = block_struct -> seq_buf_len - 1;
+    while ((k > 0) && (!ISWORD (block_struct -> seq_buf[k].value))) {
+      k--;
+    }
+    while ((k > 0) && (ISWORD (block_struct -> seq_buf[k].value))) {
+      k--;
+    }
+    /*
+    **  At this point, k will point to the last SEQ_NODE of the shortened
+    **  block_struct -> seq_buf.
+    */
+    if (k != 1) {
+      /*
+      **  m is used to iterate through the end of the array to copy
+      **  the values to an "input_stack".
+      */
+      m = k + 1;
+      block_struct -> input_stack = wmalloc (((block_struct -> seq_buf_len - m) * sizeof (SEQ_NODE)));
+      for (k = 0; k < block_struct -> seq_buf_len - m; k++) {
+        initSeqNode ((R_UINT) block_struct -> seq_buf[m + k].value, &block_struct -> input_stack[k]);
+        block_struct -> prims_array[block_struct -> seq_buf[m + k].value]--;
+        if (block_struct -> prims_array[block_struct -> seq_buf[m + k].value] == 0) {
+          block_struct -> num_prims--;
+          block_struct -> prims_array[block_struct -> seq_buf[m + k].value] = UNINITIALIZED_GENERATION;
         }
-        input_buffer_p = input_buffer;
-        input_buffer_end = input_buffer + items_read;
-      }
-      if (ferror (prog_struct -> in_file) != R_FALSE) {
-        fprintf (stderr, "Fatal error in reading from input file!\n");
-        exit (EXIT_FAILURE);
       }
 
-      if ((*input_buffer_p & NO_FLAGS) >= block_struct -> prims_array_size) {
-        fprintf (stderr, "Symbol %u encountered.\n", *input_buffer_p);
-        fprintf (stderr, "Symbol out of range in input buffer in %s, line %u.\n", __FILE__, __LINE__);
-        exit (EXIT_FAILURE);
-      }
+      /*  Decrease sequence from block_struct -> seq_buf_len by the number
+      **  of characters copied  */
+      block_struct -> seq_buf_len -= k;
+      block_struct -> seq_buf_end = block_struct -> seq_buf + (block_struct -> seq_buf_len - 1);
+      block_struct -> input_stack_size = k;
+    }
+    else {
+      /*  Roll back sequence to the beginning  */
+    }
+  }
 
-      /*  New primitive found  */
-      if (block_struct -> prims_array[(*input_buffer_p & NO_FLAGS)] == UNINITIALIZED_GENERATION) {
-        block_struct -> num_prims += 1;
-        block_struct -> prims_array[(*input_buffer_p & NO_FLAGS)] = 0;
-      }
+  block_struct -> in_length = block_struct -> seq_buf_len;
+  (block_struct -> sizelist) = initSListNode (block_struct -> num_prims);
+  endPhase (&start, &(block_struct -> phases[PHASE_FILL]));
 
-      /*  Do not increment if maximum number of primitives is reached;
-      **  basically prevents counter from overflowing back to 0.  */
-      if (block_struct -> prims_array[(*input_buffer_p & NO_FLAGS)] != UNINITIALIZED_GENERATION - 1) {
-        block_struct -> prims_array[(*input_buffer_p & NO_FLAGS)] += 1;
-      }
+  return;
+}
+
+
+/*
+**  Write the encoded block to the output files.  Blocks must be
+**  written in the order that they were read.
+*/
+static void writeRepair_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  BLOCKINDEXENTRY entry;
+  const R_UCHAR *prel_bytes = NULL;
+  size_t prel_bytes_len = 0;
+
+  if (block_struct -> prel_rec != prog_struct -> prel_rec) {
+    appendBitout (prog_struct -> prel_rec, block_struct -> prel_rec);
+  }
+  if (prog_struct -> container_out != NULL) {
+    /*  The block's prelude is a frame of its own, ending on a byte  */
+    writeBits (prog_struct -> prel_rec, 0, 0, R_TRUE);
+    prel_bytes = takeBitoutBytes (prog_struct -> prel_rec, &prel_bytes_len);
+    writeContainerBlock (prog_struct -> container_out, prel_bytes, prel_bytes_len, block_struct -> seq_out, block_struct -> seq_out_len, (R_ULL_INT) block_struct -> in_length, (R_ULL_INT) block_struct -> num_samples, block_struct -> samples, block_struct -> sample_bits);
+  }
+  else if (prog_struct -> stream_out != NULL) {
+    /*  Send the prelude so far, then the block's sequence  */
+    prel_bytes = takeBitoutBytes (prog_struct -> prel_rec, &prel_bytes_len);
+    writeStreamFrame (prog_struct -> stream_out, STREAM_FRAME_PREL, prel_bytes, prel_bytes_len);
+    writeStreamFrame (prog_struct -> stream_out, STREAM_FRAME_SEQ, block_struct -> seq_out, block_struct -> seq_out_len);
+  }
+  else {
+    (void) fwrite (block_struct -> seq_out, sizeof (R_UCHAR), block_struct -> seq_out_len, prog_struct -> seq_file);
+  }
+
+  /*  Record where the block starts in both files  */
+  entry.prel_offset = prog_struct -> index_prel_pos;
+  entry.seq_offset = prog_struct -> index_seq_pos;
+  entry.length = (R_ULL_INT) block_struct -> in_length;
+  entry.num_samples = (R_ULL_INT) block_struct -> num_samples;
+  if (prog_struct -> index_file != NULL) {
+    writeBlockIndexEntry (prog_struct -> index_file, &entry, block_struct -> samples, block_struct -> sample_bits);
+  }
+  prog_struct -> index_prel_pos = (prog_struct -> prel_rec) -> bitsWritten;
+  prog_struct -> index_seq_pos += (R_ULL_INT) block_struct -> seq_out_len;
+
+  displayStats_OneBlock (prog_struct, block_struct);
+  writeStatsJSON_OneBlock (prog_struct, block_struct);
 
-      initSeqNode ((R_UINT) *input_buffer_p, &(block_struct -> seq_buf[curr_seq_buf_len]));
-      curr_seq_buf_len++;
-      input_buffer_p++;
+  return;
+}
+
+
+/*
+**  Compress blocks given to the pool in the order that they were
+**  read, one block at a time.  Output is kept in memory until it is
+**  written out by the main thread.
+*/
+static void *repairWorker (void *arg) {
+  REPAIR_POOL *pool = (REPAIR_POOL*) arg;
+  REPAIR_SLOT *slot = NULL;
+
+  (void) pthread_mutex_lock (&pool -> lock);
+  while (R_TRUE) {
+    slot = &(pool -> slots[pool -> next_job % pool -> num_slots]);
+    while ((slot -> state != SLOT_FILLED) && (pool -> finished == R_FALSE)) {
+      (void) pthread_cond_wait (&pool -> cond, &pool -> lock);
+      slot = &(pool -> slots[pool -> next_job % pool -> num_slots]);
     }
+    if (slot -> state != SLOT_FILLED) {
+      break;
+    }
+    slot -> state = SLOT_RUNNING;
+    pool -> next_job++;
+    (void) pthread_mutex_unlock (&pool -> lock);
 
-    if (curr_seq_buf_len < block_struct -> seq_buf_len) {
-      block_struct -> seq_buf_len = curr_seq_buf_len;
-      block_struct -> seq_buf_end = block_struct -> seq_buf + (block_struct -> seq_buf_len - 1);
+    executeRepair_OneBlock (pool -> prog_struct, &(slot -> block));
+
+    (void) pthread_mutex_lock (&pool -> lock);
+    slot -> state = SLOT_DONE;
+    (void) pthread_cond_broadcast (&pool -> cond);
+  }
+  (void) pthread_mutex_unlock (&pool -> lock);
+
+  return (NULL);
+}
+
+
+/*
+**  Wait for the block in the given slot to be compressed, write it
+**  out, and release the slot for the next block
+*/
+static void drainRepairSlot (PROG_INFO *prog_struct, REPAIR_POOL *pool, REPAIR_SLOT *slot) {
+  (void) pthread_mutex_lock (&pool -> lock);
+  while ((slot -> state == SLOT_FILLED) || (slot -> state == SLOT_RUNNING)) {
+    (void) pthread_cond_wait (&pool -> cond, &pool -> lock);
+  }
+  (void) pthread_mutex_unlock (&pool -> lock);
+
+  if (slot -> state == SLOT_DONE) {
+    writeRepair_OneBlock (prog_struct, &(slot -> block));
+    uninitRepair_OneBlock (prog_struct, &(slot -> block));
+  }
+
+  (void) pthread_mutex_lock (&pool -> lock);
+  slot -> state = SLOT_EMPTY;
+  (void) pthread_mutex_unlock (&pool -> lock);
+
+  return;
+}
+
+
+/*
+**  Perform Re-Pair on a file with several blocks compressed at once.
+**  The main thread reads the blocks and writes them out in order;
+**  the worker threads compress them.
+*/
+static void executeRepair_FileParallel (PROG_INFO *prog_struct) {
+  REPAIR_POOL *pool = NULL;
+  REPAIR_SLOT *slot = NULL;
+  pthread_t *threads = NULL;
+  SEQ_NODE *carry_stack = NULL;
+  R_UINT carry_stack_size = 0;
+  R_UINT block_count = 0;
+  R_UINT i = 0;
+
+  pool = wmalloc (sizeof (REPAIR_POOL));
+  pool -> prog_struct = prog_struct;
+  /*  One slot more than the number of threads so that the next block
+  **  can be read while the others are being compressed  */
+  pool -> num_slots = prog_struct -> num_threads + 1;
+  pool -> slots = wmalloc (pool -> num_slots * sizeof (REPAIR_SLOT));
+  pool -> next_job = 0;
+  pool -> finished = R_FALSE;
+  (void) pthread_mutex_init (&pool -> lock, NULL);
+  (void) pthread_cond_init (&pool -> cond, NULL);
+
+  for (i = 0; i < pool -> num_slots; i++) {
+    initBlockInfo (&(pool -> slots[i].block));
+    pool -> slots[i].block.prel_rec = newBitout (NULL);
+    pool -> slots[i].state = SLOT_EMPTY;
+  }
+
+  threads = wmalloc (prog_struct -> num_threads * sizeof (pthread_t));
+  for (i = 0; i < prog_struct -> num_threads; i++) {
+    if (pthread_create (&threads[i], NULL, repairWorker, pool) != 0) {
+      raiseError ("Error creating thread %u in %s, line %u.\n", i, __FILE__, __LINE__);
     }
+  }
 
-    /*  Rollback sequence  */
-    if ((prog_struct -> apply_heuristics == HEUR_WA) && ((ftell (prog_struct -> in_file) < (R_L_INT) prog_struct -> in_file_size) || (input_buffer_p < input_buffer_end))) {
-      k = block_struct -> seq_buf_len - 1;
-      while ((k > 0) && (!ISWORD (block_struct -> seq_buf[k].value))) {
-	k--;
-      }
-      while ((k > 0) && (ISWORD (block_struct -> seq_buf[k].value))) {
-	k--;
-      }
-      /*
-      **  At this point, k will point to the last SEQ_NODE of the shortened
-      **  block_struct -> seq_buf.
-      */
-      if (k != 1) {
-	/*
-	**  m is used to iterate through the end of the array to copy
-	**  the values to an "input_stack".
-	*/
-	m = k + 1;
-	block_struct -> input_stack = wmalloc (((block_struct -> seq_buf_len - m) * sizeof (SEQ_NODE)));
-	for (k = 0; k < block_struct -> seq_buf_len - m; k++) {
-	  initSeqNode ((R_UINT) block_struct -> seq_buf[m + k].value, &block_struct -> input_stack[k]);
-	  block_struct -> prims_array[block_struct -> seq_buf[m + k].value]--;
-	  if (block_struct -> prims_array[block_struct -> seq_buf[m + k].value] == 0) {
-	    block_struct -> num_prims--;
-            block_struct -> prims_array[block_struct -> seq_buf[m + k].value] = UNINITIALIZED_GENERATION;
-	  }
-	}
-
-        /*  Decrease sequence from block_struct -> seq_buf_len by the number
-        **  of characters copied  */
-	block_struct -> seq_buf_len -= k;
-	block_struct -> seq_buf_end = block_struct -> seq_buf + (block_struct -> seq_buf_len - 1);
-	block_struct -> input_stack_size = k;
-      }
-      else {
-        /*  Roll back sequence to the beginning  */
-      }
+  while ((carry_stack_size != 0) || (moreInput (prog_struct))) {
+    slot = &(pool -> slots[block_count % pool -> num_slots]);
+    drainRepairSlot (prog_struct, pool, slot);
+
+    /*  Pass the end of the previous block on to this one  */
+    slot -> block.input_stack = carry_stack;
+    slot -> block.input_stack_size = carry_stack_size;
+    fillRepair_OneBlock (prog_struct, &(slot -> block));
+    carry_stack = slot -> block.input_stack;
+    carry_stack_size = slot -> block.input_stack_size;
+    slot -> block.input_stack = NULL;
+    slot -> block.input_stack_size = 0;
+
+    (void) pthread_mutex_lock (&pool -> lock);
+    slot -> state = SLOT_FILLED;
+    (void) pthread_cond_broadcast (&pool -> cond);
+    (void) pthread_mutex_unlock (&pool -> lock);
+    block_count++;
+  }
+
+  /*  Write out the remaining blocks in order  */
+  for (i = 0; i < pool -> num_slots; i++) {
+    drainRepairSlot (prog_struct, pool, &(pool -> slots[block_count % pool -> num_slots]));
+    block_count++;
+  }
+
+  (void) pthread_mutex_lock (&pool -> lock);
+  pool -> finished = R_TRUE;
+  (void) pthread_cond_broadcast (&pool -> cond);
+  (void) pthread_mutex_unlock (&pool -> lock);
+  for (i = 0; i < prog_struct -> num_threads; i++) {
+    (void) pthread_join (threads[i], NULL);
+  }
+
+  for (i = 0; i < pool -> num_slots; i++) {
+    deleteBitout (pool -> slots[i].block.prel_rec);
+  }
+  (void) pthread_mutex_destroy (&pool -> lock);
+  (void) pthread_cond_destroy (&pool -> cond);
+  wfree (threads);
+  wfree (pool -> slots);
+  wfree (pool);
+
+  return;
+}
+
+
+/*
+**  Perform Re-Pair on a file
+*/
+void executeRepair_File (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  /*  Read the input through buffers if it can not be mapped (unless
+  **  it is in memory already; see repairBuffer)  */
+  if ((prog_struct -> in_map == NULL) && ((prog_struct -> in_stream == R_TRUE) || (mapInput (prog_struct) == R_FALSE))) {
+    prog_struct -> input_buffer = wmalloc (sizeof (R_UINT) * INPUT_BUFFER_SIZE);
+    changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, 0, sizeof (R_UINT) * INPUT_BUFFER_SIZE);
+    /*  input_buffer_end points just off array  */
+    prog_struct -> input_buffer_end = prog_struct -> input_buffer + INPUT_BUFFER_SIZE;
+    prog_struct -> input_buffer_p = prog_struct -> input_buffer_end;
+
+    /*  Declare various buffers, depending on which data type is used as input  */
+    if (prog_struct -> base_datatype == (R_UINT) sizeof (R_UCHAR)) {
+      prog_struct -> input_buffer_c = wmalloc (sizeof (R_UCHAR) * INPUT_BUFFER_SIZE);
+      changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, 0, sizeof (R_UCHAR) * INPUT_BUFFER_SIZE);
     }
+    else if (prog_struct -> base_datatype == (R_UINT) sizeof (R_USHRT)) {
+      prog_struct -> input_buffer_s = wmalloc (sizeof (R_USHRT) * INPUT_BUFFER_SIZE);
+      changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, 0, sizeof (R_USHRT) * INPUT_BUFFER_SIZE);
+    }
+  }
+
+  if (prog_struct -> num_threads > 1) {
+    executeRepair_FileParallel (prog_struct);
+  }
+  else {
+    block_struct -> prel_rec = prog_struct -> prel_rec;
 
-    (block_struct -> sizelist) = initSListNode (block_struct -> num_prims);
+    /*  Fill one block  */
+    while ((block_struct -> input_stack_size != 0) || (moreInput (prog_struct))) {
+      fillRepair_OneBlock (prog_struct, block_struct);
 
-    executeRepair_OneBlock (prog_struct, block_struct);
-    encodeHierarchy_OneBlock (prog_struct, block_struct);
-    encodeSequence_OneBlock (prog_struct, block_struct);
-    displayStats_OneBlock (prog_struct, block_struct);
+      executeRepair_OneBlock (prog_struct, block_struct);
+      writeRepair_OneBlock (prog_struct, block_struct);
 
-    uninitRepair_OneBlock (prog_struct, block_struct);
+      uninitRepair_OneBlock (prog_struct, block_struct);
+    }
   }
 
-  if (input_buffer_c != NULL) {
-    wfree (input_buffer_c);
+  if (prog_struct -> input_buffer_c != NULL) {
+    wfree (prog_struct -> input_buffer_c);
+    changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, sizeof (R_UCHAR) * INPUT_BUFFER_SIZE, 0);
+  }
+  else if (prog_struct -> input_buffer_s != NULL) {
+    wfree (prog_struct -> input_buffer_s);
+    changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, sizeof (R_USHRT) * INPUT_BUFFER_SIZE, 0);
   }
-  else if (input_buffer_s != NULL) {
-    wfree (input_buffer_s);
+  prog_struct -> input_buffer_c = NULL;
+  prog_struct -> input_buffer_s = NULL;
+  if (prog_struct -> input_buffer != NULL) {
+    wfree (prog_struct -> input_buffer);
+    changeMemory (prog_struct -> memory, MEM_IO_BUFFERS, sizeof (R_UINT) * INPUT_BUFFER_SIZE, 0);
   }
+  prog_struct -> input_buffer = NULL;
+  prog_struct -> input_buffer_p = NULL;
+  prog_struct -> input_buffer_end = NULL;
+
+  if ((prog_struct -> in_map != NULL) && (prog_struct -> in_file != NULL)) {
+    (void) munmap ((void*) prog_struct -> in_map, prog_struct -> in_map_size);
+  }
+  prog_struct -> in_map = NULL;
+  prog_struct -> in_map_size = 0;
+  prog_struct -> in_map_pos = 0;
+
+  return;
+}
+
+/*
+**  Initialize values that are reset at the beginning of each block.
+**  Assumes uninitRepair_OneBlock will be run soon.
+*/
+static void initBlockInfo (BLOCK_INFO *block_struct) {
+  block_struct -> block_num = 0;
+  block_struct -> seq_buf = NULL; 
+  block_struct -> seq_buf_size = 0;
+  block_struct -> input_stack = NULL;
+  block_struct -> input_stack_size = 0;
+  block_struct -> prims_array = NULL;  
+  block_struct -> tent_phrases = NULL;
+  block_struct -> tphrase_root = NULL;
+  block_struct -> paired = NULL;
+  block_struct -> pqueue = NULL;
+
+  block_struct -> temp_phrases = NULL;
+  block_struct -> phrase_tags = NULL;
+  block_struct -> valid_pair = NULL;
+  block_struct -> sort_phrases = NULL;
+  block_struct -> new_index = NULL;
+  block_struct -> seq_nodelist = NULL;
+
+  block_struct -> prel_rec = NULL;
+  block_struct -> seq_out = NULL;
+  block_struct -> seq_out_len = 0;
+  block_struct -> seq_out_size = 0;
+  block_struct -> samples = NULL;
+  block_struct -> sample_bits = NULL;
+  block_struct -> num_samples = 0;
+  block_struct -> samples_size = 0;
+
+  /*  Initialize values to 0 before calling uninitRepair_OneBlock  */
+  block_struct -> num_prims = 0;
+  block_struct -> num_phrases = 0;
+  block_struct -> num_generation = 0;
+  block_struct -> sum_phrase_length = 0;
+  block_struct -> longest_phrase = 0;
+  block_struct -> longest_phrase_length = 0;
+  block_struct -> num_symbols = 0;
+  block_struct -> in_length = 0;
+  block_struct -> tphrase_in_use = 0;
+  block_struct -> max_tphrase_in_use = 0;
+  block_struct -> num_replacements = 0;
+  clearPhases (block_struct -> phases, NUM_REPAIR_PHASES);
+  clearMemory (block_struct -> memory, NUM_REPAIR_MEMORY);
 
   return;
 }
 
+
 /*
 **  Initialize the two main data structures
 */
 void initRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_CHAR *temp_filename = NULL;
+  FILE *fp = NULL;
+  int c;
   ARGS_INFO *args_struct = prog_struct -> args_struct;
 
   /*  Statistics on file  */
   struct stat statbuffer;
 
   if ((prog_struct == NULL) || (block_struct == NULL)) {
-    fprintf (stderr, "Structures prog_struct and block_struct need to be malloc'ed.\n");
-    exit (EXIT_FAILURE);
+    raiseError ("Structures prog_struct and block_struct need to be malloc'ed.\n");
   }
 
+  startRun (&(prog_struct -> run_start));
+
   /*  Initialize variables in structures  */
   prog_struct -> progname = NULL;
 
   prog_struct -> in_file = NULL;
+  prog_struct -> in_stream = R_FALSE;
   prog_struct -> in_file_size = 0;
   prog_struct -> seq_file = NULL;
   prog_struct -> prel_file = NULL;
   prog_struct -> prel_text_file = NULL;
   prog_struct -> shuff_file = NULL;
+  prog_struct -> index_file = NULL;
+  prog_struct -> stream_out = NULL;
+  prog_struct -> container_out = NULL;
+  prog_struct -> index_prel_pos = 0;
+  prog_struct -> index_seq_pos = 0;
+  prog_struct -> sample_rate = BLOCKINDEX_SAMPLE_RATE;
+  prog_struct -> stats_file = NULL;
+  prog_struct -> in_filename = NULL;
   prog_struct -> base_filename = NULL;
 
   prog_struct -> verbose_level = R_FALSE;
+  prog_struct -> perf_counters = R_FALSE;
   prog_struct -> max_buffer_size = MAX_BUFFER_SIZE;
   prog_struct -> max_length = UINT_MAX;
   prog_struct -> max_phrases = UINT_MAX;
   prog_struct -> max_keep_count = MIN_KEEP_COUNT;
   prog_struct -> apply_heuristics = HEUR_NONE;
   prog_struct -> word_flags = UW_NO;
+  prog_struct -> seq_coding = SEQ_CODING_RAW;
   prog_struct -> add_prims = R_FALSE;
   prog_struct -> base_datatype = (R_UINT) sizeof (R_UCHAR);
   prog_struct -> max_prims = MIN_PRIMS_ARRAY;
   prog_struct -> dowordlen = R_FALSE;
+  prog_struct -> num_threads = 1;
+
+  prog_struct -> prel_rec = NULL;
+  prog_struct -> input_buffer = NULL;
+  prog_struct -> input_buffer_p = NULL;
+  prog_struct -> input_buffer_end = NULL;
+  prog_struct -> input_buffer_c = NULL;
+  prog_struct -> input_buffer_s = NULL;
+  prog_struct -> in_file_read = 0;
+  prog_struct -> in_map = NULL;
+  prog_struct -> in_map_size = 0;
+  prog_struct -> in_map_pos = 0;
 
   prog_struct -> maximum_total_num_phrases = 0;
   prog_struct -> total_num_phrases = 0;
@@ -660,6 +1167,12 @@ void initRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   prog_struct -> max_longest_phrase_block = 0;
   prog_struct -> max_longest_phrase_num = 0;
   prog_struct -> max_longest_phrase_length = 0;
+  prog_struct -> total_in_length = 0;
+  prog_struct -> total_replacements = 0;
+  prog_struct -> maximum_tphrase_in_use = 0;
+  clearPhases (prog_struct -> total_phases, NUM_REPAIR_PHASES);
+  clearPhases (&(prog_struct -> run_time), 1);
+  clearMemory (prog_struct -> memory, NUM_REPAIR_MEMORY);
 
   if (prog_struct -> args_struct != NULL) {
     /*  Set variables from args_struct  */
@@ -667,10 +1180,23 @@ void initRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
     strcpy (prog_struct -> progname, args_struct -> progname);
     prog_struct -> max_buffer_size = args_struct -> max_buffer_size;
     prog_struct -> prel_text_file = args_struct -> prel_text_file;
-    prog_struct -> base_filename = wmalloc (sizeof (R_CHAR) * (strlen (args_struct -> base_filename) + 1));
-    strcpy (prog_struct -> base_filename, args_struct -> base_filename);
+    prog_struct -> in_filename = wmalloc (sizeof (R_CHAR) * (strlen (args_struct -> base_filename) + 1));
+    strcpy (prog_struct -> in_filename, args_struct -> base_filename);
+    /*  Output files are named after the input, unless given with -o;
+    **  they are interleaved to stdout if there is no name  */
+    if (args_struct -> out_filename != NULL) {
+      if (strcmp (args_struct -> out_filename, STDIO_FILENAME) != 0) {
+        prog_struct -> base_filename = wmalloc (sizeof (R_CHAR) * (strlen (args_struct -> out_filename) + 1));
+        strcpy (prog_struct -> base_filename, args_struct -> out_filename);
+      }
+    }
+    else if (strcmp (args_struct -> base_filename, STDIO_FILENAME) != 0) {
+      prog_struct -> base_filename = wmalloc (sizeof (R_CHAR) * (strlen (args_struct -> base_filename) + 1));
+      strcpy (prog_struct -> base_filename, args_struct -> base_filename);
+    }
     prog_struct -> apply_heuristics = args_struct -> apply_heuristics;
     prog_struct -> word_flags = args_struct -> word_flags;
+    prog_struct -> seq_coding = args_struct -> seq_coding;
     prog_struct -> add_prims = args_struct -> add_prims;
     prog_struct -> max_length = args_struct -> max_length;
     prog_struct -> max_phrases = args_struct -> max_phrases;
@@ -679,81 +1205,129 @@ void initRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
     prog_struct -> base_datatype = args_struct -> base_datatype;
     prog_struct -> max_prims = args_struct -> max_prims;
     prog_struct -> dowordlen = args_struct -> dowordlen;
+    prog_struct -> num_threads = args_struct -> num_threads;
+    if (args_struct -> stats_filename != NULL) {
+      prog_struct -> stats_file = openStatsJSON (args_struct -> stats_filename, "repair");
+    }
+    if (args_struct -> perf_counters == R_TRUE) {
+      prog_struct -> perf_counters = enablePerfCounters ();
+    }
   }
 
-  prog_struct -> seq_nodelist_size = INIT_NODELIST_SIZE;
-  prog_struct -> seq_nodelist = wmalloc (prog_struct -> seq_nodelist_size * sizeof (SEQ_NODE*));
-
-  if (args_struct -> base_filename != NULL) {
+  if (prog_struct -> in_filename != NULL) {
     /*  Open source file  */
-    prog_struct -> in_file = fopen (prog_struct -> base_filename, "r");
+    if (strcmp (prog_struct -> in_filename, STDIO_FILENAME) == 0) {
+      prog_struct -> in_file = stdin;
+    }
+    else {
+      prog_struct -> in_file = fopen (prog_struct -> in_filename, "r");
+    }
     if (prog_struct -> in_file == NULL) {
-      fprintf (stderr, "Input file not found.");
-      exit (EXIT_FAILURE);
+      raiseError ("Input file not found.");
     }
 
-    /*  Get statistics on file  */
-    if (stat (prog_struct -> base_filename, &statbuffer) != 0) {
-      fprintf (stderr, "Error in obtaining file info for %s.\n", prog_struct -> base_filename);
-      exit (EXIT_FAILURE);
+    /*  Get statistics on file; pipes and other streams have no size
+    **  and are read as the data arrives  */
+    if (fstat (fileno (prog_struct -> in_file), &statbuffer) != 0) {
+      raiseError ("Error in obtaining file info for %s.\n", prog_struct -> in_filename);
     }
-    prog_struct -> in_file_size = (R_UINT) statbuffer.st_size;
+    if (S_ISREG (statbuffer.st_mode)) {
+      prog_struct -> in_file_size = (R_ULL_INT) statbuffer.st_size;
 
-    if (prog_struct -> in_file_size < prog_struct -> max_buffer_size) {
-      prog_struct -> max_buffer_size = prog_struct -> in_file_size;
+      if (prog_struct -> in_file_size < (R_ULL_INT) prog_struct -> max_buffer_size) {
+        prog_struct -> max_buffer_size = (R_UINT) prog_struct -> in_file_size;
+      }
+
+      if (prog_struct -> in_file_size == 0) {
+        raiseError ("Empty input file.");
+      }
+    }
+    else {
+      prog_struct -> in_stream = R_TRUE;
+
+      /*  A stream has no size, so look for its first byte before
+      **  anything is written out  */
+      c = getc (prog_struct -> in_file);
+      if (c == EOF) {
+        raiseError ("Empty input file.");
+      }
+      ungetc (c, prog_struct -> in_file);
     }
 
-    if (prog_struct -> in_file_size == 0) {
-      fprintf (stderr, "Empty input file.");
-      exit (EXIT_FAILURE);
+    if ((args_struct != NULL) && (args_struct -> container == R_TRUE)) {
+      /*  One file, or stdout if there is no name; the index is written
+      **  at its end  */
+      fp = stdout;
+      if (prog_struct -> base_filename != NULL) {
+        temp_filename = wmalloc ((sizeof(R_CHAR)*(strlen (prog_struct -> base_filename)+strlen (CONTAINER_SUFFIX)+1)));
+        temp_filename = strcpy (temp_filename, prog_struct -> base_filename);
+        temp_filename = strcat (temp_filename, CONTAINER_SUFFIX);
+        fp = fopen (temp_filename, "w");
+        if (fp == NULL) {
+          raiseError ("Error creating container file.\n");
+        }
+        wfree (temp_filename);
+      }
+      prog_struct -> stream_out = newStreamOut (fp, NULL, NULL);
+      prog_struct -> prel_rec = newBitout (NULL);
+      prog_struct -> container_out = newContainerOut (prog_struct -> stream_out, prog_struct -> base_datatype, prog_struct -> sample_rate);
     }
+    else if (prog_struct -> base_filename != NULL) {
+      temp_filename = wmalloc ((sizeof(R_CHAR)*(strlen (prog_struct -> base_filename)+7)));
 
-    temp_filename = wmalloc ((sizeof(R_CHAR)*(strlen (prog_struct -> base_filename)+7)));
+      temp_filename = strcpy (temp_filename, prog_struct -> base_filename);
+      temp_filename = strcat (temp_filename, ".seq");
 
-    temp_filename = strcpy (temp_filename, prog_struct -> base_filename);
-    temp_filename = strcat (temp_filename, ".seq");
+      prog_struct -> seq_file = fopen (temp_filename, "w");
+      if (prog_struct -> seq_file == NULL) {
+        raiseError ("Error creating seq file in %s on line %u.\n", __FILE__, __LINE__);
+      }
 
-    prog_struct -> seq_file = fopen (temp_filename, "w");
-    if (prog_struct -> seq_file == NULL) {
-      fprintf (stderr, "Error creating seq file in %s on line %u.\n", __FILE__, __LINE__);
-      exit (EXIT_FAILURE);
-    }
+      /*  Create prel file  */
+      temp_filename = strcpy (temp_filename, prog_struct -> base_filename);
+      temp_filename = strcat (temp_filename, ".prel");
+      prog_struct -> prel_file = fopen (temp_filename, "w");
+      if (prog_struct -> prel_file == NULL) {
+        raiseError ("Error creating prel file.\n");
+      }
+      prog_struct -> prel_rec = newBitout (prog_struct -> prel_file);
+
+      /*  Create index of the blocks in the prel and seq files  */
+      temp_filename = strcpy (temp_filename, prog_struct -> base_filename);
+      temp_filename = strcat (temp_filename, ".idx");
+      prog_struct -> index_file = fopen (temp_filename, "w");
+      if (prog_struct -> index_file == NULL) {
+        raiseError ("Error creating idx file.\n");
+      }
+      writeBlockIndexHeader (prog_struct -> index_file, prog_struct -> sample_rate);
 
-    /*  Create prel file  */
-    temp_filename = strcpy (temp_filename, prog_struct -> base_filename);
-    temp_filename = strcat (temp_filename, ".prel");
-    prog_struct -> prel_file = fopen (temp_filename, "w");
-    if (prog_struct -> prel_file == NULL) {
-      fprintf (stderr, "Error creating prel file.\n");
+      wfree (temp_filename);
+    }
+    else {
+      /*  The prelude is kept in memory and sent out after each block;
+      **  there is no index, since the stream can not be searched  */
+      prog_struct -> stream_out = newStreamOut (stdout, NULL, NULL);
+      prog_struct -> prel_rec = newBitout (NULL);
+      writeStreamHeader (prog_struct -> stream_out);
     }
-
-    wfree (temp_filename);
   }
   else {
   }
 
-  /*  Initialize values that are reset at the beginning of each block.  */
-  /*  Assumes uninitRepair_OneBlock will be run soon.  */
-  block_struct -> seq_buf = NULL; 
-  block_struct -> input_stack = NULL;
-  block_struct -> input_stack_size = 0;
-  block_struct -> prims_array = NULL;  
-  block_struct -> tent_phrases = NULL;
-  block_struct -> pqueue = NULL;
+  initBlockInfo (block_struct);
 
-  block_struct -> temp_phrases = NULL;
-  block_struct -> sort_phrases = NULL;
-
-  /*  Initialize values to 0 before calling uninitRepair_OneBlock  */
-  block_struct -> num_prims = 0;
-  block_struct -> num_phrases = 0;
-  block_struct -> num_generation = 0;
-  block_struct -> sum_phrase_length = 0;
-  block_struct -> longest_phrase_length = 0;
-  block_struct -> num_symbols = 0;
+  if (prog_struct -> stats_file != NULL) {
+    fprintf (prog_struct -> stats_file, "  \"input\": ");
+    writeStringJSON (prog_struct -> stats_file, prog_struct -> in_filename);
+    fprintf (prog_struct -> stats_file, ",\n  \"type\": %u,\n  \"blocks\": [", prog_struct -> base_datatype);
+  }
 
   if (prog_struct -> verbose_level == R_TRUE) {
-    fprintf (stderr, "Block\tPrims\tPhrases\t  Prims + Phrases\tGenerations\tSymbols\n\n");
+    fprintf (stderr, "Block\tPrims\tPhrases\t  Prims + Phrases\tGenerations\tSymbols\n");
+    if (prog_struct -> perf_counters == R_TRUE) {
+      printCountersHeader (stderr);
+    }
+    fprintf (stderr, "\n");
   }
 
   return;
@@ -761,18 +1335,47 @@ void initRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
 
 
 void uninitRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
+  const R_UCHAR *prel_bytes = NULL;
+  size_t prel_bytes_len = 0;
+
   /*
   **  If output was sent to a file, then put an end of file marker
   **  on the prelude file and close both the seq and prel files.
   */
-  if (prog_struct -> prel_file != NULL) {
-    writeBits (prog_struct -> prel_file, 1, 1, R_FALSE);
-    writeBits (prog_struct -> prel_file, 0, 0, R_FALSE);
-    writeBits (prog_struct -> prel_file, 0, 0, R_FALSE);
-    writeBits (prog_struct -> prel_file, 0, 0, R_TRUE);
-
-    FCLOSE (prog_struct -> seq_file);
-    FCLOSE (prog_struct -> prel_file);
+  if (prog_struct -> prel_rec != NULL) {
+    /*  A container ends with its index instead  */
+    if (prog_struct -> container_out == NULL) {
+      writeBits (prog_struct -> prel_rec, 1, 1, R_FALSE);
+      writeBits (prog_struct -> prel_rec, 0, 0, R_FALSE);
+      writeBits (prog_struct -> prel_rec, 0, 0, R_FALSE);
+      writeBits (prog_struct -> prel_rec, 0, 0, R_TRUE);
+    }
+
+    if (prog_struct -> container_out != NULL) {
+      finishContainerOut (prog_struct -> container_out);
+      deleteContainerOut (prog_struct -> container_out);
+      prog_struct -> container_out = NULL;
+      if (((prog_struct -> stream_out) -> fp != NULL) && ((prog_struct -> stream_out) -> fp != stdout)) {
+        FCLOSE ((prog_struct -> stream_out) -> fp);
+      }
+      deleteStreamOut (prog_struct -> stream_out);
+      prog_struct -> stream_out = NULL;
+    }
+    else if (prog_struct -> stream_out != NULL) {
+      prel_bytes = takeBitoutBytes (prog_struct -> prel_rec, &prel_bytes_len);
+      writeStreamFrame (prog_struct -> stream_out, STREAM_FRAME_PREL, prel_bytes, prel_bytes_len);
+      writeStreamFrame (prog_struct -> stream_out, STREAM_FRAME_END, NULL, 0);
+      deleteStreamOut (prog_struct -> stream_out);
+      prog_struct -> stream_out = NULL;
+    }
+    else {
+      FCLOSE (prog_struct -> seq_file);
+      FCLOSE (prog_struct -> prel_file);
+      FCLOSE (prog_struct -> index_file);
+    }
+    deleteBitout (prog_struct -> prel_rec);
+    prog_struct -> prel_rec = NULL;
+
     if (prog_struct -> prel_text_file != NULL) {
       FCLOSE (prog_struct -> prel_text_file);
     }
@@ -781,11 +1384,11 @@ void uninitRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   
 #ifdef DEBUG
     fprintf (stderr, "\nOverall Statistics:\n\n");
-    fprintf (stderr, "Input filename:  %s\n", prog_struct -> base_filename != NULL ? prog_struct -> base_filename : "N/A");
-    fprintf (stderr, "Input file size:  %d\n", prog_struct -> base_filename != NULL ? prog_struct -> in_file_size : 0);
-    fprintf (stderr, "Total number of phrases:  %d\n", prog_struct -> total_num_phrases);
-    fprintf (stderr, "Total number of blocks:  %d\n", prog_struct -> total_blocks);
-    fprintf (stderr, "Total sequence length:  %d\n", prog_struct -> total_num_symbols);
+    fprintf (stderr, "Input filename:  %s\n", prog_struct -> in_filename != NULL ? prog_struct -> in_filename : "N/A");
+    fprintf (stderr, "Input file size:  %llu\n", prog_struct -> in_filename != NULL ? prog_struct -> in_file_size : 0);
+    fprintf (stderr, "Total number of phrases:  %llu\n", prog_struct -> total_num_phrases);
+    fprintf (stderr, "Total number of blocks:  %u\n", prog_struct -> total_blocks);
+    fprintf (stderr, "Total sequence length:  %llu\n", prog_struct -> total_num_symbols);
     if (prog_struct -> prel_text_file != NULL) {
       fprintf (stderr, "Average length of phrases:  %f per phrase\n", (R_DOUBLE) prog_struct -> total_sum_phrase_length / (R_DOUBLE) prog_struct -> total_num_phrases);
       fprintf (stderr, "The longest phrases was:\n");
@@ -804,14 +1407,146 @@ void uninitRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   /*  Must add 1 to maximum_generations since it is 0-based  */
   if (prog_struct -> verbose_level == R_TRUE) {
     fprintf (stderr, "-------------------------------------------------------------------------\n");
-    fprintf (stderr, "%5u\t%5u\t%7u\t  %15u\t%11u\t%7u\n", prog_struct -> total_blocks, prog_struct -> total_num_prims, prog_struct -> total_num_phrases, prog_struct -> total_num_prims + prog_struct -> total_num_phrases, prog_struct -> maximum_generations + 1, prog_struct -> total_num_symbols);
+    fprintf (stderr, "%5u\t%5llu\t%7llu\t  %15llu\t%11u\t%7llu\n", prog_struct -> total_blocks, prog_struct -> total_num_prims, prog_struct -> total_num_phrases, prog_struct -> total_num_prims + prog_struct -> total_num_phrases, prog_struct -> maximum_generations + 1, prog_struct -> total_num_symbols);
+    if (prog_struct -> perf_counters == R_TRUE) {
+      printPhasesCounters (stderr, phase_names, prog_struct -> total_phases, NUM_REPAIR_PHASES);
+    }
+    printMemory (stderr, memory_names, prog_struct -> memory, NUM_REPAIR_MEMORY);
+  }
+
+  if ((prog_struct -> in_file != NULL) && (prog_struct -> in_file != stdin)) {
+    FCLOSE (prog_struct -> in_file);
+  }
+
+  if (prog_struct -> stats_file != NULL) {
+    endRun (&(prog_struct -> run_start), &(prog_struct -> run_time));
+    writeStatsJSON_Totals (prog_struct);
+    closeStatsJSON (prog_struct -> stats_file);
+  }
+  prog_struct -> stats_file = NULL;
+
+  if (prog_struct -> perf_counters == R_TRUE) {
+    disablePerfCounters ();
+    prog_struct -> perf_counters = R_FALSE;
   }
 
-  wfree (prog_struct -> seq_nodelist);
   wfree (prog_struct -> progname);
-  wfree (prog_struct -> base_filename);
+  wfree (prog_struct -> in_filename);
+  if (prog_struct -> base_filename != NULL) {
+    wfree (prog_struct -> base_filename);
+  }
+
+  return;
+}
+
+
+/*
+**  Set the options of the library to the defaults of the program
+*/
+void initLibRepairOptions (LIBREPAIR_OPTIONS *options) {
+  options -> base_datatype = (R_UINT) sizeof (R_UCHAR);
+  options -> max_buffer_size = MAX_BUFFER_SIZE;
+  options -> max_length = UINT_MAX;
+  options -> max_phrases = UINT_MAX;
+  options -> max_keep_count = MIN_KEEP_COUNT;
+  options -> apply_heuristics = (R_UINT) HEUR_NONE;
+  options -> seq_coding = SEQ_CODING_RAW;
+  options -> add_prims = R_FALSE;
+  options -> container = 0;
 
   return;
 }
 
 
+/*
+**  Compress the in_length bytes at in, which are aligned for the data
+**  type, to an interleaved stream written to sink (see librepair.c)
+*/
+void repairBuffer (const LIBREPAIR_OPTIONS *options, const R_UCHAR *in, size_t in_length, STREAM_SINK sink, void *sink_arg) {
+  PROG_INFO *prog_struct = NULL;
+  BLOCK_INFO *block_struct = NULL;
+  const R_UINT *in_i = NULL;
+  R_UINT maxsym = 0;
+  size_t i = 0;
+
+  /*  Options are checked as they are by parseArguments  */
+  if ((options -> base_datatype != (R_UINT) sizeof (R_UCHAR)) &&
+      (options -> base_datatype != (R_UINT) sizeof (R_USHRT)) &&
+      (options -> base_datatype != (R_UINT) sizeof (R_UINT))) {
+    raiseError ("Input data type (-t) not valid.\n");
+  }
+  if (((size_t) in % options -> base_datatype) != 0) {
+    raiseError ("Input is not aligned for its data type.\n");
+  }
+  if ((options -> max_buffer_size == 0) || (options -> max_buffer_size > MAX_BUFFER_SIZE)) {
+    raiseError ("Option with -b must be less than or equal to MAX_BUFFER_SIZE\n");
+  }
+  if ((options -> seq_coding != SEQ_CODING_RAW) && (options -> seq_coding != SEQ_CODING_HUFFMAN) && (options -> seq_coding != SEQ_CODING_PACKED)) {
+    raiseError ("Sequence coding (-c) not valid.\n");
+  }
+  if (options -> apply_heuristics > (R_UINT) HEUR_NORECUR) {
+    raiseError ("Pairing heuristic (-e) not valid.\n");
+  }
+  if ((options -> apply_heuristics == (R_UINT) HEUR_WA) && (options -> base_datatype != (R_UINT) sizeof (R_UCHAR))) {
+    raiseError ("Word-aligned parsing with the specified data type is not possible.");
+  }
+  if (options -> max_keep_count < MIN_KEEP_COUNT) {
+    raiseError ("The value for -x can not be less than MIN_KEEP_COUNT.\n");
+  }
+  /*  As with a file, empty input is an error  */
+  if (in_length == 0) {
+    raiseError ("Empty input file.");
+  }
+
+  prog_struct = wmalloc (sizeof (PROG_INFO));
+  block_struct = wmalloc (sizeof (BLOCK_INFO));
+  prog_struct -> args_struct = NULL;
+  initRepair (prog_struct, block_struct);
+
+  prog_struct -> base_datatype = options -> base_datatype;
+  prog_struct -> max_buffer_size = options -> max_buffer_size;
+  prog_struct -> max_length = options -> max_length;
+  prog_struct -> max_phrases = options -> max_phrases;
+  prog_struct -> max_keep_count = options -> max_keep_count;
+  prog_struct -> apply_heuristics = (enum R_HEURISTICS) options -> apply_heuristics;
+  prog_struct -> seq_coding = options -> seq_coding;
+  prog_struct -> add_prims = (options -> add_prims != 0) ? R_TRUE : R_FALSE;
+
+  /*  The input is read in place, as if it were a mapped file  */
+  prog_struct -> in_map = in;
+  prog_struct -> in_map_size = in_length;
+  prog_struct -> in_map_pos = 0;
+  prog_struct -> in_file_size = (R_ULL_INT) in_length;
+  if ((R_ULL_INT) in_length < (R_ULL_INT) prog_struct -> max_buffer_size) {
+    prog_struct -> max_buffer_size = (R_UINT) in_length;
+  }
+
+  /*  Determine the largest symbol  */
+  if (prog_struct -> base_datatype == (R_UINT) sizeof (R_UINT)) {
+    in_i = (const R_UINT*) in;
+    for (i = 0; i < in_length / sizeof (R_UINT); i++) {
+      if ((in_i[i] & NO_FLAGS) > maxsym) {
+        maxsym = in_i[i] & NO_FLAGS;
+      }
+    }
+    prog_struct -> max_prims = maxsym + 1;
+  }
+
+  /*  The prelude is kept in memory and sent out after each block  */
+  prog_struct -> stream_out = newStreamOut (NULL, sink, sink_arg);
+  prog_struct -> prel_rec = newBitout (NULL);
+  if (options -> container != 0) {
+    prog_struct -> container_out = newContainerOut (prog_struct -> stream_out, prog_struct -> base_datatype, prog_struct -> sample_rate);
+  }
+  else {
+    writeStreamHeader (prog_struct -> stream_out);
+  }
+
+  executeRepair_File (prog_struct, block_struct);
+
+  uninitRepair (prog_struct, block_struct);
+  wfree (prog_struct);
+  wfree (block_struct);
+
+  return;
+}
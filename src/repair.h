@@ -35,17 +35,55 @@ Definitions
 #define MAX_PRIMS_ARRAY UINT_MAX        
              /*  Maximum size of primitives array; matches the datatype  */
                                          /*  of the array of primitives  */
+#ifdef COMPACT_SEQ_NODE
+#define MAX_BUFFER_SIZE 0x7FFFFFFFu
+                /*  Maximum length of sequence buffer; limited by the  */
+           /*  31-bit links of compact seq_nodes (SEQ_INDEX_NULL, seq.h)  */
+#else
 #define MAX_BUFFER_SIZE UINT_MAX
                                   /*  Maximum length of sequence buffer  */
+#endif
+#define INIT_STREAM_BUFFER_SIZE 1048576u
+               /*  Initial length of the sequence buffer for a stream;  */
+                  /*  doubled as symbols arrive, up to max_buffer_size  */
+#define STDIO_FILENAME "-"     /*  Filename for stdin (-i) or stdout (-o)  */
 #define MIN_KEEP_COUNT 2u
                                /*  Minimum occurrences required to pair  */
 
 #define INIT_NODELIST_SIZE 65536u                           /* (1 << 16) */
 
+#define MAX_NUM_THREADS 256u
+                     /*  Maximum number of blocks compressed at once (-j)  */
+
+/*  State of a block in the pool of blocks being compressed at once  */
+enum R_SLOT_STATE { SLOT_EMPTY = 0, SLOT_FILLED = 1, SLOT_RUNNING = 2, SLOT_DONE = 3 };
+
+/******************************
+Structure definitions
+******************************/
+typedef struct repair_slot {
+  BLOCK_INFO block;
+  enum R_SLOT_STATE state;
+} REPAIR_SLOT;
+
+/*
+**  Blocks are read into the slots in turn by the main thread and
+**  compressed by the worker threads.  Slot (n % num_slots) holds the
+**  n-th block, so the main thread can write them out in order.
+*/
+typedef struct repair_pool {
+  PROG_INFO *prog_struct;
+  REPAIR_SLOT *slots;
+  R_UINT num_slots;
+  R_UINT next_job;          /*  Number of the next block to compress  */
+  R_BOOLEAN finished;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+} REPAIR_POOL;
+
 /******************************
 Function prototypes
 ******************************/
-ARGS_INFO *parseArguments (R_INT argc, R_CHAR *argv[], ARGS_INFO *args_struct);
 void initRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 void uninitRepair (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 void executeRepair_File (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
@@ -29,6 +29,8 @@
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
 #include "repair-defn.h"
 #include "seq.h"
 
@@ -45,17 +47,18 @@ SINGLE_NODE *initSListNode (R_UINT value) {
 void initSeqNode (R_UINT value, SEQ_NODE *newnode) {
   R_UINT flag = 0;
 
-  newnode -> prev_ptr = NULL;
-  newnode -> next_ptr = NULL;
+#ifdef COMPACT_SEQ_NODE
+  newnode -> prev_ptr = 0;                  /*  Start with no punctuation bit  */
+#endif
+  CLEARSEQPTRS (newnode);
 
   flag = value & PUNC_FLAG;
   newnode -> value = value & NO_FLAGS;
-  newnode -> punc_type = WT_NONE;
   if (flag == PUNC_FLAG) {
-    newnode -> punc_type = WT_PUNC;
+    SETSEQPUNC (newnode, WT_PUNC);
   }
   else {
-    newnode -> punc_type = WT_WORD;
+    SETSEQPUNC (newnode, WT_WORD);
   }
 
   return;
@@ -84,8 +87,7 @@ void deleteSeqNode (SEQ_NODE *deletenode, BLOCK_INFO *block_struct) {
 
   /*  Case 5  */
   if (deletenode == begin) {
-    fprintf (stderr, "First node is being deleted.  Not possible!.\n");
-    exit (EXIT_FAILURE);
+    raiseError ("First node is being deleted.  Not possible!.\n");
   }
 
   if (deletenode != begin) {
@@ -98,43 +100,43 @@ void deleteSeqNode (SEQ_NODE *deletenode, BLOCK_INFO *block_struct) {
     }
     if ((next -> value != SEQ_NODE_DELETED) && (previous -> value == SEQ_NODE_DELETED)) {
                                                               /*  Case 3  */
-      deletenode -> prev_ptr = previous -> prev_ptr;
-      ((previous -> prev_ptr) + 1) -> next_ptr = next;
-      deletenode -> next_ptr = NULL;
-      previous -> prev_ptr = NULL;
+      SETSEQPREV (block_struct, deletenode, SEQPREV (block_struct, previous));
+      SETSEQNEXT (block_struct, SEQPREV (block_struct, previous) + 1, next);
+      SETSEQNEXT (block_struct, deletenode, NULL);
+      SETSEQPREV (block_struct, previous, NULL);
     }
     if ((next -> value != SEQ_NODE_DELETED) && (previous-> value != SEQ_NODE_DELETED)) {
                                                               /*  Case 1  */
-      deletenode -> prev_ptr = previous;
-      deletenode -> next_ptr = next;
+      SETSEQPREV (block_struct, deletenode, previous);
+      SETSEQNEXT (block_struct, deletenode, next);
     }
     if ((next -> value == SEQ_NODE_DELETED) && (previous -> value != SEQ_NODE_DELETED)) {
                                                               /*  Case 2  */
-      deletenode -> next_ptr = next -> next_ptr;
-      if (next -> next_ptr == begin) {
+      SETSEQNEXT (block_struct, deletenode, SEQNEXT (block_struct, next));
+      if (SEQNEXT (block_struct, next) == begin) {
   	                                                     /*  Case 2b  */
-        next -> prev_ptr = previous;
+        SETSEQPREV (block_struct, next, previous);
       }
       else {
-        ((next -> next_ptr) - 1) -> prev_ptr = previous;
+        SETSEQPREV (block_struct, SEQNEXT (block_struct, next) - 1, previous);
       }
-      next -> next_ptr = NULL;
-      deletenode -> prev_ptr = NULL;
+      SETSEQNEXT (block_struct, next, NULL);
+      SETSEQPREV (block_struct, deletenode, NULL);
     }
     if ((next -> value == SEQ_NODE_DELETED) && (previous-> value == SEQ_NODE_DELETED)) {
 	                                                     /*  Case 4  */
-      if (next -> next_ptr == begin) {
+      if (SEQNEXT (block_struct, next) == begin) {
   	                                                    /*  Case 4b  */
-        next -> prev_ptr = previous -> prev_ptr;
+        SETSEQPREV (block_struct, next, SEQPREV (block_struct, previous));
       }
       else {
-        ((next -> next_ptr) - 1) -> prev_ptr = previous -> prev_ptr;
+        SETSEQPREV (block_struct, SEQNEXT (block_struct, next) - 1, SEQPREV (block_struct, previous));
       }
-      ((previous -> prev_ptr) + 1) -> next_ptr = next -> next_ptr;
-      previous-> prev_ptr = NULL;
-      next -> next_ptr = NULL;
-      deletenode -> prev_ptr = NULL;
-      deletenode -> next_ptr = NULL;
+      SETSEQNEXT (block_struct, SEQPREV (block_struct, previous) + 1, SEQNEXT (block_struct, next));
+      SETSEQPREV (block_struct, previous, NULL);
+      SETSEQNEXT (block_struct, next, NULL);
+      SETSEQPREV (block_struct, deletenode, NULL);
+      SETSEQNEXT (block_struct, deletenode, NULL);
     }
   }
 
@@ -145,11 +147,11 @@ void deleteSeqNode (SEQ_NODE *deletenode, BLOCK_INFO *block_struct) {
 
 
 /*  Insert a seq_node into a doubly linked list between two nodes  */
-void insertSeqPtr (SEQ_NODE *newnode, SEQ_NODE *prevnode, SEQ_NODE *nextnode) {
-  newnode -> prev_ptr = prevnode;
-  newnode -> next_ptr = nextnode;
-  prevnode -> next_ptr = newnode;
-  nextnode -> prev_ptr = newnode;
+void insertSeqPtr (SEQ_NODE *newnode, SEQ_NODE *prevnode, SEQ_NODE *nextnode, BLOCK_INFO *block_struct) {
+  SETSEQPREV (block_struct, newnode, prevnode);
+  SETSEQNEXT (block_struct, newnode, nextnode);
+  SETSEQNEXT (block_struct, prevnode, newnode);
+  SETSEQPREV (block_struct, nextnode, newnode);
   return;
 }
 
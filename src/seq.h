@@ -38,6 +38,33 @@ typedef struct single_node {
     struct single_node *next;
 } SINGLE_NODE;
 
+#ifdef COMPACT_SEQ_NODE
+/*
+**  Compact layout (12 bytes):  prev_ptr and next_ptr are indices into
+**  block_struct -> seq_buf and the top bit of prev_ptr holds the
+**  punctuation type, which is only ever WT_WORD or WT_PUNC.
+*/
+typedef struct seq_node {
+  R_UINT prev_ptr;
+  R_UINT next_ptr;
+  R_UINT value;
+} SEQ_NODE;
+
+#define SEQ_INDEX_NULL 0x7FFFFFFFu             /*  Index for a NULL link  */
+#define SEQ_INDEX_MASK 0x7FFFFFFFu
+#define SEQ_PUNC_BIT 0x80000000u
+
+#define SEQINDEX(B,P) ((P) == NULL ? SEQ_INDEX_NULL : (R_UINT) ((SEQ_NODE *) (P) - (B) -> seq_buf))
+#define SEQNODE(B,I) ((I) == SEQ_INDEX_NULL ? NULL : (B) -> seq_buf + (I))
+
+#define SEQPREV(B,N) SEQNODE (B, (N) -> prev_ptr & SEQ_INDEX_MASK)
+#define SEQNEXT(B,N) SEQNODE (B, (N) -> next_ptr)
+#define SETSEQPREV(B,N,P) ((N) -> prev_ptr = ((N) -> prev_ptr & SEQ_PUNC_BIT) | SEQINDEX (B, P))
+#define SETSEQNEXT(B,N,P) ((N) -> next_ptr = SEQINDEX (B, P))
+#define CLEARSEQPTRS(N) ((N) -> prev_ptr = ((N) -> prev_ptr & SEQ_PUNC_BIT) | SEQ_INDEX_NULL, (N) -> next_ptr = SEQ_INDEX_NULL)
+#define SEQPUNC(N) (((N) -> prev_ptr & SEQ_PUNC_BIT) != 0 ? WT_PUNC : WT_WORD)
+#define SETSEQPUNC(N,T) ((N) -> prev_ptr = ((T) == WT_PUNC ? ((N) -> prev_ptr | SEQ_PUNC_BIT) : ((N) -> prev_ptr & SEQ_INDEX_MASK)))
+#else
 typedef struct seq_node {
   struct seq_node *prev_ptr;
   struct seq_node *next_ptr;
@@ -45,15 +72,26 @@ typedef struct seq_node {
   enum R_WORDPOS_TYPE punc_type;
 } SEQ_NODE;
 
+#define SEQPREV(B,N) ((N) -> prev_ptr)
+#define SEQNEXT(B,N) ((N) -> next_ptr)
+#define SETSEQPREV(B,N,P) ((N) -> prev_ptr = (P))
+#define SETSEQNEXT(B,N,P) ((N) -> next_ptr = (P))
+#define CLEARSEQPTRS(N) ((N) -> prev_ptr = NULL, (N) -> next_ptr = NULL)
+#define SEQPUNC(N) ((N) -> punc_type)
+#define SETSEQPUNC(N,T) ((N) -> punc_type = (T))
+#endif
 
- /*  Define functions used to get the previous and next sequence values  */
-#define NEXTSEQVALUE ((seqentry + 1) -> value == UINT_MAX ? ((seqentry + 1) -> next_ptr) -> value : (seqentry + 1) -> value)
-#define PREVSEQVALUE ((seqentry - 1) -> value == UINT_MAX ? ((seqentry - 1) -> prev_ptr) -> value : (seqentry - 1) -> value)
+/*
+**  Define functions used to get the previous and next sequence values.
+**  These need block_struct in scope since links may be indices.
+*/
+#define NEXTSEQVALUE ((seqentry + 1) -> value == UINT_MAX ? SEQNEXT (block_struct, seqentry + 1) -> value : (seqentry + 1) -> value)
+#define PREVSEQVALUE ((seqentry - 1) -> value == UINT_MAX ? SEQPREV (block_struct, seqentry - 1) -> value : (seqentry - 1) -> value)
 
        /*  Define functions used to get the previous and next seq_nodes  */
-#define NEXTSEQ ((seqentry + 1) -> value == UINT_MAX ? (seqentry + 1) -> next_ptr : (seqentry + 1))
-#define PREVSEQ ((seqentry - 1) -> value == UINT_MAX ? (seqentry - 1) -> prev_ptr : (seqentry - 1))
-#define CURRENTPOSNEXTSEQ (((current -> position) + 1) -> value == UINT_MAX ? ((current -> position) + 1) -> next_ptr : ((current -> position) + 1))
+#define NEXTSEQ ((seqentry + 1) -> value == UINT_MAX ? SEQNEXT (block_struct, seqentry + 1) : (seqentry + 1))
+#define PREVSEQ ((seqentry - 1) -> value == UINT_MAX ? SEQPREV (block_struct, seqentry - 1) : (seqentry - 1))
+#define CURRENTPOSNEXTSEQ (((current -> position) + 1) -> value == UINT_MAX ? SEQNEXT (block_struct, (current -> position) + 1) : ((current -> position) + 1))
 
 /*  Function for initializing a singly linked list node  */
 SINGLE_NODE *initSListNode (R_UINT value);
@@ -63,7 +101,7 @@ void initSeqNode (R_UINT value, SEQ_NODE* newnode);
 void deleteSeqNode (SEQ_NODE *deletenode, BLOCK_INFO *block_struct);
 
 /*  Functions for manipulating the pointers of sequence nodes  */
-void insertSeqPtr (SEQ_NODE *newnode, SEQ_NODE *prevnode, SEQ_NODE *nextnode);
+void insertSeqPtr (SEQ_NODE *newnode, SEQ_NODE *prevnode, SEQ_NODE *nextnode, BLOCK_INFO *block_struct);
 
 #endif
 
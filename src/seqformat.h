@@ -0,0 +1,78 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef SEQFORMAT_H
+#define SEQFORMAT_H
+
+/******************************
+Definitions
+******************************/
+/*
+**  Layout of one block in the .seq file.
+**
+**  By default, a block is a list of 4-byte integers, each a symbol
+**  plus 1, ended by a 0.  A block can instead be coded; it then
+**  starts with four 4-byte integers:  SEQ_CODED_MARKER, the coding
+**  used, the number of symbols in the block and the length of the
+**  coded data in 4-byte words.  The coded data follows, padded with
+**  0's to a whole word, without an end of block marker.  As for the
+**  rest of the .seq file, all integers are stored in little-endian
+**  order.
+**
+**  SEQ_CODED_MARKER can not be a symbol plus 1, since a block never
+**  has that many symbols.
+*/
+#define SEQ_CODED_MARKER (0xFFFFFFFFu)
+#define SEQ_CODED_HEADER_WORDS (4u)
+
+enum R_SEQ_CODING { SEQ_CODING_RAW = 0, SEQ_CODING_HUFFMAN = 1, SEQ_CODING_PACKED = 2 };
+
+/*
+**  Huffman coded blocks (SEQ_CODING_HUFFMAN) use a canonical code
+**  over the block's primitives and phrases.  Codes are limited to
+**  HUFFMAN_MAX_CODE_LEN bits, unless the block uses more symbols than
+**  that allows; they are never longer than HUFFMAN_LONGEST_CODE bits.
+**  The coded data starts with the length of the code of each symbol,
+**  in HUFFMAN_LEN_BITS bits; after a length of 0, the number of
+**  symbols in the run of 0 lengths that it starts is gamma coded.
+**  The codes of the symbols follow.  Bits are written from the most
+**  significant bit of each byte.
+*/
+#define HUFFMAN_MAX_CODE_LEN 24
+#define HUFFMAN_LONGEST_CODE 31
+#define HUFFMAN_LEN_BITS 5
+
+/*
+**  Bit-packed blocks (SEQ_CODING_PACKED) store every symbol in the
+**  same number of bits, ceilLog (num_prims + num_phrases) (at least
+**  1), so that any symbol of the block fits.  The symbols are packed
+**  in frames of PACKED_FRAME_SYMBOLS symbols; a frame of w-bit symbols
+**  takes exactly w 4-byte words.  Within a frame, symbol i is in bits
+**  i * w to (i + 1) * w - 1, counting from the least significant bit
+**  of the first byte.  The last frame is padded with 0's.
+*/
+#define PACKED_FRAME_SYMBOLS 32
+
+#endif
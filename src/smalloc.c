@@ -0,0 +1,165 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "stats.h"
+#include "smalloc.h"
+
+/*
+**  Allocator for the many small, fixed-sized records that Re-Pair
+**  creates and destroys during pairing (tentative phrases).  Building
+**  with -DNO_SMALLOC sends every request to wmalloc/wfree instead so
+**  that the two can be compared.  Either way, the items still in use
+**  are freed by uninitMemRoot.
+*/
+
+/*
+**  Create a pool for items of item_size bytes.  The memory it takes
+**  is counted in mem[mem_which].
+*/
+MEMROOT *initMemRoot (size_t item_size, R_UINT slab_items, MEM_STATS *mem, R_UINT mem_which) {
+  MEMROOT *root = wmalloc (sizeof (MEMROOT));
+
+  if (item_size < sizeof (void*)) {
+    item_size = sizeof (void*);
+  }
+  root -> item_size = (item_size + SMALLOC_ALIGN - 1) & ~((size_t) SMALLOC_ALIGN - 1);
+  root -> slab_items = slab_items;
+  root -> slabs = NULL;
+  root -> items = NULL;
+  root -> free_list = NULL;
+  root -> next_item = NULL;
+  root -> slab_end = NULL;
+  root -> in_use = 0;
+  root -> mem = mem;
+  root -> mem_which = mem_which;
+
+  return (root);
+}
+
+
+/*  Release the pool, including any items still in use  */
+void uninitMemRoot (MEMROOT *root) {
+  MEMINDEX *slab;
+  MEMITEM *header;
+
+  if (root == NULL) {
+    return;
+  }
+
+  while (root -> items != NULL) {
+    header = root -> items;
+    root -> items = header -> next;
+    wfree (header);
+    changeMemory (root -> mem, root -> mem_which, sizeof (MEMITEM) + root -> item_size, 0);
+    root -> in_use--;
+  }
+  while (root -> slabs != NULL) {
+    slab = root -> slabs;
+    root -> slabs = slab -> next;
+    wfree (slab);
+    changeMemory (root -> mem, root -> mem_which, sizeof (MEMINDEX) + (root -> item_size * root -> slab_items), 0);
+  }
+  wfree (root);
+
+  return;
+}
+
+
+/*  Return an item from the pool  */
+void *smalloc (MEMROOT *root) {
+#ifdef NO_SMALLOC
+  MEMITEM *header = wmalloc (sizeof (MEMITEM) + root -> item_size);
+
+  root -> in_use++;
+  changeMemory (root -> mem, root -> mem_which, 0, sizeof (MEMITEM) + root -> item_size);
+  header -> prev = NULL;
+  header -> next = root -> items;
+  if (root -> items != NULL) {
+    (root -> items) -> prev = header;
+  }
+  root -> items = header;
+
+  return (header + 1);
+#else
+  void *item;
+  MEMINDEX *slab;
+
+  root -> in_use++;
+
+  /*  Reuse a freed item first  */
+  if (root -> free_list != NULL) {
+    item = root -> free_list;
+    root -> free_list = *((void **) item);
+    return (item);
+  }
+
+  /*  Start a new slab when the current one is used up  */
+  if (root -> next_item == root -> slab_end) {
+    slab = wmalloc (sizeof (MEMINDEX) + (root -> item_size * root -> slab_items));
+    changeMemory (root -> mem, root -> mem_which, 0, sizeof (MEMINDEX) + (root -> item_size * root -> slab_items));
+    slab -> next = root -> slabs;
+    root -> slabs = slab;
+    root -> next_item = (R_CHAR*) (slab + 1);
+    root -> slab_end = root -> next_item + (root -> item_size * root -> slab_items);
+  }
+
+  item = root -> next_item;
+  root -> next_item += root -> item_size;
+
+  return (item);
+#endif
+}
+
+
+/*  Return an item to the pool's free list  */
+void sfree (MEMROOT *root, void *item) {
+  root -> in_use--;
+#ifdef NO_SMALLOC
+  MEMITEM *header = (MEMITEM*) item - 1;
+
+  if (header -> prev != NULL) {
+    (header -> prev) -> next = header -> next;
+  }
+  else {
+    root -> items = header -> next;
+  }
+  if (header -> next != NULL) {
+    (header -> next) -> prev = header -> prev;
+  }
+  wfree (header);
+  changeMemory (root -> mem, root -> mem_which, sizeof (MEMITEM) + root -> item_size, 0);
+#else
+  *((void **) item) = root -> free_list;
+  root -> free_list = item;
+#endif
+
+  return;
+}
+
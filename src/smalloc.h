@@ -0,0 +1,72 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef SMALLOC_H
+#define SMALLOC_H
+
+#define SMALLOC_ALIGN 8u          /*  Alignment of items within a slab  */
+#define SMALLOC_SLAB_ITEMS 4096u      /*  Default number of items per slab  */
+
+/*  Header at the start of every slab  */
+typedef struct memindex {
+  struct memindex *next;
+  R_ULL_INT pad;                  /*  Keeps the items SMALLOC_ALIGN-aligned  */
+} MEMINDEX;
+
+/*
+**  Header in front of every item with -DNO_SMALLOC, which keeps the
+**  items in use on a list so that uninitMemRoot can free them
+*/
+typedef struct memitem {
+  struct memitem *prev;
+  struct memitem *next;
+} MEMITEM;
+
+/*
+**  A pool of fixed-sized items.  Items are carved from slabs and
+**  freed items are kept on a free list for reuse.  All slabs are
+**  returned at once by uninitMemRoot.
+*/
+typedef struct memroot {
+  size_t item_size;
+  R_UINT slab_items;                          /*  Number of items per slab  */
+  MEMINDEX *slabs;                                     /*  List of slabs  */
+  MEMITEM *items;                  /*  Items in use, with -DNO_SMALLOC  */
+  void *free_list;             /*  Freed items, linked through their start  */
+  R_CHAR *next_item;                /*  Next unused item in current slab  */
+  R_CHAR *slab_end;
+  R_UINT in_use;                     /*  Number of items currently in use  */
+  struct mem_stats *mem;            /*  Memory counters charged for slabs  */
+  R_UINT mem_which;                               /*  (see stats.h)  */
+} MEMROOT;
+
+MEMROOT *initMemRoot (size_t item_size, R_UINT slab_items, struct mem_stats *mem, R_UINT mem_which);
+void uninitMemRoot (MEMROOT *root);
+void *smalloc (MEMROOT *root);
+void sfree (MEMROOT *root, void *item);
+
+#endif
+
+/*  End of smalloc.h  */
@@ -0,0 +1,580 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>                                      /*  clock_gettime  */
+#include <unistd.h>                                       /*  read, close  */
+#include <pthread.h>                        /*  pthread_key_t, per thread  */
+#ifdef __linux__
+#include <sys/syscall.h>                           /*  SYS_perf_event_open  */
+#include <linux/perf_event.h>
+#define HAVE_PERF_EVENTS
+#endif
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
+
+/*  Names of the counters; see R_PERF_COUNTER  */
+static const R_CHAR *counter_names[NUM_PERF_COUNTERS] = {
+  "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"
+};
+
+#ifdef HAVE_PERF_EVENTS
+/*  Event of each counter  */
+static const R_UINT counter_types[NUM_PERF_COUNTERS] = {
+  PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE
+};
+static const R_ULL_INT counter_configs[NUM_PERF_COUNTERS] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+  PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+#endif
+
+/*
+**  Counters which could be opened by the main thread; 0 if they are
+**  not used.  Every thread opens its own group of them when it first
+**  times a phase, which is kept under counter_key.
+*/
+static R_UINT counter_mask = 0;
+static pthread_key_t counter_key;
+static pthread_once_t multiplexed_once = PTHREAD_ONCE_INIT;
+
+static R_DOUBLE readClock (clockid_t clock);
+static void readClocks (PHASE_STATS *now, clockid_t cpu_clock);
+static PERF_GROUP *openPerfGroup (R_UINT mask);
+static void closePerfGroup (void *arg);
+static void warnMultiplexed (void);
+static void readCounters (R_ULL_INT *values);
+
+
+static R_DOUBLE readClock (clockid_t clock) {
+  struct timespec now;
+
+  if (clock_gettime (clock, &now) != 0) {
+    return (0.0);
+  }
+
+  return ((R_DOUBLE) now.tv_sec + (R_DOUBLE) now.tv_nsec / 1e9);
+}
+
+
+static void readClocks (PHASE_STATS *now, clockid_t cpu_clock) {
+  now -> wall = readClock (CLOCK_MONOTONIC);
+  now -> cpu = readClock (cpu_clock);
+
+  return;
+}
+
+
+void clearPhases (PHASE_STATS *phases, R_UINT num) {
+  R_UINT i = 0;
+  R_UINT j = 0;
+
+  for (i = 0; i < num; i++) {
+    phases[i].wall = 0.0;
+    phases[i].cpu = 0.0;
+    for (j = 0; j < NUM_PERF_COUNTERS; j++) {
+      phases[i].counters[j] = 0;
+    }
+  }
+
+  return;
+}
+
+
+/*
+**  Add the num phases to the totals
+*/
+void addPhases (PHASE_STATS *total, PHASE_STATS *phases, R_UINT num) {
+  R_UINT i = 0;
+  R_UINT j = 0;
+
+  for (i = 0; i < num; i++) {
+    total[i].wall += phases[i].wall;
+    total[i].cpu += phases[i].cpu;
+    for (j = 0; j < NUM_PERF_COUNTERS; j++) {
+      total[i].counters[j] += phases[i].counters[j];
+    }
+  }
+
+  return;
+}
+
+
+/*
+**  Time a phase run by the calling thread:  startPhase records when
+**  it starts in start; endPhase adds the time since then to phase.
+**  A phase can be timed in several pieces.
+*/
+void startPhase (PHASE_STATS *start) {
+  if (counter_mask != 0) {
+    readCounters (start -> counters);
+  }
+  readClocks (start, CLOCK_THREAD_CPUTIME_ID);
+
+  return;
+}
+
+
+void endPhase (PHASE_STATS *start, PHASE_STATS *phase) {
+  PHASE_STATS now;
+  R_UINT i = 0;
+
+  readClocks (&now, CLOCK_THREAD_CPUTIME_ID);
+  phase -> wall += now.wall - start -> wall;
+  phase -> cpu += now.cpu - start -> cpu;
+  if (counter_mask != 0) {
+    readCounters (now.counters);
+    for (i = 0; i < NUM_PERF_COUNTERS; i++) {
+      phase -> counters[i] += now.counters[i] - start -> counters[i];
+    }
+  }
+
+  return;
+}
+
+
+/*
+**  Take out of phase the time spent in another phase nested in it;
+**  before is a copy of nested, taken when phase started
+*/
+void excludePhase (PHASE_STATS *phase, PHASE_STATS *before, PHASE_STATS *nested) {
+  R_UINT i = 0;
+
+  phase -> wall -= nested -> wall - before -> wall;
+  phase -> cpu -= nested -> cpu - before -> cpu;
+  for (i = 0; i < NUM_PERF_COUNTERS; i++) {
+    phase -> counters[i] -= nested -> counters[i] - before -> counters[i];
+  }
+
+  return;
+}
+
+
+/*
+**  As startPhase and endPhase, but with the CPU time of all threads,
+**  for the whole run of a program
+*/
+void startRun (PHASE_STATS *start) {
+  readClocks (start, CLOCK_PROCESS_CPUTIME_ID);
+
+  return;
+}
+
+
+void endRun (PHASE_STATS *start, PHASE_STATS *run) {
+  PHASE_STATS now;
+
+  readClocks (&now, CLOCK_PROCESS_CPUTIME_ID);
+  run -> wall += now.wall - start -> wall;
+  run -> cpu += now.cpu - start -> cpu;
+
+  return;
+}
+
+
+/*
+**  Create the statistics file (--stats-json) and start its object.
+**  The program writes its own members, then closes it with
+**  closeStatsJSON.
+*/
+FILE *openStatsJSON (const R_CHAR *filename, const R_CHAR *program) {
+  FILE *fp = NULL;
+
+  FOPEN (filename, fp, "w");
+  fprintf (fp, "{\n  \"program\": ");
+  writeStringJSON (fp, program);
+  fprintf (fp, ",\n");
+
+  return (fp);
+}
+
+
+void closeStatsJSON (FILE *fp) {
+  fprintf (fp, "}\n");
+  if (ferror (fp) != R_FALSE) {
+    raiseError ("Error writing the statistics file.\n");
+  }
+  FCLOSE (fp);
+
+  return;
+}
+
+
+void writeStringJSON (FILE *fp, const R_CHAR *text) {
+  fputc ('"', fp);
+  for (; *text != '\0'; text++) {
+    if ((*text == '"') || (*text == '\\')) {
+      fputc ('\\', fp);
+      fputc (*text, fp);
+    }
+    else if ((R_UCHAR) *text < 0x20) {
+      fprintf (fp, "\\u%04x", (R_UINT) (R_UCHAR) *text);
+    }
+    else {
+      fputc (*text, fp);
+    }
+  }
+  fputc ('"', fp);
+
+  return;
+}
+
+
+/*
+**  Write the num phases as a JSON object of objects, keyed by the
+**  names of the phases
+*/
+void writePhasesJSON (FILE *fp, const R_CHAR **names, PHASE_STATS *phases, R_UINT num) {
+  R_UINT i = 0;
+  R_UINT j = 0;
+
+  fprintf (fp, "{");
+  for (i = 0; i < num; i++) {
+    fprintf (fp, "%s\"%s\": {\"wall_s\": %.6f, \"cpu_s\": %.6f", (i == 0) ? "" : ", ", names[i], phases[i].wall, phases[i].cpu);
+    for (j = 0; j < NUM_PERF_COUNTERS; j++) {
+      if ((counter_mask & (1u << j)) != 0) {
+        fprintf (fp, ", \"%s\": %llu", counter_names[j], phases[i].counters[j]);
+      }
+    }
+    fprintf (fp, "}");
+  }
+  fprintf (fp, "}");
+
+  return;
+}
+
+
+/*
+**  Open the counters in mask for the calling thread.  Counters which
+**  the system does not have, or does not let us use, are left out.
+*/
+static PERF_GROUP *openPerfGroup (R_UINT mask) {
+  PERF_GROUP *group = wmalloc (sizeof (PERF_GROUP));
+  R_UINT i = 0;
+#ifdef HAVE_PERF_EVENTS
+  struct perf_event_attr attr;
+  R_INT leader = -1;
+#endif
+
+  group -> num_open = 0;
+  for (i = 0; i < NUM_PERF_COUNTERS; i++) {
+    group -> fds[i] = -1;
+#ifdef HAVE_PERF_EVENTS
+    if ((mask & (1u << i)) == 0) {
+      continue;
+    }
+    memset (&attr, 0, sizeof (attr));
+    attr.size = sizeof (attr);
+    attr.type = counter_types[i];
+    attr.config = counter_configs[i];
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    /*  Only our own code, which is allowed by default  */
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    group -> fds[i] = (R_INT) syscall (SYS_perf_event_open, &attr, 0, -1, leader, 0);
+    if (group -> fds[i] >= 0) {
+      if (leader < 0) {
+        leader = group -> fds[i];
+      }
+      group -> num_open++;
+    }
+#endif
+  }
+
+  return (group);
+}
+
+
+static void closePerfGroup (void *arg) {
+  PERF_GROUP *group = (PERF_GROUP*) arg;
+  R_UINT i = 0;
+
+  for (i = 0; i < NUM_PERF_COUNTERS; i++) {
+    if (group -> fds[i] >= 0) {
+      (void) close (group -> fds[i]);
+    }
+  }
+  wfree (group);
+
+  return;
+}
+
+
+static void warnMultiplexed (void) {
+  fprintf (stderr, "Warning:  The performance counters had to share the hardware; their counts are scaled estimates.\n");
+
+  return;
+}
+
+
+/*
+**  Read the counters of the calling thread, opening them if this is
+**  the first time.  Counters which could not be read are 0.  If the
+**  kernel had to multiplex the group, the counts are scaled up to the
+**  whole time it was enabled.
+*/
+static void readCounters (R_ULL_INT *values) {
+  PERF_GROUP *group = (PERF_GROUP*) pthread_getspecific (counter_key);
+  R_ULL_INT buffer[NUM_PERF_COUNTERS + 3];
+  R_INT leader = -1;
+  R_UINT i = 0;
+  R_UINT k = 1;
+
+  if (group == NULL) {
+    group = openPerfGroup (counter_mask);
+    (void) pthread_setspecific (counter_key, group);
+  }
+
+  for (i = 0; i < NUM_PERF_COUNTERS; i++) {
+    values[i] = 0;
+    if ((leader < 0) && (group -> fds[i] >= 0)) {
+      leader = group -> fds[i];
+    }
+  }
+  if (leader < 0) {
+    return;
+  }
+
+  /*  The number of counters, the time the group was enabled and the
+  **  time it was running, then the values in the order that the
+  **  counters were opened  */
+  if (read (leader, buffer, sizeof (buffer)) < (ssize_t) ((group -> num_open + 3) * sizeof (R_ULL_INT))) {
+    return;
+  }
+  if (buffer[2] == 0) {
+    return;
+  }
+  if (buffer[2] < buffer[1]) {
+    (void) pthread_once (&multiplexed_once, warnMultiplexed);
+  }
+  for (i = 0; i < NUM_PERF_COUNTERS; i++) {
+    if (group -> fds[i] >= 0) {
+      values[i] = buffer[k + 2];
+      if (buffer[2] < buffer[1]) {
+        values[i] = (R_ULL_INT) ((R_DOUBLE) values[i] * ((R_DOUBLE) buffer[1] / (R_DOUBLE) buffer[2]));
+      }
+      k++;
+    }
+  }
+
+  return;
+}
+
+
+/*
+**  Turn on the counters (--perf-counters).  Returns R_FALSE, with a
+**  warning, if none of them can be used; the program then carries on
+**  without them.
+*/
+R_BOOLEAN enablePerfCounters (void) {
+  PERF_GROUP *group = NULL;
+  R_UINT i = 0;
+
+  errno = 0;
+  group = openPerfGroup ((1u << NUM_PERF_COUNTERS) - 1);
+  if (group -> num_open == 0) {
+#ifdef HAVE_PERF_EVENTS
+    fprintf (stderr, "Warning:  Hardware performance counters are not available (%s); continuing without them.\n", strerror (errno));
+#else
+    fprintf (stderr, "Warning:  Hardware performance counters are not supported on this system; continuing without them.\n");
+#endif
+    closePerfGroup (group);
+    return (R_FALSE);
+  }
+
+  counter_mask = 0;
+  for (i = 0; i < NUM_PERF_COUNTERS; i++) {
+    if (group -> fds[i] >= 0) {
+      counter_mask |= 1u << i;
+    }
+    else {
+      fprintf (stderr, "Warning:  Performance counter %s is not available.\n", counter_names[i]);
+    }
+  }
+
+  /*  Other threads open their own counters as they need them, and
+  **  close them when they exit  */
+  if (pthread_key_create (&counter_key, closePerfGroup) != 0) {
+    raiseError ("Error creating the key of the performance counters.\n");
+  }
+  (void) pthread_setspecific (counter_key, group);
+
+  return (R_TRUE);
+}
+
+
+/*
+**  Close the counters of the calling thread, which should be the
+**  last one running
+*/
+void disablePerfCounters (void) {
+  PERF_GROUP *group = NULL;
+
+  if (counter_mask == 0) {
+    return;
+  }
+  group = (PERF_GROUP*) pthread_getspecific (counter_key);
+  if (group != NULL) {
+    closePerfGroup (group);
+    (void) pthread_setspecific (counter_key, NULL);
+  }
+  (void) pthread_key_delete (counter_key);
+  counter_mask = 0;
+
+  return;
+}
+
+
+/*
+**  Print the names of the counters, as the header of the lines
+**  printed by printPhasesCounters
+*/
+void printCountersHeader (FILE *fp) {
+  if (counter_mask == 0) {
+    return;
+  }
+  fprintf (fp, "\t%-18s%16s%16s%14s%14s%14s\n", "Phase", "Cycles", "Instructions", "LLC misses", "dTLB misses", "Branch misses");
+
+  return;
+}
+
+
+/*
+**  Print the counters of each phase, one line per phase; counters
+**  which are not available are shown as "-"
+*/
+void printPhasesCounters (FILE *fp, const R_CHAR **names, PHASE_STATS *phases, R_UINT num) {
+  static const R_UINT widths[NUM_PERF_COUNTERS] = { 16, 16, 14, 14, 14 };
+  R_UINT i = 0;
+  R_UINT j = 0;
+
+  if (counter_mask == 0) {
+    return;
+  }
+  for (i = 0; i < num; i++) {
+    fprintf (fp, "\t%-18s", names[i]);
+    for (j = 0; j < NUM_PERF_COUNTERS; j++) {
+      if ((counter_mask & (1u << j)) != 0) {
+        fprintf (fp, "%*llu", (R_INT) widths[j], phases[i].counters[j]);
+      }
+      else {
+        fprintf (fp, "%*s", (R_INT) widths[j], "-");
+      }
+    }
+    fprintf (fp, "\n");
+  }
+
+  return;
+}
+
+
+void clearMemory (MEM_STATS *mem, R_UINT num) {
+  R_UINT i = 0;
+
+  for (i = 0; i < num; i++) {
+    mem[i].current = 0;
+    mem[i].peak = 0;
+  }
+
+  return;
+}
+
+
+/*
+**  Record that a structure has gone from old_size to new_size bytes;
+**  old_size is 0 for an allocation and new_size is 0 for a free
+*/
+void changeMemory (MEM_STATS *mem, R_UINT which, size_t old_size, size_t new_size) {
+  mem[which].current = mem[which].current - old_size + new_size;
+  if (mem[which].current > mem[which].peak) {
+    mem[which].peak = mem[which].current;
+  }
+
+  mem[MEM_TOTAL].current = mem[MEM_TOTAL].current - old_size + new_size;
+  if (mem[MEM_TOTAL].current > mem[MEM_TOTAL].peak) {
+    mem[MEM_TOTAL].peak = mem[MEM_TOTAL].current;
+  }
+
+  return;
+}
+
+
+/*
+**  Raise the peaks of total, which counts the memory kept across all
+**  blocks, to what they were while the block with counters mem was
+**  being worked on
+*/
+void mergeMemory (MEM_STATS *total, MEM_STATS *mem, R_UINT num) {
+  R_UINT i = 0;
+
+  for (i = 0; i < num; i++) {
+    if (total[i].current + mem[i].peak > total[i].peak) {
+      total[i].peak = total[i].current + mem[i].peak;
+    }
+  }
+
+  return;
+}
+
+
+/*
+**  Write the memory counters as a JSON object, with one member for
+**  each structure
+*/
+void writeMemoryJSON (FILE *fp, const R_CHAR **names, MEM_STATS *mem, R_UINT num) {
+  R_UINT i = 0;
+
+  fprintf (fp, "{");
+  for (i = 0; i < num; i++) {
+    fprintf (fp, "%s\"%s\": {\"current_bytes\": %llu, \"peak_bytes\": %llu}", (i == 0) ? "" : ", ", names[i], mem[i].current, mem[i].peak);
+  }
+  fprintf (fp, "}");
+
+  return;
+}
+
+
+/*
+**  Print the memory counters on one line, in KiB
+*/
+void printMemory (FILE *fp, const R_CHAR **names, MEM_STATS *mem, R_UINT num) {
+  R_UINT i = 0;
+
+  fprintf (fp, "\tMemory in KiB (current / peak):");
+  for (i = 0; i < num; i++) {
+    fprintf (fp, "%s %s %llu / %llu", (i == 0) ? "" : ";", names[i], (mem[i].current + 1023) >> 10, (mem[i].peak + 1023) >> 10);
+  }
+  fprintf (fp, "\n");
+
+  return;
+}
@@ -0,0 +1,103 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+/******************************
+Definitions
+******************************/
+/*
+**  Hardware performance counters kept for each phase, if they are
+**  turned on (--perf-counters) and the system has them
+*/
+enum R_PERF_COUNTER { COUNTER_CYCLES = 0, COUNTER_INSTRUCTIONS = 1, COUNTER_LLC_MISSES = 2, COUNTER_DTLB_MISSES = 3, COUNTER_BRANCH_MISSES = 4, NUM_PERF_COUNTERS = 5 };
+
+/*
+**  Memory is counted for each structure of a program (see
+**  R_REPAIR_MEMORY and R_DESPAIR_MEMORY); the first counter is the
+**  total of the others
+*/
+#define MEM_TOTAL 0
+
+/******************************
+Structure definitions
+******************************/
+/*
+**  Time spent in one phase of Re-Pair or Des-Pair.  The CPU time and
+**  the counters are those of the thread which ran the phase, so that
+**  phases of blocks compressed or decoded at once (-j) are not
+**  counted twice.
+*/
+typedef struct phase_stats {
+  R_DOUBLE wall;                            /*  Elapsed time, in seconds  */
+  R_DOUBLE cpu;                                 /*  CPU time, in seconds  */
+  R_ULL_INT counters[NUM_PERF_COUNTERS];
+                        /*  Events counted; 0 if the counter is not used  */
+} PHASE_STATS;
+
+/*
+**  The counters of one thread, opened as one group so that they are
+**  read together
+*/
+typedef struct perf_group {
+  R_INT fds[NUM_PERF_COUNTERS];  /*  -1 if the counter could not be opened  */
+  R_UINT num_open;
+} PERF_GROUP;
+
+/*
+**  Bytes allocated for one structure.  Each block has its own
+**  counters, which are only changed by the thread working on the
+**  block, so they need no locks.
+*/
+typedef struct mem_stats {
+  R_ULL_INT current;                           /*  Bytes allocated now  */
+  R_ULL_INT peak;                      /*  Most bytes allocated at once  */
+} MEM_STATS;
+
+/******************************
+Function prototypes
+******************************/
+void clearPhases (PHASE_STATS *phases, R_UINT num);
+void addPhases (PHASE_STATS *total, PHASE_STATS *phases, R_UINT num);
+void startPhase (PHASE_STATS *start);
+void endPhase (PHASE_STATS *start, PHASE_STATS *phase);
+void excludePhase (PHASE_STATS *phase, PHASE_STATS *before, PHASE_STATS *nested);
+void startRun (PHASE_STATS *start);
+void endRun (PHASE_STATS *start, PHASE_STATS *run);
+FILE *openStatsJSON (const R_CHAR *filename, const R_CHAR *program);
+void closeStatsJSON (FILE *fp);
+void writeStringJSON (FILE *fp, const R_CHAR *text);
+void writePhasesJSON (FILE *fp, const R_CHAR **names, PHASE_STATS *phases, R_UINT num);
+R_BOOLEAN enablePerfCounters (void);
+void disablePerfCounters (void);
+void printCountersHeader (FILE *fp);
+void printPhasesCounters (FILE *fp, const R_CHAR **names, PHASE_STATS *phases, R_UINT num);
+void clearMemory (MEM_STATS *mem, R_UINT num);
+void changeMemory (MEM_STATS *mem, R_UINT which, size_t old_size, size_t new_size);
+void mergeMemory (MEM_STATS *total, MEM_STATS *mem, R_UINT num);
+void writeMemoryJSON (FILE *fp, const R_CHAR **names, MEM_STATS *mem, R_UINT num);
+void printMemory (FILE *fp, const R_CHAR **names, MEM_STATS *mem, R_UINT num);
+
+#endif
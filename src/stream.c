@@ -0,0 +1,287 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common-def.h"
+#include "wmalloc.h"
+#include "error.h"
+#include "stream.h"
+
+#define STREAM_COPY_SIZE 65536
+#define STREAM_FRAME_HEADER_SIZE 5
+
+static void packStreamLE (R_UCHAR *buffer, R_UINT x, R_UINT bytes);
+static R_UINT unpackStreamLE (const R_UCHAR *buffer, R_UINT bytes);
+static R_UINT readStreamLE (FILE *fp, R_UINT bytes);
+static size_t nextStreamFrame (const R_UCHAR *in, size_t in_length, size_t pos, R_UINT *type, R_UINT *length);
+
+
+/*
+**  Store x in buffer as an integer of the given number of bytes,
+**  least significant byte first.
+*/
+static void packStreamLE (R_UCHAR *buffer, R_UINT x, R_UINT bytes) {
+  R_UINT i;
+
+  for (i = 0; i < bytes; i++) {
+    buffer[i] = (R_UCHAR) (x & MASK_EIGHT);
+    x >>= 8;
+  }
+
+  return;
+}
+
+
+static R_UINT unpackStreamLE (const R_UCHAR *buffer, R_UINT bytes) {
+  R_UINT x = 0;
+
+  while (bytes > 0) {
+    bytes--;
+    x = (x << 8) | (R_UINT) buffer[bytes];
+  }
+
+  return (x);
+}
+
+
+/*
+**  Read an integer of the given number of bytes; an error is raised if
+**  the stream ends first
+*/
+static R_UINT readStreamLE (FILE *fp, R_UINT bytes) {
+  R_UCHAR buffer[4];
+
+  if (fread (buffer, sizeof (R_UCHAR), (size_t) bytes, fp) != (size_t) bytes) {
+    raiseError ("Error:  Input stream is truncated.\n");
+  }
+
+  return (unpackStreamLE (buffer, bytes));
+}
+
+
+/*
+**  Read the header of the frame at position pos of a stream in memory.
+**  Returns the position of its data, which is checked to be all there.
+*/
+static size_t nextStreamFrame (const R_UCHAR *in, size_t in_length, size_t pos, R_UINT *type, R_UINT *length) {
+  if (in_length - pos < STREAM_FRAME_HEADER_SIZE) {
+    raiseError ("Error:  Input stream is truncated.\n");
+  }
+  *type = unpackStreamLE (in + pos, 1);
+  *length = unpackStreamLE (in + pos + 1, 4);
+  pos += STREAM_FRAME_HEADER_SIZE;
+  if (in_length - pos < (size_t) *length) {
+    raiseError ("Error:  Input stream is truncated.\n");
+  }
+  if ((*type != STREAM_FRAME_END) && (*type != STREAM_FRAME_PREL) && (*type != STREAM_FRAME_SEQ)) {
+    raiseError ("Error:  Unknown frame type %u in input stream.\n", *type);
+  }
+
+  return (pos);
+}
+
+
+STREAM_OUT *newStreamOut (FILE *fp, STREAM_SINK sink, void *sink_arg) {
+  STREAM_OUT *out = wmalloc (sizeof (STREAM_OUT));
+
+  out -> fp = fp;
+  out -> sink = sink;
+  out -> sink_arg = sink_arg;
+
+  return (out);
+}
+
+
+void deleteStreamOut (STREAM_OUT *out) {
+  wfree (out);
+
+  return;
+}
+
+
+void writeStreamBytes (STREAM_OUT *out, const R_UCHAR *data, size_t length) {
+  R_BOOLEAN written = R_FALSE;
+
+  if (out -> sink != NULL) {
+    written = (R_BOOLEAN) (out -> sink (out -> sink_arg, data, length) == 0);
+  }
+  else {
+    written = (R_BOOLEAN) (fwrite (data, sizeof (R_UCHAR), length, out -> fp) == length);
+  }
+  if (written == R_FALSE) {
+    raiseError ("Error writing to the output stream in %s, line %u.\n", __FILE__, __LINE__);
+  }
+
+  return;
+}
+
+
+void writeStreamHeader (STREAM_OUT *out) {
+  R_UCHAR buffer[4];
+
+  packStreamLE (buffer, STREAM_MAGIC, 4);
+  writeStreamBytes (out, buffer, 4);
+
+  return;
+}
+
+
+/*
+**  Write one frame; empty frames, other than the end of the stream,
+**  are not written at all
+*/
+void writeStreamFrame (STREAM_OUT *out, R_UINT type, const R_UCHAR *data, size_t length) {
+  R_UCHAR buffer[STREAM_FRAME_HEADER_SIZE];
+
+  if ((length == 0) && (type != STREAM_FRAME_END)) {
+    return;
+  }
+
+  packStreamLE (buffer, type, 1);
+  packStreamLE (buffer + 1, (R_UINT) length, 4);
+  writeStreamBytes (out, buffer, STREAM_FRAME_HEADER_SIZE);
+  if (length > 0) {
+    writeStreamBytes (out, data, length);
+  }
+  if ((type == STREAM_FRAME_END) && (out -> fp != NULL)) {
+    (void) fflush (out -> fp);
+  }
+
+  return;
+}
+
+
+/*
+**  Read the magic number at the start of a stream, which tells an
+**  interleaved stream (STREAM_MAGIC) from a container (see
+**  container.h)
+*/
+R_UINT readStreamMagic (FILE *fp) {
+  return (readStreamLE (fp, 4));
+}
+
+
+/*
+**  Read an interleaved stream from fp, whose magic number has already
+**  been read, up to its end frame, and copy the data of its frames to
+**  the prel and seq files
+*/
+void splitStream (FILE *fp, FILE *prel_file, FILE *seq_file) {
+  R_UCHAR *buffer = NULL;
+  R_UINT type = 0;
+  R_UINT length = 0;
+  size_t n = 0;
+  FILE *dest = NULL;
+
+  buffer = wmalloc (sizeof (R_UCHAR) * STREAM_COPY_SIZE);
+  while (R_TRUE) {
+    type = readStreamLE (fp, 1);
+    length = readStreamLE (fp, 4);
+    if (type == STREAM_FRAME_END) {
+      break;
+    }
+    else if (type == STREAM_FRAME_PREL) {
+      dest = prel_file;
+    }
+    else if (type == STREAM_FRAME_SEQ) {
+      dest = seq_file;
+    }
+    else {
+      raiseError ("Error:  Unknown frame type %u in input stream.\n", type);
+    }
+
+    while (length > 0) {
+      n = (length < STREAM_COPY_SIZE) ? (size_t) length : (size_t) STREAM_COPY_SIZE;
+      if (fread (buffer, sizeof (R_UCHAR), n, fp) != n) {
+        raiseError ("Error:  Input stream is truncated.\n");
+      }
+      (void) fwrite (buffer, sizeof (R_UCHAR), n, dest);
+      length -= (R_UINT) n;
+    }
+  }
+  wfree (buffer);
+
+  return;
+}
+
+
+/*
+**  Split an interleaved stream in memory, up to its end frame, into
+**  the data of the prel file and the words of the seq file.  Both are
+**  allocated here.
+*/
+void splitStreamBuffer (const R_UCHAR *in, size_t in_length, R_UCHAR **prel, size_t *prel_length, R_UINT **seq, size_t *seq_words) {
+  size_t pos = 0;
+  size_t prel_pos = 0;
+  size_t seq_pos = 0;
+  R_UINT type = 0;
+  R_UINT length = 0;
+
+  if ((in_length < 4) || (unpackStreamLE (in, 4) != STREAM_MAGIC)) {
+    raiseError ("Error:  Input is not a Re-Pair stream.\n");
+  }
+
+  /*  Find the size of both files first  */
+  *prel_length = 0;
+  *seq_words = 0;
+  pos = 4;
+  do {
+    pos = nextStreamFrame (in, in_length, pos, &type, &length);
+    if (type == STREAM_FRAME_PREL) {
+      *prel_length += (size_t) length;
+    }
+    else if (type == STREAM_FRAME_SEQ) {
+      seq_pos += (size_t) length;
+    }
+    pos += (size_t) length;
+  } while (type != STREAM_FRAME_END);
+  if (seq_pos % sizeof (R_UINT) != 0) {
+    raiseError ("Error:  Input stream is truncated.\n");
+  }
+  *seq_words = seq_pos / sizeof (R_UINT);
+
+  /*  Then copy them; neither is empty, so that both can be allocated  */
+  *prel = wmalloc (*prel_length + 1);
+  *seq = wmalloc ((*seq_words + 1) * sizeof (R_UINT));
+  seq_pos = 0;
+  pos = 4;
+  do {
+    pos = nextStreamFrame (in, in_length, pos, &type, &length);
+    if (type == STREAM_FRAME_PREL) {
+      memcpy (*prel + prel_pos, in + pos, (size_t) length);
+      prel_pos += (size_t) length;
+    }
+    else if (type == STREAM_FRAME_SEQ) {
+      memcpy ((R_UCHAR*) *seq + seq_pos, in + pos, (size_t) length);
+      seq_pos += (size_t) length;
+    }
+    pos += (size_t) length;
+  } while (type != STREAM_FRAME_END);
+
+  return;
+}
@@ -0,0 +1,74 @@
+/**************************************************************************
+**  Re-Pair / Des-Pair
+**  Compressor and decompressor based on recursive pairing.
+**
+**  Copyright (C) 2003-2022 by Raymond Wan, All rights reserved.
+**  Contact:  rwan.work@gmail.com
+**
+**  This file is part of Re-Pair / Des-Pair.
+**  
+**  Re-Pair / Des-Pair is free software; you can redistribute it and/or 
+**  modify it under the terms of the GNU General Public License 
+**  as published by the Free Software Foundation; either version 
+**  3 of the License, or (at your option) any later version.
+**  
+**  Re-Pair / Des-Pair is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**  
+**  You should have received a copy of the GNU General Public 
+**  License along with Re-Pair / Des-Pair; if not, see 
+**  <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#ifndef STREAM_H
+#define STREAM_H
+
+/******************************
+Definitions
+******************************/
+#define STREAM_MAGIC (0x54535052u)      /*  "RPST" in little-endian order  */
+#define STREAM_FRAME_END (0u)
+#define STREAM_FRAME_PREL (1u)
+#define STREAM_FRAME_SEQ (2u)
+
+/*
+**  Interleaved output of Re-Pair, for when the .prel and .seq files
+**  can not be written separately (e.g., to standard output).
+**
+**  The stream starts with the 4-byte magic number.  It is followed by
+**  frames, each made of a 1-byte type and a 4-byte length, then
+**  length bytes of data.  The data of the STREAM_FRAME_PREL frames,
+**  in order, is the .prel file; that of the STREAM_FRAME_SEQ frames
+**  is the .seq file.  A STREAM_FRAME_END frame, of length 0, ends the
+**  stream.  All integers are stored in little-endian order.
+*/
+
+/*
+**  A sink takes the bytes written to it, in order, and returns 0 if
+**  they were all taken
+*/
+typedef R_INT (*STREAM_SINK) (void *sink_arg, const R_UCHAR *data, size_t length);
+
+/*
+**  Where a stream (or the output of Des-Pair) is written:  to sink if
+**  it is given, and to fp otherwise
+*/
+typedef struct stream_out {
+  FILE *fp;
+  STREAM_SINK sink;
+  void *sink_arg;
+} STREAM_OUT;
+
+STREAM_OUT *newStreamOut (FILE *fp, STREAM_SINK sink, void *sink_arg);
+void deleteStreamOut (STREAM_OUT *out);
+void writeStreamBytes (STREAM_OUT *out, const R_UCHAR *data, size_t length);
+void writeStreamHeader (STREAM_OUT *out);
+void writeStreamFrame (STREAM_OUT *out, R_UINT type, const R_UCHAR *data, size_t length);
+R_UINT readStreamMagic (FILE *fp);
+void splitStream (FILE *fp, FILE *prel_file, FILE *seq_file);
+void splitStreamBuffer (const R_UCHAR *in, size_t in_length, R_UCHAR **prel, size_t *prel_length, R_UINT **seq, size_t *seq_words);
+
+#endif
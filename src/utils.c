@@ -27,6 +27,7 @@
 #include <stdio.h>
 
 #include "common-def.h"
+#include "error.h"
 #include "utils.h"
 
 /* return the binary log of x, 0 if there's an error */
@@ -39,8 +40,7 @@ R_UINT floorLog (R_UINT x) {
   }
 
   if (y == 0) {
-    fprintf (stderr, "Unexpected error in %s, line %u.\n", __FILE__, __LINE__);
-    exit (EXIT_FAILURE);
+    raiseError ("Unexpected error in %s, line %u.\n", __FILE__, __LINE__);
   }
 
   return (y - 1);
@@ -62,10 +62,16 @@ R_UINT ceilLog (R_UINT x) {
 R_UINT ceilLogULL (R_ULL_INT x) {
   R_UINT y = 0;
   x--;
+#if defined (__GNUC__)
+  if (x != 0) {
+    y = 64u - (R_UINT) __builtin_clzll (x);
+  }
+#else
   while (x != 0) {
     x >>= 1ull;
     y++;
   }
+#endif
 
   return (y);
 }
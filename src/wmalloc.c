@@ -26,20 +26,119 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>                  /*  pthread_key_t, per thread  */
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
 
 static R_UINT inuse_malloc = 0;
 static R_UINT max_malloc = 0;
 static WMSTRUCT **wm_array;
 static R_CHAR *tempstr;
 
+static pthread_key_t wm_key;
+static pthread_once_t wm_once = PTHREAD_ONCE_INIT;
+static R_BOOLEAN wm_key_created = R_FALSE;
+
+static void createWMKey (void);
+static WMCONTEXT *getWMContext (void);
+static void linkWMHeader (WMCONTEXT *wm, WMHEADER *header);
+
+
+static void createWMKey (void) {
+  if (pthread_key_create (&wm_key, NULL) == 0) {
+    wm_key_created = R_TRUE;
+  }
+
+  return;
+}
+
+
+static WMCONTEXT *getWMContext (void) {
+  (void) pthread_once (&wm_once, createWMKey);
+  if (wm_key_created == R_FALSE) {
+    return (NULL);
+  }
+
+  return ((WMCONTEXT*) pthread_getspecific (wm_key));
+}
+
+
+/*
+**  Add a block to the front of the list of wm
+*/
+static void linkWMHeader (WMCONTEXT *wm, WMHEADER *header) {
+  header -> links.prev = &(wm -> blocks);
+  header -> links.next = wm -> blocks.links.next;
+  header -> links.next -> links.prev = header;
+  wm -> blocks.links.next = header;
+
+  return;
+}
+
+
+void initWMContext (WMCONTEXT *wm) {
+  wm -> blocks.links.prev = &(wm -> blocks);
+  wm -> blocks.links.next = &(wm -> blocks);
+
+  return;
+}
+
+
+/*
+**  List the blocks that this thread allocates in wm, or stop listing
+**  them if wm is NULL.  Returns R_FALSE if the context could not be
+**  set.
+*/
+R_BOOLEAN setWMContext (WMCONTEXT *wm) {
+  (void) pthread_once (&wm_once, createWMKey);
+  if (wm_key_created == R_FALSE) {
+    return (R_FALSE);
+  }
+
+  return (pthread_setspecific (wm_key, wm) == 0);
+}
+
+
+/*
+**  Free the blocks still listed in wm
+*/
+void releaseWMContext (WMCONTEXT *wm) {
+  WMHEADER *curr = wm -> blocks.links.next;
+  WMHEADER *next = NULL;
+
+  while (curr != &(wm -> blocks)) {
+    next = curr -> links.next;
+#ifdef COUNT_MALLOC
+    countFree ((void*) (curr + 1));
+#endif
+    free (curr);
+    curr = next;
+  }
+  initWMContext (wm);
+
+  return;
+}
+
+
 void *wmalloc (size_t y_arg) {
-  void *x_arg = malloc (y_arg);
+  WMCONTEXT *wm = getWMContext ();
+  WMHEADER *header = NULL;
+  void *x_arg = NULL;
+
+  if (wm != NULL) {
+    header = malloc (sizeof (WMHEADER) + y_arg);
+    if (header != NULL) {
+      linkWMHeader (wm, header);
+      x_arg = (void*) (header + 1);
+    }
+  }
+  else {
+    x_arg = malloc (y_arg);
+  }
   if (x_arg == NULL) {
-    fprintf (stderr, "Error in malloc while allocating %u bytes in [%s, %u].\n", (R_UINT) y_arg, __FILE__, __LINE__);
-    exit (EXIT_FAILURE);  
+    raiseError ("Error in malloc while allocating %u bytes in [%s, %u].\n", (R_UINT) y_arg, __FILE__, __LINE__);
   }
 #ifdef COUNT_MALLOC
   countMalloc (x_arg, y_arg, __FILE__, __LINE__);
@@ -50,14 +149,33 @@ void *wmalloc (size_t y_arg) {
 
 
 void *wrealloc (void *x_arg, size_t y_arg) {
+  WMCONTEXT *wm = getWMContext ();
+  WMHEADER *header = NULL;
+
+  if ((wm != NULL) && (x_arg == NULL)) {
+    return (wmalloc (y_arg));
+  }
 #ifdef COUNT_MALLOC
   countFree ((void*) x_arg);
 #endif
-  x_arg = realloc (x_arg, y_arg);
+  if (wm != NULL) {
+    /*  The block stays in the list if it can not be grown  */
+    header = realloc ((WMHEADER*) x_arg - 1, sizeof (WMHEADER) + y_arg);
+    if (header != NULL) {
+      header -> links.prev -> links.next = header;
+      header -> links.next -> links.prev = header;
+      x_arg = (void*) (header + 1);
+    }
+    else {
+      x_arg = NULL;
+    }
+  }
+  else {
+    x_arg = realloc (x_arg, y_arg);
+  }
 
   if (x_arg == NULL) {
-    fprintf (stderr, "Error in realloc while allocating %u bytes in [%s, %u].\n", (R_UINT) y_arg, __FILE__, __LINE__);
-    exit (EXIT_FAILURE);
+    raiseError ("Error in realloc while allocating %u bytes in [%s, %u].\n", (R_UINT) y_arg, __FILE__, __LINE__);
   }
 #ifdef COUNT_MALLOC
   countMalloc ((void*) x_arg, y_arg, __FILE__, __LINE__);
@@ -67,9 +185,18 @@ void *wrealloc (void *x_arg, size_t y_arg) {
 }
 
 void wfree (void *x_arg) {
+  WMCONTEXT *wm = getWMContext ();
+  WMHEADER *header = NULL;
+
 #ifdef COUNT_MALLOC
   countFree (x_arg);
 #endif
+  if ((wm != NULL) && (x_arg != NULL)) {
+    header = (WMHEADER*) x_arg - 1;
+    header -> links.prev -> links.next = header -> links.next;
+    header -> links.next -> links.prev = header -> links.prev;
+    x_arg = (void*) header;
+  }
   free (x_arg);
 }
 
@@ -186,8 +313,7 @@ void countFree (void *ptr) {
     curr = curr -> next;
   }
   if (curr -> ptr == NULL) {
-    fprintf (stderr, "(F) Fatal error.  Node %p could not be found.\n", ptr);
-    exit (EXIT_FAILURE);
+    raiseError ("(F) Fatal error.  Node %p could not be found.\n", ptr);
   }
 
   inuse_malloc -= curr -> size;
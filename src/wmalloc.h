@@ -37,10 +37,35 @@ typedef struct wmstruct {
   struct wmstruct *next;
 } WMSTRUCT;
 
+/*
+**  Header of each block allocated while the thread has a WMCONTEXT;
+**  the union keeps the memory after it aligned for any type
+*/
+typedef union wmheader {
+  struct {
+    union wmheader *prev;
+    union wmheader *next;
+  } links;
+  long double align;
+} WMHEADER;
+
+/*
+**  Blocks allocated by a thread while it has a WMCONTEXT (during a
+**  call to the library; see librepair.c) are listed in it, so that
+**  those still allocated when an error is raised can be freed
+*/
+typedef struct wmcontext {
+  WMHEADER blocks;              /*  Sentinel of a circular list  */
+} WMCONTEXT;
+
 void *wmalloc (size_t y_arg);
 void *wrealloc (void *x_arg, size_t y_arg);
 void wfree (void *x_arg);
 
+void initWMContext (WMCONTEXT *wm);
+R_BOOLEAN setWMContext (WMCONTEXT *wm);
+void releaseWMContext (WMCONTEXT *wm);
+
 void initWMalloc (void);
 void printWMalloc (void);
 void printInUseWMalloc (void);
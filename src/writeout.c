@@ -25,47 +25,208 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>                                           /*  memcpy  */
 #include <limits.h>                                         /*  UINT_MAX  */
 
 #include "common-def.h"
 #include "wmalloc.h"
+#include "error.h"
+#include "stats.h"
 #include "repair-defn.h"
 #include "bitout.h"
 #include "seq.h"
 #include "phrase.h"
 #include "utils.h"
+#include "seqformat.h"
+#include "huffman-encode.h"
+#include "packed-encode.h"
 #include "writeout.h"
 
-static void intEncodeHierarchy (FILE *filedesc, R_UINT a, R_UINT b, R_ULL_INT lo, R_ULL_INT hi, struct phrase final_sorted_phrases[]);
+static void putSeqWord (BLOCK_INFO *block_struct, R_UINT x);
+static void encodeCodedSequence (BLOCK_INFO *block_struct, const R_UINT *symbols, R_UINT num_symbols, R_UINT coding, R_UINT sample_rate);
+static void intEncodeHierarchy (BITOUTREC *w, R_UINT a, R_UINT b, R_ULL_INT lo, R_ULL_INT hi, struct phrase final_sorted_phrases[]);
 
 
 /*
-**  Writes out the sequence file an integer at a time from the array
-**  of seq_entrys.  All integers are incremented by 1 since a 0
-**  indicates the end of a block
+**  Append one 4-byte integer to the block's sequence output, in
+**  little-endian order
+*/
+static void putSeqWord (BLOCK_INFO *block_struct, R_UINT x) {
+  R_UCHAR *buf;
+
+  if (block_struct -> seq_out_len + SIZE_OF_UINT > block_struct -> seq_out_size) {
+    block_struct -> seq_out_size = block_struct -> seq_out_size << 1;
+    block_struct -> seq_out = wrealloc (block_struct -> seq_out, block_struct -> seq_out_size);
+  }
+  buf = block_struct -> seq_out + block_struct -> seq_out_len;
+  buf[0] = (R_UCHAR) (x >> 0) & 255;
+  buf[1] = (R_UCHAR) (x >> 8) & 255;
+  buf[2] = (R_UCHAR) (x >> 16) & 255;
+  buf[3] = (R_UCHAR) (x >> 24);
+  block_struct -> seq_out_len += SIZE_OF_UINT;
+
+  return;
+}
+
+
+/*
+**  Write the sequence of the block as a coded block (see seqformat.h)
+**  over the block's primitives and phrases, with the given coding.
+**  The offset in bits in the coded data of each sampled symbol is
+**  recorded for the block index.  The Huffman coder's tables and its
+**  output, before it is copied, are counted while they exist.
+*/
+static void encodeCodedSequence (BLOCK_INFO *block_struct, const R_UINT *symbols, R_UINT num_symbols, R_UINT coding, R_UINT sample_rate) {
+  R_UINT alphabet_size = block_struct -> num_prims + block_struct -> num_phrases;
+  BITOUTREC *w = NULL;
+  const R_UCHAR *data = NULL;
+  size_t length = 0;
+  size_t out_size = 0;
+  R_UINT width = 0;
+  R_UINT i = 0;
+
+  if (coding == SEQ_CODING_HUFFMAN) {
+    w = newBitout (NULL);
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, 0, huffmanScratchSize (alphabet_size));
+    huffmanEncode (w, symbols, num_symbols, alphabet_size, sample_rate, block_struct -> sample_bits);
+    writeBits (w, 0, 0, R_TRUE);
+    data = takeBitoutBytes (w, &length);
+    out_size = w -> bufferTop;
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, 0, out_size);
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, huffmanScratchSize (alphabet_size), 0);
+  }
+  else {
+    width = ceilLog (alphabet_size);
+    if (width == 0) {
+      width = 1;
+    }
+    length = packedSize (num_symbols, width);
+    for (i = 0; i < block_struct -> num_samples; i++) {
+      block_struct -> sample_bits[i] = (R_ULL_INT) i * sample_rate * width;
+    }
+  }
+
+  putSeqWord (block_struct, SEQ_CODED_MARKER);
+  putSeqWord (block_struct, coding);
+  putSeqWord (block_struct, num_symbols);
+  putSeqWord (block_struct, (R_UINT) ((length + SIZE_OF_UINT - 1) / SIZE_OF_UINT));
+  while (block_struct -> seq_out_len + length + SIZE_OF_UINT > block_struct -> seq_out_size) {
+    block_struct -> seq_out_size = block_struct -> seq_out_size << 1;
+    block_struct -> seq_out = wrealloc (block_struct -> seq_out, block_struct -> seq_out_size);
+  }
+  if (coding == SEQ_CODING_HUFFMAN) {
+    memcpy (block_struct -> seq_out + block_struct -> seq_out_len, data, length);
+    deleteBitout (w);
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, out_size, 0);
+  }
+  else {
+    packedEncode (block_struct -> seq_out + block_struct -> seq_out_len, symbols, num_symbols, width);
+  }
+  block_struct -> seq_out_len += length;
+  while (block_struct -> seq_out_len % SIZE_OF_UINT != 0) {
+    block_struct -> seq_out[block_struct -> seq_out_len] = 0;
+    block_struct -> seq_out_len++;
+  }
+
+  return;
+}
+
+
+/*
+**  Writes out the sequence an integer at a time from the array of
+**  seq_entrys into the block's sequence output buffer, translating
+**  each through the final indexes given by sortPhrases.  All integers
+**  are incremented by 1 since a 0 indicates the end of a block.
+**  Every sample_rate symbols, the position in the original block is
+**  sampled for the block index.  With another coding (-c), the
+**  symbols are gathered first and the block is written coded instead;
+**  the samples then also hold where each sampled symbol is coded.
 */
 void encodeSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct) {
   R_UINT x;
-  R_UCHAR buf[SIZE_OF_UINT];
+  R_UINT value;
+  R_UCHAR *buf;
+  const R_UINT *new_index = block_struct -> new_index;
   SEQ_NODE *seqentry = block_struct -> seq_buf;
   R_UINT seq_length = 0;
+  R_ULL_INT position = 0;
+  R_UINT *symbols = NULL;
+  R_UINT symbols_size = 0;
+  R_UINT length_hint = 0;
+
+  block_struct -> seq_out_len = 0;
+  if (block_struct -> seq_out == NULL) {
+    block_struct -> seq_out_size = INIT_SEQ_OUT_SIZE;
+    block_struct -> seq_out = wmalloc (block_struct -> seq_out_size);
+  }
+  /*  seq_buf_len is normally the length of the sequence left by
+  **  rePairPhrases; make room for all of it, and the end of block
+  **  marker, at once.  It is only a hint, as some heuristics (-e) do
+  **  not keep it up to date.  */
+  if (block_struct -> seq_buf_len <= (R_UINT) (block_struct -> seq_buf_end - block_struct -> seq_buf) + 1) {
+    length_hint = block_struct -> seq_buf_len;
+  }
+  if ((prog_struct -> seq_coding == SEQ_CODING_RAW) && (((size_t) length_hint + 1) * SIZE_OF_UINT > block_struct -> seq_out_size)) {
+    block_struct -> seq_out_size = ((size_t) length_hint + 1) * SIZE_OF_UINT;
+    block_struct -> seq_out = wrealloc (block_struct -> seq_out, block_struct -> seq_out_size);
+  }
+  block_struct -> num_samples = 0;
+  if (block_struct -> samples == NULL) {
+    block_struct -> samples_size = INIT_SAMPLES_SIZE;
+    block_struct -> samples = wmalloc (block_struct -> samples_size * sizeof (R_ULL_INT));
+    block_struct -> sample_bits = wmalloc (block_struct -> samples_size * sizeof (R_ULL_INT));
+  }
+  if (prog_struct -> seq_coding != SEQ_CODING_RAW) {
+    symbols_size = INIT_SEQ_OUT_SIZE / SIZE_OF_UINT;
+    if (symbols_size < length_hint) {
+      symbols_size = length_hint;
+    }
+    symbols = wmalloc (symbols_size * sizeof (R_UINT));
+  }
 
   do {
     if (seqentry -> value != SEQ_NODE_DELETED) {
+      value = new_index[seqentry -> value];
       /*  Must increment all by 1 to allow 0 to be an end 
       **  of buffer marker  */
-      x = seqentry -> value + 1;
+      x = value + 1;
       if (prog_struct -> word_flags == UW_YES) {
-	if (seqentry -> punc_type == WT_PUNC) {
+	if (SEQPUNC (seqentry) == WT_PUNC) {
 	  x = x | PUNC_FLAG;
 	}
       }
-      buf[0] = (R_UCHAR) (x >> 0) & 255;
-      buf[1] = (R_UCHAR) (x >> 8) & 255;
-      buf[2] = (R_UCHAR) (x >> 16) & 255;
-      buf[3] = (R_UCHAR) (x >> 24);
-      (void) fwrite (buf, SIZE_OF_UINT, 1, prog_struct -> seq_file);  
-                                                   /*  Write out buffer  */
+      if (symbols != NULL) {
+        if (seq_length == symbols_size) {
+          symbols_size = symbols_size << 1;
+          symbols = wrealloc (symbols, symbols_size * sizeof (R_UINT));
+        }
+        symbols[seq_length] = value;
+      }
+      else {
+        /*  Reserve room for this symbol and the end of block marker  */
+        if (block_struct -> seq_out_len + (2 * SIZE_OF_UINT) > block_struct -> seq_out_size) {
+          block_struct -> seq_out_size = block_struct -> seq_out_size << 1;
+          block_struct -> seq_out = wrealloc (block_struct -> seq_out, block_struct -> seq_out_size);
+        }
+        buf = block_struct -> seq_out + block_struct -> seq_out_len;
+        buf[0] = (R_UCHAR) (x >> 0) & 255;
+        buf[1] = (R_UCHAR) (x >> 8) & 255;
+        buf[2] = (R_UCHAR) (x >> 16) & 255;
+        buf[3] = (R_UCHAR) (x >> 24);
+        block_struct -> seq_out_len += SIZE_OF_UINT;
+      }
+
+      if (seq_length % prog_struct -> sample_rate == 0) {
+        if (block_struct -> num_samples == block_struct -> samples_size) {
+          block_struct -> samples_size = block_struct -> samples_size << 1;
+          block_struct -> samples = wrealloc (block_struct -> samples, block_struct -> samples_size * sizeof (R_ULL_INT));
+          block_struct -> sample_bits = wrealloc (block_struct -> sample_bits, block_struct -> samples_size * sizeof (R_ULL_INT));
+        }
+        block_struct -> samples[block_struct -> num_samples] = position;
+        block_struct -> sample_bits[block_struct -> num_samples] = 0;
+        block_struct -> num_samples++;
+      }
+      position += (R_ULL_INT) block_struct -> sort_phrases[value].length;
       seq_length++;
       if (seqentry == block_struct -> seq_buf_end) {
         break;
@@ -81,16 +242,32 @@ void encodeSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct)
   **  and (end -> next_seq) lead to garbage values.
   */
 
-  /*  Write a 0 out to indicate end of buffer  */
-  buf[0] = (R_UCHAR) 0;               
-  buf[1] = (R_UCHAR) 0;
-  buf[2] = (R_UCHAR) 0;
-  buf[3] = (R_UCHAR) 0;
-  (void) fwrite (buf, SIZE_OF_UINT, 1, prog_struct -> seq_file);
+  if (symbols != NULL) {
+    /*  The symbols are counted while they are coded  */
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, 0, symbols_size * sizeof (R_UINT));
+    encodeCodedSequence (block_struct, symbols, seq_length, prog_struct -> seq_coding, prog_struct -> sample_rate);
+  }
+  else {
+    /*  Write a 0 out to indicate end of buffer  */
+    buf = block_struct -> seq_out + block_struct -> seq_out_len;
+    buf[0] = (R_UCHAR) 0;               
+    buf[1] = (R_UCHAR) 0;
+    buf[2] = (R_UCHAR) 0;
+    buf[3] = (R_UCHAR) 0;
+    block_struct -> seq_out_len += SIZE_OF_UINT;
+  }
   seq_length++;
 
   block_struct -> num_symbols = seq_length;
 
+  /*  The output buffers only grow while the block is encoded, so they
+  **  are counted once they are complete  */
+  changeMemory (block_struct -> memory, MEM_IO_BUFFERS, 0, block_struct -> seq_out_size + 2 * block_struct -> samples_size * sizeof (R_ULL_INT));
+  if (symbols != NULL) {
+    wfree (symbols);
+    changeMemory (block_struct -> memory, MEM_IO_BUFFERS, symbols_size * sizeof (R_UINT), 0);
+  }
+
   return;
 }
 
@@ -98,7 +275,7 @@ void encodeSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct)
 **  Encodes a subset of an array of phrases where all of the
 **  elements in the subset have the same generation
 */
-static void intEncodeHierarchy (FILE *filedesc, R_UINT a, R_UINT b, R_ULL_INT lo, R_ULL_INT hi, PHRASE final_sorted_phrases[]) {
+static void intEncodeHierarchy (BITOUTREC *w, R_UINT a, R_UINT b, R_ULL_INT lo, R_ULL_INT hi, PHRASE final_sorted_phrases[]) {
   R_ULL_INT mid = 0;
   R_UINT halfway = 0;
   R_UINT range = 0;
@@ -107,7 +284,7 @@ static void intEncodeHierarchy (FILE *filedesc, R_UINT a, R_UINT b, R_ULL_INT lo
 
   switch (range) {
     case 0:  return;
-    case 1:  binaryEncode (filedesc, final_sorted_phrases[a].unit, lo, hi);
+    case 1:  binaryEncode (w, final_sorted_phrases[a].unit, lo, hi);
              return;
   }
   halfway = range >> 1;
@@ -116,11 +293,11 @@ static void intEncodeHierarchy (FILE *filedesc, R_UINT a, R_UINT b, R_ULL_INT lo
   mid = final_sorted_phrases[a + halfway].unit;
                                /*  Obtain the unit of the halfway point  */
 
-  binaryEncode (filedesc, mid, lo + (R_ULL_INT) halfway, hi - (R_ULL_INT) (range - halfway - 1));
+  binaryEncode (w, mid, lo + (R_ULL_INT) halfway, hi - (R_ULL_INT) (range - halfway - 1));
                                         /*  Binary encode the mid-point  */
-  intEncodeHierarchy (filedesc, a, a + halfway, lo, mid, final_sorted_phrases);
+  intEncodeHierarchy (w, a, a + halfway, lo, mid, final_sorted_phrases);
                                    /*  Recursively encode the left half  */
-  intEncodeHierarchy (filedesc, a + halfway + 1, b, mid + 1ull, hi, final_sorted_phrases);
+  intEncodeHierarchy (w, a + halfway + 1, b, mid + 1ull, hi, final_sorted_phrases);
                                   /*  Recursively encode the right half  */
 
   return;
@@ -141,20 +318,20 @@ void encodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct)
   SINGLE_NODE *back_sizes = NULL;
   R_UINT currgen = 0;
 
-  deltaEncode (prog_struct -> prel_file, block_struct -> num_prims + block_struct -> num_phrases, 0);
+  deltaEncode (block_struct -> prel_rec, block_struct -> num_prims + block_struct -> num_phrases, 0);
             /*  Delta encode the total number of primitives and phrases  */
 
-  deltaEncode (prog_struct -> prel_file, block_struct -> num_prims, 1);
+  deltaEncode (block_struct -> prel_rec, block_struct -> num_prims, 1);
                         /*  Delta encode the total number of primitives  */
 
   max = block_struct -> sort_phrases[block_struct -> num_prims - 1].left;
                   /*  Get the maximum ASCII value of all the primitives  */
   logRange = (R_UINT) ceilLog (max + 1);
   topRange = 1u << logRange;
-  gammaEncode (prog_struct -> prel_file, logRange, 0);
+  gammaEncode (block_struct -> prel_rec, logRange, 0);
                     /*  Calculate and gamma encode the log of the range  */
 
-  intEncodeHierarchy (prog_struct -> prel_file, 0, block_struct -> num_prims, 0, topRange, block_struct -> sort_phrases);
+  intEncodeHierarchy (block_struct -> prel_rec, 0, block_struct -> num_prims, 0, topRange, block_struct -> sort_phrases);
   currgen++;
                                               /*  Encode the primitives  */
 
@@ -170,11 +347,11 @@ void encodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct)
 #endif
 
     currgen++;
-    gammaEncode (prog_struct -> prel_file, currentsize, 1);
+    gammaEncode (block_struct -> prel_rec, currentsize, 1);
                             /*  Gamma encode the size of the generation  */
     kpSqr = kp * kp;
 
-    intEncodeHierarchy (prog_struct -> prel_file, (R_UINT) kp, (R_UINT) kp + currentsize, 0ull, kpSqr - kppSqr, block_struct -> sort_phrases);
+    intEncodeHierarchy (block_struct -> prel_rec, (R_UINT) kp, (R_UINT) kp + currentsize, 0ull, kpSqr - kppSqr, block_struct -> sort_phrases);
  	                           /*  Encode the generation of phrases  */
     kpp = kp;
     kppSqr = kpSqr;
@@ -189,8 +366,7 @@ void encodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct)
   block_struct -> sizelist = NULL;
 
   if (kp > (block_struct -> num_prims + block_struct -> num_phrases)) {
-    fprintf (stderr, "Wrong generation sizes in %s, line %u.", __FILE__, __LINE__);
-    exit (EXIT_FAILURE);
+    raiseError ("Wrong generation sizes in %s, line %u.", __FILE__, __LINE__);
   }
 
   return;
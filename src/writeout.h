@@ -26,6 +26,11 @@
 #ifndef WRITEOUT_H
 #define WRITEOUT_H
 
+#define INIT_SEQ_OUT_SIZE 262144u
+                   /*  Initial size in bytes of a block's sequence output  */
+#define INIT_SAMPLES_SIZE 4096u
+                       /*  Initial number of position samples in a block  */
+
 void encodeSequence_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 void encodeHierarchy_OneBlock (PROG_INFO *prog_struct, BLOCK_INFO *block_struct);
 